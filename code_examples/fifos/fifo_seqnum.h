@@ -38,12 +38,30 @@
  * */
 struct request {
     pid_t pid;          /* PID of the client */
-    int seq_len;        /* Length of requested sequence */
+    int seq_len;        /* Length of requested sequence; never negative, but for the 
+                           session markers below */
 };
 
-/* Format for the response message from server ----> client */
+/* Format for the response message from server ----> client. The numbers start at 
+ * zero and only grow, so they are never negative and a long does not wrap. */
 struct response {
-    int seq_num;
+    long seq_num;
+    int seq_len;        /* Length of the sequence, copied from the request */
 };
 
+/* Session mode (fifo_seqnum_server -s). Instead of opening and closing the client FIFO 
+ * for every request, the server keeps it open for as long as the client is around. 
+ * The client opens its own FIFO for both reading and writing, so that it never sees 
+ * end-of-file while the server has the FIFO closed, and then sends a request with 
+ * seq_len set to SEQNUM_SESSION_START. After that it may send a window of requests 
+ * before reading the responses, which come back in order. The responses to a window 
+ * must fit in the client FIFO: a server blocked writing them stops reading requests, 
+ * and a client blocked writing more of them never gets to read the responses. When 
+ * done, the client sends a request with seq_len set to SEQNUM_SESSION_END so that the 
+ * server can close its end of the FIFO. Neither of the two is answered. Requests from 
+ * clients that have not started a session are served one at a time, as in the 
+ * default mode. */
+#define SEQNUM_SESSION_END (-1)
+#define SEQNUM_SESSION_START (-2)
+
 #endif  /* _FIFO_SEQNUM_H_ */
@@ -0,0 +1,228 @@
+/* Benchmark for the sequence number server in fifo_seqnum_server.c. A number of 
+ * client processes request sequences of length one as fast as they can, and the 
+ * program reports the number of requests per second served in total. It also 
+ * checks that no number was handed out twice.
+ *
+ * Without -s each request is made the way fifo_seqnum_client.c makes it: create 
+ * the client FIFO, open the server FIFO, send the request, open the client FIFO, 
+ * read the response, close and remove everything. With -s the clients use the 
+ * session protocol and keep up to depth requests in flight. With -m they take 
+ * their numbers from the shared memory counter (see seqnum_shm.h).
+ *
+ * Start the server first, in the matching mode:
+ *      ./fifo_seqnum_server > /dev/null &          (or with -s, or with -m)
+ *      ./fifo_seqnum_bench [-s | -m] [clients] [requests per client] [depth]
+ *
+ * Date created: October 19, 2026
+ *
+ * Compile as follows:
+ * gcc -o fifo_seqnum_bench fifo_seqnum_bench.c seqnum_shm.c -std=c11 -Wall -O2 -lrt
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include "fifo_seqnum.h"
+#include "seqnum_shm.h"
+
+#define MAX_DEPTH 256
+
+static double 
+now_seconds (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void 
+die (const char *message)
+{
+    perror (message);
+    exit (EXIT_FAILURE);
+}
+
+/* One request, made the way fifo_seqnum_client.c makes it */
+static long 
+request_once (const char *client_fifo)
+{
+    struct request req;
+    struct response resp;
+    int server_fd, client_fd;
+
+    if (mkfifo (client_fifo, S_IRUSR | S_IWUSR | S_IWGRP) == -1 && errno != EEXIST)
+        die ("mkfifo");
+    server_fd = open (SERVER_FIFO, O_WRONLY);
+    if (server_fd == -1)
+        die ("open server FIFO");
+
+    req.pid = getpid ();
+    req.seq_len = 1;
+    if (write (server_fd, &req, sizeof (struct request)) != sizeof (struct request))
+        die ("write");
+    client_fd = open (client_fifo, O_RDONLY);
+    if (client_fd == -1)
+        die ("open client FIFO");
+    if (read (client_fd, &resp, sizeof (struct response)) != sizeof (struct response))
+        die ("read");
+
+    close (client_fd);
+    close (server_fd);
+    unlink (client_fifo);
+    return resp.seq_num;
+}
+
+/* Read exactly len bytes */
+static void 
+read_full (int fd, void *buf, size_t len)
+{
+    ssize_t n;
+    size_t done = 0;
+
+    while (done < len){
+        n = read (fd, (char *)buf + done, len - done);
+        if (n <= 0)
+            die ("read");
+        done += n;
+    }
+}
+
+/* A whole run of requests over one session, depth requests at a time */
+static void 
+run_session (const char *client_fifo, long *results, long requests, int depth)
+{
+    struct request reqs[MAX_DEPTH];
+    struct response resps[MAX_DEPTH];
+    int server_fd, client_fd, i, batch;
+    long done;
+
+    if (mkfifo (client_fifo, S_IRUSR | S_IWUSR | S_IWGRP) == -1 && errno != EEXIST)
+        die ("mkfifo");
+    client_fd = open (client_fifo, O_RDWR);
+    server_fd = open (SERVER_FIFO, O_WRONLY);
+    if (client_fd == -1 || server_fd == -1)
+        die ("open");
+
+    reqs[0].pid = getpid ();
+    reqs[0].seq_len = SEQNUM_SESSION_START;
+    if (write (server_fd, reqs, sizeof (struct request)) != sizeof (struct request))
+        die ("write");
+
+    for (i = 0; i < depth; i++){
+        reqs[i].pid = getpid ();
+        reqs[i].seq_len = 1;
+    }
+
+    for (done = 0; done < requests; done += batch){
+        batch = (requests - done < depth) ? requests - done : depth;
+        if (write (server_fd, reqs, batch * sizeof (struct request)) != batch * sizeof (struct request))
+            die ("write");
+        read_full (client_fd, resps, batch * sizeof (struct response));
+        for (i = 0; i < batch; i++)
+            results[done + i] = resps[i].seq_num;
+    }
+
+    reqs[0].seq_len = SEQNUM_SESSION_END;
+    write (server_fd, reqs, sizeof (struct request));
+    close (client_fd);
+    close (server_fd);
+    unlink (client_fifo);
+}
+
+/* A whole run of requests against the shared memory counter */
+static void 
+run_shared (long *results, long requests, long *fallbacks)
+{
+    long i;
+
+    if (seqnum_attach () == -1)
+        die ("seqnum_attach");
+    for (i = 0; i < requests; i++)
+        results[i] = seqnum_alloc (1);
+    __atomic_fetch_add (fallbacks, seqnum_fallbacks (), __ATOMIC_RELAXED);
+    seqnum_detach ();
+}
+
+static int 
+compare_longs (const void *a, const void *b)
+{
+    long x = *(const long *)a, y = *(const long *)b;
+
+    return (x > y) - (x < y);
+}
+
+int 
+main (int argc, char **argv)
+{
+    int session_mode = 0, shared_mode = 0, clients, depth, c;
+    long requests, i, total, duplicates = 0, *results, *fallbacks;
+    double start, elapsed;
+
+    if (argc > 1 && strcmp (argv[1], "-s") == 0){
+        session_mode = 1;
+        argc--;
+        argv++;
+    }
+    else if (argc > 1 && strcmp (argv[1], "-m") == 0){
+        shared_mode = session_mode = 1;
+        argc--;
+        argv++;
+    }
+    clients = (argc > 1) ? atoi (argv[1]) : 4;
+    requests = (argc > 2) ? atol (argv[2]) : (session_mode ? 200000 : 5000);
+    depth = (argc > 3) ? atoi (argv[3]) : 16;
+    if (clients <= 0 || requests <= 0 || depth <= 0 || depth > MAX_DEPTH){
+        printf ("Usage: %s [-s] [clients] [requests per client] [depth <= %d] \n", argv[0], MAX_DEPTH);
+        exit (EXIT_FAILURE);
+    }
+    if (access (SERVER_FIFO, F_OK) == -1){
+        printf ("Start fifo_seqnum_server first \n");
+        exit (EXIT_FAILURE);
+    }
+
+    /* The clients leave the numbers they got here for the uniqueness check */
+    total = clients * requests;
+    results = (long *)mmap (NULL, total * sizeof (long), PROT_READ | PROT_WRITE, 
+                            MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    fallbacks = (long *)mmap (NULL, sizeof (long), PROT_READ | PROT_WRITE, 
+                              MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (results == MAP_FAILED || fallbacks == MAP_FAILED)
+        die ("mmap");
+
+    umask (0);
+    start = now_seconds ();
+    for (c = 0; c < clients; c++){
+        if (fork () == 0){
+            char client_fifo[CLIENT_FIFO_NAME_LEN];
+            long *mine = results + c * requests;
+
+            snprintf (client_fifo, CLIENT_FIFO_NAME_LEN, CLIENT_FIFO_TEMPLATE, (long)getpid ());
+            if (shared_mode)
+                run_shared (mine, requests, fallbacks);
+            else if (session_mode)
+                run_session (client_fifo, mine, requests, depth);
+            else
+                for (i = 0; i < requests; i++)
+                    mine[i] = request_once (client_fifo);
+            _exit (EXIT_SUCCESS);
+        }
+    }
+    while (wait (NULL) > 0);
+    elapsed = now_seconds () - start;
+
+    qsort (results, total, sizeof (long), compare_longs);
+    for (i = 1; i < total; i++)
+        if (results[i] == results[i - 1])
+            duplicates++;
+
+    printf ("%s: %d clients, %ld requests, %.0f requests/s, %ld duplicates", 
+            shared_mode ? "shared memory" : (session_mode ? "session" : "per-request"), 
+            clients, total, total / elapsed, duplicates);
+    if (shared_mode)
+        printf (", %ld through the FIFO", *fallbacks);
+    printf (" \n");
+    exit (EXIT_SUCCESS);
+}
@@ -2,15 +2,29 @@
  *
  * Source: Source: M. Kerrisk, Linux Programming Interface
  *
+ * Usage: ./fifo_seqnum_client [seq-len]
+ *        ./fifo_seqnum_client -n count [seq-len]
+ *        ./fifo_seqnum_client -m count [seq-len]
+ * The second form asks for count sequences in one session with a server that was 
+ * started with -s (see fifo_seqnum.h). The third takes them straight from the shared 
+ * memory counter of a server started with -m (see seqnum_shm.h).
+ *
  * Compile as follows:
- * gcc -o fifo_seqnum_client fifo_seqnum_client.c -std=c99 -Wall
+ * gcc -o fifo_seqnum_client fifo_seqnum_client.c seqnum_shm.c -std=c11 -Wall -lrt
  *
  * Author: Naga Kandasamy
  * Date created: July 11, 2018
  *
  */
 
+#define _DEFAULT_SOURCE
+
 #include "fifo_seqnum.h"
+#include "seqnum_shm.h"
+
+/* Requests in flight in a session. Their responses fit in the client FIFO, so the 
+ * server never blocks writing them while we are still writing requests. */
+#define SESSION_WINDOW 64
 
 static char client_fifo[CLIENT_FIFO_NAME_LEN];
 
@@ -21,14 +35,124 @@ remove_fifo (void)
     unlink (client_fifo);
 }
 
+/* Read exactly len bytes */
+static void 
+read_full (int fd, void *buf, size_t len)
+{
+    ssize_t n;
+    size_t done = 0;
+
+    while (done < len){
+        n = read (fd, (char *)buf + done, len - done);
+        if (n <= 0){
+            printf ("Cannot read response from server \n");
+            exit (EXIT_FAILURE);
+        }
+        done += n;
+    }
+}
+
+/* Request count sequences of length seq_len over one session. Our FIFO is opened 
+ * for reading and writing before the first request goes out, so that the open does 
+ * not wait for the server and we never see end-of-file in between responses. The 
+ * requests are pipelined: up to SESSION_WINDOW of them go out with one write (), 
+ * and only then are their responses read, which come back in the order of the 
+ * requests. */
+static void 
+run_session (int count, int seq_len)
+{
+    int server_fd, client_fd, i, window, done;
+    struct request reqs[SESSION_WINDOW];
+    struct response resps[SESSION_WINDOW];
+
+    client_fd = open (client_fifo, O_RDWR);
+    if (client_fd == -1){
+        printf ("Cannot open FIFO %s \n", client_fifo);
+        exit (EXIT_FAILURE);
+    }
+    server_fd = open (SERVER_FIFO, O_WRONLY);
+    if (server_fd == -1){
+        printf ("Cannot open server FIFO %s\n", SERVER_FIFO);
+        exit (EXIT_FAILURE);
+    }
+
+    for (i = 0; i < SESSION_WINDOW; i++){
+        reqs[i].pid = getpid ();
+        reqs[i].seq_len = seq_len;
+    }
+
+    /* Ask the server to keep our FIFO open */
+    reqs[0].seq_len = SEQNUM_SESSION_START;
+    if (write (server_fd, reqs, sizeof (struct request)) != sizeof (struct request)){
+        printf ("Cannot write to server");
+        exit (EXIT_FAILURE);
+    }
+    reqs[0].seq_len = seq_len;
+
+    for (done = 0; done < count; done += window){
+        window = (count - done < SESSION_WINDOW) ? count - done : SESSION_WINDOW;
+        if (write (server_fd, reqs, window * sizeof (struct request)) != window * sizeof (struct request)){
+            printf ("Cannot write to server");
+            exit (EXIT_FAILURE);
+        }
+        read_full (client_fd, resps, window * sizeof (struct response));
+        for (i = 0; i < window; i++){
+            if (resps[i].seq_len != seq_len){
+                printf ("Response %d does not match its request \n", done + i);
+                exit (EXIT_FAILURE);
+            }
+            printf ("Response received from server: %ld \n", resps[i].seq_num);
+        }
+    }
+
+    /* Let the server close its end of our FIFO */
+    reqs[0].seq_len = SEQNUM_SESSION_END;
+    if (write (server_fd, reqs, sizeof (struct request)) != sizeof (struct request)){
+        printf ("Cannot write to server");
+        exit (EXIT_FAILURE);
+    }
+    exit (EXIT_SUCCESS);
+}
+
+/* Take count sequences from the shared memory counter */
+static void 
+run_shared (int count, int seq_len)
+{
+    long seq;
+    int i;
+
+    if (seqnum_attach () == -1){
+        perror ("seqnum_attach");
+        exit (EXIT_FAILURE);
+    }
+    for (i = 0; i < count; i++){
+        seq = seqnum_alloc (seq_len);
+        if (seq == -1){
+            perror ("seqnum_alloc");
+            exit (EXIT_FAILURE);
+        }
+        printf ("Sequence from shared memory: %ld \n", seq);
+    }
+    seqnum_detach ();
+    exit (EXIT_SUCCESS);
+}
+
 int 
 main (int argc, char **argv)
 {
     /* Read command line argument to the program. */
     if (argc > 1 && strcmp (argv[1], "--help") == 0){
-        printf ("Usage: %s <seq-len> \n", argv[0]);
+        printf ("Usage: %s [-n count | -m count] <seq-len> \n", argv[0]);
         exit (EXIT_SUCCESS);
     }
+    if (argc > 2 && strcmp (argv[1], "-m") == 0)
+        run_shared (atoi (argv[2]), (argc > 3) ? atoi (argv[3]) : 1);
+    int session_count = 0;
+    if (argc > 2 && strcmp (argv[1], "-n") == 0){
+        session_count = atoi (argv[2]);
+        argc -= 2;
+        argv += 2;
+    }
 
     /* Create a FIFO using the template to be used for receiving 
      * the response from the server. This is done before sending the 
@@ -65,6 +189,13 @@ main (int argc, char **argv)
         req.seq_len = atoi (argv[1]);
     else
         req.seq_len = 1;
+    if (req.seq_len < 0){
+        printf ("The sequence length cannot be negative \n");
+        exit (EXIT_FAILURE);
+    }
+
+    if (session_count > 0)
+        run_session (session_count, req.seq_len);
 
     server_fd = open (SERVER_FIFO, O_WRONLY);
     if (server_fd == -1){
@@ -90,7 +221,7 @@ main (int argc, char **argv)
         exit (EXIT_FAILURE);
     }
 
-    printf ("Response received from server: %d \n", resp.seq_num);
+    printf ("Response received from server: %ld \n", resp.seq_num);
     exit (EXIT_SUCCESS);
 }
 
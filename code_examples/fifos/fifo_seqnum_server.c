@@ -2,20 +2,70 @@
  *
  * Source: Source: M. Kerrisk, Linux Programming Interface
  *
+ * Usage: ./fifo_seqnum_server [-s | -m]
+ *      -s      Session mode: keep the FIFOs of clients that start a session open and 
+ *              answer requests in bulk (see fifo_seqnum.h)
+ *      -m      Shared memory mode: publish the counter in shared memory so that 
+ *              clients can allocate without asking the server (see seqnum_shm.h). 
+ *              Requests that still come in over the FIFO are served as with -s.
+ *
+ * With -s and -m the server runs on the epoll reactor in ../file_io/reactor.c: the 
+ * server FIFO is watched for requests and, with -m, a periodic timer checks the 
+ * lease every LEASE_CHECK_MS milliseconds.
+ *
  * Compile as follows:
- * gcc -o fifo_seqnum_server fifo_seqnum_server.c -std=c99 -Wall
+ * gcc -o fifo_seqnum_server fifo_seqnum_server.c ../file_io/reactor.c -std=c11 -Wall -lrt
  *
  * Author: Naga Kandasamy
  * Date created: July 10, 2018
  *
  */
 
+#define _DEFAULT_SOURCE
+
 #include <signal.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include "../file_io/reactor.h"
 #include "fifo_seqnum.h"
+#include "seqnum_shm.h"
+
+#define MAX_SESSIONS 4096       /* Size of the client FIFO table; a power of two */
+#define REQUEST_BATCH 512       /* Requests taken from the server FIFO per read () */
+#define LEASE_CHECK_MS 100      /* How often to check the lease in shared memory mode */
+#define RESERVED_FDS 16         /* Descriptors kept free for everything but client FIFOs */
+
+/* An open client FIFO, kept in a hash table keyed by the pid of the client */
+struct session {
+    pid_t pid;                  /* Zero if the entry is free */
+    int fd;
+    unsigned long batch;        /* Last batch that had requests from the client */
+    int batch_index;            /* Position among the clients of that batch */
+    int closing;                /* Client ended the session or went away, or never 
+                                   started one; the FIFO is closed after the batch */
+};
+
+static struct session sessions[MAX_SESSIONS];
+static int num_sessions;
+static int max_sessions;        /* Sessions kept open between batches */
+
+static long seq_num = 0;    /* This is the service that we provide as a server */
+static struct seqnum_page *page;    /* The counter, in shared memory mode */
+
+static void serve_requests (int server_fd);
+static void serve_sessions (int server_fd);
+static void setup_shared_counter (void);
 
 int 
 main (int argc, char **argv)
 {
+    int session_mode = (argc > 1 && strcmp (argv[1], "-s") == 0);
+
+    if (argc > 1 && strcmp (argv[1], "-m") == 0){
+        setup_shared_counter ();
+        session_mode = 1;
+    }
+
     /* Create a well-known FIFO and open it for reading. The server 
      * must be run before any of its clients so that the server FIFO exists by the 
      * time a client attempts to open it. The server's open() blocks until the first client 
@@ -54,22 +104,35 @@ main (int argc, char **argv)
        exit (EXIT_FAILURE);
    }
 
-   /* Loop that reads and responds to each incoming client request. To send the 
-    * response, the server constructs the name of the client FIFO and then opens the 
-    * FIFO for writing. If the server encounters an error in opening the client FIFO, 
-    * it abandons that client's request and moves on to the next one.
-    */
+   if (session_mode)
+       serve_sessions (server_fd);
+   else
+       serve_requests (server_fd);
+   exit (EXIT_SUCCESS);
+}
+
+/* Loop that reads and responds to each incoming client request. To send the 
+ * response, the server constructs the name of the client FIFO and then opens the 
+ * FIFO for writing. If the server encounters an error in opening the client FIFO, 
+ * it abandons that client's request and moves on to the next one.
+ */
+static void 
+serve_requests (int server_fd)
+{
    int client_fd;
    char client_fifo[CLIENT_FIFO_NAME_LEN];
    struct request req;
    struct response resp;
-   int seq_num = 0; /* This is the service that we provide as a server */
 
    while (1){
        if (read (server_fd, &req, sizeof (struct request)) != sizeof (struct request)){
            fprintf (stderr, "SERVER: Error reading request; discarding \n");
            continue;
        }
+       if (req.seq_len < 0){
+           fprintf (stderr, "SERVER: Bad sequence length %d; discarding \n", req.seq_len);
+           continue;
+       }
 
        /* Construct the name of the client FIFO previously created by the client and 
         * open it for writing. */
@@ -84,6 +147,7 @@ main (int argc, char **argv)
 
        /* Send the response to the client and close FIFO */
        resp.seq_num = seq_num;
+       resp.seq_len = req.seq_len;
        if (write (client_fd, &resp, sizeof (struct response)) != sizeof (struct response))
            fprintf (stderr, "Error writing to client FIFO %s \n", client_fifo);
        if (close (client_fd) == -1)
@@ -94,3 +158,378 @@ main (int argc, char **argv)
    }
 }
 
+
+/* Atomically replace the checkpoint file with the new high-water mark */
+static void 
+write_checkpoint (long mark)
+{
+    char tmp[sizeof (SEQNUM_CHECKPOINT_FILE) + 4];
+    FILE *fp;
+
+    snprintf (tmp, sizeof (tmp), "%s.tmp", SEQNUM_CHECKPOINT_FILE);
+    fp = fopen (tmp, "w");
+    if (fp == NULL || fprintf (fp, "%ld\n", mark) < 0 || fflush (fp) != 0 
+        || fsync (fileno (fp)) == -1 || fclose (fp) != 0 
+        || rename (tmp, SEQNUM_CHECKPOINT_FILE) == -1){
+        /* Handing out numbers that are not covered by a checkpoint could repeat 
+         * them after a crash, so stop instead. */
+        perror ("SERVER: checkpoint");
+        exit (EXIT_FAILURE);
+    }
+}
+
+static long 
+read_checkpoint (void)
+{
+    FILE *fp = fopen (SEQNUM_CHECKPOINT_FILE, "r");
+    long mark = 0;
+
+    if (fp != NULL){
+        if (fscanf (fp, "%ld", &mark) != 1 || mark < 0)
+            mark = 0;
+        fclose (fp);
+    }
+    return mark;
+}
+
+/* Move the limit so that at least needed numbers are covered, plus a full lease. 
+ * The checkpoint goes to disk before the clients may use the new numbers. */
+static void 
+extend_lease (long needed)
+{
+    long limit = needed + SEQNUM_LEASE;
+
+    write_checkpoint (limit);
+    atomic_store (&page->limit, limit);
+}
+
+/* Move the limit ahead once the clients have used up half of the lease */
+static void 
+check_lease (void)
+{
+    long next = atomic_load (&page->next);
+
+    if (next > atomic_load (&page->limit) - SEQNUM_LEASE / 2)
+        extend_lease (next);
+}
+
+/* Publish the counter in shared memory. The page is kept if it already exists, so 
+ * that clients of a previous server that crashed can carry on with this one. */
+static void 
+setup_shared_counter (void)
+{
+    long start;
+    int fd;
+
+    fd = shm_open (SEQNUM_SHM_NAME, O_CREAT | O_RDWR, S_IRUSR | S_IWUSR);
+    if (fd == -1 || ftruncate (fd, sizeof (struct seqnum_page)) == -1){
+        perror ("shm_open");
+        exit (EXIT_FAILURE);
+    }
+    page = (struct seqnum_page *)mmap (NULL, sizeof (struct seqnum_page), PROT_READ | PROT_WRITE, 
+                                       MAP_SHARED, fd, 0);
+    close (fd);
+    if (page == MAP_FAILED){
+        perror ("mmap");
+        exit (EXIT_FAILURE);
+    }
+
+    /* Numbers up to the checkpointed mark may have been handed out before a crash. 
+     * Clients stuck past the old limit fall back to the FIFO until we are up. */
+    start = read_checkpoint ();
+    atomic_store (&page->limit, 0);
+    if (page->magic == SEQNUM_MAGIC && atomic_load (&page->next) > start)
+        start = atomic_load (&page->next);
+    atomic_store (&page->next, start);
+    extend_lease (start);
+    page->server_pid = getpid ();
+    page->magic = SEQNUM_MAGIC;
+
+    fprintf (stderr, "SERVER: Counter starts at %ld, published in %s \n", start, SEQNUM_SHM_NAME);
+}
+
+/* Hand out the next seq_len numbers */
+static long 
+next_seq_num (int seq_len)
+{
+    long first;
+
+    if (page == NULL){
+        first = seq_num;
+        seq_num += seq_len;
+        return first;
+    }
+
+    first = atomic_fetch_add (&page->next, seq_len);
+    if (first + seq_len > atomic_load (&page->limit))
+        extend_lease (first + seq_len);
+    return first;
+}
+
+/* Find the table entry for the client, or the free entry where it would go */
+static struct session *
+session_slot (pid_t pid)
+{
+    unsigned int i = (unsigned int)pid & (MAX_SESSIONS - 1);
+
+    while (sessions[i].pid != 0 && sessions[i].pid != pid)
+        i = (i + 1) & (MAX_SESSIONS - 1);
+    return &sessions[i];
+}
+
+/* Close the client FIFO and remove the entry from the table. The entries that 
+ * follow it in the same run are shifted back so that lookups still find them. */
+static void 
+session_evict (struct session *s)
+{
+    unsigned int i = s - sessions, j = i, home;
+
+    close (s->fd);
+    num_sessions--;
+    while (1){
+        sessions[i].pid = 0;
+        do {
+            j = (j + 1) & (MAX_SESSIONS - 1);
+            if (sessions[j].pid == 0)
+                return;
+            home = (unsigned int)sessions[j].pid & (MAX_SESSIONS - 1);
+            /* Leave the entry alone if its home slot lies cyclically in (i, j] */
+        } while (i <= j ? (i < home && home <= j) : (i < home || home <= j));
+        sessions[i] = sessions[j];
+        i = j;
+    }
+}
+
+/* Open the client FIFO for writing. A session client already has its FIFO open, so 
+ * the open succeeds at once. A one-shot client opens its FIFO only after sending the 
+ * request, and for that one we have to wait as serve_requests () does, but only while 
+ * the client is still alive. */
+static int 
+open_client_fifo (pid_t pid)
+{
+    char client_fifo[CLIENT_FIFO_NAME_LEN];
+    int fd;
+
+    snprintf (client_fifo, CLIENT_FIFO_NAME_LEN, CLIENT_FIFO_TEMPLATE, (long)pid);
+    fd = open (client_fifo, O_WRONLY | O_NONBLOCK);
+    if (fd == -1 && errno == ENXIO && kill (pid, 0) == 0)
+        fd = open (client_fifo, O_WRONLY);
+    if (fd == -1){
+        fprintf (stderr, "SERVER: Error opening client fifo %s \n", client_fifo);
+        return -1;
+    }
+    fcntl (fd, F_SETFL, fcntl (fd, F_GETFL) & ~O_NONBLOCK);
+    return fd;
+}
+
+/* Open the client FIFO and enter it in the table. The entry of a one-shot client is 
+ * marked closing so that it lasts only for the current batch. A client that is in 
+ * the table already gets its FIFO opened afresh: it may be a new process that was 
+ * given the pid of one that went away without ending its session. */
+static struct session *
+session_open (pid_t pid, int one_shot)
+{
+    struct session *s = session_slot (pid);
+    int fd;
+
+    if ((fd = open_client_fifo (pid)) == -1)
+        return NULL;
+
+    if (s->pid == pid)
+        close (s->fd);
+    else {
+        s->pid = pid;
+        s->batch = 0;
+        num_sessions++;
+    }
+    s->fd = fd;
+    s->closing = one_shot;
+    return s;
+}
+
+/* Send the responses to a client. If its FIFO has lost its reader, the pid may now 
+ * belong to another process with a FIFO of its own under the same name, so open the 
+ * FIFO by name and try once more. */
+static int 
+send_responses (struct session *s, const struct response *resps, ssize_t n)
+{
+    int fd;
+
+    if (write (s->fd, resps, n) == n)
+        return 0;
+    if (errno != EPIPE || (fd = open_client_fifo (s->pid)) == -1)
+        return -1;
+    close (s->fd);
+    s->fd = fd;
+    return (write (fd, resps, n) == n) ? 0 : -1;
+}
+
+/* Every open client FIFO is a descriptor: the sessions kept between batches, plus 
+ * the one-shot clients of a batch, up to REQUEST_BATCH of them. Raise the soft limit 
+ * on descriptors as far as the hard limit allows, and keep the sessions within what 
+ * is left of it. */
+static void 
+set_session_limit (void)
+{
+    struct rlimit limit;
+
+    max_sessions = MAX_SESSIONS - REQUEST_BATCH - 1;
+    if (getrlimit (RLIMIT_NOFILE, &limit) == -1)
+        return;
+    if (limit.rlim_cur < limit.rlim_max){
+        limit.rlim_cur = limit.rlim_max;
+        if (setrlimit (RLIMIT_NOFILE, &limit) == -1)
+            getrlimit (RLIMIT_NOFILE, &limit);
+    }
+    if (limit.rlim_cur != RLIM_INFINITY 
+        && (long)limit.rlim_cur - RESERVED_FDS - REQUEST_BATCH < max_sessions)
+        max_sessions = (long)limit.rlim_cur - RESERVED_FDS - REQUEST_BATCH;
+    if (max_sessions < 0)
+        max_sessions = 0;
+}
+
+/* Read a batch of requests and answer all the requests of a client in the batch 
+ * with one write (). The FIFOs of session clients stay open between batches; a FIFO 
+ * is closed when its client ends the session, or when writing to it fails because 
+ * the client exited without saying goodbye. The FIFOs of one-shot clients are 
+ * closed once the batch is answered. Entries are only removed from the table 
+ * between batches, so pointers to them stay valid within one. 
+ */
+static void 
+serve_batch (reactor_t *reactor, int server_fd, uint32_t events, void *arg)
+{
+    static struct request reqs[REQUEST_BATCH];
+    static struct response resps[REQUEST_BATCH];
+    static struct response grouped[REQUEST_BATCH];
+    static unsigned long batch = 0;
+    static size_t leftover = 0;
+    struct session *batch_sessions[REQUEST_BATCH], *s;
+    int req_session[REQUEST_BATCH], first[REQUEST_BATCH + 1], next[REQUEST_BATCH];
+    size_t bytes;
+    ssize_t n;
+    int num_reqs, num_batch, i, k;
+
+    /* Make sure the table, and the descriptor limit, have room for every client 
+     * of the next batch. The clients we drop are not harmed: their requests are 
+     * served one at a time from then on. */
+    while (num_sessions > max_sessions){
+        s = &sessions[random () & (MAX_SESSIONS - 1)];
+        if (s->pid != 0)
+            session_evict (s);
+    }
+
+    n = read (server_fd, (char *)reqs + leftover, sizeof (reqs) - leftover);
+    if (n <= 0){
+        if (n == -1 && errno != EINTR)
+            perror ("read");
+        return;
+    }
+    bytes = n + leftover;
+    num_reqs = bytes / sizeof (struct request);
+    batch++;
+
+    /* Hand out the numbers in arrival order and note which client each 
+     * response is for */
+    num_batch = 0;
+    for (i = 0; i < num_reqs; i++){
+        req_session[i] = -1;
+        if (reqs[i].seq_len == SEQNUM_SESSION_START){
+            session_open (reqs[i].pid, 0);
+            continue;
+        }
+        s = session_slot (reqs[i].pid);
+        if (s->pid != reqs[i].pid){
+            if (reqs[i].seq_len == SEQNUM_SESSION_END)
+                continue;
+            if ((s = session_open (reqs[i].pid, 1)) == NULL)
+                continue;
+        }
+        if (reqs[i].seq_len < 0 && reqs[i].seq_len != SEQNUM_SESSION_END){
+            fprintf (stderr, "SERVER: Bad sequence length %d from client %ld; discarding \n", 
+                     reqs[i].seq_len, (long)reqs[i].pid);
+            continue;
+        }
+
+        if (s->batch != batch){
+            s->batch = batch;
+            s->batch_index = num_batch;
+            batch_sessions[num_batch++] = s;
+        }
+        if (reqs[i].seq_len == SEQNUM_SESSION_END){
+            s->closing = 1;
+            continue;
+        }
+
+        req_session[i] = s->batch_index;
+        resps[i].seq_num = next_seq_num (reqs[i].seq_len);
+        resps[i].seq_len = reqs[i].seq_len;
+    }
+
+    /* Group the responses by client, keeping their order */
+    memset (first, 0, (num_batch + 1) * sizeof (int));
+    for (i = 0; i < num_reqs; i++)
+        if (req_session[i] >= 0)
+            first[req_session[i] + 1]++;
+    for (k = 0; k < num_batch; k++)
+        first[k + 1] += first[k];
+    memcpy (next, first, num_batch * sizeof (int));
+    for (i = 0; i < num_reqs; i++)
+        if (req_session[i] >= 0)
+            grouped[next[req_session[i]]++] = resps[i];
+
+    for (k = 0; k < num_batch; k++){
+        s = batch_sessions[k];
+        n = (first[k + 1] - first[k]) * sizeof (struct response);
+        if (n > 0 && send_responses (s, &grouped[first[k]], n) == -1){
+            if (errno != EPIPE)
+                fprintf (stderr, "SERVER: Error writing to client %ld \n", (long)s->pid);
+            s->closing = 1;
+        }
+    }
+
+    /* Close the FIFOs of the one-shot clients and of the clients that ended their 
+     * session or went away. Evicting shifts entries around, so look each one up 
+     * again by pid. */
+    for (k = 0; k < num_batch; k++)
+        next[k] = batch_sessions[k]->closing ? batch_sessions[k]->pid : 0;
+    for (k = 0; k < num_batch; k++){
+        if (next[k] == 0)
+            continue;
+        s = session_slot (next[k]);
+        if (s->pid == next[k])
+            session_evict (s);
+    }
+
+    /* Keep a partial request for the next read */
+    leftover = bytes % sizeof (struct request);
+    memmove (reqs, (char *)reqs + num_reqs * sizeof (struct request), leftover);
+}
+
+/* In shared memory mode the clients use up the lease without telling us, so look 
+ * at the counter now and then */
+static void 
+lease_timer (reactor_t *reactor, void *arg)
+{
+    check_lease ();
+}
+
+static void 
+serve_sessions (int server_fd)
+{
+    reactor_t *reactor = reactor_create ();
+
+    set_session_limit ();
+    /* Level-triggered: each round reads one batch, and comes back for more */
+    if (reactor == NULL || reactor_add (reactor, server_fd, EPOLLIN, serve_batch, NULL) == -1 || \
+            (page != NULL && reactor_timer_add (reactor, LEASE_CHECK_MS, LEASE_CHECK_MS, 
+                                                lease_timer, NULL) == NULL)){
+        perror ("reactor");
+        exit (EXIT_FAILURE);
+    }
+
+    fprintf (stderr, "SERVER: Running in %s mode \n", page ? "shared memory" : "session");
+    if (reactor_run (reactor) == -1){
+        perror ("epoll_wait");
+        exit (EXIT_FAILURE);
+    }
+}
@@ -0,0 +1,193 @@
+/* The client side of the shared memory fast path described in seqnum_shm.h.
+ *
+ * Date created: October 19, 2026
+ *
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <poll.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include "seqnum_shm.h"
+
+#define REPLY_CHECK_MS 500      /* How often to check on the server while waiting */
+
+static struct seqnum_page *page;
+static long num_fallbacks;
+
+/* FIFO session used when the fast path runs past the limit; opened on first use */
+static char client_fifo[CLIENT_FIFO_NAME_LEN];
+static int server_fd = -1;
+static int client_fd = -1;
+
+int 
+seqnum_attach (void)
+{
+    int fd;
+
+    fd = shm_open (SEQNUM_SHM_NAME, O_RDWR, 0);
+    if (fd == -1)
+        return -1;
+    page = (struct seqnum_page *)mmap (NULL, sizeof (struct seqnum_page), PROT_READ | PROT_WRITE, 
+                                       MAP_SHARED, fd, 0);
+    close (fd);
+    if (page == MAP_FAILED){
+        page = NULL;
+        return -1;
+    }
+    if (page->magic != SEQNUM_MAGIC){
+        munmap (page, sizeof (struct seqnum_page));
+        page = NULL;
+        errno = EINVAL;
+        return -1;
+    }
+    return 0;
+}
+
+/* Whether the server that was sent a request is still there. With the page mapped 
+ * we know its pid, and a restarted server puts its own pid in the page. Without it 
+ * we can only tell whether some server has the server FIFO open for reading. */
+static int 
+server_alive (pid_t server_pid)
+{
+    int fd;
+
+    if (page != NULL)
+        return page->server_pid == server_pid && kill (server_pid, 0) == 0;
+    fd = open (SERVER_FIFO, O_WRONLY | O_NONBLOCK);
+    if (fd == -1)
+        return 0;
+    close (fd);
+    return 1;
+}
+
+/* Wait for the response. Since we hold our FIFO open for writing too, a server 
+ * that dies never shows up as end-of-file, so look at the server now and then. 
+ * Returns 0, or -1 with errno set to EPIPE if the server went away. */
+static int 
+read_response (struct response *resp, pid_t server_pid)
+{
+    struct pollfd pfd = { .fd = client_fd, .events = POLLIN };
+    int n;
+
+    while ((n = poll (&pfd, 1, REPLY_CHECK_MS)) <= 0){
+        if (n == -1 && errno != EINTR)
+            return -1;
+        if (n == 0 && !server_alive (server_pid)){
+            errno = EPIPE;
+            return -1;
+        }
+    }
+    if (read (client_fd, resp, sizeof (struct response)) != sizeof (struct response)){
+        errno = EPIPE;
+        return -1;
+    }
+    return 0;
+}
+
+/* Ask the server over the FIFOs, using the session protocol */
+static long 
+fifo_alloc (int seq_len)
+{
+    struct request req;
+    struct response resp;
+    pid_t server_pid;
+
+    if (client_fd == -1){
+        umask (0);
+        snprintf (client_fifo, CLIENT_FIFO_NAME_LEN, CLIENT_FIFO_TEMPLATE, (long)getpid ());
+        if (mkfifo (client_fifo, S_IRUSR | S_IWUSR | S_IWGRP) == -1 && errno != EEXIST)
+            return -1;
+        client_fd = open (client_fifo, O_RDWR);
+        if (client_fd == -1)
+            return -1;
+    }
+    req.pid = getpid ();
+    if (server_fd == -1){
+        /* Blocks until a server has the FIFO open for reading */
+        server_fd = open (SERVER_FIFO, O_WRONLY);
+        if (server_fd == -1)
+            return -1;
+        req.seq_len = SEQNUM_SESSION_START;
+        if (write (server_fd, &req, sizeof (struct request)) != sizeof (struct request)){
+            close (server_fd);
+            server_fd = -1;
+            return -1;
+        }
+    }
+
+    server_pid = (page != NULL) ? page->server_pid : 0;
+    req.seq_len = seq_len;
+    if (write (server_fd, &req, sizeof (struct request)) != sizeof (struct request))
+        goto server_gone;
+
+    /* A request sent to a server that died before reading it stays in the server 
+     * FIFO, and the next server answers it as well as the one sent again. The 
+     * extra sequence is still ours to use if it has the length asked for this 
+     * time; otherwise it is skipped. */
+    do {
+        if (read_response (&resp, server_pid) == -1)
+            goto server_gone;
+    } while (resp.seq_len != seq_len);
+    num_fallbacks++;
+    return resp.seq_num;
+
+server_gone:
+    /* Start over, and send the request again, with the next server */
+    close (server_fd);
+    server_fd = -1;
+    return -1;
+}
+
+long 
+seqnum_alloc (int seq_len)
+{
+    long first, seq;
+
+    if (seq_len < 0){
+        errno = EINVAL;
+        return -1;
+    }
+    if (page != NULL){
+        first = atomic_fetch_add (&page->next, seq_len);
+        if (first + seq_len <= atomic_load (&page->limit))
+            return first;
+        /* Past the checkpointed mark; these numbers are simply skipped */
+    }
+
+    while ((seq = fifo_alloc (seq_len)) == -1){
+        if (errno != EPIPE && errno != EINTR)
+            return -1;
+    }
+    return seq;
+}
+
+long 
+seqnum_fallbacks (void)
+{
+    return num_fallbacks;
+}
+
+void 
+seqnum_detach (void)
+{
+    struct request req;
+
+    if (server_fd != -1){
+        req.pid = getpid ();
+        req.seq_len = SEQNUM_SESSION_END;
+        write (server_fd, &req, sizeof (struct request));
+        close (server_fd);
+        server_fd = -1;
+    }
+    if (client_fd != -1){
+        close (client_fd);
+        unlink (client_fifo);
+        client_fd = -1;
+    }
+    if (page != NULL){
+        munmap (page, sizeof (struct seqnum_page));
+        page = NULL;
+    }
+}
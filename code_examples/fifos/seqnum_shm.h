@@ -0,0 +1,63 @@
+/* Header file for the shared memory fast path of the sequence number server 
+ * (fifo_seqnum_server -m) and its client side in seqnum_shm.c
+ *
+ * All the server does is seq_num += seq_len, and going through two FIFOs for that 
+ * costs far more than the addition. In shared memory mode the server publishes its 
+ * counter in a page of shared memory and the clients reserve their sequences with 
+ * a single atomic fetch-and-add on it, without involving the server at all.
+ *
+ * The server stays in charge of persistence. It writes a high-water mark to a 
+ * checkpoint file and lets the clients hand out numbers only up to that mark (the 
+ * limit in the page). When the counter gets close to the limit the server moves 
+ * the limit ahead, after checkpointing the new one. If the server dies, no number 
+ * beyond the last checkpoint can have been handed out, so a restarted server that 
+ * starts counting from the checkpoint never repeats a number. Some numbers below 
+ * the mark may be skipped, which is the price for not checkpointing every one.
+ *
+ * A client whose fetch-and-add runs past the limit (the server has not kept up, 
+ * or is down) falls back to the FIFO protocol of fifo_seqnum.h. The server moves 
+ * the limit before answering. A client that finds the server gone, whether before 
+ * sending the request or while waiting for the answer, waits for it to be 
+ * restarted and sends the request again.
+ *
+ * Date created: October 19, 2026
+ *
+ */
+#ifndef _SEQNUM_SHM_H_
+#define _SEQNUM_SHM_H_
+
+#include <stdatomic.h>
+#include "fifo_seqnum.h"
+
+#define SEQNUM_SHM_NAME "/seqnum_shm"
+#define SEQNUM_CHECKPOINT_FILE "/tmp/seqnum_checkpoint"
+
+/* Numbers that may be handed out beyond the current counter before the server 
+ * has to checkpoint again. The server moves the limit once half of it is used. */
+#define SEQNUM_LEASE 1000000L
+
+#define SEQNUM_MAGIC 0x53514e4dU        /* "SQNM" */
+
+/* Layout of the shared page */
+struct seqnum_page {
+    unsigned int magic;
+    pid_t server_pid;
+    _Alignas (64) atomic_long next;     /* Next number to hand out */
+    _Alignas (64) atomic_long limit;    /* Numbers below this are covered by the checkpoint */
+};
+
+/* Map the page published by the server. Returns 0 on success, -1 on error. */
+int seqnum_attach (void);
+
+/* Reserve a sequence of seq_len numbers and return the first one, which is never 
+ * negative, or -1 on error. A client that wants to ride out a restart of the server 
+ * should ignore SIGPIPE. */
+long seqnum_alloc (int seq_len);
+
+/* Number of allocations that had to go through the FIFOs. */
+long seqnum_fallbacks (void);
+
+/* End the FIFO session, if one was started, and unmap the page. */
+void seqnum_detach (void);
+
+#endif  /* _SEQNUM_SHM_H_ */
@@ -0,0 +1,214 @@
+/* Benchmark for the copy engine in copy_engine.c. For each file size it writes a
+ * source file of random data, then copies it with each method and thread count
+ * and prints the rate in MB/s, the best of a few runs.
+ *
+ * Before every run the destination is removed and the source is dropped from the
+ * page cache with posix_fadvise (POSIX_FADV_DONTNEED), so the copy has to read it
+ * from the device; use -S to include writing the copy back with fdatasync (),
+ * otherwise the written data may still be in the cache when the clock stops.
+ * Without -S and with a source that fits in memory the numbers say more about
+ * the page cache than about the device.
+ *
+ * The files go in the directory given with -d (the current one by default), so
+ * that the test runs on the filesystem of interest; on one that shares extents,
+ * copy_file_range () finishes at once whatever the size.
+ *
+ * With -q N each size also gets a row for the I/O engine (io_engine.c) at queue
+ * depth N. The engine runs on one thread, so that row has a single figure,
+ * followed by the backend the engine chose.
+ *
+ * A rate marked with * comes from runs that fell back to another method, such as
+ * sendfile () with more than one thread (see copy_engine.h).
+ *
+ * Usage: ./copy_bench [-d directory] [-s sizes in MB, e.g. 16,256,1024]
+ *                     [-j thread counts, e.g. 1,2,4,8] [-q depth] [-r runs] [-S]
+ *
+ * Date created: October 19, 2026
+ *
+ * Compile as follows: 
+ * gcc -o copy_bench copy_bench.c copy_engine.c io_engine.c -std=c99 -Wall -O2 -pthread
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "copy_engine.h"
+
+#define MAX_LIST 16
+
+/* Parse a comma-separated list of positive numbers; returns how many */
+static int
+parse_list (const char *arg, long *values)
+{
+    char *copy = strdup (arg), *token, *save;
+    int n = 0;
+
+    for (token = strtok_r (copy, ",", &save); token != NULL && n < MAX_LIST;
+            token = strtok_r (NULL, ",", &save))
+        if ((values[n] = atol (token)) > 0)
+            n++;
+    free (copy);
+    return n;
+}
+
+static void
+make_source (const char *path, long megabytes)
+{
+    char *buf = malloc (1 << 20);
+    long i;
+    size_t j;
+    int fd;
+
+    fd = open (path, O_CREAT | O_WRONLY | O_TRUNC, S_IRUSR | S_IWUSR);
+    if (fd == -1 || buf == NULL){
+        perror ("open");
+        exit (EXIT_FAILURE);
+    }
+    for (i = 0; i < megabytes; i++){
+        for (j = 0; j < (1 << 20); j++)
+            buf[j] = random ();
+        if (write (fd, buf, 1 << 20) != 1 << 20){
+            perror ("write");
+            exit (EXIT_FAILURE);
+        }
+    }
+
+    /* Only clean pages can be dropped from the cache before each run */
+    if (fdatasync (fd) == -1){
+        perror ("fdatasync");
+        exit (EXIT_FAILURE);
+    }
+    close (fd);
+    free (buf);
+}
+
+/* Copy src to dst once; returns MB/s */
+static double
+run_copy (const char *src, const char *dst, const struct copy_options *opts,
+          enum copy_method *used, const char **engine)
+{
+    struct copy_stats stats;
+    int in_fd, out_fd;
+
+    unlink (dst);
+    in_fd = open (src, O_RDONLY);
+    out_fd = open (dst, O_CREAT | O_WRONLY | O_TRUNC, S_IRUSR | S_IWUSR);
+    if (in_fd == -1 || out_fd == -1){
+        perror ("open");
+        exit (EXIT_FAILURE);
+    }
+    posix_fadvise (in_fd, 0, 0, POSIX_FADV_DONTNEED);
+
+    if (copy_fd_with (in_fd, out_fd, opts, &stats) == -1){
+        perror ("copy");
+        exit (EXIT_FAILURE);
+    }
+    close (in_fd);
+    close (out_fd);
+
+    *used = stats.method;
+    *engine = stats.engine;
+    return stats.seconds > 0 ? stats.bytes / stats.seconds / 1e6 : 0.0;
+}
+
+int
+main (int argc, char **argv)
+{
+    static const enum copy_method methods[] = { COPY_FILE_RANGE, COPY_SENDFILE, COPY_MMAP,
+                                                COPY_READ_WRITE };
+    const char *dir = ".";
+    long sizes[MAX_LIST] = { 16, 256 }, threads[MAX_LIST] = { 1, 2, 4, 8 };
+    int nsizes = 2, nthreads = 4, runs = 3, sync = 0, depth = 0;
+    char src[4096], dst[4096];
+    struct copy_options opts;
+    enum copy_method used;
+    const char *engine;
+    double rate, best;
+    int opt, i, m, t, r;
+
+    while ((opt = getopt (argc, argv, "d:s:j:q:r:S")) != -1){
+        switch (opt){
+            case 'd':
+                dir = optarg;
+                break;
+
+            case 's':
+                nsizes = parse_list (optarg, sizes);
+                break;
+
+            case 'j':
+                nthreads = parse_list (optarg, threads);
+                break;
+
+            case 'q':
+                depth = atoi (optarg);
+                break;
+
+            case 'r':
+                runs = atoi (optarg);
+                break;
+
+            case 'S':
+                sync = 1;
+                break;
+
+            default:
+                fprintf (stderr, "Usage: %s [-d directory] [-s sizes in MB] [-j thread counts] "
+                         "[-q depth] [-r runs] [-S] \n", argv[0]);
+                exit (EXIT_FAILURE);
+        }
+    }
+    if (nsizes == 0 || nthreads == 0 || runs < 1 || depth < 0){
+        fprintf (stderr, "Bad arguments \n");
+        exit (EXIT_FAILURE);
+    }
+
+    snprintf (src, sizeof (src), "%s/copy_bench.%ld.src", dir, (long) getpid ());
+    snprintf (dst, sizeof (dst), "%s/copy_bench.%ld.dst", dir, (long) getpid ());
+
+    printf ("%10s  %-16s", "size (MB)", "method");
+    for (t = 0; t < nthreads; t++)
+        printf ("  %6ld thr", threads[t]);
+    printf ("   (MB/s, best of %d%s) \n", runs, sync ? ", with fdatasync" : "");
+
+    for (i = 0; i < nsizes; i++){
+        make_source (src, sizes[i]);
+        for (m = 0; m < (int)(sizeof (methods) / sizeof (methods[0])); m++){
+            printf ("%10ld  %-16s", sizes[i], copy_method_name (methods[m]));
+            for (t = 0; t < nthreads; t++){
+                memset (&opts, 0, sizeof (opts));
+                opts.method = methods[m];
+                opts.threads = threads[t];
+                opts.sync = sync;
+                for (best = 0, r = 0; r < runs; r++)
+                    if ((rate = run_copy (src, dst, &opts, &used, &engine)) > best)
+                        best = rate;
+                /* A star marks a run that had to fall back to another method */
+                printf ("  %9.0f%c", best, used != methods[m] ? '*' : ' ');
+            }
+            printf ("\n");
+            fflush (stdout);
+        }
+
+        if (depth > 0){
+            memset (&opts, 0, sizeof (opts));
+            opts.threads = 1;
+            opts.queue_depth = depth;
+            opts.sync = sync;
+            for (best = 0, r = 0; r < runs; r++)
+                if ((rate = run_copy (src, dst, &opts, &used, &engine)) > best)
+                    best = rate;
+            printf ("%10ld  engine, depth %-3d  %9.0f   (%s) \n", sizes[i], depth, best, engine);
+            fflush (stdout);
+        }
+    }
+
+    unlink (src);
+    unlink (dst);
+    exit (EXIT_SUCCESS);
+}
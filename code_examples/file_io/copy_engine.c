@@ -0,0 +1,626 @@
+/* Implementation of the copy engine described in copy_engine.h.
+ *
+ * Each method copies as much as it can and returns; if it stopped because the
+ * files do not support it (rather than because of a real error), copy_range ()
+ * moves on to the next method for whatever is left.
+ *
+ * Date created: October 19, 2026
+ *
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include "copy_engine.h"
+#include "io_engine.h"
+
+#define SENDFILE_MAX 0x7ffff000         /* Most sendfile () moves in one call */
+
+#define DONE 0
+#define FALLBACK 1
+#define FAILED -1
+
+static double
+now_seconds (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Errors that say "not with these files" rather than "something went wrong" */
+static int
+unsupported (int err)
+{
+    return err == EXDEV || err == EINVAL || err == ENOSYS || err == EOPNOTSUPP || \
+           err == ENODEV || err == EACCES;
+}
+
+/* Each copy_* function copies up to length bytes from offset and returns the bytes
+ * copied. A short count comes with *status set to FALLBACK if the method cannot be
+ * used on these files, to FAILED (and errno) on an error, and otherwise means end
+ * of file. */
+
+static long long
+copy_with_file_range (int in_fd, int out_fd, off_t offset, off_t length, int *status)
+{
+    loff_t off_in = offset, off_out = offset;
+    long long done = 0;
+    ssize_t n;
+
+    while (done < length){
+        n = copy_file_range (in_fd, &off_in, out_fd, &off_out, length - done, 0);
+        if (n == 0)
+            break;
+        if (n == -1){
+            if (errno == EINTR)
+                continue;
+            *status = unsupported (errno) ? FALLBACK : FAILED;
+            break;
+        }
+        done += n;
+    }
+    return done;
+}
+
+static long long
+copy_with_sendfile (int in_fd, int out_fd, off_t offset, off_t length, int *status)
+{
+    off_t off_in = offset;
+    long long done = 0;
+    ssize_t n;
+
+    if (lseek (out_fd, offset, SEEK_SET) == -1){
+        *status = FALLBACK;
+        return 0;
+    }
+    while (done < length){
+        n = sendfile (out_fd, in_fd, &off_in,
+                      (length - done > SENDFILE_MAX) ? SENDFILE_MAX : length - done);
+        if (n == 0)
+            break;
+        if (n == -1){
+            if (errno == EINTR)
+                continue;
+            *status = unsupported (errno) ? FALLBACK : FAILED;
+            break;
+        }
+        done += n;
+    }
+    return done;
+}
+
+/* Write all of buf at offset, however many pwrite () calls it takes; an offset of 
+ * -1 writes at the file offset instead */
+static int
+write_all (int fd, const char *buf, size_t length, off_t offset)
+{
+    ssize_t n;
+
+    while (length > 0){
+        n = (offset == -1) ? write (fd, buf, length) : pwrite (fd, buf, length, offset);
+        if (n == -1){
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        buf += n;
+        length -= n;
+        if (offset != -1)
+            offset += n;
+    }
+    return 0;
+}
+
+static long long
+copy_with_mmap (int in_fd, int out_fd, off_t offset, off_t length, int *status)
+{
+    long page = sysconf (_SC_PAGESIZE);
+    struct stat sb;
+    long long done = 0;
+    off_t start, skip;
+    size_t window;
+    char *map;
+
+    /* Never map beyond the end of the file: touching that would raise SIGBUS */
+    if (fstat (in_fd, &sb) == -1){
+        *status = FAILED;
+        return 0;
+    }
+    if (offset + length > sb.st_size)
+        length = (sb.st_size > offset) ? sb.st_size - offset : 0;
+
+    while (done < length){
+        /* The mapping must start on a page boundary */
+        start = (offset + done) & ~(off_t)(page - 1);
+        skip = offset + done - start;
+        window = (length - done + skip > COPY_MMAP_WINDOW) ? COPY_MMAP_WINDOW : length - done + skip;
+
+        map = mmap (NULL, window, PROT_READ, MAP_PRIVATE, in_fd, start);
+        if (map == MAP_FAILED){
+            *status = unsupported (errno) ? FALLBACK : FAILED;
+            break;
+        }
+        madvise (map, window, MADV_SEQUENTIAL);
+        if (write_all (out_fd, map + skip, window - skip, offset + done) == -1){
+            *status = FAILED;
+            munmap (map, window);
+            break;
+        }
+        munmap (map, window);
+        done += window - skip;
+    }
+    return done;
+}
+
+/* The buffer starts at the larger st_blksize of the two files and doubles after
+ * each read that fills it, so small files need little memory and large ones soon
+ * move a megabyte per call. A streaming copy reads and writes at the file offsets
+ * until end of file, for sources that have no offsets to speak of. */
+static long long
+copy_with_read_write (int in_fd, int out_fd, off_t offset, off_t length, int streaming,
+                      int *status)
+{
+    struct stat in_sb, out_sb;
+    size_t size = 4096, want;
+    long long done = 0;
+    char *buf, *bigger;
+    ssize_t n;
+
+    if (fstat (in_fd, &in_sb) == 0 && in_sb.st_blksize > (blksize_t)size)
+        size = in_sb.st_blksize;
+    if (fstat (out_fd, &out_sb) == 0 && out_sb.st_blksize > (blksize_t)size)
+        size = out_sb.st_blksize;
+    if (size > COPY_MAX_BUF)
+        size = COPY_MAX_BUF;
+    if ((buf = malloc (size)) == NULL){
+        *status = FAILED;
+        return 0;
+    }
+
+    while (streaming || done < length){
+        want = (streaming || length - done > (off_t)size) ? size : (size_t)(length - done);
+        n = streaming ? read (in_fd, buf, want) : pread (in_fd, buf, want, offset + done);
+        if (n == -1 && errno == EINTR)
+            continue;
+        if (n <= 0){
+            if (n == -1)
+                *status = FAILED;
+            break;
+        }
+
+        if (write_all (out_fd, buf, n, streaming ? -1 : offset + done) == -1){
+            *status = FAILED;
+            break;
+        }
+        done += n;
+
+        if ((size_t)n == size && size < COPY_MAX_BUF && (bigger = realloc (buf, size * 2)) != NULL){
+            buf = bigger;
+            size *= 2;
+        }
+    }
+
+    free (buf);
+    return done;
+}
+
+long long
+copy_range (int in_fd, int out_fd, off_t offset, off_t length, enum copy_method *method,
+            int flags)
+{
+    long long done = 0, n;
+    int status;
+
+    while (done < length){
+        status = DONE;
+        if (*method == COPY_SENDFILE && (flags & COPY_POSITIONAL))
+            *method = COPY_MMAP;
+        switch (*method){
+            case COPY_FILE_RANGE:
+                n = copy_with_file_range (in_fd, out_fd, offset + done, length - done, &status);
+                break;
+
+            case COPY_SENDFILE:
+                n = copy_with_sendfile (in_fd, out_fd, offset + done, length - done, &status);
+                break;
+
+            case COPY_MMAP:
+                n = copy_with_mmap (in_fd, out_fd, offset + done, length - done, &status);
+                break;
+
+            default:
+                n = copy_with_read_write (in_fd, out_fd, offset + done, length - done, 0, &status);
+                break;
+        }
+        done += n;
+
+        if (status == FALLBACK && *method != COPY_READ_WRITE){
+            (*method)++;
+            continue;
+        }
+        if (status != DONE)
+            return -1;
+        break;                          /* End of file */
+    }
+    return done;
+}
+
+const char *
+copy_method_name (enum copy_method method)
+{
+    switch (method){
+        case COPY_FILE_RANGE:
+            return "copy_file_range";
+        case COPY_SENDFILE:
+            return "sendfile";
+        case COPY_MMAP:
+            return "mmap";
+        default:
+            return "read/write";
+    }
+}
+
+/* Copy the data regions between start and end, skipping the holes. Returns the 
+ * number of data bytes copied, or -1 with errno set. */
+static long long
+copy_regions (int in_fd, int out_fd, off_t start, off_t end, enum copy_method *method,
+              int flags)
+{
+    off_t data, hole;
+    long long n, done = 0;
+
+    /* lseek () fails with ENXIO when no data is left. It moves the shared file 
+     * offset, which none of the methods used here depends on. */
+    for (hole = start; hole < end; ){
+        data = lseek (in_fd, hole, SEEK_DATA);
+        if (data == -1 && errno == ENXIO)
+            break;
+        if (data == -1){
+            data = hole;                /* No hole support: all of it is data */
+            hole = end;
+        }
+        else if ((hole = lseek (in_fd, data, SEEK_HOLE)) == -1 || hole > end)
+            hole = end;
+        if (data >= end)
+            break;
+
+        n = copy_range (in_fd, out_fd, data, hole - data, method, flags);
+        if (n == -1)
+            return -1;
+        done += n;
+        if (n < hole - data)
+            break;                      /* The file shrank under us */
+    }
+    return done;
+}
+
+struct parallel_copy {
+    int in_fd, out_fd;
+    off_t size, chunk;
+    enum copy_method first;
+    long next_chunk;                    /* Handed out with an atomic add */
+    pthread_mutex_t lock;               /* Protects the fields below */
+    long long bytes;
+    enum copy_method method;            /* The furthest any thread fell back */
+    int error;                          /* errno of the first failure */
+};
+
+static void *
+copy_chunks (void *arg)
+{
+    struct parallel_copy *pc = arg;
+    enum copy_method method = pc->first;
+    long long bytes = 0, n = 0;
+    off_t start, end;
+    long chunk;
+
+    while (!__atomic_load_n (&pc->error, __ATOMIC_RELAXED)){
+        chunk = __atomic_fetch_add (&pc->next_chunk, 1, __ATOMIC_RELAXED);
+        start = chunk * pc->chunk;
+        if (start >= pc->size)
+            break;
+        end = (pc->size - start > pc->chunk) ? start + pc->chunk : pc->size;
+
+        /* Start reading the chunk now; the copy below then rarely waits */
+        posix_fadvise (pc->in_fd, start, end - start, POSIX_FADV_WILLNEED);
+        n = copy_regions (pc->in_fd, pc->out_fd, start, end, &method, COPY_POSITIONAL);
+        if (n == -1){
+            __atomic_store_n (&pc->error, errno, __ATOMIC_RELAXED);
+            break;
+        }
+        bytes += n;
+    }
+
+    pthread_mutex_lock (&pc->lock);
+    pc->bytes += bytes;
+    if (method > pc->method)
+        pc->method = method;
+    pthread_mutex_unlock (&pc->lock);
+    return NULL;
+}
+
+/* Split [0, size) into chunks that threads take in turn. The output already has 
+ * its final length, so the chunks can be written in any order. */
+static int
+copy_parallel (int in_fd, int out_fd, off_t size, const struct copy_options *opts,
+               struct copy_stats *s)
+{
+    struct parallel_copy pc;
+    pthread_t *threads;
+    int i, started;
+
+    memset (&pc, 0, sizeof (pc));
+    pc.in_fd = in_fd;
+    pc.out_fd = out_fd;
+    pc.size = size;
+    pc.first = pc.method = opts->method;
+    pthread_mutex_init (&pc.lock, NULL);
+
+    /* Enough chunks per thread to even out the load, none smaller than 1 MB */
+    pc.chunk = opts->chunk;
+    if (pc.chunk <= 0){
+        pc.chunk = size / ((off_t)opts->threads * 4);
+        if (pc.chunk > COPY_CHUNK)
+            pc.chunk = COPY_CHUNK;
+    }
+    pc.chunk = (pc.chunk + (1 << 20) - 1) & ~(off_t)((1 << 20) - 1);
+    if (pc.chunk == 0)
+        pc.chunk = 1 << 20;
+
+    if ((threads = calloc (opts->threads, sizeof (pthread_t))) == NULL)
+        return -1;
+    for (started = 0; started < opts->threads; started++)
+        if (pthread_create (&threads[started], NULL, copy_chunks, &pc) != 0)
+            break;
+    if (started == 0)
+        copy_chunks (&pc);              /* No threads to be had; do it here */
+    for (i = 0; i < started; i++)
+        pthread_join (threads[i], NULL);
+    free (threads);
+    pthread_mutex_destroy (&pc.lock);
+
+    s->bytes = pc.bytes;
+    s->method = pc.method;
+    if (pc.error != 0){
+        errno = pc.error;
+        return -1;
+    }
+    return 0;
+}
+
+/* One block of the file on its way through the I/O engine: a read of the block 
+ * linked to the write of the same buffer */
+struct async_block {
+    off_t offset;
+    size_t length;
+    char *buf;
+    int pending;                        /* Requests not yet completed; 0 when free */
+    ssize_t read_result, write_result;
+};
+
+/* Walks the data regions of the source one block at a time */
+struct block_source {
+    int fd;
+    off_t next, region_end, size;
+};
+
+static int
+next_block (struct block_source *bs, off_t *offset, size_t *length)
+{
+    off_t data, hole;
+
+    if (bs->next >= bs->region_end){
+        if (bs->next >= bs->size)
+            return 0;
+        data = lseek (bs->fd, bs->next, SEEK_DATA);
+        if (data == -1 && errno == ENXIO)
+            return 0;
+        if (data == -1){
+            data = bs->next;            /* No hole support: all of it is data */
+            hole = bs->size;
+        }
+        else if ((hole = lseek (bs->fd, data, SEEK_HOLE)) == -1 || hole > bs->size)
+            hole = bs->size;
+        if (data >= bs->size)
+            return 0;
+        bs->next = data;
+        bs->region_end = hole;
+    }
+    *offset = bs->next;
+    *length = (bs->region_end - bs->next > COPY_ASYNC_BLOCK) ? COPY_ASYNC_BLOCK : \
+              (size_t)(bs->region_end - bs->next);
+    bs->next += *length;
+    return 1;
+}
+
+/* Finish a block whose read and write have both completed. A block the engine 
+ * could not copy in full (a short read, say) is copied again with pread () and 
+ * pwrite (). Returns the bytes copied, or -1 with errno set. */
+static long long
+finish_block (int in_fd, int out_fd, struct async_block *b)
+{
+    enum copy_method method = COPY_READ_WRITE;
+
+    if (b->read_result == (ssize_t)b->length && b->write_result == (ssize_t)b->length)
+        return b->length;
+    return copy_range (in_fd, out_fd, b->offset, b->length, &method, COPY_POSITIONAL);
+}
+
+/* Keep up to queue_depth requests in the I/O engine: each free buffer takes the 
+ * next block of the file as a read linked to a write. User data numbers each 
+ * request: twice the block index, plus one for the write. */
+static int
+copy_async (int in_fd, int out_fd, off_t size, const struct copy_options *opts,
+            struct copy_stats *s)
+{
+    struct block_source bs = { in_fd, 0, 0, size };
+    struct async_block *blocks = NULL, *b;
+    struct ioe_completion *done = NULL;
+    struct iovec iov;
+    io_engine_t *e;
+    char *bufs = NULL;
+    int fds[2] = { in_fd, out_fd };
+    int nblocks, busy = 0, more = 1, status = 0, i, n;
+    long long copied;
+    unsigned long tag;
+
+    nblocks = (opts->queue_depth > 1) ? opts->queue_depth / 2 : 1;
+    if ((e = ioe_create (2 * nblocks, opts->engine_flags)) == NULL)
+        return -1;
+    s->engine = ioe_backend (e);
+    s->method = COPY_READ_WRITE;
+
+    blocks = calloc (nblocks, sizeof (struct async_block));
+    done = calloc (2 * nblocks, sizeof (struct ioe_completion));
+    if (blocks == NULL || done == NULL || \
+            posix_memalign ((void **)&bufs, 4096, (size_t)nblocks * COPY_ASYNC_BLOCK) != 0){
+        bufs = NULL;
+        status = -1;
+        goto out;
+    }
+
+    /* One registered buffer covers all the blocks; failing to register is no error */
+    iov.iov_base = bufs;
+    iov.iov_len = (size_t)nblocks * COPY_ASYNC_BLOCK;
+    ioe_register_files (e, fds, 2);
+    ioe_register_buffers (e, &iov, 1);
+
+    while (more || busy > 0){
+        for (i = 0; more && i < nblocks; i++){
+            b = &blocks[i];
+            if (b->pending > 0)
+                continue;
+            if (!(more = next_block (&bs, &b->offset, &b->length)))
+                break;
+            b->buf = bufs + (size_t)i * COPY_ASYNC_BLOCK;
+            b->pending = 2;
+            busy++;
+            ioe_prep (e, IOE_READ, in_fd, b->buf, b->length, b->offset, IOE_LINK, (void *)(2UL * i));
+            ioe_prep (e, IOE_WRITE, out_fd, b->buf, b->length, b->offset, 0, (void *)(2UL * i + 1));
+        }
+        if (busy == 0)
+            break;
+        if (ioe_submit (e) == -1 || (n = ioe_complete (e, done, 2 * nblocks, 1)) == -1){
+            status = -1;
+            break;
+        }
+
+        for (i = 0; i < n; i++){
+            tag = (unsigned long)done[i].user;
+            b = &blocks[tag / 2];
+            if (tag % 2)
+                b->write_result = done[i].result;
+            else
+                b->read_result = done[i].result;
+            if (--b->pending > 0)
+                continue;
+
+            busy--;
+            if ((copied = finish_block (in_fd, out_fd, b)) == -1){
+                status = -1;
+                more = 0;               /* Let the requests in flight drain */
+            }
+            else
+                s->bytes += copied;
+        }
+    }
+
+out:
+    ioe_destroy (e);
+    free (bufs);
+    free (done);
+    free (blocks);
+    return status;
+}
+
+int
+copy_fd_with (int in_fd, int out_fd, const struct copy_options *opts, struct copy_stats *stats)
+{
+    struct copy_stats s;
+    struct stat sb, out_sb;
+    long long n;
+    int status = 0, rw_status = DONE;
+
+    memset (&s, 0, sizeof (s));
+    s.method = opts->method;
+    s.seconds = now_seconds ();
+
+    if (fstat (in_fd, &sb) == -1 || fstat (out_fd, &out_sb) == -1){
+        status = -1;
+        goto out;
+    }
+
+    /* Anything but a regular file (on either side) is simply read to the end */
+    if (!S_ISREG (sb.st_mode) || !S_ISREG (out_sb.st_mode)){
+        s.method = COPY_READ_WRITE;
+        s.bytes = copy_with_read_write (in_fd, out_fd, 0, 0, 1, &rw_status);
+        status = (rw_status == DONE) ? 0 : -1;
+        goto out;
+    }
+
+    posix_fadvise (in_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    if (opts->queue_depth > 0){
+        /* Give the output its final length first; the blocks land in any order */
+        if (ftruncate (out_fd, sb.st_size) == -1 || \
+                copy_async (in_fd, out_fd, sb.st_size, opts, &s) == -1){
+            status = -1;
+            goto out;
+        }
+    }
+    else if (opts->threads > 1){
+        /* Give the output its final length first; the holes stay holes */
+        if (ftruncate (out_fd, sb.st_size) == -1 || \
+                copy_parallel (in_fd, out_fd, sb.st_size, opts, &s) == -1){
+            status = -1;
+            goto out;
+        }
+    }
+    else {
+        n = copy_regions (in_fd, out_fd, 0, sb.st_size, &s.method, 0);
+        if (n == -1){
+            status = -1;
+            goto out;
+        }
+        s.bytes = n;
+
+        /* Extend the output over any hole at the end of the source */
+        if (ftruncate (out_fd, sb.st_size) == -1){
+            status = -1;
+            goto out;
+        }
+    }
+    s.holes = sb.st_size - s.bytes;
+
+    /* The data is only on the device once fdatasync () returns */
+    if (opts->sync && fdatasync (out_fd) == -1)
+        status = -1;
+
+out:
+    s.seconds = now_seconds () - s.seconds;
+    if (stats != NULL)
+        *stats = s;
+    return status;
+}
+
+int
+copy_fd (int in_fd, int out_fd, enum copy_method first, struct copy_stats *stats)
+{
+    struct copy_options opts;
+
+    memset (&opts, 0, sizeof (opts));
+    opts.method = first;
+    opts.threads = 1;
+    return copy_fd_with (in_fd, out_fd, &opts, stats);
+}
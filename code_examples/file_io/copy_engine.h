@@ -0,0 +1,99 @@
+/* Header file for the copy engine in copy_engine.c, used by copy.c
+ *
+ * copy.c used to move data through a 1 KB buffer with read () and write (), two
+ * system calls per kilobyte. The engine tries the cheaper ways first and falls
+ * back one step at a time when the files do not support a way:
+ *
+ *   - copy_file_range () copies inside the kernel. On a filesystem that can share
+ *     extents (btrfs, XFS) or copy on the server (NFS 4.2, SMB) it is nearly free.
+ *
+ *   - sendfile () also stays in the kernel, but always copies page by page.
+ *
+ *   - mmap () maps the source and writes straight from the mapping, after telling
+ *     the kernel with madvise (MADV_SEQUENTIAL) to read ahead aggressively.
+ *
+ *   - read () and write () with a buffer of st_blksize bytes, doubled after every
+ *     full read up to COPY_MAX_BUF.
+ *
+ * Only the data regions of a regular source file are copied, as found with
+ * lseek (SEEK_DATA) and lseek (SEEK_HOLE); the holes are skipped in the output as
+ * well, and the output is finally truncated to the length of the source, so a
+ * sparse file stays sparse. A source that is not a regular file (a pipe, say) is
+ * read until end of file with read () and write ().
+ *
+ * copy_fd_with () can also split a regular file into chunks and have several 
+ * threads copy them at once with pread ()/pwrite (), mmap () or copy_file_range () 
+ * at explicit offsets (sendfile () writes at the shared file offset, so it is 
+ * skipped), which keeps more requests in flight than a single stream does. Each 
+ * thread asks for its next chunk to be read ahead with posix_fadvise ().
+ *
+ * With a queue depth, copy_fd_with () hands the copy to the I/O engine in 
+ * io_engine.c instead: one thread keeps that many reads and writes of 
+ * COPY_ASYNC_BLOCK bytes in flight, each read linked to the write of its buffer, 
+ * through io_uring if the kernel has it.
+ *
+ * Date created: October 19, 2026
+ *
+ */
+#ifndef _COPY_ENGINE_H_
+#define _COPY_ENGINE_H_
+
+#include <sys/types.h>
+
+#define COPY_MAX_BUF (1 << 20)          /* Largest read () and write () buffer */
+#define COPY_MMAP_WINDOW (64 << 20)     /* Bytes of the source mapped at a time */
+#define COPY_CHUNK (64 << 20)           /* Largest default chunk for parallel copies */
+#define COPY_ASYNC_BLOCK (256 << 10)    /* Bytes per read and write with a queue depth */
+
+/* Flags for copy_range () */
+#define COPY_POSITIONAL 1               /* Use only methods with explicit offsets */
+
+/* In order of preference; each falls back to the next one */
+enum copy_method {
+    COPY_FILE_RANGE,
+    COPY_SENDFILE,
+    COPY_MMAP,
+    COPY_READ_WRITE
+};
+
+struct copy_stats {
+    long long bytes;                    /* Data bytes copied (holes not included) */
+    long long holes;                    /* Bytes of holes skipped */
+    double seconds;
+    enum copy_method method;            /* The method that finished the copy (the
+                                           slowest one, if threads differed) */
+    const char *engine;                 /* Backend of the I/O engine, if one was used */
+};
+
+struct copy_options {
+    enum copy_method method;            /* The method to start with */
+    int threads;                        /* More than 1 for a parallel copy */
+    off_t chunk;                        /* Bytes per chunk, or 0 to pick one */
+    int sync;                           /* fdatasync () the output at the end */
+    int queue_depth;                    /* Requests in flight with the I/O engine,
+                                           or 0 not to use it */
+    int engine_flags;                   /* Flags for ioe_create (), such as IOE_THREADS */
+};
+
+/* Copy the whole of in_fd to out_fd, which should be empty and not opened with
+ * O_APPEND, starting with method first. Returns 0, or -1 with errno set; stats,
+ * if not NULL, is filled in either way. */
+int copy_fd (int in_fd, int out_fd, enum copy_method first, struct copy_stats *stats);
+
+/* The same, with the choices in opts. */
+int copy_fd_with (int in_fd, int out_fd, const struct copy_options *opts,
+                  struct copy_stats *stats);
+
+/* Copy length bytes at offset of in_fd to the same offset of out_fd, starting with
+ * *method and leaving in it the method that worked. Does not use or move the file
+ * offsets of either descriptor except with COPY_SENDFILE, which writes at the
+ * offset of out_fd and is passed over if flags has COPY_POSITIONAL. Returns the
+ * number of bytes copied, which is less than length only at end of file, or -1
+ * with errno set. */
+long long copy_range (int in_fd, int out_fd, off_t offset, off_t length,
+                      enum copy_method *method, int flags);
+
+/* "copy_file_range", "sendfile", "mmap" or "read/write" */
+const char *copy_method_name (enum copy_method method);
+
+#endif /* _COPY_ENGINE_H_ */
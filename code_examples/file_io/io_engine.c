@@ -0,0 +1,593 @@
+/* Implementation of the asynchronous I/O engine described in io_engine.h.
+ *
+ * The io_uring backend shares two rings with the kernel: the application fills
+ * in submission queue entries (SQEs) and moves the tail of the submission ring,
+ * and the kernel posts completion queue entries (CQEs) and moves the tail of the
+ * completion ring. io_uring_enter () starts the new SQEs and, if asked, waits for
+ * CQEs. Each side reads the other's index with acquire and publishes its own with
+ * release ordering, which is all the synchronization the rings need.
+ *
+ * The thread backend keeps the prepared requests in chains (requests joined by
+ * IOE_LINK), hands whole chains to the workers, so that the requests of a chain
+ * run in order, and puts finished requests on a list for ioe_complete ().
+ *
+ * Date created: October 19, 2026
+ *
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include "io_engine.h"
+
+#define BACKEND_URING 0
+#define BACKEND_THREADS 1
+
+struct ioe_req {
+    int op, fd, flags;
+    char *buf;
+    size_t len;
+    off_t offset;
+    void *user;
+    ssize_t result;
+    struct ioe_req *next;               /* Next in the chain, or on a free or done list */
+    struct ioe_req *next_chain;         /* Next chain waiting for a worker */
+};
+
+struct io_engine {
+    int backend;
+    unsigned int depth;
+    unsigned int in_flight;             /* Prepared and not yet collected */
+    unsigned int submitted;             /* Submitted and not yet collected */
+    unsigned int queued;                /* Prepared and not yet submitted */
+    struct ioe_req *reqs, *free;
+
+    int *files;                         /* Registered descriptors, by index */
+    unsigned int nfiles;
+    struct iovec *bufs;                 /* Registered buffers, by index */
+    unsigned int nbufs;
+
+    /* io_uring */
+    int ring_fd;
+    void *rings;                        /* Both rings, in one mapping */
+    size_t rings_size;
+    struct io_uring_sqe *sqes;
+    size_t sqes_size;
+    unsigned int *sq_head, *sq_tail, *sq_mask, *sq_array;
+    unsigned int *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_cqe *cqes;
+
+    /* Thread pool */
+    pthread_t *threads;
+    int nthreads;
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready, work_done;
+    struct ioe_req *prep_head, *prep_tail;   /* Chains prepared, not submitted */
+    struct ioe_req *prep_last;               /* Last request prepared */
+    struct ioe_req *work_head, *work_tail;   /* Chains submitted, not started */
+    struct ioe_req *done;                    /* Finished requests */
+    int ndone;
+    int stopping;
+};
+
+static int
+io_uring_setup (unsigned int entries, struct io_uring_params *p)
+{
+    return syscall (__NR_io_uring_setup, entries, p);
+}
+
+static int
+io_uring_enter (int fd, unsigned int to_submit, unsigned int min_complete, unsigned int flags)
+{
+    return syscall (__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static int
+io_uring_register (int fd, unsigned int opcode, const void *arg, unsigned int nr_args)
+{
+    return syscall (__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+/* Check that the kernel knows every operation the engine may be asked for */
+static int
+uring_probe (int ring_fd)
+{
+    static const int needed[] = { IORING_OP_READ, IORING_OP_WRITE, IORING_OP_READ_FIXED,
+                                  IORING_OP_WRITE_FIXED, IORING_OP_ACCEPT };
+    struct io_uring_probe *probe;
+    size_t size = sizeof (*probe) + 256 * sizeof (struct io_uring_probe_op);
+    unsigned int i;
+    int ok = 1;
+
+    if ((probe = calloc (1, size)) == NULL)
+        return 0;
+    if (io_uring_register (ring_fd, IORING_REGISTER_PROBE, probe, 256) == -1)
+        ok = 0;
+    for (i = 0; ok && i < sizeof (needed) / sizeof (needed[0]); i++)
+        if (needed[i] > probe->last_op || !(probe->ops[needed[i]].flags & IO_URING_OP_SUPPORTED))
+            ok = 0;
+    free (probe);
+    return ok;
+}
+
+static int
+uring_init (io_engine_t *e)
+{
+    struct io_uring_params p;
+    size_t cq_size;
+    char *rings;
+
+    memset (&p, 0, sizeof (p));
+    e->ring_fd = io_uring_setup (e->depth, &p);
+    if (e->ring_fd == -1)
+        return -1;
+    /* IORING_OP_READ and IORING_OP_WRITE came in 5.6, after both of these */
+    if (!(p.features & IORING_FEAT_SINGLE_MMAP) || !(p.features & IORING_FEAT_NODROP) || \
+            !uring_probe (e->ring_fd)){
+        close (e->ring_fd);
+        return -1;
+    }
+    e->depth = p.sq_entries;            /* Rounded up to a power of 2 */
+
+    /* Both rings live in one mapping, as large as the larger of the two */
+    e->rings_size = p.sq_off.array + p.sq_entries * sizeof (unsigned int);
+    cq_size = p.cq_off.cqes + p.cq_entries * sizeof (struct io_uring_cqe);
+    if (cq_size > e->rings_size)
+        e->rings_size = cq_size;
+
+    e->rings = mmap (NULL, e->rings_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                     e->ring_fd, IORING_OFF_SQ_RING);
+    e->sqes_size = p.sq_entries * sizeof (struct io_uring_sqe);
+    e->sqes = mmap (NULL, e->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    e->ring_fd, IORING_OFF_SQES);
+    if (e->rings == MAP_FAILED || e->sqes == MAP_FAILED){
+        if (e->rings != MAP_FAILED)
+            munmap (e->rings, e->rings_size);
+        close (e->ring_fd);
+        return -1;
+    }
+
+    rings = e->rings;
+    e->sq_head = (unsigned int *)(rings + p.sq_off.head);
+    e->sq_tail = (unsigned int *)(rings + p.sq_off.tail);
+    e->sq_mask = (unsigned int *)(rings + p.sq_off.ring_mask);
+    e->sq_array = (unsigned int *)(rings + p.sq_off.array);
+    e->cq_head = (unsigned int *)(rings + p.cq_off.head);
+    e->cq_tail = (unsigned int *)(rings + p.cq_off.tail);
+    e->cq_mask = (unsigned int *)(rings + p.cq_off.ring_mask);
+    e->cqes = (struct io_uring_cqe *)(rings + p.cq_off.cqes);
+    return 0;
+}
+
+/* Index of a registered descriptor or buffer, or -1 */
+static int
+file_index (io_engine_t *e, int fd)
+{
+    unsigned int i;
+
+    for (i = 0; i < e->nfiles; i++)
+        if (e->files[i] == fd)
+            return i;
+    return -1;
+}
+
+static int
+buffer_index (io_engine_t *e, const char *buf, size_t len)
+{
+    unsigned int i;
+    const char *base;
+
+    for (i = 0; i < e->nbufs; i++){
+        base = e->bufs[i].iov_base;
+        if (buf >= base && buf + len <= base + e->bufs[i].iov_len)
+            return i;
+    }
+    return -1;
+}
+
+static void
+uring_prep (io_engine_t *e, struct ioe_req *r)
+{
+    unsigned int tail = *e->sq_tail, index = tail & *e->sq_mask;
+    struct io_uring_sqe *sqe = &e->sqes[index];
+    int fixed_file = file_index (e, r->fd), fixed_buf = -1;
+
+    memset (sqe, 0, sizeof (*sqe));
+    sqe->fd = (fixed_file != -1) ? fixed_file : r->fd;
+    if (fixed_file != -1)
+        sqe->flags |= IOSQE_FIXED_FILE;
+    if (r->flags & IOE_LINK)
+        sqe->flags |= IOSQE_IO_LINK;
+    sqe->user_data = (unsigned long)r;
+
+    switch (r->op){
+        case IOE_ACCEPT:
+            sqe->opcode = IORING_OP_ACCEPT;
+            sqe->accept_flags = SOCK_CLOEXEC;
+            break;
+
+        default:
+            fixed_buf = buffer_index (e, r->buf, r->len);
+            if (r->op == IOE_READ)
+                sqe->opcode = (fixed_buf != -1) ? IORING_OP_READ_FIXED : IORING_OP_READ;
+            else
+                sqe->opcode = (fixed_buf != -1) ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+            sqe->addr = (unsigned long)r->buf;
+            sqe->len = r->len;
+            sqe->off = (__u64)r->offset;    /* -1 means the file offset */
+            if (fixed_buf != -1)
+                sqe->buf_index = fixed_buf;
+            break;
+    }
+
+    e->sq_array[index] = index;
+    __atomic_store_n (e->sq_tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+static int
+uring_submit (io_engine_t *e)
+{
+    int n;
+
+    while (e->queued > 0){
+        n = io_uring_enter (e->ring_fd, e->queued, 0, 0);
+        if (n == -1){
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        e->queued -= n;
+        e->submitted += n;
+    }
+    return 0;
+}
+
+static int
+uring_complete (io_engine_t *e, struct ioe_completion *done, int max, int min)
+{
+    unsigned int head, tail;
+    struct io_uring_cqe *cqe;
+    struct ioe_req *r;
+    int n = 0;
+
+    for (;;){
+        head = *e->cq_head;
+        tail = __atomic_load_n (e->cq_tail, __ATOMIC_ACQUIRE);
+        while (head != tail && n < max){
+            cqe = &e->cqes[head & *e->cq_mask];
+            r = (struct ioe_req *)(unsigned long)cqe->user_data;
+            done[n].user = r->user;
+            done[n].result = cqe->res;
+            n++;
+            head++;
+
+            r->next = e->free;
+            e->free = r;
+            e->in_flight--;
+            e->submitted--;
+        }
+        __atomic_store_n (e->cq_head, head, __ATOMIC_RELEASE);
+
+        if (n >= min)
+            return n;
+        if (io_uring_enter (e->ring_fd, 0, min - n, IORING_ENTER_GETEVENTS) == -1 && errno != EINTR)
+            return n > 0 ? n : -1;
+    }
+}
+
+/* Carry out a chain of requests, cancelling the rest of it once a linked one falls short */
+static void
+run_chain (struct ioe_req *r)
+{
+    int cancel = 0;
+
+    for (; r != NULL; r = r->next){
+        if (cancel){
+            r->result = -ECANCELED;
+            continue;
+        }
+        switch (r->op){
+            case IOE_ACCEPT:
+                r->result = accept4 (r->fd, NULL, NULL, SOCK_CLOEXEC);
+                break;
+
+            case IOE_READ:
+                r->result = (r->offset == -1) ? read (r->fd, r->buf, r->len) : \
+                            pread (r->fd, r->buf, r->len, r->offset);
+                break;
+
+            default:
+                r->result = (r->offset == -1) ? write (r->fd, r->buf, r->len) : \
+                            pwrite (r->fd, r->buf, r->len, r->offset);
+                break;
+        }
+        if (r->result == -1)
+            r->result = -errno;
+        if ((r->flags & IOE_LINK) && (r->result < 0 || (r->op != IOE_ACCEPT && (size_t)r->result != r->len)))
+            cancel = 1;
+    }
+}
+
+static void *
+worker (void *arg)
+{
+    io_engine_t *e = arg;
+    struct ioe_req *chain, *r, *last;
+
+    pthread_mutex_lock (&e->lock);
+    for (;;){
+        while (e->work_head == NULL && !e->stopping)
+            pthread_cond_wait (&e->work_ready, &e->lock);
+        if (e->work_head == NULL)
+            break;
+        chain = e->work_head;
+        e->work_head = chain->next_chain;
+        if (e->work_head == NULL)
+            e->work_tail = NULL;
+        pthread_mutex_unlock (&e->lock);
+
+        run_chain (chain);
+
+        pthread_mutex_lock (&e->lock);
+        for (last = chain, e->ndone++; last->next != NULL; last = last->next)
+            e->ndone++;
+        r = chain;
+        last->next = e->done;
+        e->done = r;
+        pthread_cond_signal (&e->work_done);
+    }
+    pthread_mutex_unlock (&e->lock);
+    return NULL;
+}
+
+static int
+threads_init (io_engine_t *e)
+{
+    int i;
+
+    e->nthreads = (e->depth < IOE_MAX_THREADS) ? e->depth : IOE_MAX_THREADS;
+    if ((e->threads = calloc (e->nthreads, sizeof (pthread_t))) == NULL)
+        return -1;
+    pthread_mutex_init (&e->lock, NULL);
+    pthread_cond_init (&e->work_ready, NULL);
+    pthread_cond_init (&e->work_done, NULL);
+    for (i = 0; i < e->nthreads; i++)
+        if (pthread_create (&e->threads[i], NULL, worker, e) != 0)
+            break;
+    if (i == 0){
+        free (e->threads);
+        return -1;
+    }
+    e->nthreads = i;
+    return 0;
+}
+
+static int
+threads_submit (io_engine_t *e)
+{
+    if (e->prep_head == NULL)
+        return 0;
+    pthread_mutex_lock (&e->lock);
+    if (e->work_tail != NULL)
+        e->work_tail->next_chain = e->prep_head;
+    else
+        e->work_head = e->prep_head;
+    e->work_tail = e->prep_tail;
+    pthread_cond_broadcast (&e->work_ready);
+    pthread_mutex_unlock (&e->lock);
+
+    e->prep_head = e->prep_tail = e->prep_last = NULL;
+    e->submitted += e->queued;
+    e->queued = 0;
+    return 0;
+}
+
+static int
+threads_complete (io_engine_t *e, struct ioe_completion *done, int max, int min)
+{
+    struct ioe_req *r;
+    int n = 0;
+
+    pthread_mutex_lock (&e->lock);
+    while (e->ndone < min)
+        pthread_cond_wait (&e->work_done, &e->lock);
+    while (e->done != NULL && n < max){
+        r = e->done;
+        e->done = r->next;
+        e->ndone--;
+        done[n].user = r->user;
+        done[n].result = r->result;
+        n++;
+
+        r->next = e->free;
+        e->free = r;
+    }
+    pthread_mutex_unlock (&e->lock);
+
+    e->in_flight -= n;
+    e->submitted -= n;
+    return n;
+}
+
+io_engine_t *
+ioe_create (unsigned int depth, int flags)
+{
+    io_engine_t *e;
+    unsigned int i;
+
+    if (depth == 0){
+        errno = EINVAL;
+        return NULL;
+    }
+    if ((e = calloc (1, sizeof (io_engine_t))) == NULL)
+        return NULL;
+    e->depth = depth;
+
+    if ((flags & IOE_THREADS) || uring_init (e) == -1){
+        e->backend = BACKEND_THREADS;
+        e->depth = depth;
+        if (threads_init (e) == -1){
+            free (e);
+            return NULL;
+        }
+    }
+
+    if ((e->reqs = calloc (e->depth, sizeof (struct ioe_req))) == NULL){
+        ioe_destroy (e);
+        return NULL;
+    }
+    for (i = 0; i < e->depth; i++){
+        e->reqs[i].next = e->free;
+        e->free = &e->reqs[i];
+    }
+    return e;
+}
+
+const char *
+ioe_backend (io_engine_t *e)
+{
+    return (e->backend == BACKEND_URING) ? "io_uring" : "threads";
+}
+
+int
+ioe_register_files (io_engine_t *e, const int *fds, unsigned int count)
+{
+    if (e->backend == BACKEND_THREADS || e->nfiles > 0)
+        return 0;
+    if ((e->files = malloc (count * sizeof (int))) == NULL)
+        return -1;
+    if (io_uring_register (e->ring_fd, IORING_REGISTER_FILES, fds, count) == -1){
+        free (e->files);
+        e->files = NULL;
+        return -1;
+    }
+    memcpy (e->files, fds, count * sizeof (int));
+    e->nfiles = count;
+    return 0;
+}
+
+int
+ioe_register_buffers (io_engine_t *e, const struct iovec *iov, unsigned int count)
+{
+    if (e->backend == BACKEND_THREADS || e->nbufs > 0)
+        return 0;
+    if ((e->bufs = malloc (count * sizeof (struct iovec))) == NULL)
+        return -1;
+    /* Fails with ENOMEM if the pages would exceed RLIMIT_MEMLOCK */
+    if (io_uring_register (e->ring_fd, IORING_REGISTER_BUFFERS, iov, count) == -1){
+        free (e->bufs);
+        e->bufs = NULL;
+        return -1;
+    }
+    memcpy (e->bufs, iov, count * sizeof (struct iovec));
+    e->nbufs = count;
+    return 0;
+}
+
+unsigned int
+ioe_space (io_engine_t *e)
+{
+    return e->depth - e->in_flight;
+}
+
+int
+ioe_prep (io_engine_t *e, int op, int fd, void *buf, size_t len, off_t offset,
+          int flags, void *user)
+{
+    struct ioe_req *r = e->free;
+
+    if (r == NULL){
+        errno = EBUSY;
+        return -1;
+    }
+    e->free = r->next;
+    r->op = op;
+    r->fd = fd;
+    r->buf = buf;
+    r->len = len;
+    r->offset = offset;
+    r->flags = flags;
+    r->user = user;
+    r->next = r->next_chain = NULL;
+    e->in_flight++;
+    e->queued++;
+
+    if (e->backend == BACKEND_URING){
+        uring_prep (e, r);
+        return 0;
+    }
+
+    /* A request follows the last one in its chain if that one was linked */
+    if (e->prep_last != NULL && (e->prep_last->flags & IOE_LINK))
+        e->prep_last->next = r;
+    else if (e->prep_tail != NULL){
+        e->prep_tail->next_chain = r;
+        e->prep_tail = r;
+    }
+    else
+        e->prep_head = e->prep_tail = r;
+    e->prep_last = r;
+    return 0;
+}
+
+int
+ioe_submit (io_engine_t *e)
+{
+    unsigned int queued = e->queued;
+
+    if (e->backend == BACKEND_URING){
+        if (uring_submit (e) == -1)
+            return -1;
+    }
+    else
+        threads_submit (e);
+    return queued;
+}
+
+int
+ioe_complete (io_engine_t *e, struct ioe_completion *done, int max, int min)
+{
+    if (min > (int)e->submitted)
+        min = e->submitted;
+    if (min > max)
+        min = max;
+    if (e->backend == BACKEND_URING)
+        return uring_complete (e, done, max, min);
+    return threads_complete (e, done, max, min);
+}
+
+void
+ioe_destroy (io_engine_t *e)
+{
+    int i;
+
+    if (e->backend == BACKEND_URING){
+        munmap (e->sqes, e->sqes_size);
+        munmap (e->rings, e->rings_size);
+        close (e->ring_fd);             /* Also drops the registrations */
+    }
+    else {
+        pthread_mutex_lock (&e->lock);
+        e->stopping = 1;
+        pthread_cond_broadcast (&e->work_ready);
+        pthread_mutex_unlock (&e->lock);
+        for (i = 0; i < e->nthreads; i++)
+            pthread_join (e->threads[i], NULL);
+        free (e->threads);
+        pthread_mutex_destroy (&e->lock);
+        pthread_cond_destroy (&e->work_ready);
+        pthread_cond_destroy (&e->work_done);
+    }
+    free (e->files);
+    free (e->bufs);
+    free (e->reqs);
+    free (e);
+}
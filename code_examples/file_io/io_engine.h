@@ -0,0 +1,90 @@
+/* Header file for the asynchronous I/O engine in io_engine.c, used by the copy
+ * engine (copy_engine.c) and by us_xfr_server.c in the sockets directory
+ *
+ * A blocking read () or write () keeps one request in flight per thread, and
+ * select () only says when a descriptor is ready, not when I/O is done. The
+ * engine instead lets one thread keep up to depth requests queued at once and
+ * collect them as they finish:
+ *
+ *      ioe_prep ()      queue a read, write or accept
+ *      ioe_submit ()    start everything queued since the last call
+ *      ioe_complete ()  collect finished requests, waiting for some if asked
+ *
+ * On Linux 5.6 and later the engine is a thin layer over io_uring, reached with
+ * raw system calls, so no library is needed. Requests prepared with IOE_LINK run
+ * in order, the next one starting only when this one has fully succeeded, so a
+ * read and the write of the same buffer go in together. Registered files and
+ * buffers (ioe_register_files () and ioe_register_buffers ()) spare the kernel
+ * from looking up the descriptor and pinning the pages on every request; the
+ * engine uses them automatically for any request that names a registered
+ * descriptor or a buffer inside a registered one.
+ *
+ * Where io_uring is missing or forbidden, the same calls are served by a pool of
+ * threads making the blocking calls, one thread per request in flight up to
+ * IOE_MAX_THREADS. Registration is then accepted and ignored.
+ *
+ * An offset of -1 reads or writes at the file offset, for pipes and sockets.
+ *
+ * Date created: October 19, 2026
+ *
+ */
+#ifndef _IO_ENGINE_H_
+#define _IO_ENGINE_H_
+
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#define IOE_MAX_THREADS 16              /* Largest pool for the thread backend */
+
+/* Operations */
+#define IOE_READ 0
+#define IOE_WRITE 1
+#define IOE_ACCEPT 2                    /* buf, len and offset are not used */
+
+/* Flags for ioe_create () */
+#define IOE_THREADS 1                   /* Use the thread pool even if io_uring works */
+
+/* Flags for ioe_prep () */
+#define IOE_LINK 1                      /* Hold the next request until this one is done;
+                                           cancel it (-ECANCELED) if this one fails or
+                                           transfers less than len */
+
+typedef struct io_engine io_engine_t;
+
+struct ioe_completion {
+    void *user;                         /* As given to ioe_prep () */
+    ssize_t result;                     /* Bytes moved, new descriptor, or -errno */
+};
+
+/* Create an engine for up to depth requests in flight. Returns NULL on error. */
+io_engine_t *ioe_create (unsigned int depth, int flags);
+
+/* "io_uring" or "threads" */
+const char *ioe_backend (io_engine_t *e);
+
+/* Register descriptors and buffers for faster requests. Returns 0, or -1 with
+ * errno set, in which case requests still work without registration. */
+int ioe_register_files (io_engine_t *e, const int *fds, unsigned int count);
+int ioe_register_buffers (io_engine_t *e, const struct iovec *iov, unsigned int count);
+
+/* Requests that may still be prepared before some have to be collected */
+unsigned int ioe_space (io_engine_t *e);
+
+/* Queue a request. Returns 0, or -1 with errno EBUSY if depth requests are
+ * already in flight. */
+int ioe_prep (io_engine_t *e, int op, int fd, void *buf, size_t len, off_t offset,
+              int flags, void *user);
+
+/* Start the queued requests. Returns how many, or -1 with errno set. */
+int ioe_submit (io_engine_t *e);
+
+/* Collect up to max finished requests, waiting until at least min have finished
+ * (min is lowered to the number of requests submitted and not yet collected).
+ * Returns the number collected, or -1 with errno set. */
+int ioe_complete (io_engine_t *e, struct ioe_completion *done, int max, int min);
+
+/* Requests submitted and not yet collected must have finished or be waited for
+ * first; ioe_destroy () does not cancel them. */
+void ioe_destroy (io_engine_t *e);
+
+#endif /* _IO_ENGINE_H_ */
@@ -0,0 +1,411 @@
+/* Implementation of the event loop described in reactor.h.
+ *
+ * Each registered descriptor has an entry in a table indexed by descriptor
+ * number, grown as larger numbers turn up. The entry holds the callback and a
+ * generation count that changes whenever the descriptor is added or removed; the
+ * epoll data of an event carries the generation along with the descriptor, so an
+ * event for a descriptor removed earlier in the same batch is recognised as
+ * stale and dropped.
+ *
+ * Timers live in a binary min-heap of deadlines; each timer remembers its
+ * position in the heap, so it can be cancelled in O(log n).
+ *
+ * Date created: October 19, 2026
+ *
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include "reactor.h"
+
+struct fd_entry {
+    reactor_fd_fn fn;
+    void *arg;
+    uint32_t generation;
+    int used;
+};
+
+struct reactor_timer {
+    long long deadline;                 /* reactor_now_ms () at which it fires */
+    long interval;                      /* Milliseconds between firings, or 0 */
+    reactor_task_fn fn;
+    void *arg;
+    int index;                          /* Position in the heap, or -1 while a
+                                           one-shot timer is firing */
+};
+
+struct task {
+    reactor_task_fn fn;
+    void *arg;
+    struct task *next;
+};
+
+struct reactor {
+    int epfd;
+    int stopped;
+
+    struct fd_entry *fds;               /* Indexed by descriptor */
+    int nfds;
+
+    reactor_timer_t **heap;             /* Earliest deadline first */
+    int ntimers, max_timers;
+
+    struct task *tasks, *tasks_tail;    /* Deferred, in order */
+    struct task *free_tasks;
+};
+
+long long
+reactor_now_ms (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return (long long) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+reactor_t *
+reactor_create (void)
+{
+    reactor_t *r = calloc (1, sizeof (*r));
+
+    if (r == NULL)
+        return NULL;
+    if ((r->epfd = epoll_create1 (EPOLL_CLOEXEC)) == -1){
+        free (r);
+        return NULL;
+    }
+    return r;
+}
+
+void
+reactor_destroy (reactor_t *r)
+{
+    struct task *t, *lists[2];
+    int i;
+
+    if (r == NULL)
+        return;
+    close (r->epfd);
+    for (i = 0; i < r->ntimers; i++)
+        free (r->heap[i]);
+    lists[0] = r->tasks;
+    lists[1] = r->free_tasks;
+    for (i = 0; i < 2; i++)
+        while ((t = lists[i]) != NULL){
+            lists[i] = t->next;
+            free (t);
+        }
+    free (r->heap);
+    free (r->fds);
+    free (r);
+}
+
+/* Make room in the descriptor table for fd */
+static int
+grow_fds (reactor_t *r, int fd)
+{
+    struct fd_entry *fds;
+    int n = r->nfds > 0 ? r->nfds : 64;
+
+    while (n <= fd)
+        n *= 2;
+    if ((fds = realloc (r->fds, n * sizeof (*fds))) == NULL)
+        return -1;
+    memset (fds + r->nfds, 0, (n - r->nfds) * sizeof (*fds));
+    r->fds = fds;
+    r->nfds = n;
+    return 0;
+}
+
+static int
+control (reactor_t *r, int op, int fd, uint32_t events)
+{
+    struct epoll_event ev;
+
+    memset (&ev, 0, sizeof (ev));
+    ev.events = events;
+    ev.data.u64 = (uint64_t) r->fds[fd].generation << 32 | (uint32_t) fd;
+    return epoll_ctl (r->epfd, op, fd, &ev);
+}
+
+int
+reactor_add (reactor_t *r, int fd, uint32_t events, reactor_fd_fn fn, void *arg)
+{
+    struct fd_entry *entry;
+
+    if (fd < 0 || fn == NULL){
+        errno = EINVAL;
+        return -1;
+    }
+    if (fd >= r->nfds && grow_fds (r, fd) == -1)
+        return -1;
+    entry = &r->fds[fd];
+    if (entry->used){
+        errno = EEXIST;
+        return -1;
+    }
+
+    entry->generation++;
+    if (control (r, EPOLL_CTL_ADD, fd, events) == -1)
+        return -1;
+    entry->fn = fn;
+    entry->arg = arg;
+    entry->used = 1;
+    return 0;
+}
+
+int
+reactor_modify (reactor_t *r, int fd, uint32_t events)
+{
+    if (fd < 0 || fd >= r->nfds || !r->fds[fd].used){
+        errno = ENOENT;
+        return -1;
+    }
+    return control (r, EPOLL_CTL_MOD, fd, events);
+}
+
+int
+reactor_remove (reactor_t *r, int fd)
+{
+    if (fd < 0 || fd >= r->nfds || !r->fds[fd].used){
+        errno = ENOENT;
+        return -1;
+    }
+
+    /* Forget the descriptor even if epoll has already done so (because it was
+     * closed, say), so that the number can be added again */
+    r->fds[fd].used = 0;
+    r->fds[fd].generation++;
+    return epoll_ctl (r->epfd, EPOLL_CTL_DEL, fd, NULL);
+}
+
+/* Heap maintenance */
+
+static void
+heap_set (reactor_t *r, int i, reactor_timer_t *timer)
+{
+    r->heap[i] = timer;
+    timer->index = i;
+}
+
+static void
+sift_up (reactor_t *r, int i)
+{
+    reactor_timer_t *timer = r->heap[i];
+    int parent;
+
+    while (i > 0 && r->heap[parent = (i - 1) / 2]->deadline > timer->deadline){
+        heap_set (r, i, r->heap[parent]);
+        i = parent;
+    }
+    heap_set (r, i, timer);
+}
+
+static void
+sift_down (reactor_t *r, int i)
+{
+    reactor_timer_t *timer = r->heap[i];
+    int child;
+
+    while ((child = 2 * i + 1) < r->ntimers){
+        if (child + 1 < r->ntimers && r->heap[child + 1]->deadline < r->heap[child]->deadline)
+            child++;
+        if (r->heap[child]->deadline >= timer->deadline)
+            break;
+        heap_set (r, i, r->heap[child]);
+        i = child;
+    }
+    heap_set (r, i, timer);
+}
+
+static int
+heap_insert (reactor_t *r, reactor_timer_t *timer)
+{
+    reactor_timer_t **heap;
+    int n;
+
+    if (r->ntimers == r->max_timers){
+        n = r->max_timers > 0 ? 2 * r->max_timers : 16;
+        if ((heap = realloc (r->heap, n * sizeof (*heap))) == NULL)
+            return -1;
+        r->heap = heap;
+        r->max_timers = n;
+    }
+    heap_set (r, r->ntimers++, timer);
+    sift_up (r, timer->index);
+    return 0;
+}
+
+static void
+heap_delete (reactor_t *r, reactor_timer_t *timer)
+{
+    int i = timer->index;
+    reactor_timer_t *last = r->heap[--r->ntimers];
+
+    timer->index = -1;
+    if (last == timer)
+        return;
+    heap_set (r, i, last);
+    if (i > 0 && r->heap[(i - 1) / 2]->deadline > last->deadline)
+        sift_up (r, i);
+    else
+        sift_down (r, i);
+}
+
+reactor_timer_t *
+reactor_timer_add (reactor_t *r, long ms, long interval_ms, reactor_task_fn fn, void *arg)
+{
+    reactor_timer_t *timer;
+
+    if (fn == NULL || ms < 0 || interval_ms < 0){
+        errno = EINVAL;
+        return NULL;
+    }
+    if ((timer = malloc (sizeof (*timer))) == NULL)
+        return NULL;
+    timer->deadline = reactor_now_ms () + ms;
+    timer->interval = interval_ms;
+    timer->fn = fn;
+    timer->arg = arg;
+    if (heap_insert (r, timer) == -1){
+        free (timer);
+        return NULL;
+    }
+    return timer;
+}
+
+void
+reactor_timer_cancel (reactor_t *r, reactor_timer_t *timer)
+{
+    /* A one-shot timer cancelled from its own callback is freed when that returns */
+    if (timer == NULL || timer->index == -1)
+        return;
+    heap_delete (r, timer);
+    free (timer);
+}
+
+/* Fire the timers that are due at now */
+static void
+run_timers (reactor_t *r, long long now)
+{
+    reactor_timer_t *timer;
+
+    while (r->ntimers > 0 && (timer = r->heap[0])->deadline <= now){
+        if (timer->interval > 0){
+            /* Put it back before the callback, which may cancel it; a timer that
+             * fell more than one interval behind skips the missed firings */
+            timer->deadline += timer->interval;
+            if (timer->deadline <= now)
+                timer->deadline = now + timer->interval;
+            sift_down (r, 0);
+            timer->fn (r, timer->arg);
+        } else {
+            heap_delete (r, timer);
+            timer->fn (r, timer->arg);
+            free (timer);
+        }
+    }
+}
+
+int
+reactor_defer (reactor_t *r, reactor_task_fn fn, void *arg)
+{
+    struct task *t;
+
+    if ((t = r->free_tasks) != NULL)
+        r->free_tasks = t->next;
+    else if ((t = malloc (sizeof (*t))) == NULL)
+        return -1;
+    t->fn = fn;
+    t->arg = arg;
+    t->next = NULL;
+    if (r->tasks == NULL)
+        r->tasks = t;
+    else
+        r->tasks_tail->next = t;
+    r->tasks_tail = t;
+    return 0;
+}
+
+/* Run the tasks deferred so far; those they defer in turn wait for the next round,
+ * so that a task that keeps deferring itself cannot starve the descriptors */
+static void
+run_tasks (reactor_t *r)
+{
+    struct task *t, *list = r->tasks;
+
+    r->tasks = r->tasks_tail = NULL;
+    while ((t = list) != NULL){
+        list = t->next;
+        t->fn (r, t->arg);
+        t->next = r->free_tasks;
+        r->free_tasks = t;
+    }
+}
+
+int
+reactor_run_once (reactor_t *r, int timeout_ms)
+{
+    struct epoll_event events[REACTOR_MAX_EVENTS];
+    struct fd_entry *entry;
+    long long wait;
+    uint32_t generation;
+    int n, i, fd;
+
+    /* Sleep no longer than until the next timer, and not at all with tasks waiting */
+    if (r->tasks != NULL)
+        timeout_ms = 0;
+    else if (r->ntimers > 0){
+        wait = r->heap[0]->deadline - reactor_now_ms ();
+        if (wait < 0)
+            wait = 0;
+        if (timeout_ms < 0 || wait < timeout_ms)
+            timeout_ms = (int) wait;
+    }
+
+    n = epoll_wait (r->epfd, events, REACTOR_MAX_EVENTS, timeout_ms);
+    if (n == -1){
+        if (errno != EINTR)
+            return -1;
+        n = 0;
+    }
+
+    for (i = 0; i < n; i++){
+        fd = (int)(uint32_t) events[i].data.u64;
+        generation = (uint32_t)(events[i].data.u64 >> 32);
+
+        /* The table may have moved, and the entry changed, in an earlier callback */
+        if (fd >= r->nfds)
+            continue;
+        entry = &r->fds[fd];
+        if (!entry->used || entry->generation != generation)
+            continue;
+        entry->fn (r, fd, events[i].events, entry->arg);
+    }
+
+    if (r->ntimers > 0)
+        run_timers (r, reactor_now_ms ());
+    run_tasks (r);
+    return 0;
+}
+
+int
+reactor_run (reactor_t *r)
+{
+    r->stopped = 0;
+    while (!r->stopped)
+        if (reactor_run_once (r, -1) == -1)
+            return -1;
+    return 0;
+}
+
+void
+reactor_stop (reactor_t *r)
+{
+    r->stopped = 1;
+}
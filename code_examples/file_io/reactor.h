@@ -0,0 +1,93 @@
+/* Header file for the event loop in reactor.c, used by reactor_example.c, the
+ * servers in ../sockets and ../fifos, and pssh (shackleford/src/projects/pssh/pssh_v2)
+ *
+ * select_example.c waits for one descriptor with select (), which has to be
+ * given the whole set of descriptors again on every call and cannot watch one
+ * numbered FD_SETSIZE (1024) or above. The reactor is built on epoll instead:
+ * descriptors are registered once, each with a callback, and epoll_wait () costs
+ * the same however many of them are idle, so tens of thousands of connections
+ * are no problem (given a high enough RLIMIT_NOFILE).
+ *
+ * Besides descriptors the reactor runs:
+ *
+ *   - Timers, one-shot or periodic, kept in a binary heap ordered by deadline.
+ *     The earliest deadline becomes the timeout of epoll_wait (), so timers cost
+ *     no extra system calls or descriptors.
+ *
+ *   - Deferred tasks, run once the callbacks for the current batch of events are
+ *     done. A callback can defer work (closing a connection, resuming a busy one)
+ *     instead of doing it while other events of the batch still refer to it. While
+ *     tasks are waiting the reactor does not sleep in epoll_wait ().
+ *
+ * Descriptors are level-triggered unless EPOLLET is among their events; an
+ * edge-triggered callback must read or write until EAGAIN. A callback may add,
+ * modify or remove any descriptor, including its own; events still pending in
+ * the batch for a descriptor that was removed are dropped, even if the number is
+ * reused in the meantime.
+ *
+ * A reactor belongs to the thread that runs it; use one per thread.
+ *
+ * Date created: October 19, 2026
+ *
+ */
+#ifndef _REACTOR_H_
+#define _REACTOR_H_
+
+#include <stdint.h>
+#include <sys/epoll.h>
+
+#define REACTOR_MAX_EVENTS 256          /* Events taken per epoll_wait () */
+
+typedef struct reactor reactor_t;
+typedef struct reactor_timer reactor_timer_t;
+
+/* Called with the epoll events (EPOLLIN, EPOLLOUT, EPOLLHUP, ...) of fd */
+typedef void (*reactor_fd_fn) (reactor_t *r, int fd, uint32_t events, void *arg);
+
+/* Called for timers and deferred tasks */
+typedef void (*reactor_task_fn) (reactor_t *r, void *arg);
+
+/* Create a reactor. Returns NULL on error. */
+reactor_t *reactor_create (void);
+
+/* Free the reactor and its timers and tasks; registered descriptors are not closed. */
+void reactor_destroy (reactor_t *r);
+
+/* Watch fd for events (EPOLLIN, EPOLLOUT, optionally EPOLLET, ...) and call fn when
+ * they occur. Returns 0, or -1 with errno set. */
+int reactor_add (reactor_t *r, int fd, uint32_t events, reactor_fd_fn fn, void *arg);
+
+/* Change the events watched for fd. Returns 0, or -1 with errno set. */
+int reactor_modify (reactor_t *r, int fd, uint32_t events);
+
+/* Stop watching fd; call this before closing it. Returns 0, or -1 with errno set. */
+int reactor_remove (reactor_t *r, int fd);
+
+/* Call fn after ms milliseconds, and then every interval_ms milliseconds if that is
+ * not 0. Returns a handle for reactor_timer_cancel (), or NULL on error. The handle
+ * of a one-shot timer is no longer valid once the timer has fired. */
+reactor_timer_t *reactor_timer_add (reactor_t *r, long ms, long interval_ms,
+                                    reactor_task_fn fn, void *arg);
+
+/* Cancel a timer that has not fired yet, or a periodic one */
+void reactor_timer_cancel (reactor_t *r, reactor_timer_t *timer);
+
+/* Call fn once the callbacks for the current events are done. Returns 0, or -1 with
+ * errno set. */
+int reactor_defer (reactor_t *r, reactor_task_fn fn, void *arg);
+
+/* Wait for one round of events, call the callbacks, fire the timers that are due
+ * and run the deferred tasks. timeout_ms (-1 for none) bounds the wait. Returns 0,
+ * or -1 with errno set if epoll_wait () failed for a reason other than EINTR. */
+int reactor_run_once (reactor_t *r, int timeout_ms);
+
+/* Run rounds until reactor_stop () is called. Returns 0, or -1 with errno set. */
+int reactor_run (reactor_t *r);
+
+/* Make reactor_run () return after the current round */
+void reactor_stop (reactor_t *r);
+
+/* Milliseconds on the monotonic clock, as the timers see it */
+long long reactor_now_ms (void);
+
+#endif /* _REACTOR_H_ */
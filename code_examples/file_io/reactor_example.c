@@ -0,0 +1,95 @@
+/* This example program does what select_example.c does, on the epoll reactor in
+ * reactor.c: it waits for input on stdin, and gives up after five seconds without
+ * any. Unlike select_example.c it keeps going after the first input, so the
+ * five seconds start again with every read; the timeout is a reactor timer that
+ * is cancelled and added again each time. A periodic timer prints a dot every
+ * second meanwhile, and the echo of each read is a deferred task.
+ *
+ * Usage: ./reactor_example
+ *
+ * Date created: October 19, 2026
+ *
+ * Compile as follows:
+ * gcc -o reactor_example reactor_example.c reactor.c -std=c99 -Wall -O2
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "reactor.h"
+
+#define TIMEOUT 5   /* Time out parameter in seconds */
+#define BUF_LEN 256 /* Length of the read buffer in bytes */
+
+static reactor_timer_t *timeout;
+static char buf[BUF_LEN + 1];
+
+static void
+timed_out (reactor_t *r, void *arg)
+{
+    printf ("\nno input for %d seconds \n", TIMEOUT);
+    reactor_stop (r);
+}
+
+static void
+tick (reactor_t *r, void *arg)
+{
+    printf (".");
+    fflush (stdout);
+}
+
+static void
+echo (reactor_t *r, void *arg)
+{
+    printf ("read: %s \n", buf);
+}
+
+static void
+stdin_ready (reactor_t *r, int fd, uint32_t events, void *arg)
+{
+    ssize_t len;
+
+    len = read (fd, buf, BUF_LEN);
+    if (len == -1){
+        perror ("read");
+        exit (EXIT_FAILURE);
+    }
+    if (len == 0){
+        printf ("end of input \n");
+        reactor_stop (r);
+        return;
+    }
+    buf[len] = '\0';    /* Null terminate our string. */
+    reactor_defer (r, echo, NULL);
+
+    /* Start the five seconds again */
+    reactor_timer_cancel (r, timeout);
+    timeout = reactor_timer_add (r, TIMEOUT * 1000, 0, timed_out, NULL);
+}
+
+int
+main (void)
+{
+    reactor_t *r = reactor_create ();
+
+    if (r == NULL){
+        perror ("reactor_create");
+        return 1;
+    }
+
+    /* Level-triggered: anything not read this time is reported again */
+    if (reactor_add (r, STDIN_FILENO, EPOLLIN, stdin_ready, NULL) == -1){
+        perror ("reactor_add");
+        return 1;
+    }
+    timeout = reactor_timer_add (r, TIMEOUT * 1000, 0, timed_out, NULL);
+    reactor_timer_add (r, 1000, 1000, tick, NULL);
+
+    if (reactor_run (r) == -1){
+        perror ("epoll_wait");
+        return 1;
+    }
+    reactor_destroy (r);
+    return 0;
+}
@@ -0,0 +1,869 @@
+/*
+Benchmark that measures every IPC transport demonstrated in this repository under
+the same conditions, so that the numbers can be compared directly:
+
+    pipe          a pair of pipes, as in ../pipes
+    fifo          a pair of FIFOs, as in ../fifos
+    unix-stream   a UNIX domain stream socket pair, as in ../sockets/us_xfr*
+    unix-dgram    a UNIX domain datagram socket pair, as in ../sockets/ud_ucase*
+    mq            a pair of POSIX message queues, as in ../mq
+    posix-shm     POSIX shared memory slots guarded by POSIX semaphores, as in
+                  ../shm/posix and ../sem/posix
+    sysv-shm      System V shared memory slots guarded by System V semaphores, as
+                  in ../shm/SystemV and ../sem/systemV
+    shm-channel   the futex-based ring in ../shm/posix/shm_channel.c
+
+For each transport and each message size from 8 bytes to 1 MB (8 B, 64 B, 512 B,
+4 KB, 32 KB, 256 KB and 1 MB), a parent and a child process run two tests:
+
+    latency       ping-pong: the parent sends a message, the child sends it back.
+                  Every round trip is timed; the median and 99th percentile are
+                  reported, and half the median as the one-way latency.
+
+    throughput    the parent streams messages to the child as fast as it can and
+                  the child acknowledges the last one.
+
+Each test starts with a warmup of a tenth of its iterations, which is not timed.
+The parent and child are pinned to two different CPUs (the first two allowed, or
+those given with -c) so that the scheduler does not move them mid-test; on a
+machine with one CPU both run on it and every message costs a context switch.
+
+Transports that limit the size of one message (datagrams, message queues) carry
+the larger sizes in several pieces, as an application would have to.
+
+Results go to a CSV file (one row per transport and size) and a summary table is
+printed on standard output.
+
+Usage: ./ipc_bench [-t transport,...] [-m max size] [-b MB per test] [-c cpu,cpu | -n] [-o file.csv]
+
+Date created: October 19, 2026
+
+Compile as follows:
+
+	gcc -o ipc_bench ipc_bench.c ../mq/mq_stream.c ../shm/posix/shm_channel.c -std=c11 -Wall -O2 -lrt -pthread
+
+*/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <signal.h>
+#include <time.h>
+#include <semaphore.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <sys/sem.h>
+#include "../mq/mq_stream.h"
+#include "../shm/posix/shm_channel.h"
+
+#define MAX_SIZE (1 << 20)
+#define NSLOTS 8                        /* Messages in flight in the shared memory transports */
+#define DGRAM_CHUNK 65536               /* Largest datagram sent */
+#define MIN_ITERATIONS 100
+#define MAX_ROUND_TRIPS 20000
+#define MAX_MESSAGES 200000
+#define TEST_TIMEOUT 120                /* Seconds before a stuck test is abandoned */
+
+enum { TO_CHILD = 0, TO_PARENT = 1 };
+
+/* Semaphores of the shared memory transports, per direction */
+#define SEM_EMPTY(dir) (2 * (dir))
+#define SEM_FULL(dir) (2 * (dir) + 1)
+
+static const size_t sizes[] = { 8, 64, 512, 4096, 32768, 262144, 1 << 20 };
+
+#define NUM_SIZES (sizeof (sizes) / sizeof (sizes[0]))
+
+struct channel {
+    int fd[2][2];                       /* Per direction: read end, write end */
+    size_t chunk;                       /* Most bytes moved by one call, 0 for no limit */
+    mqd_t mqd[2];
+    char *bounce;                       /* For message queue pieces shorter than msgsize */
+    char *region;                       /* Shared memory: semaphores, then the slots */
+    size_t region_size, slot_size;
+    sem_t *sems;
+    int semid;
+    unsigned int head[2], tail[2];      /* Next slot to fill and to empty, per process */
+    shm_channel_t *shm_ch[2];
+};
+
+struct transport {
+    const char *name;
+    void (*open) (struct channel *ch, size_t size);
+    void (*send) (struct channel *ch, int dir, const char *buf, size_t len);
+    void (*recv) (struct channel *ch, int dir, char *buf, size_t len);
+    void (*close) (struct channel *ch);
+};
+
+struct result {
+    double rtt_p50, rtt_p99;            /* Microseconds */
+    double msgs_per_sec, mb_per_sec;
+    long round_trips, messages;
+};
+
+static const char *test_name = "";
+
+/* What timeout_handler () cleans up after a stuck test. Every other object is
+ * removed from its namespace as soon as it is created, and goes away with the
+ * processes that hold it. */
+static volatile pid_t test_child;
+static volatile int test_semid = -1;
+
+static void
+die (const char *what)
+{
+    fprintf (stderr, "%s: ", test_name);
+    perror (what);
+    exit (EXIT_FAILURE);
+}
+
+static double
+now_seconds (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Descriptor-based transports: pipes, FIFOs and sockets */
+
+static void
+fd_send (struct channel *ch, int dir, const char *buf, size_t len)
+{
+    size_t off = 0, n;
+    ssize_t w;
+
+    while (off < len){
+        n = len - off;
+        if (ch->chunk && n > ch->chunk)
+            n = ch->chunk;
+        w = write (ch->fd[dir][1], buf + off, n);
+        if (w == -1){
+            if (errno == EINTR)
+                continue;
+            die ("write");
+        }
+        off += w;
+    }
+}
+
+/* A datagram socket returns one whole piece per read, which is exactly what is
+ * asked for here since the sender cut the message into the same pieces. */
+static void
+fd_recv (struct channel *ch, int dir, char *buf, size_t len)
+{
+    size_t off = 0, n;
+    ssize_t r;
+
+    while (off < len){
+        n = len - off;
+        if (ch->chunk && n > ch->chunk)
+            n = ch->chunk;
+        r = read (ch->fd[dir][0], buf + off, n);
+        if (r == -1){
+            if (errno == EINTR)
+                continue;
+            die ("read");
+        }
+        if (r == 0)
+            die ("read: end of file");
+        off += r;
+    }
+}
+
+static void
+fd_close (struct channel *ch)
+{
+    int dir, end;
+
+    for (dir = 0; dir < 2; dir++)
+        for (end = 0; end < 2; end++)
+            if (ch->fd[dir][end] != -1 && (end == 0 || ch->fd[dir][1] != ch->fd[dir][0]))
+                close (ch->fd[dir][end]);
+}
+
+static void
+pipe_open (struct channel *ch, size_t size)
+{
+    if (pipe (ch->fd[TO_CHILD]) == -1 || pipe (ch->fd[TO_PARENT]) == -1)
+        die ("pipe");
+}
+
+/* Opening a FIFO for reading and writing does not wait for a partner on Linux,
+ * so both FIFOs are opened before the fork and removed from /tmp at once. */
+static void
+fifo_open (struct channel *ch, size_t size)
+{
+    char path[64];
+    int dir, fd;
+
+    for (dir = 0; dir < 2; dir++){
+        snprintf (path, sizeof (path), "/tmp/ipc_bench.%ld.%d", (long)getpid (), dir);
+        unlink (path);
+        if (mkfifo (path, S_IRUSR | S_IWUSR) == -1)
+            die ("mkfifo");
+        fd = open (path, O_RDWR);
+        if (fd == -1)
+            die ("open");
+        unlink (path);
+        ch->fd[dir][0] = ch->fd[dir][1] = fd;
+    }
+}
+
+static void
+socket_open (struct channel *ch, int type)
+{
+    int sv[2];
+
+    if (socketpair (AF_UNIX, type, 0, sv) == -1)
+        die ("socketpair");
+
+    /* The parent talks on sv[0] and the child on sv[1] */
+    ch->fd[TO_CHILD][1] = sv[0];
+    ch->fd[TO_CHILD][0] = sv[1];
+    ch->fd[TO_PARENT][1] = sv[1];
+    ch->fd[TO_PARENT][0] = sv[0];
+}
+
+static void
+stream_open (struct channel *ch, size_t size)
+{
+    socket_open (ch, SOCK_STREAM);
+}
+
+static void
+socket_close (struct channel *ch)
+{
+    close (ch->fd[TO_CHILD][1]);
+    close (ch->fd[TO_CHILD][0]);
+}
+
+static void
+dgram_open (struct channel *ch, size_t size)
+{
+    int bufsize = 4 * DGRAM_CHUNK, i;
+
+    socket_open (ch, SOCK_DGRAM);
+    ch->chunk = DGRAM_CHUNK;
+    for (i = 0; i < 2; i++){
+        setsockopt (ch->fd[TO_CHILD][i], SOL_SOCKET, SO_SNDBUF, &bufsize, sizeof (bufsize));
+        setsockopt (ch->fd[TO_CHILD][i], SOL_SOCKET, SO_RCVBUF, &bufsize, sizeof (bufsize));
+    }
+}
+
+/* POSIX message queues */
+
+static void
+mq_transport_open (struct channel *ch, size_t size)
+{
+    char name[64];
+    long msgsize;
+    int dir;
+
+    for (dir = 0; dir < 2; dir++){
+        snprintf (name, sizeof (name), "/ipc_bench.%ld.%d", (long)getpid (), dir);
+        mq_unlink (name);
+        ch->mqd[dir] = mqs_open (name, O_RDWR | O_CREAT | O_EXCL, 0, 0);
+        if (ch->mqd[dir] == (mqd_t)-1)
+            die ("mq_open");
+        mq_unlink (name);
+    }
+    msgsize = mqs_msgsize (ch->mqd[0]);
+    if (msgsize == -1)
+        die ("mq_getattr");
+    ch->chunk = msgsize;
+    ch->bounce = malloc (msgsize);
+    if (ch->bounce == NULL)
+        die ("malloc");
+}
+
+static void
+mq_transport_send (struct channel *ch, int dir, const char *buf, size_t len)
+{
+    size_t off, n;
+
+    for (off = 0; off < len; off += n){
+        n = (len - off > ch->chunk) ? ch->chunk : len - off;
+        while (mq_send (ch->mqd[dir], buf + off, n, 0) == -1)
+            if (errno != EINTR)
+                die ("mq_send");
+    }
+}
+
+/* mq_receive () wants room for a whole mq_msgsize message, so the last piece of
+ * a message goes through the bounce buffer. */
+static void
+mq_transport_recv (struct channel *ch, int dir, char *buf, size_t len)
+{
+    size_t off = 0;
+    ssize_t n;
+
+    while (off < len){
+        if (len - off >= ch->chunk)
+            n = mq_receive (ch->mqd[dir], buf + off, ch->chunk, NULL);
+        else {
+            n = mq_receive (ch->mqd[dir], ch->bounce, ch->chunk, NULL);
+            if (n > 0)
+                memcpy (buf + off, ch->bounce, n);
+        }
+        if (n == -1){
+            if (errno == EINTR)
+                continue;
+            die ("mq_receive");
+        }
+        off += n;
+    }
+}
+
+static void
+mq_transport_close (struct channel *ch)
+{
+    mq_close (ch->mqd[0]);
+    mq_close (ch->mqd[1]);
+    free (ch->bounce);
+}
+
+/* Shared memory transports. Each direction has NSLOTS slots of the message size
+ * and a pair of counting semaphores, empty and full, as in the bounded buffer of
+ * ../shm/SystemV/sv_xfr.c. Only one process sends and one receives in each
+ * direction, so the slot indexes need not be shared. */
+
+#define SEM_AREA 256
+#define SLOT(ch, dir, i) ((ch)->region + SEM_AREA + ((dir) * NSLOTS + (i)) * (ch)->slot_size)
+
+static void
+sem_wait_op (struct channel *ch, int sem)
+{
+    struct sembuf sop = { sem, -1, 0 };
+
+    if (ch->sems != NULL){
+        while (sem_wait (&ch->sems[sem]) == -1)
+            if (errno != EINTR)
+                die ("sem_wait");
+    }
+    else {
+        while (semop (ch->semid, &sop, 1) == -1)
+            if (errno != EINTR)
+                die ("semop");
+    }
+}
+
+static void
+sem_post_op (struct channel *ch, int sem)
+{
+    struct sembuf sop = { sem, 1, 0 };
+
+    if (ch->sems != NULL){
+        if (sem_post (&ch->sems[sem]) == -1)
+            die ("sem_post");
+    }
+    else if (semop (ch->semid, &sop, 1) == -1)
+        die ("semop");
+}
+
+static void
+shm_send (struct channel *ch, int dir, const char *buf, size_t len)
+{
+    sem_wait_op (ch, SEM_EMPTY (dir));
+    memcpy (SLOT (ch, dir, ch->head[dir]), buf, len);
+    ch->head[dir] = (ch->head[dir] + 1) % NSLOTS;
+    sem_post_op (ch, SEM_FULL (dir));
+}
+
+static void
+shm_recv (struct channel *ch, int dir, char *buf, size_t len)
+{
+    sem_wait_op (ch, SEM_FULL (dir));
+    memcpy (buf, SLOT (ch, dir, ch->tail[dir]), len);
+    ch->tail[dir] = (ch->tail[dir] + 1) % NSLOTS;
+    sem_post_op (ch, SEM_EMPTY (dir));
+}
+
+static void
+shm_sizes (struct channel *ch, size_t size)
+{
+    ch->slot_size = (size + 63) & ~(size_t)63;
+    ch->region_size = SEM_AREA + 2 * NSLOTS * ch->slot_size;
+}
+
+static void
+posix_shm_open (struct channel *ch, size_t size)
+{
+    char name[64];
+    int fd, dir;
+
+    shm_sizes (ch, size);
+    snprintf (name, sizeof (name), "/ipc_bench.%ld", (long)getpid ());
+    fd = shm_open (name, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+    if (fd == -1)
+        die ("shm_open");
+    shm_unlink (name);
+    if (ftruncate (fd, ch->region_size) == -1)
+        die ("ftruncate");
+    ch->region = mmap (NULL, ch->region_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (ch->region == MAP_FAILED)
+        die ("mmap");
+    close (fd);
+
+    ch->sems = (sem_t *)ch->region;
+    for (dir = 0; dir < 2; dir++){
+        if (sem_init (&ch->sems[SEM_EMPTY (dir)], 1, NSLOTS) == -1
+            || sem_init (&ch->sems[SEM_FULL (dir)], 1, 0) == -1)
+            die ("sem_init");
+    }
+}
+
+static void
+posix_shm_close (struct channel *ch)
+{
+    int i;
+
+    for (i = 0; i < 4; i++)
+        sem_destroy (&ch->sems[i]);
+    munmap (ch->region, ch->region_size);
+}
+
+static void
+sysv_shm_open (struct channel *ch, size_t size)
+{
+    unsigned short values[4] = { NSLOTS, 0, NSLOTS, 0 };
+    int shmid;
+
+    shm_sizes (ch, size);
+    shmid = shmget (IPC_PRIVATE, ch->region_size, IPC_CREAT | S_IRUSR | S_IWUSR);
+    if (shmid == -1)
+        die ("shmget");
+    ch->region = shmat (shmid, NULL, 0);
+    if (ch->region == (void *)-1)
+        die ("shmat");
+    /* The segment goes away once both processes have detached from it */
+    shmctl (shmid, IPC_RMID, NULL);
+
+    ch->semid = semget (IPC_PRIVATE, 4, IPC_CREAT | S_IRUSR | S_IWUSR);
+    if (ch->semid == -1)
+        die ("semget");
+    test_semid = ch->semid;
+    if (semctl (ch->semid, 0, SETALL, values) == -1)
+        die ("semctl");
+}
+
+static void
+sysv_shm_close (struct channel *ch)
+{
+    test_semid = -1;
+    semctl (ch->semid, 0, IPC_RMID);
+    shmdt (ch->region);
+}
+
+/* The futex-based shared memory channel */
+
+static void
+channel_transport_open (struct channel *ch, size_t size)
+{
+    char name[64];
+    int dir;
+
+    for (dir = 0; dir < 2; dir++){
+        snprintf (name, sizeof (name), "/ipc_bench_ch.%ld.%d", (long)getpid (), dir);
+        channel_unlink (name);
+        ch->shm_ch[dir] = channel_create (name, NSLOTS, size);
+        if (ch->shm_ch[dir] == NULL)
+            die ("channel_create");
+        channel_unlink (name);
+    }
+}
+
+static void
+channel_transport_send (struct channel *ch, int dir, const char *buf, size_t len)
+{
+    if (channel_send (ch->shm_ch[dir], buf, len) == -1)
+        die ("channel_send");
+}
+
+static void
+channel_transport_recv (struct channel *ch, int dir, char *buf, size_t len)
+{
+    if (channel_receive (ch->shm_ch[dir], buf, len) == -1)
+        die ("channel_receive");
+}
+
+static void
+channel_transport_close (struct channel *ch)
+{
+    channel_close (ch->shm_ch[0]);
+    channel_close (ch->shm_ch[1]);
+}
+
+static const struct transport transports[] = {
+    { "pipe", pipe_open, fd_send, fd_recv, fd_close },
+    { "fifo", fifo_open, fd_send, fd_recv, fd_close },
+    { "unix-stream", stream_open, fd_send, fd_recv, socket_close },
+    { "unix-dgram", dgram_open, fd_send, fd_recv, socket_close },
+    { "mq", mq_transport_open, mq_transport_send, mq_transport_recv, mq_transport_close },
+    { "posix-shm", posix_shm_open, shm_send, shm_recv, posix_shm_close },
+    { "sysv-shm", sysv_shm_open, shm_send, shm_recv, sysv_shm_close },
+    { "shm-channel", channel_transport_open, channel_transport_send, channel_transport_recv,
+      channel_transport_close },
+};
+
+#define NUM_TRANSPORTS (sizeof (transports) / sizeof (transports[0]))
+
+static int pin = 1, cpus[2] = { -1, -1 };
+
+static void
+pin_to (int cpu)
+{
+    cpu_set_t set;
+
+    if (!pin || cpu < 0)
+        return;
+    CPU_ZERO (&set);
+    CPU_SET (cpu, &set);
+    if (sched_setaffinity (0, sizeof (set), &set) == -1)
+        perror ("sched_setaffinity");
+}
+
+/* Default to the first two CPUs this process may run on */
+static void
+choose_cpus (void)
+{
+    cpu_set_t set;
+    int cpu, n = 0;
+
+    if (cpus[0] >= 0 || sched_getaffinity (0, sizeof (set), &set) == -1)
+        return;
+    for (cpu = 0; cpu < CPU_SETSIZE && n < 2; cpu++)
+        if (CPU_ISSET (cpu, &set))
+            cpus[n++] = cpu;
+    if (n == 1)
+        cpus[1] = cpus[0];
+}
+
+static void
+timeout_handler (int sig)
+{
+    static const char msg[] = "test timed out \n";
+
+    write (STDERR_FILENO, msg, sizeof (msg) - 1);
+    if (test_child > 0){
+        kill (test_child, SIGKILL);
+        waitpid (test_child, NULL, 0);
+    }
+    if (test_semid != -1)
+        semctl (test_semid, 0, IPC_RMID);
+    _exit (EXIT_FAILURE);
+}
+
+static int
+compare_double (const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+static pid_t
+start_child (const struct transport *t, struct channel *ch, char *buf, size_t size,
+             long warmup, long count, int pingpong)
+{
+    pid_t pid;
+    long i;
+
+    pid = fork ();
+    if (pid == -1)
+        die ("fork");
+    if (pid > 0){
+        test_child = pid;
+        return pid;
+    }
+
+    pin_to (cpus[1]);
+    alarm (TEST_TIMEOUT);
+    if (pingpong){
+        for (i = 0; i < warmup + count; i++){
+            t->recv (ch, TO_CHILD, buf, size);
+            t->send (ch, TO_PARENT, buf, size);
+        }
+    }
+    else {
+        /* Acknowledge the end of the warmup and of the timed run */
+        for (i = 0; i < warmup; i++)
+            t->recv (ch, TO_CHILD, buf, size);
+        t->send (ch, TO_PARENT, buf, 1);
+        for (i = 0; i < count; i++)
+            t->recv (ch, TO_CHILD, buf, size);
+        t->send (ch, TO_PARENT, buf, 1);
+    }
+    _exit (EXIT_SUCCESS);
+}
+
+static int
+finish_child (pid_t pid)
+{
+    int status;
+
+    if (waitpid (pid, &status, 0) == -1)
+        status = -1;
+    test_child = 0;
+    return status != -1 && WIFEXITED (status) && WEXITSTATUS (status) == EXIT_SUCCESS;
+}
+
+static int
+run_latency (const struct transport *t, size_t size, long round_trips, char *buf, struct result *res)
+{
+    struct channel ch;
+    double *rtt, start;
+    long warmup = round_trips / 10, i, bad = 0;
+    pid_t pid;
+
+    memset (&ch, 0, sizeof (ch));
+    memset (ch.fd, -1, sizeof (ch.fd));
+    t->open (&ch, size);
+    rtt = malloc (round_trips * sizeof (double));
+    if (rtt == NULL)
+        die ("malloc");
+
+    pid = start_child (t, &ch, buf, size, warmup, round_trips, 1);
+    for (i = -warmup; i < round_trips; i++){
+        buf[0] = buf[size - 1] = (char)i;
+        start = now_seconds ();
+        t->send (&ch, TO_CHILD, buf, size);
+        t->recv (&ch, TO_PARENT, buf, size);
+        if (i >= 0)
+            rtt[i] = (now_seconds () - start) * 1e6;
+        if (buf[0] != (char)i || buf[size - 1] != (char)i)
+            bad++;
+    }
+
+    qsort (rtt, round_trips, sizeof (double), compare_double);
+    res->round_trips = round_trips;
+    res->rtt_p50 = rtt[round_trips / 2];
+    res->rtt_p99 = rtt[round_trips * 99 / 100];
+    free (rtt);
+    if (bad)
+        fprintf (stderr, "%s: %ld corrupted replies \n", test_name, bad);
+
+    i = finish_child (pid);
+    t->close (&ch);
+    return i && !bad;
+}
+
+static int
+run_throughput (const struct transport *t, size_t size, long messages, char *buf, struct result *res)
+{
+    struct channel ch;
+    char ack[1];
+    double start, elapsed;
+    long warmup = messages / 10, i;
+    pid_t pid;
+    int ok;
+
+    memset (&ch, 0, sizeof (ch));
+    memset (ch.fd, -1, sizeof (ch.fd));
+    t->open (&ch, size);
+
+    pid = start_child (t, &ch, buf, size, warmup, messages, 0);
+    for (i = 0; i < warmup; i++)
+        t->send (&ch, TO_CHILD, buf, size);
+    t->recv (&ch, TO_PARENT, ack, 1);
+
+    start = now_seconds ();
+    for (i = 0; i < messages; i++)
+        t->send (&ch, TO_CHILD, buf, size);
+    t->recv (&ch, TO_PARENT, ack, 1);
+    elapsed = now_seconds () - start;
+
+    res->messages = messages;
+    res->msgs_per_sec = messages / elapsed;
+    res->mb_per_sec = messages * (double)size / elapsed / 1e6;
+
+    ok = finish_child (pid);
+    t->close (&ch);
+    return ok;
+}
+
+static long
+iterations (long bytes, size_t size, long max)
+{
+    long n = bytes / size;
+
+    if (n < MIN_ITERATIONS)
+        n = MIN_ITERATIONS;
+    return (n > max) ? max : n;
+}
+
+static void
+usage (const char *program)
+{
+    unsigned int i;
+
+    fprintf (stderr, "Usage: %s [-t transport,...] [-m max size] [-b MB per test] "
+             "[-c cpu,cpu | -n] [-o file.csv] \n", program);
+    fprintf (stderr, "  -t   transports to run (default all):");
+    for (i = 0; i < NUM_TRANSPORTS; i++)
+        fprintf (stderr, " %s", transports[i].name);
+    fprintf (stderr, "\n  -m   largest message size in bytes (default %d) \n", MAX_SIZE);
+    fprintf (stderr, "  -b   megabytes moved by each test, which sets the iterations (default 64) \n");
+    fprintf (stderr, "  -c   CPUs for the parent and the child (default the first two allowed) \n");
+    fprintf (stderr, "  -n   do not pin the processes to CPUs \n");
+    fprintf (stderr, "  -o   CSV output file, - for standard output (default ipc_bench.csv) \n");
+    exit (EXIT_FAILURE);
+}
+
+int
+main (int argc, char **argv)
+{
+    static struct result results[NUM_TRANSPORTS][NUM_SIZES];
+    static int valid[NUM_TRANSPORTS][NUM_SIZES];
+    int selected[NUM_TRANSPORTS];
+    const char *csv_file = "ipc_bench.csv", *name;
+    char label[64], *list = NULL, *buf;
+    long budget = 64L << 20, max_size = MAX_SIZE;
+    size_t size;
+    unsigned int t, s;
+    int opt, ok;
+    FILE *csv;
+
+    while ((opt = getopt (argc, argv, "t:m:b:c:no:")) != -1){
+        switch (opt){
+            case 't':
+                list = optarg;
+                break;
+
+            case 'm':
+                max_size = atol (optarg);
+                break;
+
+            case 'b':
+                budget = atol (optarg) << 20;
+                break;
+
+            case 'c':
+                if (sscanf (optarg, "%d,%d", &cpus[0], &cpus[1]) != 2)
+                    usage (argv[0]);
+                break;
+
+            case 'n':
+                pin = 0;
+                break;
+
+            case 'o':
+                csv_file = optarg;
+                break;
+
+            default:
+                usage (argv[0]);
+        }
+    }
+    if (max_size < (long)sizes[0] || max_size > MAX_SIZE || budget <= 0)
+        usage (argv[0]);
+
+    for (t = 0; t < NUM_TRANSPORTS; t++)
+        selected[t] = (list == NULL);
+    for (name = list ? strtok (list, ",") : NULL; name != NULL; name = strtok (NULL, ",")){
+        for (t = 0; t < NUM_TRANSPORTS; t++)
+            if (strcmp (name, transports[t].name) == 0)
+                break;
+        if (t == NUM_TRANSPORTS)
+            usage (argv[0]);
+        selected[t] = 1;
+    }
+
+    csv = (strcmp (csv_file, "-") == 0) ? stdout : fopen (csv_file, "w");
+    if (csv == NULL)
+        die ("fopen");
+    fprintf (csv, "transport,size,round_trips,rtt_p50_us,rtt_p99_us,one_way_us,"
+             "messages,msgs_per_sec,mb_per_sec\n");
+
+    buf = malloc (MAX_SIZE);
+    if (buf == NULL)
+        die ("malloc");
+    memset (buf, 0x5a, MAX_SIZE);
+
+    choose_cpus ();
+    pin_to (cpus[0]);
+    signal (SIGALRM, timeout_handler);
+    signal (SIGPIPE, SIG_IGN);
+
+    for (t = 0; t < NUM_TRANSPORTS; t++){
+        if (!selected[t])
+            continue;
+        for (s = 0; s < NUM_SIZES && (size = sizes[s]) <= (size_t)max_size; s++){
+            struct result *res = &results[t][s];
+
+            snprintf (label, sizeof (label), "%s %zu bytes", transports[t].name, size);
+            test_name = label;
+            if (isatty (STDERR_FILENO))
+                fprintf (stderr, "%-32s\r", label);
+
+            alarm (TEST_TIMEOUT);
+            ok = run_latency (&transports[t], size, iterations (budget / 4, size, MAX_ROUND_TRIPS), buf, res)
+                 && run_throughput (&transports[t], size, iterations (budget, size, MAX_MESSAGES), buf, res);
+            alarm (0);
+            if (!ok){
+                fprintf (stderr, "%s: child failed \n", label);
+                continue;
+            }
+
+            valid[t][s] = 1;
+            fprintf (csv, "%s,%zu,%ld,%.3f,%.3f,%.3f,%ld,%.0f,%.1f\n", transports[t].name, size,
+                     res->round_trips, res->rtt_p50, res->rtt_p99, res->rtt_p50 / 2,
+                     res->messages, res->msgs_per_sec, res->mb_per_sec);
+            fflush (csv);
+        }
+    }
+    if (isatty (STDERR_FILENO))
+        fprintf (stderr, "%-32s\r", "");
+    if (csv != stdout){
+        fclose (csv);
+        printf ("Results written to %s \n", csv_file);
+    }
+
+    if (pin)
+        printf ("\nParent on CPU %d, child on CPU %d%s \n", cpus[0], cpus[1],
+                cpus[0] == cpus[1] ? " (only one CPU available)" : "");
+
+    /* Summary: one-way latency and throughput, a row per transport */
+    for (opt = 0; opt < 2; opt++){
+        printf ("\n%s \n%-12s", opt == 0 ? "One-way latency, median (us)" : "Throughput (MB/s)", "");
+        for (s = 0; s < NUM_SIZES && (size = sizes[s]) <= (size_t)max_size; s++){
+            if (size >= (1 << 20))
+                snprintf (label, sizeof (label), "%zuM", size >> 20);
+            else if (size >= 1024)
+                snprintf (label, sizeof (label), "%zuK", size >> 10);
+            else
+                snprintf (label, sizeof (label), "%zu", size);
+            printf (" %9s", label);
+        }
+        printf ("\n");
+        for (t = 0; t < NUM_TRANSPORTS; t++){
+            if (!selected[t])
+                continue;
+            printf ("%-12s", transports[t].name);
+            for (s = 0; s < NUM_SIZES && (size = sizes[s]) <= (size_t)max_size; s++){
+                if (!valid[t][s])
+                    printf (" %9s", "-");
+                else if (opt == 0)
+                    printf (" %9.2f", results[t][s].rtt_p50 / 2);
+                else
+                    printf (" %9.1f", results[t][s].mb_per_sec);
+            }
+            printf ("\n");
+        }
+    }
+
+    free (buf);
+    exit (EXIT_SUCCESS);
+}
@@ -0,0 +1,253 @@
+/* Implementation of the shared memory arena described in shm_arena.h.
+ *
+ * Layout of the arena:
+ *
+ *   struct shm_arena            -- size, break offset, free list heads
+ *   chunks of blocks            -- each block is a struct block_header followed by
+ *                                  the object; blocks of one chunk share a class
+ *
+ * All the state lives inside the shared region itself, so the shm_arena_t pointer
+ * handed out to the caller is simply the start of the mapping.
+ *
+ * Date created: October 19, 2026
+ *
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include "shm_arena.h"
+
+#define NUM_CLASSES 17                  /* ARENA_MIN_ALLOC << 16 == ARENA_MAX_ALLOC */
+#define BLOCK_MAGIC 0x424c4b21U         /* "BLK!" */
+#define HUGE_PAGE_SIZE (2UL << 20)
+#define CACHE_LINE 64
+
+/* A list head packs the offset of the first block, in units of 16 bytes, into the
+ * low 40 bits and a version tag that is bumped on every update into the high 24. */
+#define OFF_BITS 40
+#define OFF_MASK ((1ULL << OFF_BITS) - 1)
+#define HEAD_OFF(head) (((head) & OFF_MASK) << 4)
+#define HEAD_TAG(head) ((head) >> OFF_BITS)
+#define MAKE_HEAD(off, tag) (((uint64_t)(off) >> 4) | ((uint64_t)(tag) << OFF_BITS))
+
+struct block_header {
+    uint32_t size_class;
+    uint32_t magic;
+    uint64_t next;                      /* Link while on a free list or a stack */
+};
+
+struct shm_arena {
+    uint64_t size;
+    int hugepages;
+    uint64_t brk __attribute__ ((aligned (CACHE_LINE)));   /* Start of the untouched memory */
+    uint64_t free_list[NUM_CLASSES] __attribute__ ((aligned (CACHE_LINE)));
+};
+
+#define BLOCK(arena, off) ((struct block_header *)((char *)(arena) + (off)))
+#define BLOCK_SIZE(cls) (sizeof (struct block_header) + ((size_t)ARENA_MIN_ALLOC << (cls)))
+
+/* Push the chain of blocks first .. last onto a list. */
+static void
+list_push (shm_arena_t *arena, uint64_t *head, uint64_t first, uint64_t last)
+{
+    uint64_t old, new;
+
+    old = __atomic_load_n (head, __ATOMIC_RELAXED);
+    do {
+        __atomic_store_n (&BLOCK (arena, last)->next, HEAD_OFF (old), __ATOMIC_RELAXED);
+        new = MAKE_HEAD (first, HEAD_TAG (old) + 1);
+    } while (!__atomic_compare_exchange_n (head, &old, new, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
+/* Pop the first block off a list. The block we read the link from may be popped
+ * and reused by another process before our compare-and-swap; the link is then
+ * garbage, but the tag will have changed and the swap fails. */
+static uint64_t
+list_pop (shm_arena_t *arena, uint64_t *head)
+{
+    uint64_t old, new, off, next;
+
+    old = __atomic_load_n (head, __ATOMIC_ACQUIRE);
+    do {
+        off = HEAD_OFF (old);
+        if (off == 0)
+            return 0;
+        next = __atomic_load_n (&BLOCK (arena, off)->next, __ATOMIC_RELAXED);
+        new = MAKE_HEAD (next, HEAD_TAG (old) + 1);
+    } while (!__atomic_compare_exchange_n (head, &old, new, 1, __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE));
+
+    return off;
+}
+
+static int
+size_class (size_t size)
+{
+    int cls = 0;
+
+    while (((size_t)ARENA_MIN_ALLOC << cls) < size)
+        cls++;
+    return cls;
+}
+
+/* Carve a chunk of blocks of the given class off the untouched end of the arena.
+ * Returns one block and puts the rest on the free list of the class. */
+static uint64_t
+refill (shm_arena_t *arena, int cls)
+{
+    size_t block = BLOCK_SIZE (cls);
+    uint64_t start, n, i, off;
+
+    start = __atomic_load_n (&arena->brk, __ATOMIC_RELAXED);
+    do {
+        n = ARENA_CHUNK_SIZE / block;
+        if (n == 0)
+            n = 1;
+        if (start + n * block > arena->size)
+            n = (arena->size - start) / block;
+        if (n == 0)
+            return 0;
+    } while (!__atomic_compare_exchange_n (&arena->brk, &start, start + n * block, 1,
+                                           __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    for (i = 0, off = start; i < n; i++, off += block){
+        BLOCK (arena, off)->size_class = cls;
+        BLOCK (arena, off)->magic = BLOCK_MAGIC;
+        BLOCK (arena, off)->next = off + block;
+    }
+    if (n > 1)
+        list_push (arena, &arena->free_list[cls], start + block, start + (n - 1) * block);
+
+    return start;
+}
+
+shm_arena_t *
+arena_create (size_t size, int flags)
+{
+    shm_arena_t *arena = MAP_FAILED;
+    size_t page = sysconf (_SC_PAGESIZE);
+    int hugepages = 0;
+
+    if (flags & ARENA_HUGEPAGES){
+        /* Explicit huge pages have to be reserved by the administrator (see
+         * /proc/sys/vm/nr_hugepages); fall back to transparent huge pages. */
+        size = (size + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+        arena = mmap (NULL, size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        hugepages = (arena != MAP_FAILED);
+    }
+    if (arena == MAP_FAILED){
+        size = (size + page - 1) & ~(page - 1);
+        arena = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (arena == MAP_FAILED)
+            return NULL;
+        if (flags & ARENA_HUGEPAGES)
+            madvise (arena, size, MADV_HUGEPAGE);
+    }
+
+    if (size > (OFF_MASK << 4)){
+        munmap (arena, size);
+        errno = EINVAL;
+        return NULL;
+    }
+
+    /* The mapping is zero-filled, so the free lists start out empty */
+    arena->size = size;
+    arena->hugepages = hugepages;
+    arena->brk = (sizeof (struct shm_arena) + CACHE_LINE - 1) & ~(uint64_t)(CACHE_LINE - 1);
+    return arena;
+}
+
+void
+arena_destroy (shm_arena_t *arena)
+{
+    munmap (arena, arena->size);
+}
+
+arena_off_t
+arena_alloc (shm_arena_t *arena, size_t size)
+{
+    uint64_t off;
+    int cls;
+
+    if (size > ARENA_MAX_ALLOC){
+        errno = EINVAL;
+        return 0;
+    }
+
+    cls = size_class (size);
+    off = list_pop (arena, &arena->free_list[cls]);
+    if (off == 0)
+        off = refill (arena, cls);
+    if (off == 0){
+        errno = ENOMEM;
+        return 0;
+    }
+
+    return off + sizeof (struct block_header);
+}
+
+void
+arena_free (shm_arena_t *arena, arena_off_t off)
+{
+    struct block_header *block;
+
+    if (off == 0)
+        return;
+
+    off -= sizeof (struct block_header);
+    block = BLOCK (arena, off);
+    if (block->magic != BLOCK_MAGIC || block->size_class >= NUM_CLASSES){
+        fprintf (stderr, "arena_free: bad offset %lu \n", (unsigned long)off);
+        abort ();
+    }
+    list_push (arena, &arena->free_list[block->size_class], off, off);
+}
+
+size_t
+arena_usable_size (shm_arena_t *arena, arena_off_t off)
+{
+    return (size_t)ARENA_MIN_ALLOC << BLOCK (arena, off - sizeof (struct block_header))->size_class;
+}
+
+arena_off_t
+arena_stack_create (shm_arena_t *arena)
+{
+    arena_off_t off = arena_alloc (arena, sizeof (arena_stack_t));
+
+    if (off != 0)
+        ((arena_stack_t *)arena_ptr (arena, off))->head = 0;
+    return off;
+}
+
+void
+arena_stack_push (shm_arena_t *arena, arena_stack_t *stack, arena_off_t off)
+{
+    off -= sizeof (struct block_header);
+    list_push (arena, &stack->head, off, off);
+}
+
+arena_off_t
+arena_stack_pop (shm_arena_t *arena, arena_stack_t *stack)
+{
+    uint64_t off = list_pop (arena, &stack->head);
+
+    return off ? off + sizeof (struct block_header) : 0;
+}
+
+void
+arena_usage (shm_arena_t *arena, size_t *used, size_t *size)
+{
+    *used = __atomic_load_n (&arena->brk, __ATOMIC_RELAXED);
+    *size = arena->size;
+}
+
+int
+arena_hugepages (shm_arena_t *arena)
+{
+    return arena->hugepages;
+}
@@ -0,0 +1,87 @@
+/* Header file for the shared memory arena in shm_arena.c, used by shm_arena_demo.c
+ *
+ * shared_memory.c maps a fixed-size area from /dev/zero before calling fork ()
+ * so that parent and child can share an array. That works for data whose size is
+ * known up front, but processes that want to hand each other objects of varying
+ * size end up copying them through pipes instead.
+ *
+ * The arena is one large MAP_SHARED | MAP_ANONYMOUS region, created before the
+ * worker processes are forked, out of which any of the processes can allocate and
+ * free objects of up to ARENA_MAX_ALLOC bytes:
+ *
+ *   - Requests are rounded up to a power-of-two size class. Each class has its own
+ *     free list, a lock-free stack whose head carries a version tag so that a block
+ *     that is popped and pushed back in the meantime cannot fool the compare-and-
+ *     swap (the ABA problem).
+ *
+ *   - When a class runs dry, a chunk of fresh memory is cut off the end of the
+ *     arena with an atomic add and split into blocks of that class.
+ *
+ *   - Objects are named by their offset from the start of the arena rather than by
+ *     a pointer, so that they can be stored inside other shared objects and passed
+ *     between processes even if the arena is mapped at a different address.
+ *
+ * Freed memory goes back to the free list of its class and is never returned to
+ * the chunk pool, so the arena suits workloads whose mix of sizes is steady.
+ *
+ * Date created: October 19, 2026
+ *
+ */
+#ifndef _SHM_ARENA_H_
+#define _SHM_ARENA_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ARENA_MIN_ALLOC 16
+#define ARENA_MAX_ALLOC (1 << 20)
+#define ARENA_CHUNK_SIZE (64 * 1024)    /* Carved off at once when a class runs dry */
+
+/* Flags for arena_create () */
+#define ARENA_HUGEPAGES 0x1             /* Back the arena with huge pages if possible */
+
+typedef struct shm_arena shm_arena_t;
+typedef uint64_t arena_off_t;           /* Offset of an object; 0 is the null offset */
+
+/* A lock-free stack of objects that lives in the arena and can be shared by all
+ * processes. Used to hand objects from one process to another. */
+typedef struct arena_stack {
+    uint64_t head;
+} arena_stack_t;
+
+/* Create an arena of the given size. Must be called before fork () so that the
+ * children inherit the mapping. Returns NULL on failure. */
+shm_arena_t *arena_create (size_t size, int flags);
+
+/* Unmap the arena in the calling process. */
+void arena_destroy (shm_arena_t *arena);
+
+/* Allocate an object of the given size and return its offset, or 0 if the arena
+ * is out of memory or the size is larger than ARENA_MAX_ALLOC. */
+arena_off_t arena_alloc (shm_arena_t *arena, size_t size);
+
+/* Return an object to the arena. */
+void arena_free (shm_arena_t *arena, arena_off_t off);
+
+/* Translate between offsets and pointers in the calling process */
+#define arena_ptr(arena, off) ((off) ? (void *)((char *)(arena) + (off)) : NULL)
+#define arena_off(arena, ptr) ((ptr) ? (arena_off_t)((char *)(ptr) - (char *)(arena)) : 0)
+
+/* Usable size of an object, which may exceed the size that was asked for. */
+size_t arena_usable_size (shm_arena_t *arena, arena_off_t off);
+
+/* Allocate a stack inside the arena (offset 0 on failure). */
+arena_off_t arena_stack_create (shm_arena_t *arena);
+
+/* Push an allocated object onto a stack, or pop the most recently pushed one (0
+ * if the stack is empty). An object can be on only one stack at a time. */
+void arena_stack_push (shm_arena_t *arena, arena_stack_t *stack, arena_off_t off);
+arena_off_t arena_stack_pop (shm_arena_t *arena, arena_stack_t *stack);
+
+/* Bytes carved out of the arena so far, and its total size. */
+void arena_usage (shm_arena_t *arena, size_t *used, size_t *size);
+
+/* Non-zero if the arena ended up backed by MAP_HUGETLB pages. */
+int arena_hugepages (shm_arena_t *arena);
+
+#endif /* _SHM_ARENA_H_ */
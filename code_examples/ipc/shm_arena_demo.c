@@ -0,0 +1,212 @@
+/*
+Program shows worker processes handing variable-size objects to their parent through
+the shared memory arena in shm_arena.c, and compares this with sending the same
+objects through a pipe.
+
+The parent creates the arena and a shared stack before forking the workers. Each
+worker allocates objects of random size in the arena, fills them in, and pushes
+their offsets onto the stack. The parent pops them, checks their contents and frees
+them, so the memory goes straight back to the workers. Nothing is copied, and the
+only system calls are the parent's naps when the stack runs empty.
+
+In the pipe version the workers write each object into a pipe and the parent reads
+it back out, which costs two copies and two system calls per object. Objects are
+kept under PIPE_BUF bytes so that writes from several workers do not interleave.
+
+Usage: ./shm_arena_demo [workers] [objects per worker] [hugepages (0 or 1)]
+
+Date created: October 19, 2026
+
+Compile as follows:
+
+	gcc -o shm_arena_demo shm_arena_demo.c shm_arena.c -std=c99 -Wall -O2
+
+*/
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <limits.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "shm_arena.h"
+
+#define ARENA_SIZE (64 << 20)
+#define MAX_PAYLOAD (PIPE_BUF - sizeof (struct object))
+
+/* The objects exchanged between the workers and the parent */
+struct object {
+    pid_t pid;
+    uint32_t length;                    /* Bytes in payload */
+    uint32_t fill;                      /* Value of every payload byte */
+    char payload[];
+};
+
+static double
+now_seconds (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint32_t
+random_length (unsigned int *seed)
+{
+    return 16 + rand_r (seed) % (MAX_PAYLOAD - 16);
+}
+
+/* Fill in an object with length bytes of payload and return its total size */
+static size_t
+make_object (struct object *obj, uint32_t length, unsigned int *seed)
+{
+    obj->pid = getpid ();
+    obj->length = length;
+    obj->fill = rand_r (seed) & 0xff;
+    memset (obj->payload, obj->fill, length);
+    return sizeof (struct object) + length;
+}
+
+static int
+check_object (const struct object *obj)
+{
+    uint32_t i;
+
+    if (obj->length > MAX_PAYLOAD)
+        return 0;
+    for (i = 0; i < obj->length; i++)
+        if ((unsigned char)obj->payload[i] != obj->fill)
+            return 0;
+    return 1;
+}
+
+static void
+run_arena (int workers, long objects, int flags)
+{
+    shm_arena_t *arena;
+    arena_stack_t *stack;
+    struct object *obj;
+    arena_off_t off;
+    long received = 0, bad = 0;
+    size_t used, size, bytes = 0;
+    double start, elapsed;
+    int i;
+
+    arena = arena_create (ARENA_SIZE, flags);
+    if (arena == NULL){
+        perror ("arena_create");
+        exit (EXIT_FAILURE);
+    }
+    stack = (arena_stack_t *)arena_ptr (arena, arena_stack_create (arena));
+
+    start = now_seconds ();
+    for (i = 0; i < workers; i++){
+        if (fork () == 0){
+            unsigned int seed = getpid ();
+            uint32_t length;
+            long n;
+
+            for (n = 0; n < objects; n++){
+                /* Wait for the parent to free some objects if the arena is full */
+                length = random_length (&seed);
+                while ((off = arena_alloc (arena, sizeof (struct object) + length)) == 0)
+                    usleep (100);
+                make_object ((struct object *)arena_ptr (arena, off), length, &seed);
+                arena_stack_push (arena, stack, off);
+            }
+            _exit (EXIT_SUCCESS);
+        }
+    }
+
+    while (received < workers * objects){
+        off = arena_stack_pop (arena, stack);
+        if (off == 0){
+            usleep (10);
+            continue;
+        }
+        obj = (struct object *)arena_ptr (arena, off);
+        if (!check_object (obj))
+            bad++;
+        bytes += obj->length;
+        received++;
+        arena_free (arena, off);
+    }
+    elapsed = now_seconds () - start;
+    while (wait (NULL) > 0);
+
+    arena_usage (arena, &used, &size);
+    printf ("arena: %ld objects, %.0f objects/s, %.1f MB/s, %ld corrupt, %zu KB of %zu KB carved%s \n",
+            received, received / elapsed, bytes / elapsed / 1e6, bad, used >> 10, size >> 10,
+            arena_hugepages (arena) ? ", huge pages" : "");
+    arena_destroy (arena);
+}
+
+static void
+run_pipe (int workers, long objects)
+{
+    char buf[PIPE_BUF];
+    struct object *obj = (struct object *)buf;
+    long received = 0, bad = 0;
+    size_t bytes = 0;
+    double start, elapsed;
+    int fd[2], i;
+
+    if (pipe (fd) == -1){
+        perror ("pipe");
+        exit (EXIT_FAILURE);
+    }
+
+    start = now_seconds ();
+    for (i = 0; i < workers; i++){
+        if (fork () == 0){
+            unsigned int seed = getpid ();
+            long n;
+
+            close (fd[0]);
+            for (n = 0; n < objects; n++)
+                write (fd[1], buf, make_object (obj, random_length (&seed), &seed));
+            _exit (EXIT_SUCCESS);
+        }
+    }
+    close (fd[1]);
+
+    /* Read the fixed-size part first to learn the length of the payload */
+    while (received < workers * objects){
+        if (read (fd[0], buf, sizeof (struct object)) != sizeof (struct object)
+            || obj->length > MAX_PAYLOAD
+            || read (fd[0], obj->payload, obj->length) != obj->length)
+            break;
+        if (!check_object (obj))
+            bad++;
+        bytes += obj->length;
+        received++;
+    }
+    elapsed = now_seconds () - start;
+    close (fd[0]);
+    while (wait (NULL) > 0);
+
+    printf ("pipe:  %ld objects, %.0f objects/s, %.1f MB/s, %ld corrupt \n",
+            received, received / elapsed, bytes / elapsed / 1e6, bad);
+}
+
+int
+main (int argc, char **argv)
+{
+    int workers = (argc > 1) ? atoi (argv[1]) : 4;
+    long objects = (argc > 2) ? atol (argv[2]) : 100000;
+    int flags = (argc > 3 && atoi (argv[3])) ? ARENA_HUGEPAGES : 0;
+
+    if (workers <= 0 || objects <= 0){
+        printf ("Usage: %s [workers] [objects per worker] [hugepages (0 or 1)] \n", argv[0]);
+        exit (EXIT_FAILURE);
+    }
+
+    run_arena (workers, objects, flags);
+    run_pipe (workers, objects);
+    exit (EXIT_SUCCESS);
+}
@@ -0,0 +1,215 @@
+/* Benchmark that sends messages of 64 bytes to 8 KB from a parent to a child
+ * process over a POSIX message queue, a batching message queue (see mq_stream.h),
+ * a pipe and a UNIX domain datagram socket, and reports messages per second and
+ * MB/s for each.
+ *
+ * The plain queue is limited to msg_max messages in flight (10 by default), so the
+ * two processes take turns much of the time. Batching packs as many messages as fit
+ * into mq_msgsize bytes into each mq_send (), and is skipped for the sizes where two
+ * messages do not fit. The pipe carries a byte stream, so the child reads fixed-size
+ * messages back out of it; the datagram socket keeps message boundaries as the queue
+ * does.
+ *
+ * Usage: ./mq_bench [messages per size]
+ *
+ * Date created: October 19, 2026
+ *
+ * Compile as follows: gcc -o mq_bench mq_bench.c mq_stream.c -std=c99 -Wall -O2 -lrt
+ */
+
+#define _GNU_SOURCE
+
+#include <mqueue.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <errno.h>
+#include "mq_stream.h"
+
+#define MQ_NAME "/mq_bench"
+#define MAX_MSG_SIZE 8192
+
+static const size_t sizes[] = { 64, 256, 1024, 4096, 8192 };
+
+static double
+now_seconds (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+die (const char *what)
+{
+    perror (what);
+    exit (EXIT_FAILURE);
+}
+
+static int
+count_record (const char *data, size_t length, unsigned int priority, void *arg)
+{
+    (*(long *)arg)++;
+    return 0;
+}
+
+/* Child side: receive count messages and exit with 0 if they all arrived */
+static void
+receive_mq (long count, int packed)
+{
+    mqd_t mqd = mq_open (MQ_NAME, O_RDONLY);
+    long msgsize = mqs_msgsize (mqd);
+    char *buf = malloc (msgsize);
+    long received = 0;
+    unsigned int priority;
+    ssize_t n;
+    int stopped;
+
+    while (received < count){
+        n = mq_receive (mqd, buf, msgsize, &priority);
+        if (n <= 0)
+            _exit (EXIT_FAILURE);
+        if (packed)
+            mqs_unpack (buf, n, priority, count_record, &received, &stopped);
+        else
+            received++;
+    }
+    _exit (EXIT_SUCCESS);
+}
+
+static void
+receive_fd (int fd, long count, size_t size)
+{
+    char buf[MAX_MSG_SIZE];
+    long received;
+    size_t got;
+    ssize_t n;
+
+    for (received = 0; received < count; received++){
+        /* A datagram arrives whole; a pipe may hand over part of a message */
+        for (got = 0; got < size; got += n){
+            n = read (fd, buf + got, size - got);
+            if (n <= 0)
+                _exit (EXIT_FAILURE);
+        }
+    }
+    _exit (EXIT_SUCCESS);
+}
+
+static int
+wait_child (pid_t pid)
+{
+    int status;
+
+    waitpid (pid, &status, 0);
+    return WIFEXITED (status) && WEXITSTATUS (status) == EXIT_SUCCESS;
+}
+
+static double
+run_mq (long count, size_t size, int packed)
+{
+    static char msg[MAX_MSG_SIZE];
+    mq_batcher_t batcher;
+    mqd_t mqd;
+    pid_t pid;
+    double start;
+    long i;
+
+    mq_unlink (MQ_NAME);
+    mqd = mqs_open (MQ_NAME, O_WRONLY | O_CREAT | O_EXCL, 0, MAX_MSG_SIZE);
+    if (mqd == (mqd_t)-1)
+        die ("mq_open");
+    if (packed && mqs_batcher_init (&batcher, mqd, UINT_MAX) == -1)
+        die ("mqs_batcher_init");
+
+    start = now_seconds ();
+    if ((pid = fork ()) == 0)
+        receive_mq (count, packed);
+
+    for (i = 0; i < count; i++){
+        if (packed){
+            if (mqs_batch_add (&batcher, msg, size, 0) == -1)
+                die ("mq_send");
+        }
+        else if (mq_send (mqd, msg, size, 0) == -1)
+            die ("mq_send");
+    }
+    if (packed){
+        if (mqs_batch_flush (&batcher) == -1)
+            die ("mq_send");
+        mqs_batcher_free (&batcher);
+    }
+
+    if (!wait_child (pid))
+        fprintf (stderr, "mq: receiver failed \n");
+    start = now_seconds () - start;
+    mq_close (mqd);
+    mq_unlink (MQ_NAME);
+    return start;
+}
+
+static double
+run_fd (long count, size_t size, int use_socket)
+{
+    static char msg[MAX_MSG_SIZE];
+    int fd[2];
+    pid_t pid;
+    double start;
+    long i;
+
+    if (use_socket ? socketpair (AF_UNIX, SOCK_DGRAM, 0, fd) : pipe (fd))
+        die (use_socket ? "socketpair" : "pipe");
+
+    start = now_seconds ();
+    if ((pid = fork ()) == 0){
+        close (fd[1]);
+        receive_fd (fd[0], count, size);
+    }
+    close (fd[0]);
+
+    for (i = 0; i < count; i++)
+        if (write (fd[1], msg, size) != size)
+            die ("write");
+    close (fd[1]);
+
+    if (!wait_child (pid))
+        fprintf (stderr, "%s: receiver failed \n", use_socket ? "socket" : "pipe");
+    return now_seconds () - start;
+}
+
+static void
+report (const char *name, long count, size_t size, double elapsed)
+{
+    printf ("%-12s %6zu %12.0f %10.1f \n", name, size, count / elapsed, count * size / elapsed / 1e6);
+}
+
+int
+main (int argc, char **argv)
+{
+    long count = (argc > 1) ? atol (argv[1]) : 200000;
+    unsigned int i;
+
+    if (count <= 0){
+        printf ("Usage: %s [messages per size] \n", argv[0]);
+        exit (EXIT_FAILURE);
+    }
+
+    printf ("%-12s %6s %12s %10s \n", "transport", "bytes", "msgs/s", "MB/s");
+    for (i = 0; i < sizeof (sizes) / sizeof (sizes[0]); i++){
+        report ("mq", count, sizes[i], run_mq (count, sizes[i], 0));
+        if (2 * (MQS_RECORD_HEADER + sizes[i]) <= MAX_MSG_SIZE)
+            report ("mq batched", count, sizes[i], run_mq (count, sizes[i], 1));
+        report ("pipe", count, sizes[i], run_fd (count, sizes[i], 0));
+        report ("unix dgram", count, sizes[i], run_fd (count, sizes[i], 1));
+    }
+    exit (EXIT_SUCCESS);
+}
@@ -0,0 +1,218 @@
+/* Implementation of the message queue helpers described in mq_stream.h.
+ *
+ * Date created: October 19, 2026
+ *
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "mq_stream.h"
+
+/* An absolute timeout that has long passed. mq_timedreceive () does not look at
+ * the timeout when a message is waiting, and fails at once with ETIMEDOUT when
+ * none is, which makes it a non-blocking receive that needs no mq_setattr (). */
+static const struct timespec expired = { 0, 0 };
+
+static long
+read_limit (const char *file, long fallback)
+{
+    FILE *fp = fopen (file, "r");
+    long value;
+
+    if (fp == NULL)
+        return fallback;
+    if (fscanf (fp, "%ld", &value) != 1)
+        value = fallback;
+    fclose (fp);
+    return value;
+}
+
+mqd_t
+mqs_open (const char *name, int flags, long maxmsg, long msgsize)
+{
+    struct mq_attr attr;
+    mqd_t mqd;
+
+    if (!(flags & O_CREAT))
+        return mq_open (name, flags);
+
+    memset (&attr, 0, sizeof (attr));
+    attr.mq_maxmsg = maxmsg ? maxmsg : read_limit ("/proc/sys/fs/mqueue/msg_max", 10);
+    attr.mq_msgsize = msgsize ? msgsize : read_limit ("/proc/sys/fs/mqueue/msgsize_max", 8192);
+    mqd = mq_open (name, flags, S_IRUSR | S_IWUSR, &attr);
+
+    /* Asked for more than the system allows; settle for its defaults */
+    if (mqd == (mqd_t)-1 && errno == EINVAL)
+        mqd = mq_open (name, flags, S_IRUSR | S_IWUSR, NULL);
+    return mqd;
+}
+
+long
+mqs_msgsize (mqd_t mqd)
+{
+    struct mq_attr attr;
+
+    if (mq_getattr (mqd, &attr) == -1)
+        return -1;
+    return attr.mq_msgsize;
+}
+
+int
+mqs_send_many (mqd_t mqd, const char **data, const size_t *length,
+               const unsigned int *priority, int count)
+{
+    int i;
+
+    for (i = 0; i < count; i++){
+        if (mq_send (mqd, data[i], length[i], priority ? priority[i] : 0) == -1){
+            if (errno == EINTR){
+                i--;
+                continue;
+            }
+            if (errno == EAGAIN)
+                break;
+            return -1;
+        }
+    }
+    return i;
+}
+
+int
+mqs_send_end (mqd_t mqd)
+{
+    return mq_send (mqd, "", 0, 0);
+}
+
+long
+mqs_unpack (const char *msg, size_t length, unsigned int priority,
+            mqs_record_fn fn, void *arg, int *stopped)
+{
+    const char *p = msg, *end = msg + length;
+    uint16_t len;
+    long records = 0;
+
+    while (p < end){
+        if ((size_t)(end - p) < MQS_RECORD_HEADER)
+            return -1;
+        memcpy (&len, p, sizeof (len));
+        p += MQS_RECORD_HEADER;
+        if ((size_t)(end - p) < len)
+            return -1;
+        records++;
+        if (fn (p, len, priority, arg)){
+            *stopped = 1;
+            break;
+        }
+        p += len;
+    }
+    return records;
+}
+
+long
+mqs_drain (mqd_t mqd, char *buf, size_t msgsize, int packed,
+           mqs_record_fn fn, void *arg, int *stopped)
+{
+    unsigned int priority;
+    ssize_t n;
+    long records = 0, r;
+
+    *stopped = 0;
+    while (!*stopped){
+        n = mq_timedreceive (mqd, buf, msgsize, &priority, &expired);
+        if (n == -1){
+            if (errno == EINTR)
+                continue;
+            if (errno == ETIMEDOUT || errno == EAGAIN)
+                break;
+            return -1;
+        }
+        if (n == 0){
+            *stopped = 1;
+            break;
+        }
+        if (packed){
+            r = mqs_unpack (buf, n, priority, fn, arg, stopped);
+            if (r == -1){
+                errno = EBADMSG;
+                return -1;
+            }
+            records += r;
+        }
+        else {
+            records++;
+            if (fn (buf, n, priority, arg))
+                *stopped = 1;
+        }
+    }
+    return records;
+}
+
+int
+mqs_batcher_init (mq_batcher_t *batcher, mqd_t mqd, unsigned int urgent)
+{
+    long size = mqs_msgsize (mqd);
+
+    memset (batcher, 0, sizeof (*batcher));
+    if (size == -1)
+        return -1;
+    batcher->mqd = mqd;
+    batcher->size = size;
+    batcher->urgent = urgent;
+    batcher->buf = malloc (size);
+    return (batcher->buf == NULL) ? -1 : 0;
+}
+
+void
+mqs_batcher_free (mq_batcher_t *batcher)
+{
+    free (batcher->buf);
+    batcher->buf = NULL;
+}
+
+int
+mqs_batch_flush (mq_batcher_t *batcher)
+{
+    if (batcher->used == 0)
+        return 0;
+
+    while (mq_send (batcher->mqd, batcher->buf, batcher->used, batcher->priority) == -1)
+        if (errno != EINTR)
+            return -1;
+    batcher->messages++;
+    batcher->used = 0;
+    return 0;
+}
+
+int
+mqs_batch_add (mq_batcher_t *batcher, const void *data, size_t length, unsigned int priority)
+{
+    uint16_t len = length;
+
+    if (length > UINT16_MAX || MQS_RECORD_HEADER + length > batcher->size){
+        errno = EMSGSIZE;
+        return -1;
+    }
+
+    /* A batch carries records of a single priority, so that no record is received
+     * ahead of or behind where the queue's priority order would put it */
+    if (batcher->used > 0 && (priority != batcher->priority
+                              || batcher->used + MQS_RECORD_HEADER + length > batcher->size))
+        if (mqs_batch_flush (batcher) == -1)
+            return -1;
+
+    memcpy (batcher->buf + batcher->used, &len, sizeof (len));
+    memcpy (batcher->buf + batcher->used + MQS_RECORD_HEADER, data, length);
+    batcher->used += MQS_RECORD_HEADER + length;
+    batcher->priority = priority;
+    batcher->records++;
+
+    if (priority >= batcher->urgent)
+        return mqs_batch_flush (batcher);
+    return 0;
+}
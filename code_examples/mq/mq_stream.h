@@ -0,0 +1,90 @@
+/* Header file for the message queue helpers in mq_stream.c, used by send_stream.c,
+ * recv_stream.c and mq_bench.c
+ *
+ * send_msg.c and recv_msg.c move a single message per process. The helpers here
+ * are for programs that keep a queue open and stream many messages through it:
+ *
+ *   - mqs_open () creates the queue with the largest attributes the system allows
+ *     (see /proc/sys/fs/mqueue) instead of fixed ones.
+ *
+ *   - mqs_drain () empties the queue without blocking, whether or not the queue was
+ *     opened with O_NONBLOCK, so that a consumer woken by mq_notify () or epoll can
+ *     take everything that has piled up at once.
+ *
+ *   - A batcher packs several small records of the same priority into one message,
+ *     so that a queue limited to a handful of messages (msg_max is 10 by default)
+ *     still holds thousands of records, and each mq_send () carries many of them.
+ *     Records at or above the batcher's urgent priority are never held back, and
+ *     a change of priority flushes the batch first, so the queue's priority order
+ *     is kept.
+ *
+ * A packed message is a sequence of records, each a 16-bit length followed by the
+ * data. An empty message marks the end of a stream.
+ *
+ * Date created: October 19, 2026
+ *
+ */
+#ifndef _MQ_STREAM_H_
+#define _MQ_STREAM_H_
+
+#include <mqueue.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define MQS_RECORD_HEADER sizeof (uint16_t)
+
+/* Called for every record received; a non-zero return stops the receiver. */
+typedef int (*mqs_record_fn) (const char *data, size_t length, unsigned int priority, void *arg);
+
+typedef struct mq_batcher {
+    mqd_t mqd;
+    char *buf;
+    size_t size;                        /* mq_msgsize of the queue */
+    size_t used;                        /* Bytes packed so far */
+    unsigned int priority;              /* Priority of the packed records */
+    unsigned int urgent;                /* Records at or above this go out at once */
+    unsigned long records;              /* Records added */
+    unsigned long messages;             /* Messages sent */
+} mq_batcher_t;
+
+/* Open a queue. With O_CREAT in flags, a maxmsg or msgsize of 0 picks the largest
+ * value allowed by the system. Returns (mqd_t)-1 on error. */
+mqd_t mqs_open (const char *name, int flags, long maxmsg, long msgsize);
+
+/* The queue's maximum message size, or -1 on error. */
+long mqs_msgsize (mqd_t mqd);
+
+/* Send count messages of the given lengths and priorities. Returns the number sent,
+ * which is less than count only if the queue is non-blocking and full, or -1. */
+int mqs_send_many (mqd_t mqd, const char **data, const size_t *length,
+                   const unsigned int *priority, int count);
+
+/* Receive everything currently in the queue without waiting. Each message is
+ * handed to fn as it is, or split into its records if packed is non-zero. buf
+ * must hold msgsize bytes. Returns the number of records handed to fn, or -1;
+ * *stopped is set if fn asked to stop or the end-of-stream message arrived. */
+long mqs_drain (mqd_t mqd, char *buf, size_t msgsize, int packed,
+                mqs_record_fn fn, void *arg, int *stopped);
+
+/* Split a packed message into its records. Returns the number of records, or -1
+ * if the message is malformed; *stopped is set if fn asked to stop. */
+long mqs_unpack (const char *msg, size_t length, unsigned int priority,
+                 mqs_record_fn fn, void *arg, int *stopped);
+
+/* Set up a batcher for a queue opened for writing. Returns 0 or -1. */
+int mqs_batcher_init (mq_batcher_t *batcher, mqd_t mqd, unsigned int urgent);
+
+/* Add a record, sending the batch when it is full, when the priority changes, or
+ * when the record is urgent. Returns 0 or -1. */
+int mqs_batch_add (mq_batcher_t *batcher, const void *data, size_t length, unsigned int priority);
+
+/* Send whatever is packed. Returns 0 or -1. */
+int mqs_batch_flush (mq_batcher_t *batcher);
+
+void mqs_batcher_free (mq_batcher_t *batcher);
+
+/* Send the empty end-of-stream message at the lowest priority, so that it is
+ * received after everything sent before it. */
+int mqs_send_end (mqd_t mqd);
+
+#endif /* _MQ_STREAM_H_ */
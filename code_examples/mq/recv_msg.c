@@ -68,7 +68,7 @@ main (int argc, char **argv)
     }
 
     /* Allocate local buffer to store the received message from the MQ */
-    buffer = malloc (sizeof(attr.mq_msgsize));
+    buffer = malloc (attr.mq_msgsize);
     if (buffer == NULL){
         perror ("malloc");
         exit (EXIT_FAILURE);
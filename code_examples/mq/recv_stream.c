@@ -0,0 +1,252 @@
+/* Program receives the messages sent by send_stream.c and prints them, one per
+ * line with its priority, until the empty message that ends the stream arrives.
+ *
+ * Three ways of waiting for messages are shown:
+ *
+ *   (default)  mq_receive () blocks for each message in turn.
+ *
+ *   -e         The queue descriptor is added to an epoll set (on Linux an mqd_t is
+ *              a file descriptor). Each time epoll_wait () reports it readable, the
+ *              queue is drained without blocking.
+ *
+ *   -t         mq_notify () with SIGEV_THREAD starts a thread when a message lands
+ *              on the empty queue. The thread registers for the next notification
+ *              first and only then drains the queue, so that a message arriving
+ *              while it drains cannot be missed.
+ *
+ * In the last two modes a burst of messages is taken with one wakeup; the program
+ * reports how many wakeups there were. With -b, messages are unpacked into the
+ * lines batched by send_stream -b. With -q, lines are counted but not printed.
+ *
+ * Usage: ./recv_stream [-e | -t] [-b] [-q] mq-name
+ *
+ * Date created: October 19, 2026
+ *
+ * Compile as follows: gcc -o recv_stream recv_stream.c mq_stream.c -std=c99 -Wall -lrt -pthread
+ */
+
+#define _GNU_SOURCE
+
+#include <mqueue.h>
+#include <sys/stat.h>
+#include <sys/epoll.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <semaphore.h>
+#include <pthread.h>
+#include <errno.h>
+#include "mq_stream.h"
+
+mqd_t mqd;
+char *buffer;
+long msgsize;
+int packed = 0, quiet = 0;
+unsigned long records = 0, wakeups = 0;
+sem_t done;                             /* Posted by the notification thread at the end */
+pthread_mutex_t drain_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void
+usage_error (char *program_name)
+{
+    fprintf (stderr, "Usage: %s [-e | -t] [-b] [-q] mq-name \n", program_name);
+    fprintf (stderr, " -e           Wait with epoll and drain the queue \n");
+    fprintf (stderr, " -t           Wait with mq_notify (SIGEV_THREAD) and drain the queue \n");
+    fprintf (stderr, " -b           Messages are batches packed by send_stream -b \n");
+    fprintf (stderr, " -q           Count the lines without printing them \n");
+    exit (EXIT_FAILURE);
+}
+
+int
+print_record (const char *data, size_t length, unsigned int priority, void *arg)
+{
+    records++;
+    if (!quiet){
+        printf ("[%u] ", priority);
+        fwrite (data, 1, length, stdout);
+        putchar ('\n');
+    }
+    return 0;
+}
+
+/* Drain the queue; returns 1 once the end of the stream has been seen. A new
+ * notification thread may start while an earlier drain is still running, hence
+ * the lock. */
+int
+drain (void)
+{
+    int stopped;
+
+    pthread_mutex_lock (&drain_lock);
+    wakeups++;
+    if (mqs_drain (mqd, buffer, msgsize, packed, print_record, NULL, &stopped) == -1){
+        /* EBADMSG: a message that is not a batch (was it sent with -b?) */
+        perror (errno == EBADMSG ? "Malformed batch" : "mq_receive");
+        exit (EXIT_FAILURE);
+    }
+    pthread_mutex_unlock (&drain_lock);
+    return stopped;
+}
+
+void
+receive_blocking (void)
+{
+    unsigned int priority;
+    ssize_t n;
+    int stopped = 0;
+
+    while (!stopped){
+        n = mq_receive (mqd, buffer, msgsize, &priority);
+        if (n == -1){
+            if (errno == EINTR)
+                continue;
+            perror ("mq_receive");
+            exit (EXIT_FAILURE);
+        }
+        if (n == 0)
+            break;
+        if (packed){
+            if (mqs_unpack (buffer, n, priority, print_record, NULL, &stopped) == -1){
+                fprintf (stderr, "Malformed batch of %ld bytes (was it sent with -b?) \n", (long) n);
+                exit (EXIT_FAILURE);
+            }
+        }
+        else
+            print_record (buffer, n, priority, NULL);
+    }
+}
+
+void
+receive_epoll (void)
+{
+    struct epoll_event ev;
+    int epfd;
+
+    epfd = epoll_create1 (0);
+    if (epfd == -1){
+        perror ("epoll_create1");
+        exit (EXIT_FAILURE);
+    }
+    ev.events = EPOLLIN;
+    ev.data.fd = mqd;
+    if (epoll_ctl (epfd, EPOLL_CTL_ADD, mqd, &ev) == -1){
+        perror ("epoll_ctl");
+        exit (EXIT_FAILURE);
+    }
+
+    for (;;){
+        if (epoll_wait (epfd, &ev, 1, -1) == -1){
+            if (errno == EINTR)
+                continue;
+            perror ("epoll_wait");
+            exit (EXIT_FAILURE);
+        }
+        if (drain ())
+            break;
+    }
+    close (epfd);
+}
+
+void register_notification (void);
+
+void
+notify_thread (union sigval sv)
+{
+    register_notification ();
+    if (drain ())
+        sem_post (&done);
+}
+
+void
+register_notification (void)
+{
+    struct sigevent sev;
+
+    memset (&sev, 0, sizeof (sev));
+    sev.sigev_notify = SIGEV_THREAD;
+    sev.sigev_notify_function = notify_thread;
+    sev.sigev_notify_attributes = NULL;
+    if (mq_notify (mqd, &sev) == -1){
+        perror ("mq_notify");
+        exit (EXIT_FAILURE);
+    }
+}
+
+void
+receive_notify (void)
+{
+    sem_init (&done, 0, 0);
+
+    /* Messages already on the queue do not trigger a notification */
+    register_notification ();
+    if (drain ())
+        return;
+
+    while (sem_wait (&done) == -1 && errno == EINTR);
+}
+
+int
+main (int argc, char **argv)
+{
+    int opt, mode = 0;
+
+    while ((opt = getopt (argc, argv, "etbq")) != -1){
+        switch (opt){
+            case 'e':
+            case 't':
+                mode = opt;
+                break;
+
+            case 'b':
+                packed = 1;
+                break;
+
+            case 'q':
+                quiet = 1;
+                break;
+
+            default:
+                usage_error (argv[0]);
+        }
+    }
+
+    if (optind >= argc)
+        usage_error (argv[0]);
+
+    /* Open the MQ for O_RDONLY operation */
+    mqd = mq_open (argv[optind], O_RDONLY);
+    if (mqd == (mqd_t) -1){
+        perror ("mq_open");
+        exit (EXIT_FAILURE);
+    }
+
+    msgsize = mqs_msgsize (mqd);
+    buffer = malloc (msgsize);
+    if (msgsize == -1 || buffer == NULL){
+        perror ("malloc");
+        exit (EXIT_FAILURE);
+    }
+
+    switch (mode){
+        case 'e':
+            receive_epoll ();
+            break;
+
+        case 't':
+            receive_notify ();
+            break;
+
+        default:
+            receive_blocking ();
+    }
+
+    fflush (stdout);
+    if (mode)
+        fprintf (stderr, "Received %lu lines in %lu wakeups \n", records, wakeups);
+    else
+        fprintf (stderr, "Received %lu lines \n", records);
+    exit (EXIT_SUCCESS);
+}
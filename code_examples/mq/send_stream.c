@@ -0,0 +1,176 @@
+/* Program sends each line read from standard input as a message on a message
+ * queue, and ends the stream with an empty message when the input runs out.
+ * Unlike send_msg.c, the queue is opened once and any number of messages go
+ * through it.
+ *
+ * With -P, each line starts with its priority ("5 some text"). With -b, lines are
+ * packed into batches (see mq_stream.h): lines that arrive together with the same
+ * priority share one message, and lines with a priority of at least the -u value
+ * are sent on their own straight away. Use recv_stream -b to read them.
+ *
+ * Usage: ./send_stream [-n] [-c] [-b] [-P] [-p priority] [-u urgent] mq-name
+ *
+ * Date created: October 19, 2026
+ *
+ * Compile as follows: gcc -o send_stream send_stream.c mq_stream.c -std=c99 -Wall -lrt
+ */
+
+#define _GNU_SOURCE
+
+#include <mqueue.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include "mq_stream.h"
+
+#define BUF_SIZE 65536
+
+void
+usage_error (char *program_name)
+{
+    fprintf (stderr, "Usage: %s [-n] [-c] [-b] [-P] [-p priority] [-u urgent] mq-name \n", program_name);
+    fprintf (stderr, " -n           Use O_NOBLOCK flag \n");
+    fprintf (stderr, " -c           Create the queue with the largest attributes allowed \n");
+    fprintf (stderr, " -b           Pack lines into batches \n");
+    fprintf (stderr, " -P           Each line starts with its priority \n");
+    fprintf (stderr, " -p priority  Priority of every line (default 0) \n");
+    fprintf (stderr, " -u urgent    With -b, lines of this priority or more are not batched (default 1) \n");
+    exit (EXIT_FAILURE);
+}
+
+int batch = 0, line_priority = 0;
+unsigned int priority = 0;
+mqd_t mqd;
+mq_batcher_t batcher;
+unsigned long lines = 0;
+
+/* Send the line that ends at eol, where the newline was */
+void
+send_line (char *line, char *eol)
+{
+    unsigned int prio = priority;
+    char *text = line;
+    size_t length;
+
+    *eol = '\0';
+    if (line_priority)
+        prio = strtoul (line, &text, 10);
+    if (line_priority && *text == ' ')
+        text++;
+    length = eol - text;
+    if (length == 0)
+        return;
+
+    if ((batch ? mqs_batch_add (&batcher, text, length, prio)
+               : mq_send (mqd, text, length, prio)) == -1){
+        perror ("mq_send");
+        exit (EXIT_FAILURE);
+    }
+    lines++;
+}
+
+int
+main (int argc, char **argv)
+{
+    int flags, opt;
+    unsigned int urgent = 1;
+    char buffer[BUF_SIZE], *line, *newline, *end;
+    size_t pending = 0;
+    ssize_t n;
+
+    flags = O_WRONLY;
+    while ((opt = getopt (argc, argv, "ncbPp:u:")) != -1){
+        switch (opt){
+            case 'n':
+                flags |= O_NONBLOCK;
+                break;
+
+            case 'c':
+                flags |= O_CREAT;
+                break;
+
+            case 'b':
+                batch = 1;
+                break;
+
+            case 'P':
+                line_priority = 1;
+                break;
+
+            case 'p':
+                priority = atoi (optarg);
+                break;
+
+            case 'u':
+                urgent = atoi (optarg);
+                break;
+
+            default:
+                usage_error (argv[0]);
+        }
+    }
+
+    if (optind >= argc)
+        usage_error (argv[0]);
+
+    mqd = mqs_open (argv[optind], flags, 0, 0);
+    if (mqd == (mqd_t) -1){
+        perror ("mq_open");
+        exit (EXIT_FAILURE);
+    }
+    if (batch && mqs_batcher_init (&batcher, mqd, urgent) == -1){
+        perror ("mqs_batcher_init");
+        exit (EXIT_FAILURE);
+    }
+
+    /* Lines that arrive with the same read () are batched together; the batch goes
+     * out before the next read (), so nothing waits on input that may never come. */
+    while ((n = read (STDIN_FILENO, buffer + pending, BUF_SIZE - pending)) > 0){
+        end = buffer + pending + n;
+        line = buffer;
+        while ((newline = memchr (line, '\n', end - line)) != NULL){
+            send_line (line, newline);
+            line = newline + 1;
+        }
+
+        /* Keep the unfinished line for the next read */
+        pending = end - line;
+        if (pending == BUF_SIZE){
+            fprintf (stderr, "Line too long \n");
+            exit (EXIT_FAILURE);
+        }
+        memmove (buffer, line, pending);
+        if (batch && mqs_batch_flush (&batcher) == -1){
+            perror ("mq_send");
+            exit (EXIT_FAILURE);
+        }
+    }
+    if (n == -1){
+        perror ("read");
+        exit (EXIT_FAILURE);
+    }
+
+    /* A last line without a newline; pending < BUF_SIZE leaves room to end it */
+    if (pending > 0){
+        send_line (buffer, buffer + pending);
+        if (batch && mqs_batch_flush (&batcher) == -1){
+            perror ("mq_send");
+            exit (EXIT_FAILURE);
+        }
+    }
+
+    if (mqs_send_end (mqd) == -1){
+        perror ("mq_send");
+        exit (EXIT_FAILURE);
+    }
+
+    if (batch)
+        fprintf (stderr, "Sent %lu lines in %lu messages \n", lines, batcher.messages);
+    else
+        fprintf (stderr, "Sent %lu lines \n", lines);
+    exit (EXIT_SUCCESS);
+}
@@ -1,3 +1,17 @@
+/* Filter used by simple_co_process.c: reads two integers from standard input and
+ * writes their sum to standard output.
+ *
+ * With -f, the requests and replies are frames (see frame.h) rather than raw
+ * text, and add2 keeps answering requests until its input is closed.
+ *
+ * With -l, it is a co-process for the pool in coproc.c: each request is a line
+ * "seq number1 number2" and each reply a line "seq sum", and add2 keeps answering
+ * until its input is closed. It reads as many requests as the pipe holds at once
+ * and sends the replies to all of them with one write.
+ *
+ * Compile as follows: gcc -o add2 add2.c frame.c -std=c99 -Wall
+ */
+
 #include <stdio.h>
 #include <string.h>
 #include <sys/types.h>
@@ -5,11 +19,128 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <errno.h>
+#include "frame.h"
 
 #define BUF_SIZE 256
+#define LINE_BUF_SIZE 65536
+#define REPLY_MAX 64            /* Longest reply line */
 #define STDIN 0 
 #define STDOUT 1
 
+/* Answer each framed request with a framed reply holding the sum */
+static int
+serve_frames (void)
+{
+    frame_reader_t reader;
+    char request[BUF_SIZE], reply[BUF_SIZE];
+    uint16_t type;
+    void *payload;
+    size_t length;
+    int number1, number2;
+
+    if (frame_reader_init (&reader, STDIN_FILENO) == -1)
+        return -1;
+
+    while (frame_read (&reader, &type, &payload, &length) == 1){
+        if (length >= BUF_SIZE)
+            length = BUF_SIZE - 1;
+        memcpy (request, payload, length);
+        request[length] = '\0';
+
+        if (sscanf (request, "%d %d", &number1, &number2) == 2)
+            snprintf (reply, BUF_SIZE, "%d", number1 + number2);
+        else
+            snprintf (reply, BUF_SIZE, "invalid request");
+        if (frame_write (STDOUT_FILENO, type, reply, strlen (reply)) == -1)
+            break;
+    }
+
+    frame_reader_free (&reader);
+    return 0;
+}
+
+static int
+write_all (const char *buf, size_t len)
+{
+    ssize_t n;
+
+    while (len > 0){
+        n = write (STDOUT_FILENO, buf, len);
+        if (n == -1){
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        buf += n;
+        len -= n;
+    }
+    return 0;
+}
+
+/* Answer each request line "seq number1 number2" with a reply line "seq sum". The
+ * replies to every line that one read () brings in go out with one write (). */
+static int
+serve_lines (void)
+{
+    static char in[LINE_BUF_SIZE], out[LINE_BUF_SIZE];
+    char head[32], *line, *newline;
+    size_t start, end = 0, used = 0;
+    unsigned long seq;
+    int number1, number2, skipping = 0;
+    ssize_t n;
+
+    for (;;){
+        n = read (STDIN_FILENO, in + end, sizeof (in) - end);
+        if (n == -1 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        end += n;
+
+        for (start = 0; (newline = memchr (in + start, '\n', end - start)) != NULL; ){
+            *newline = '\0';
+            line = in + start;
+            start = newline + 1 - in;
+            if (skipping){              /* The end of a line that was too long */
+                skipping = 0;
+                continue;
+            }
+            if (used > sizeof (out) - REPLY_MAX){
+                if (write_all (out, used) == -1)
+                    return -1;
+                used = 0;
+            }
+            if (sscanf (line, "%lu %d %d", &seq, &number1, &number2) == 3)
+                used += snprintf (out + used, REPLY_MAX, "%lu %d\n", seq, number1 + number2);
+            else
+                used += snprintf (out + used, REPLY_MAX, "%lu invalid request\n",
+                                  strtoul (line, NULL, 10));
+        }
+
+        if (start == 0 && end == sizeof (in)){
+            /* A line longer than the buffer: answer it now and drop the rest of it */
+            if (!skipping){
+                memcpy (head, in, sizeof (head) - 1);
+                head[sizeof (head) - 1] = '\0';
+                used += snprintf (out + used, REPLY_MAX, "%lu invalid request\n",
+                                  strtoul (head, NULL, 10));
+                skipping = 1;
+            }
+            end = 0;
+        } else {
+            memmove (in, in + start, end - start);
+            end -= start;
+        }
+
+        if (used > 0){
+            if (write_all (out, used) == -1)
+                return -1;
+            used = 0;
+        }
+    }
+    return 0;
+}
+
 int 
 main (int argc, char **argv)
 {
@@ -17,6 +148,11 @@ main (int argc, char **argv)
     int number1, number2;
     int n;
 
+    if (argc > 1 && strcmp (argv[1], "-f") == 0)
+        exit (serve_frames () == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+    if (argc > 1 && strcmp (argv[1], "-l") == 0)
+        exit (serve_lines () == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+
     n = read (STDIN_FILENO, buffer, BUF_SIZE); /* Read n bytes from STDIN */
     buffer[n] = '\0'; /* Terminate the string */
     
@@ -0,0 +1,505 @@
+/* Implementation of the co-process pool described in coproc.h.
+ *
+ * Each co-process is a one-stage pipeline (see pipeline.h) that the caller feeds
+ * and captures; both of the caller's ends are non-blocking. A co-process has a
+ * table of window slots for its outstanding requests and a stack of the free
+ * ones. The sequence number of a request encodes its slot, as issued * window +
+ * slot, where issued counts the requests sent to that co-process, so a reply finds
+ * its slot with one division whatever order it comes back in, and a reply with a
+ * stale or unknown number is recognised and dropped.
+ *
+ * Date created: October 19, 2026
+ *
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include "pipeline.h"
+#include "coproc.h"
+
+#define WRITE_BUF_SIZE 65536
+#define READ_BUF_SIZE 65536
+#define SEQ_ROOM 24                     /* A sequence number, the space and the newline */
+
+struct slot {
+    unsigned long seq;
+    coproc_reply_fn fn;                 /* NULL while the slot is free */
+    void *arg;
+};
+
+struct coproc {
+    pipeline_t *p;
+    int in_fd, out_fd;                  /* Requests to it, replies from it; -1 once closed */
+    int eof;                            /* It has closed its output */
+
+    char *wbuf;
+    size_t wstart, wend;                /* Queued requests not yet written */
+    char *rbuf;
+    size_t rsize, rend;                 /* Start of a reply not yet complete */
+
+    struct slot *slots;
+    int *free_slots;
+    int nfree;
+    int outstanding;
+    unsigned long issued, replies;
+};
+
+struct coproc_pool {
+    struct coproc *procs;
+    int n;
+    int policy;
+    int window;
+    int next;                           /* Where the search for a co-process starts */
+    struct pollfd *fds;
+};
+
+static void
+release_slot (struct coproc *c, int i)
+{
+    c->slots[i].fn = NULL;
+    c->free_slots[c->nfree++] = i;
+    c->outstanding--;
+}
+
+static void
+close_input (struct coproc *c)
+{
+    pipeline_close_input (c->p);
+    c->in_fd = -1;
+    c->wstart = c->wend = 0;
+}
+
+/* The co-process has closed its output: fail whatever it has not answered */
+static void
+lose_proc (coproc_pool_t *pool, struct coproc *c)
+{
+    coproc_reply_fn fn;
+    void *arg;
+    int i;
+
+    c->eof = 1;
+    if (c->in_fd != -1)
+        close_input (c);
+    for (i = 0; i < pool->window; i++){
+        if ((fn = c->slots[i].fn) == NULL)
+            continue;
+        arg = c->slots[i].arg;
+        release_slot (c, i);
+        fn (NULL, 0, arg);
+    }
+}
+
+/* Write as much of the queue as the pipe takes without blocking */
+static int
+write_requests (coproc_pool_t *pool, struct coproc *c)
+{
+    ssize_t n;
+
+    while (c->wstart < c->wend){
+        n = write (c->in_fd, c->wbuf + c->wstart, c->wend - c->wstart);
+        if (n == -1){
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN)
+                return 0;
+            if (errno == EPIPE){
+                /* It has exited; its requests fail when its output reaches end of file */
+                close_input (c);
+                return 0;
+            }
+            return -1;
+        }
+        c->wstart += n;
+    }
+    c->wstart = c->wend = 0;
+    return 0;
+}
+
+/* Read the replies waiting in the pipe and hand them out. Returns the number
+ * handled, or -1 on error. */
+static int
+read_replies (coproc_pool_t *pool, struct coproc *c)
+{
+    char *line, *newline, *reply, *buf;
+    struct slot *s;
+    coproc_reply_fn fn;
+    void *arg;
+    unsigned long seq;
+    size_t start, room;
+    ssize_t n;
+    int handled = 0;
+
+    for (;;){
+        if (c->rend == c->rsize){
+            /* A reply longer than the buffer */
+            if ((buf = realloc (c->rbuf, 2 * c->rsize)) == NULL)
+                return -1;
+            c->rbuf = buf;
+            c->rsize *= 2;
+        }
+        room = c->rsize - c->rend;
+        n = read (c->out_fd, c->rbuf + c->rend, room);
+        if (n == -1){
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN)
+                return handled;
+            return -1;
+        }
+        if (n == 0){
+            lose_proc (pool, c);
+            return handled;
+        }
+        c->rend += n;
+
+        for (start = 0; (newline = memchr (c->rbuf + start, '\n', c->rend - start)) != NULL; ){
+            *newline = '\0';
+            line = c->rbuf + start;
+            start = newline + 1 - c->rbuf;
+
+            seq = strtoul (line, &reply, 10);
+            if (reply == line)
+                continue;
+            if (*reply == ' ')
+                reply++;
+            s = &c->slots[seq % pool->window];
+            if (s->fn == NULL || s->seq != seq)
+                continue;               /* Not a reply to anything outstanding */
+
+            fn = s->fn;
+            arg = s->arg;
+            release_slot (c, s - c->slots);
+            c->replies++;
+            handled++;
+            fn (reply, newline - reply, arg);
+        }
+        memmove (c->rbuf, c->rbuf + start, c->rend - start);
+        c->rend -= start;
+
+        /* A short read means the pipe is empty for now */
+        if ((size_t) n < room)
+            return handled;
+    }
+}
+
+/* Wait on one co-process, reading its replies meanwhile, until its queue has been
+ * written and, if full is set, it has room for another request */
+static int
+settle (coproc_pool_t *pool, struct coproc *c, int full)
+{
+    struct pollfd fds[2];
+
+    for (;;){
+        if (c->in_fd != -1 && write_requests (pool, c) == -1)
+            return -1;
+        if (c->in_fd == -1 || (c->wstart == c->wend && (!full || c->outstanding < pool->window)))
+            return 0;
+
+        fds[0].fd = c->eof ? -1 : c->out_fd;
+        fds[0].events = POLLIN;
+        fds[1].fd = c->in_fd;
+        fds[1].events = (c->wstart < c->wend) ? POLLOUT : 0;
+        if (poll (fds, 2, -1) == -1){
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        if (fds[0].revents != 0 && read_replies (pool, c) == -1)
+            return -1;
+    }
+}
+
+/* The co-process for the next request, by the pool's policy, or NULL if none is
+ * left to take it */
+static struct coproc *
+pick (coproc_pool_t *pool)
+{
+    struct coproc *c, *best = NULL;
+    int i, k;
+
+    for (k = 0; k < pool->n; k++){
+        i = (pool->next + k) % pool->n;
+        c = &pool->procs[i];
+        if (c->in_fd == -1)
+            continue;
+        if (pool->policy == COPROC_ROUND_ROBIN){
+            best = c;
+            break;
+        }
+        if (best == NULL || c->outstanding < best->outstanding)
+            best = c;
+    }
+    if (best != NULL)
+        pool->next = (best - pool->procs + 1) % pool->n;
+    return best;
+}
+
+static int
+start_proc (coproc_pool_t *pool, struct coproc *c, char *const argv[])
+{
+    int i;
+
+    c->wbuf = malloc (WRITE_BUF_SIZE);
+    c->rsize = READ_BUF_SIZE;
+    c->rbuf = malloc (c->rsize);
+    c->slots = calloc (pool->window, sizeof (*c->slots));
+    c->free_slots = malloc (pool->window * sizeof (int));
+    if (c->wbuf == NULL || c->rbuf == NULL || c->slots == NULL || c->free_slots == NULL)
+        return -1;
+    for (i = 0; i < pool->window; i++)
+        c->free_slots[i] = pool->window - 1 - i;
+    c->nfree = pool->window;
+
+    if ((c->p = pipeline_create (0)) == NULL)
+        return -1;
+    if (pipeline_add (c->p, argv) == -1)
+        return -1;
+    pipeline_feed (c->p);
+    pipeline_capture (c->p);
+    if (pipeline_start (c->p) == -1)
+        return -1;
+
+    /* The pipeline's pipes are made afresh for each co-process, and are
+     * close-on-exec, so no co-process holds another's input open */
+    c->in_fd = pipeline_input_fd (c->p);
+    c->out_fd = pipeline_output_fd (c->p);
+    if (fcntl (c->in_fd, F_SETFL, fcntl (c->in_fd, F_GETFL) | O_NONBLOCK) == -1
+        || fcntl (c->out_fd, F_SETFL, fcntl (c->out_fd, F_GETFL) | O_NONBLOCK) == -1)
+        return -1;
+    return 0;
+}
+
+coproc_pool_t *
+coproc_pool_create (char *const argv[], int n, int policy, int window)
+{
+    coproc_pool_t *pool;
+    int i, saved;
+
+    if (argv == NULL || argv[0] == NULL || n < 1
+        || (policy != COPROC_ROUND_ROBIN && policy != COPROC_LEAST_OUTSTANDING)){
+        errno = EINVAL;
+        return NULL;
+    }
+    if ((pool = calloc (1, sizeof (*pool))) == NULL)
+        return NULL;
+    pool->n = n;
+    pool->policy = policy;
+    pool->window = (window > 0) ? window : COPROC_DEFAULT_WINDOW;
+    pool->procs = calloc (n, sizeof (*pool->procs));
+    pool->fds = calloc (2 * n, sizeof (*pool->fds));
+    if (pool->procs == NULL || pool->fds == NULL){
+        free (pool->procs);
+        free (pool->fds);
+        free (pool);
+        return NULL;
+    }
+    for (i = 0; i < n; i++)
+        pool->procs[i].in_fd = pool->procs[i].out_fd = -1;
+
+    for (i = 0; i < n; i++)
+        if (start_proc (pool, &pool->procs[i], argv) == -1){
+            saved = errno;
+            coproc_pool_destroy (pool);
+            errno = saved;
+            return NULL;
+        }
+    return pool;
+}
+
+int
+coproc_call_async (coproc_pool_t *pool, const char *request, coproc_reply_fn fn, void *arg)
+{
+    size_t length = strlen (request);
+    struct coproc *c;
+    struct slot *s;
+    int i;
+
+    if (fn == NULL || strchr (request, '\n') != NULL){
+        errno = EINVAL;
+        return -1;
+    }
+    if (length + SEQ_ROOM > WRITE_BUF_SIZE){
+        errno = EMSGSIZE;
+        return -1;
+    }
+
+    /* Make room in the window and in the queue; the co-process may turn out to
+     * have exited meanwhile, in which case try another */
+    do {
+        if ((c = pick (pool)) == NULL){
+            errno = EPIPE;
+            return -1;
+        }
+        if (c->outstanding == pool->window && settle (pool, c, 1) == -1)
+            return -1;
+        if (c->wend + length + SEQ_ROOM > WRITE_BUF_SIZE && settle (pool, c, 0) == -1)
+            return -1;
+    } while (c->in_fd == -1);
+
+    i = c->free_slots[--c->nfree];
+    s = &c->slots[i];
+    s->seq = c->issued++ * pool->window + i;
+    s->fn = fn;
+    s->arg = arg;
+    c->outstanding++;
+
+    c->wend += sprintf (c->wbuf + c->wend, "%lu ", s->seq);
+    memcpy (c->wbuf + c->wend, request, length);
+    c->wend += length;
+    c->wbuf[c->wend++] = '\n';
+    return 0;
+}
+
+int
+coproc_outstanding (coproc_pool_t *pool)
+{
+    int i, total = 0;
+
+    for (i = 0; i < pool->n; i++)
+        total += pool->procs[i].outstanding;
+    return total;
+}
+
+int
+coproc_poll (coproc_pool_t *pool, int timeout_ms)
+{
+    struct pollfd *fds = pool->fds;
+    struct coproc *c;
+    int i, n, handled = 0;
+
+    for (i = 0; i < pool->n; i++){
+        c = &pool->procs[i];
+        if (c->in_fd != -1 && write_requests (pool, c) == -1)
+            return -1;
+        fds[2 * i].fd = (c->outstanding > 0 && !c->eof) ? c->out_fd : -1;
+        fds[2 * i].events = POLLIN;
+        fds[2 * i + 1].fd = (c->wstart < c->wend) ? c->in_fd : -1;
+        fds[2 * i + 1].events = POLLOUT;
+    }
+    if (coproc_outstanding (pool) == 0)
+        return 0;
+
+    if (poll (fds, 2 * pool->n, timeout_ms) == -1)
+        return (errno == EINTR) ? 0 : -1;
+
+    for (i = 0; i < pool->n; i++){
+        c = &pool->procs[i];
+        if (fds[2 * i].fd != -1 && fds[2 * i].revents != 0){
+            if ((n = read_replies (pool, c)) == -1)
+                return -1;
+            handled += n;
+        }
+        if (c->in_fd != -1 && fds[2 * i + 1].revents != 0 && write_requests (pool, c) == -1)
+            return -1;
+    }
+    return handled;
+}
+
+int
+coproc_drain (coproc_pool_t *pool)
+{
+    while (coproc_outstanding (pool) > 0)
+        if (coproc_poll (pool, -1) == -1)
+            return -1;
+    return 0;
+}
+
+struct result {
+    char *reply;
+    size_t size;
+    int done;
+    int lost;
+};
+
+static void
+store_reply (const char *reply, size_t length, void *arg)
+{
+    struct result *r = arg;
+
+    r->done = 1;
+    if (reply == NULL){
+        r->lost = 1;
+        return;
+    }
+    if (length >= r->size)
+        length = r->size - 1;
+    memcpy (r->reply, reply, length);
+    r->reply[length] = '\0';
+}
+
+int
+coproc_call (coproc_pool_t *pool, const char *request, char *reply, size_t size)
+{
+    struct result r = { reply, size, 0, 0 };
+
+    if (size == 0){
+        errno = EINVAL;
+        return -1;
+    }
+    if (coproc_call_async (pool, request, store_reply, &r) == -1)
+        return -1;
+    while (!r.done)
+        if (coproc_poll (pool, -1) == -1)
+            return -1;
+    if (r.lost){
+        errno = EPIPE;
+        return -1;
+    }
+    return 0;
+}
+
+unsigned long
+coproc_replies (coproc_pool_t *pool, int index)
+{
+    return (index >= 0 && index < pool->n) ? pool->procs[index].replies : 0;
+}
+
+void
+coproc_pool_destroy (coproc_pool_t *pool)
+{
+    struct pollfd fd;
+    struct coproc *c;
+    int i;
+
+    if (pool == NULL)
+        return;
+
+    /* Write what is queued and close every input first, so that the co-processes
+     * finish together, then collect the last replies from each until it exits */
+    for (i = 0; i < pool->n; i++){
+        c = &pool->procs[i];
+        if (c->in_fd == -1)
+            continue;
+        settle (pool, c, 0);
+        if (c->in_fd != -1)
+            close_input (c);
+    }
+    for (i = 0; i < pool->n; i++){
+        c = &pool->procs[i];
+        while (c->out_fd != -1 && !c->eof){
+            fd.fd = c->out_fd;
+            fd.events = POLLIN;
+            if (poll (&fd, 1, -1) == -1 && errno != EINTR)
+                break;
+            if (read_replies (pool, c) == -1)
+                break;
+        }
+        if (c->p != NULL){
+            pipeline_wait (c->p, NULL);
+            pipeline_destroy (c->p);
+        }
+        free (c->wbuf);
+        free (c->rbuf);
+        free (c->slots);
+        free (c->free_slots);
+    }
+    free (pool->procs);
+    free (pool->fds);
+    free (pool);
+}
@@ -0,0 +1,92 @@
+/* Header file for the co-process pool in coproc.c, used by coproc_rpc.c
+ *
+ * simple_co_process.c talks to one add2 over two pipes. A pool runs n copies of
+ * a filter as co-processes, each with a pipe to its standard input and one from
+ * its standard output, and lets the caller have many requests outstanding on
+ * each of them at once instead of waiting for every reply in turn.
+ *
+ * Requests and replies are lines of text that start with a sequence number:
+ *
+ *      request:  "<seq> <request>\n"
+ *      reply:    "<seq> <reply>\n"
+ *
+ * The co-process must answer each request with one line carrying the same number,
+ * in whatever order suits it; add2 -l does so. The pool matches each reply to its
+ * request by the number and hands it to the callback given with the request.
+ *
+ * Requests are queued in a buffer per co-process and written many at a time, when
+ * the buffer fills up or the caller waits for replies with coproc_poll () or
+ * coproc_drain (); replies are read as many at a time as the pipe holds. A
+ * co-process that reads its input the same way answers a whole batch of requests
+ * for a pair of system calls, where the lock-step round trip costs a pair of
+ * system calls and two context switches for every request.
+ *
+ * Each request goes to the next co-process in turn (COPROC_ROUND_ROBIN) or to the
+ * one with the fewest requests outstanding (COPROC_LEAST_OUTSTANDING), which keeps
+ * a slow co-process from holding up more than its share. A co-process takes at
+ * most window requests at a time; beyond that coproc_call_async () waits for it to
+ * answer some.
+ *
+ * The pool never blocks in write (): while a co-process is not reading its input,
+ * the pool reads its replies, so the two cannot end up each waiting for the other
+ * to empty a full pipe.
+ *
+ * Callbacks run inside coproc_call_async (), coproc_poll (), coproc_drain () and
+ * coproc_pool_destroy (), and must not call back into the pool. When a co-process
+ * exits, the requests it had not answered get a callback with a NULL reply. The
+ * caller should ignore SIGPIPE, so that writing to a co-process that has exited
+ * fails with EPIPE rather than killing the caller.
+ *
+ * Date created: October 19, 2026
+ *
+ */
+#ifndef _COPROC_H_
+#define _COPROC_H_
+
+#include <stddef.h>
+
+/* Dispatch policies */
+#define COPROC_ROUND_ROBIN 0
+#define COPROC_LEAST_OUTSTANDING 1
+
+#define COPROC_DEFAULT_WINDOW 1024      /* Requests outstanding per co-process */
+
+typedef struct coproc_pool coproc_pool_t;
+
+/* Called with the reply to a request, without its sequence number and newline and
+ * terminated with a null byte, or with NULL if the co-process exited first. The
+ * reply is valid only until the callback returns. */
+typedef void (*coproc_reply_fn) (const char *reply, size_t length, void *arg);
+
+/* Start n co-processes running argv[0] with execvp (). window <= 0 means
+ * COPROC_DEFAULT_WINDOW. Returns NULL with errno set on error. */
+coproc_pool_t *coproc_pool_create (char *const argv[], int n, int policy, int window);
+
+/* Queue a request, a string without a newline, for one of the co-processes; fn (arg)
+ * gets the reply. Returns 0, or -1 with errno set (EPIPE if every co-process has
+ * exited). */
+int coproc_call_async (coproc_pool_t *pool, const char *request, coproc_reply_fn fn, void *arg);
+
+/* Write the queued requests and wait up to timeout_ms (-1 for no limit) for
+ * replies, handing each to its callback. Returns the number of replies handled,
+ * or -1 with errno set. */
+int coproc_poll (coproc_pool_t *pool, int timeout_ms);
+
+/* Wait until every request has been answered. Returns 0, or -1 with errno set. */
+int coproc_drain (coproc_pool_t *pool);
+
+/* Send a request and wait for its reply, which is copied into reply (and cut short
+ * to fit size bytes). Returns 0, or -1 with errno set. */
+int coproc_call (coproc_pool_t *pool, const char *request, char *reply, size_t size);
+
+/* The number of requests not yet answered */
+int coproc_outstanding (coproc_pool_t *pool);
+
+/* The number of replies received from co-process index */
+unsigned long coproc_replies (coproc_pool_t *pool, int index);
+
+/* Close the co-processes' input, hand out the replies still to come, wait for the
+ * co-processes to exit, and free the pool */
+void coproc_pool_destroy (coproc_pool_t *pool);
+
+#endif /* _COPROC_H_ */
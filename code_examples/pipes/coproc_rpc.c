@@ -0,0 +1,155 @@
+/* Example program and benchmark for the co-process pool in coproc.c. It starts a
+ * pool of add2 co-processes in line mode (add2 -l) and asks them for the sums
+ * i + (i + 1), first in lock-step with coproc_call (), waiting for each reply
+ * before sending the next request, and then pipelined with coproc_call_async (),
+ * with up to a window of requests outstanding on each co-process. It checks every
+ * sum and prints the rate of each way, and how many replies each co-process sent
+ * in the pipelined run.
+ *
+ * Usage: ./coproc_rpc [-n co-processes] [-r requests] [-w window]
+ *                     [-l (dispatch to the least outstanding; round-robin otherwise)]
+ *
+ * Date created: October 19, 2026
+ *
+ * Compile as follows:
+ * gcc -o coproc_rpc coproc_rpc.c coproc.c pipeline.c -std=c99 -Wall -O2
+ * and compile add2.c as described there.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include "coproc.h"
+
+#define BUF_SIZE 64
+
+static long wrong = 0, lost = 0;
+
+static double
+now (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* The argument is the sum expected */
+static void
+check_sum (const char *reply, size_t length, void *arg)
+{
+    if (reply == NULL)
+        lost++;
+    else if (atol (reply) != (long)(intptr_t) arg)
+        wrong++;
+}
+
+static double
+lock_step (coproc_pool_t *pool, long requests)
+{
+    char request[BUF_SIZE], reply[BUF_SIZE];
+    double start = now ();
+    long i;
+
+    for (i = 0; i < requests; i++){
+        snprintf (request, BUF_SIZE, "%ld %ld", i, i + 1);
+        if (coproc_call (pool, request, reply, BUF_SIZE) == -1){
+            perror ("coproc_call");
+            exit (EXIT_FAILURE);
+        }
+        if (atol (reply) != 2 * i + 1)
+            wrong++;
+    }
+    return requests / (now () - start);
+}
+
+static double
+pipelined (coproc_pool_t *pool, long requests)
+{
+    char request[BUF_SIZE];
+    double start = now ();
+    long i;
+
+    for (i = 0; i < requests; i++){
+        snprintf (request, BUF_SIZE, "%ld %ld", i, i + 1);
+        if (coproc_call_async (pool, request, check_sum, (void *)(intptr_t)(2 * i + 1)) == -1){
+            perror ("coproc_call_async");
+            exit (EXIT_FAILURE);
+        }
+    }
+    if (coproc_drain (pool) == -1){
+        perror ("coproc_drain");
+        exit (EXIT_FAILURE);
+    }
+    return requests / (now () - start);
+}
+
+int
+main (int argc, char **argv)
+{
+    static char *add2_argv[] = { "./add2", "-l", NULL };
+    coproc_pool_t *pool;
+    int nprocs = 2, window = 0, policy = COPROC_ROUND_ROBIN;
+    long requests = 100000;
+    unsigned long before[64];
+    double rate;
+    int opt, i;
+
+    while ((opt = getopt (argc, argv, "n:r:w:l")) != -1){
+        switch (opt){
+            case 'n':
+                nprocs = atoi (optarg);
+                break;
+
+            case 'r':
+                requests = atol (optarg);
+                break;
+
+            case 'w':
+                window = atoi (optarg);
+                break;
+
+            case 'l':
+                policy = COPROC_LEAST_OUTSTANDING;
+                break;
+
+            default:
+                fprintf (stderr, "Usage: %s [-n co-processes] [-r requests] [-w window] [-l] \n",
+                         argv[0]);
+                exit (EXIT_FAILURE);
+        }
+    }
+    if (nprocs < 1 || nprocs > 64 || requests < 1){
+        fprintf (stderr, "Bad arguments \n");
+        exit (EXIT_FAILURE);
+    }
+
+    /* A co-process that has died should show up as lost requests, not kill us */
+    signal (SIGPIPE, SIG_IGN);
+
+    if ((pool = coproc_pool_create (add2_argv, nprocs, policy, window)) == NULL){
+        perror ("coproc_pool_create");
+        exit (EXIT_FAILURE);
+    }
+
+    rate = lock_step (pool, requests);
+    printf ("lock-step: %10.0f requests/s \n", rate);
+
+    for (i = 0; i < nprocs; i++)
+        before[i] = coproc_replies (pool, i);
+    rate = pipelined (pool, requests);
+    printf ("pipelined: %10.0f requests/s (%s, window %d) \n", rate,
+            policy == COPROC_ROUND_ROBIN ? "round-robin" : "least outstanding",
+            window > 0 ? window : COPROC_DEFAULT_WINDOW);
+    for (i = 0; i < nprocs; i++)
+        printf ("  co-process %d: %lu replies \n", i, coproc_replies (pool, i) - before[i]);
+
+    coproc_pool_destroy (pool);
+    printf ("%ld wrong, %ld lost \n", wrong, lost);
+    exit ((wrong == 0 && lost == 0) ? EXIT_SUCCESS : EXIT_FAILURE);
+}
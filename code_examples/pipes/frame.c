@@ -0,0 +1,266 @@
+/* Implementation of the framing layer described in frame.h.
+ *
+ * The reader keeps one buffer per descriptor. Bytes between start and end have
+ * been read but not yet handed out; complete frames are returned straight out of
+ * the buffer, and a partial frame at the end is moved to the front before the
+ * next read () so that it can be completed.
+ *
+ * Date created: October 19, 2026
+ *
+ */
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include "frame.h"
+
+#define FRAME_MAX_IOV 16
+
+static uint32_t crc_table[256];
+static int crc_table_ready = 0;
+
+/* Table for the reflected CRC-32 polynomial used by Ethernet and zlib */
+static void
+make_crc_table (void)
+{
+    uint32_t c;
+    int i, k;
+
+    for (i = 0; i < 256; i++){
+        c = i;
+        for (k = 0; k < 8; k++)
+            c = (c & 1) ? 0xedb88320U ^ (c >> 1) : c >> 1;
+        crc_table[i] = c;
+    }
+    crc_table_ready = 1;
+}
+
+static uint32_t
+crc32_update (uint32_t crc, const void *data, size_t length)
+{
+    const unsigned char *p = data;
+
+    if (!crc_table_ready)
+        make_crc_table ();
+    while (length--)
+        crc = crc_table[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    return crc;
+}
+
+static uint16_t
+header_check (const struct frame_header *hdr)
+{
+    uint32_t fields[3] = { hdr->magic, hdr->type, hdr->length };
+    uint32_t crc = ~crc32_update (~0U, fields, sizeof (fields));
+
+    return crc ^ (crc >> 16);
+}
+
+/* CRC over the type and length, continued over the payload by the caller */
+static uint32_t
+frame_crc_start (const struct frame_header *hdr)
+{
+    uint32_t fields[2] = { hdr->type, hdr->length };
+
+    return crc32_update (~0U, fields, sizeof (fields));
+}
+
+int
+frame_writev (int fd, uint16_t type, const struct iovec *iov, int iovcnt)
+{
+    struct frame_header hdr;
+    struct iovec vec[FRAME_MAX_IOV + 1], *v = vec;
+    size_t length = 0;
+    uint32_t crc;
+    ssize_t n;
+    int i, count;
+
+    if (iovcnt < 0 || iovcnt > FRAME_MAX_IOV){
+        errno = EINVAL;
+        return -1;
+    }
+    for (i = 0; i < iovcnt; i++)
+        length += iov[i].iov_len;
+    if (length > FRAME_MAX_PAYLOAD){
+        errno = EMSGSIZE;
+        return -1;
+    }
+
+    hdr.magic = FRAME_MAGIC;
+    hdr.type = type;
+    hdr.length = length;
+    hdr.hcheck = header_check (&hdr);
+    crc = frame_crc_start (&hdr);
+    for (i = 0; i < iovcnt; i++)
+        crc = crc32_update (crc, iov[i].iov_base, iov[i].iov_len);
+    hdr.crc = ~crc;
+
+    vec[0].iov_base = &hdr;
+    vec[0].iov_len = sizeof (hdr);
+    memcpy (&vec[1], iov, iovcnt * sizeof (struct iovec));
+    count = iovcnt + 1;
+
+    /* A pipe takes the whole frame at once unless it is larger than PIPE_BUF or the
+     * descriptor is non-blocking; otherwise carry on where the last write stopped. */
+    while (count > 0){
+        n = writev (fd, v, count);
+        if (n == -1){
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        while (count > 0 && (size_t)n >= v->iov_len){
+            n -= v->iov_len;
+            v++;
+            count--;
+        }
+        if (count > 0){
+            v->iov_base = (char *)v->iov_base + n;
+            v->iov_len -= n;
+        }
+    }
+
+    return 0;
+}
+
+int
+frame_write (int fd, uint16_t type, const void *payload, size_t length)
+{
+    struct iovec iov;
+
+    iov.iov_base = (void *)payload;
+    iov.iov_len = length;
+    return frame_writev (fd, type, &iov, 1);
+}
+
+int
+frame_reader_init (frame_reader_t *reader, int fd)
+{
+    memset (reader, 0, sizeof (*reader));
+    reader->fd = fd;
+    reader->size = FRAME_READ_SIZE;
+    reader->buf = malloc (reader->size);
+    return (reader->buf == NULL) ? -1 : 0;
+}
+
+void
+frame_reader_free (frame_reader_t *reader)
+{
+    free (reader->buf);
+    reader->buf = NULL;
+}
+
+/* Drop the damaged frame at the start of the buffer: skip to the next place where
+ * the magic value occurs, or keep only the last few bytes, which may be the first
+ * part of a magic value still being written. */
+static void
+resync (frame_reader_t *reader)
+{
+    uint32_t magic = FRAME_MAGIC;
+    char *next;
+
+    reader->resyncs++;
+    next = memmem (reader->buf + reader->start + 1, reader->end - reader->start - 1,
+                   &magic, sizeof (magic));
+    if (next != NULL)
+        reader->start = next - reader->buf;
+    else if (reader->end - reader->start > sizeof (magic) - 1)
+        reader->start = reader->end - (sizeof (magic) - 1);
+}
+
+/* Look for a complete frame at the start of the buffer. Returns 1 if one is found,
+ * and 0 if more bytes are needed, in which case *need is set to the size of the
+ * frame that is being waited for. */
+static int
+parse (frame_reader_t *reader, struct frame_header *hdr, size_t *need)
+{
+    size_t avail;
+    uint32_t crc;
+
+    for (;;){
+        avail = reader->end - reader->start;
+        *need = sizeof (*hdr);
+        if (avail < sizeof (*hdr))
+            return 0;
+
+        memcpy (hdr, reader->buf + reader->start, sizeof (*hdr));
+        if (hdr->magic != FRAME_MAGIC || hdr->hcheck != header_check (hdr)
+            || hdr->length > FRAME_MAX_PAYLOAD){
+            resync (reader);
+            continue;
+        }
+
+        *need = sizeof (*hdr) + hdr->length;
+        if (avail < *need)
+            return 0;
+
+        crc = frame_crc_start (hdr);
+        crc = ~crc32_update (crc, reader->buf + reader->start + sizeof (*hdr), hdr->length);
+        if (crc != hdr->crc){
+            resync (reader);
+            continue;
+        }
+        return 1;
+    }
+}
+
+int
+frame_buffered (frame_reader_t *reader)
+{
+    struct frame_header hdr;
+    size_t need;
+
+    return parse (reader, &hdr, &need);
+}
+
+int
+frame_read (frame_reader_t *reader, uint16_t *type, void **payload, size_t *length)
+{
+    struct frame_header hdr;
+    size_t need;
+    ssize_t n;
+    char *buf;
+
+    for (;;){
+        if (parse (reader, &hdr, &need)){
+            *type = hdr.type;
+            *payload = reader->buf + reader->start + sizeof (hdr);
+            *length = hdr.length;
+            reader->start += sizeof (hdr) + hdr.length;
+            reader->frames++;
+            return 1;
+        }
+
+        /* Move the partial frame to the front and make room for all of it */
+        if (reader->start > 0){
+            memmove (reader->buf, reader->buf + reader->start, reader->end - reader->start);
+            reader->end -= reader->start;
+            reader->start = 0;
+        }
+        if (need > reader->size){
+            buf = realloc (reader->buf, need);
+            if (buf == NULL)
+                return -1;
+            reader->buf = buf;
+            reader->size = need;
+        }
+
+        n = read (reader->fd, reader->buf + reader->end, reader->size - reader->end);
+        if (n == -1){
+            if (errno == EINTR)
+                continue;
+            return -1;
+        }
+        if (n == 0){
+            /* The writer has gone. Whatever is left is a frame cut short, but there
+             * may be whole frames after its start. */
+            if (reader->end - reader->start < sizeof (hdr))
+                return 0;
+            resync (reader);
+            continue;
+        }
+        reader->end += n;
+    }
+}
@@ -0,0 +1,87 @@
+/* Header file for the message framing layer in frame.c
+ *
+ * A pipe or FIFO carries a stream of bytes, so the two ends have to agree on where
+ * one message ends and the next begins. The FIFO examples (see ../fifos/fifo_seqnum.h)
+ * use fixed-size messages, which breaks down as soon as one short or long message
+ * gets into the stream: every message after it is read out of step.
+ *
+ * Here every message travels as a frame: a small header followed by the payload.
+ *
+ *   magic    -- a fixed value that marks the start of a frame
+ *   type     -- a message type for the application to use as it sees fit
+ *   hcheck   -- 16-bit check over the magic, type and length, so that a damaged
+ *               length is caught before the reader waits for a payload that
+ *               will never come
+ *   length   -- number of payload bytes that follow the header
+ *   crc      -- CRC-32 over the type, length and payload
+ *
+ * The writer sends the header and the payload with one writev () call, so a frame
+ * costs a single system call and, as long as it is no larger than PIPE_BUF, reaches
+ * the reader in one piece even when several processes write to the same FIFO.
+ *
+ * The reader pulls in as much as the pipe holds with each read () and hands out
+ * the frames one at a time from its buffer, so a burst of small messages costs one
+ * system call rather than two per message. If a frame turns out to be damaged (bad
+ * magic, an impossible length, or a CRC mismatch), the reader skips ahead to the
+ * next magic value in the stream and carries on from there, instead of staying out
+ * of step for good.
+ *
+ * Date created: October 19, 2026
+ *
+ */
+#ifndef _FRAME_H_
+#define _FRAME_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <limits.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#define FRAME_MAGIC 0x46524d31U         /* "FRM1" as a big-endian word */
+#define FRAME_MAX_PAYLOAD (1 << 20)
+#define FRAME_READ_SIZE 65536           /* Bytes asked for by each read () */
+
+struct frame_header {
+    uint32_t magic;
+    uint16_t type;
+    uint16_t hcheck;
+    uint32_t length;
+    uint32_t crc;
+};
+
+/* Largest frame that a pipe delivers in one piece when it has several writers */
+#define FRAME_ATOMIC_PAYLOAD (PIPE_BUF - sizeof (struct frame_header))
+
+typedef struct frame_reader {
+    int fd;
+    char *buf;
+    size_t size;                        /* Bytes allocated */
+    size_t start;                       /* First byte not yet parsed */
+    size_t end;                         /* One past the last byte read */
+    unsigned long frames;               /* Frames returned */
+    unsigned long resyncs;              /* Damaged frames skipped */
+} frame_reader_t;
+
+/* Send one frame. Returns 0 on success, -1 on error. */
+int frame_write (int fd, uint16_t type, const void *payload, size_t length);
+
+/* Send one frame whose payload is gathered from several buffers. */
+int frame_writev (int fd, uint16_t type, const struct iovec *iov, int iovcnt);
+
+/* Set up a reader for the given descriptor. Returns 0 on success, -1 on error. */
+int frame_reader_init (frame_reader_t *reader, int fd);
+
+/* Release the reader's buffer. The descriptor is left open. */
+void frame_reader_free (frame_reader_t *reader);
+
+/* Return the next frame: its type, a pointer to its payload inside the reader's
+ * buffer (valid until the next call), and its length. Returns 1 if a frame was
+ * returned, 0 at end of file, and -1 on a read error. */
+int frame_read (frame_reader_t *reader, uint16_t *type, void **payload, size_t *length);
+
+/* Non-zero if a complete frame is already buffered, so that frame_read () will
+ * not block. Useful when the descriptor is also watched with poll (). */
+int frame_buffered (frame_reader_t *reader);
+
+#endif /* _FRAME_H_ */
@@ -10,12 +10,16 @@
  * The end result is that the output from ls is directed into the pipe and the standard 
  * input of wc is taken from the read end of the pipe.
  *
+ * The fork (), dup2 () and close () calls that do this are in the pipeline builder, 
+ * pipeline.c; see the comments there for the order in which the pipe ends are 
+ * passed on and closed. Any arguments are taken as a file for the output of wc.
+ *
  * Source: M. Kerrisk, The Linux Programming Interface. 
  *
  * Author: Naga Kandasamy
  * Date created: July 4, 2018
  *
- * Compile as follows: gcc -o pipe_lw_wc pipe_ls_wc.c -std=c99 -Wall
+ * Compile as follows: gcc -o pipe_ls_wc pipe_ls_wc.c pipeline.c -std=c99 -Wall
  *
  */
 
@@ -23,109 +27,45 @@
 #include <string.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <stdlib.h>
 #include <errno.h>
+#include "pipeline.h"
 
 
 int 
 main (int argc, char **argv)
 {
-    int pfd[2];
-
-    if (pipe (pfd) ==  -1){
-        perror ("pipe");
+    char *ls_argv[] = { "ls", NULL };
+    char *wc_argv[] = { "wc", "-l", NULL };
+    pipeline_t *p;
+    int status;
+
+    p = pipeline_create (0);
+    if (p == NULL){
+        perror ("pipeline_create");
         exit (EXIT_FAILURE);
     }
 
-    switch (fork ()){
-        case -1:
-            perror ("fork");
-            exit (EXIT_FAILURE);
-
-        case 0:                 /* Child code */
-            if (close (pfd[0]) == -1){
-                perror ("close 1");
-                exit (EXIT_FAILURE);
-            }
-
-            /* Duplicate stdout on write end of pipe; close the duplicated 
-             * descriptor. */
-            if (pfd[1] != STDOUT_FILENO){
-                if (dup2 (pfd[1], STDOUT_FILENO) == -1){
-                    perror ("dup2 1");
-                    exit (EXIT_FAILURE);
-                }
-            
-                if (close (pfd[1]) == -1){
-                    perror ("close 2");
-                    exit (EXIT_FAILURE);
-                }
-            }
-            
-            /* Execute the first command. Write to pipe. */
-            execlp ("ls", "ls", (char *)NULL);
-            exit (EXIT_FAILURE);    /* Should not get here unless execlp returns an error */
-
-        default:
-            break; /* Parent falls through to create the next child */
-    }
-
-    switch (fork ()){
-        case -1:
-            perror ("fork");
-            exit (EXIT_FAILURE);
-
-        case 0:                 /* Child code */
-            if (close (pfd[1]) == -1){
-                perror ("close 3");
-                exit (EXIT_FAILURE);
-            }
-
-            /* Duplicate stdin on read end of pipe; close the duplicated 
-             * descriptor. */
-            if (pfd[0] != STDIN_FILENO){
-                if (dup2 (pfd[0], STDIN_FILENO) == -1){
-                    perror ("dup2 2");
-                    exit (EXIT_FAILURE);
-                }
-
-                if (close (pfd[0]) == -1){
-                    perror ("close 4");
-                    exit (EXIT_FAILURE);
-                }
-            }
-                
-            /* Execute the second command. Reads from pipe. */
-            execlp ("wc", "wc", "-l", (char *)NULL);
-            exit (EXIT_FAILURE);
-
-        default:
-            break; /* Parent falls through. */
-    }
-
-
-    /* Parent closes unused file descriptors for pipe and waits for the 
-     * children to terminate. */
-    if (close (pfd[0]) == -1){
-        perror ("close 5");
-        exit (EXIT_FAILURE);
-    }
-    
-    if (close (pfd[1]) == -1){
-        perror ("close 6");
-        exit (EXIT_FAILURE);
-    }
+    /* The first command writes to the pipe and the second one reads from it */
+    pipeline_add (p, ls_argv);
+    pipeline_add (p, wc_argv);
+    if (argc > 1)
+        pipeline_open (p, 1, STDOUT_FILENO, argv[1], O_WRONLY | O_CREAT | O_TRUNC, 0666);
 
-    if (wait (NULL) == -1){
-        perror ("wait 1");
+    if (pipeline_start (p) == -1){
+        perror ("pipeline_start");
         exit (EXIT_FAILURE);
     }
 
-    if (wait (NULL) == -1){
-        perror ("wait 2");
+    /* Wait for both children to terminate */
+    status = pipeline_wait (p, NULL);
+    if (status == -1){
+        perror ("wait");
         exit (EXIT_FAILURE);
     }
+    pipeline_destroy (p);
     
-    exit (EXIT_SUCCESS);
+    exit ((WIFEXITED (status) && WEXITSTATUS (status) == 0) ? EXIT_SUCCESS : EXIT_FAILURE);
 }
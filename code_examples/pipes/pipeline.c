@@ -0,0 +1,446 @@
+/* Implementation of the pipeline builder described in pipeline.h.
+ *
+ * The stages are forked in order. Before stage i is forked, the parent holds
+ * the read end of the pipe from stage i - 1 and both ends of the pipe to stage
+ * i + 1; the child puts the first and the write end of the second on standard
+ * input and output, and the parent then closes both, so that when the next
+ * stage is forked the parent holds nothing but the one read end it needs. Every
+ * descriptor the builder makes is close-on-exec, and a function stage closes the
+ * caller's ends by hand, so no stage keeps a pipe open that it does not use.
+ *
+ * Date created: October 19, 2026
+ *
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/uio.h>
+#include <sys/wait.h>
+#include "pipeline.h"
+
+#define ACTION_OPEN 0
+#define ACTION_DUP2 1
+
+struct stage {
+    char *const *argv;                  /* Program and arguments, or NULL */
+    int (*fn) (void *arg);              /* Function to run instead */
+    void *arg;
+};
+
+struct action {
+    int type;
+    int stage;                          /* Or PIPELINE_ALL_STAGES */
+    int fd, newfd;                      /* Target, or oldfd and newfd for dup2 () */
+    const char *path;
+    int flags;
+    mode_t mode;
+};
+
+struct pipeline {
+    int flags;
+    struct stage *stages;
+    int nstages;
+    struct action *actions;
+    int nactions;
+    pid_t *pids;
+    int npids;
+    pid_t pgid;
+    int pipe_size;                      /* Asked for, then obtained */
+    int feed, capture;
+    int in_fd, out_fd;                  /* The caller's ends, or -1 */
+};
+
+pipeline_t *
+pipeline_create (int flags)
+{
+    pipeline_t *p = calloc (1, sizeof (*p));
+
+    if (p == NULL)
+        return NULL;
+    p->flags = flags;
+    p->in_fd = p->out_fd = -1;
+    return p;
+}
+
+static int
+add_stage (pipeline_t *p, char *const argv[], int (*fn) (void *), void *arg)
+{
+    struct stage *stages;
+
+    stages = realloc (p->stages, (p->nstages + 1) * sizeof (*stages));
+    if (stages == NULL)
+        return -1;
+    p->stages = stages;
+    stages[p->nstages].argv = argv;
+    stages[p->nstages].fn = fn;
+    stages[p->nstages].arg = arg;
+    return p->nstages++;
+}
+
+int
+pipeline_add (pipeline_t *p, char *const argv[])
+{
+    if (argv == NULL || argv[0] == NULL){
+        errno = EINVAL;
+        return -1;
+    }
+    return add_stage (p, argv, NULL, NULL);
+}
+
+int
+pipeline_add_fn (pipeline_t *p, int (*fn) (void *arg), void *arg)
+{
+    if (fn == NULL){
+        errno = EINVAL;
+        return -1;
+    }
+    return add_stage (p, NULL, fn, arg);
+}
+
+static struct action *
+add_action (pipeline_t *p, int type, int stage)
+{
+    struct action *actions;
+
+    if (stage < PIPELINE_ALL_STAGES){
+        errno = EINVAL;
+        return NULL;
+    }
+    actions = realloc (p->actions, (p->nactions + 1) * sizeof (*actions));
+    if (actions == NULL)
+        return NULL;
+    p->actions = actions;
+    memset (&actions[p->nactions], 0, sizeof (*actions));
+    actions[p->nactions].type = type;
+    actions[p->nactions].stage = stage;
+    return &actions[p->nactions++];
+}
+
+int
+pipeline_open (pipeline_t *p, int stage, int fd, const char *path, int flags, mode_t mode)
+{
+    struct action *a = add_action (p, ACTION_OPEN, stage);
+
+    if (a == NULL)
+        return -1;
+    a->fd = fd;
+    a->path = path;
+    a->flags = flags;
+    a->mode = mode;
+    return 0;
+}
+
+int
+pipeline_dup2 (pipeline_t *p, int stage, int oldfd, int newfd)
+{
+    struct action *a = add_action (p, ACTION_DUP2, stage);
+
+    if (a == NULL)
+        return -1;
+    a->fd = oldfd;
+    a->newfd = newfd;
+    return 0;
+}
+
+void
+pipeline_set_pipe_size (pipeline_t *p, int size)
+{
+    p->pipe_size = size;
+}
+
+void
+pipeline_feed (pipeline_t *p)
+{
+    p->feed = 1;
+}
+
+void
+pipeline_capture (pipeline_t *p)
+{
+    p->capture = 1;
+}
+
+/* Make a close-on-exec pipe of the size asked for, or as close to it as allowed */
+static int
+make_pipe (pipeline_t *p, int fds[2])
+{
+    int size;
+
+    if (pipe2 (fds, O_CLOEXEC) == -1)
+        return -1;
+    if (p->pipe_size > 0 && fcntl (fds[1], F_SETPIPE_SZ, p->pipe_size) == -1 && errno == EPERM){
+        /* Over /proc/sys/fs/pipe-max-size; take the largest size allowed */
+        FILE *f = fopen ("/proc/sys/fs/pipe-max-size", "r");
+
+        if (f != NULL){
+            if (fscanf (f, "%d", &size) == 1 && size < p->pipe_size)
+                fcntl (fds[1], F_SETPIPE_SZ, size);
+            fclose (f);
+        }
+    }
+    size = fcntl (fds[1], F_GETPIPE_SZ);
+    if (size > 0)
+        p->pipe_size = size;
+    return 0;
+}
+
+/* Put fd on target in the child, closing the original. The pipes are opened
+ * close-on-exec, and dup2 () leaves the flag off the copy; an fd that is already
+ * in place has to have it cleared by hand. That fd may also be the inherited
+ * stdin or stdout of an end stage, which the caller may have closed. */
+static void
+move_fd (int fd, int target)
+{
+    if (fd == target){
+        fcntl (target, F_SETFD, 0);
+        return;
+    }
+    if (dup2 (fd, target) == -1){
+        perror ("dup2");
+        _exit (126);
+    }
+    close (fd);
+}
+
+/* In the child: connect the pipes, carry out the file actions, run the stage */
+static void
+run_stage (pipeline_t *p, int index, int in, int out)
+{
+    struct stage *s = &p->stages[index];
+    struct action *a;
+    int i, fd;
+
+    if (p->flags & PIPELINE_NEW_PGRP)
+        setpgid (0, p->pgid);
+
+    /* A function stage does not exec, so close-on-exec does not help it */
+    if (p->in_fd != -1)
+        close (p->in_fd);
+    if (p->out_fd != -1)
+        close (p->out_fd);
+
+    move_fd (in, STDIN_FILENO);
+    move_fd (out, STDOUT_FILENO);
+
+    for (i = 0; i < p->nactions; i++){
+        a = &p->actions[i];
+        if (a->stage != index && a->stage != PIPELINE_ALL_STAGES)
+            continue;
+        if (a->type == ACTION_DUP2){
+            if (a->fd != a->newfd && dup2 (a->fd, a->newfd) == -1){
+                perror ("dup2");
+                _exit (126);
+            }
+            continue;
+        }
+        fd = open (a->path, a->flags, a->mode);
+        if (fd == -1){
+            fprintf (stderr, "%s: %s \n", a->path, strerror (errno));
+            _exit (126);
+        }
+        move_fd (fd, a->fd);
+    }
+
+    if (s->fn != NULL)
+        exit (s->fn (s->arg));         /* exit () flushes what the function printed */
+
+    execvp (s->argv[0], s->argv);
+    fprintf (stderr, "%s: %s \n", s->argv[0], strerror (errno));
+    _exit (127);
+}
+
+int
+pipeline_start (pipeline_t *p)
+{
+    int feed[2], next[2];
+    int in, out, t, saved;
+    pid_t pid;
+
+    if (p->nstages == 0 || p->pids != NULL){
+        errno = EINVAL;
+        return -1;
+    }
+    if ((p->pids = calloc (p->nstages, sizeof (pid_t))) == NULL)
+        return -1;
+
+    if (p->feed){
+        if (make_pipe (p, feed) == -1)
+            return -1;
+        p->in_fd = feed[1];
+    }
+
+    in = p->feed ? feed[0] : STDIN_FILENO;
+    for (t = 0; t < p->nstages; t++){
+        /* The capture pipe is made last, so that only the last stage has it */
+        next[0] = next[1] = -1;
+        out = STDOUT_FILENO;
+        if (t < p->nstages - 1 || p->capture){
+            if (make_pipe (p, next) == -1)
+                goto fail;
+            out = next[1];
+            if (t == p->nstages - 1){
+                p->out_fd = next[0];
+                next[0] = -1;
+            }
+        }
+
+        pid = fork ();
+        if (pid == -1)
+            goto fail;
+        if (pid == 0){
+            if (next[0] != -1)
+                close (next[0]);
+            run_stage (p, t, in, out);
+        }
+
+        /* Both parent and child set the group, so that it is in place whichever
+         * runs first */
+        p->pids[p->npids++] = pid;
+        if (p->flags & PIPELINE_NEW_PGRP){
+            if (t == 0)
+                p->pgid = pid;
+            setpgid (pid, p->pgid);
+        }
+
+        if (in != STDIN_FILENO)
+            close (in);
+        if (out != STDOUT_FILENO)
+            close (out);
+        in = next[0];
+    }
+    return 0;
+
+fail:
+    saved = errno;
+    if (in != STDIN_FILENO)
+        close (in);
+    if (out != STDOUT_FILENO)
+        close (out);
+    if (next[0] != -1)
+        close (next[0]);
+    errno = saved;
+    return -1;
+}
+
+const pid_t *
+pipeline_pids (pipeline_t *p, int *count)
+{
+    *count = p->npids;
+    return p->pids;
+}
+
+pid_t
+pipeline_pgid (pipeline_t *p)
+{
+    return (p->flags & PIPELINE_NEW_PGRP) ? p->pgid : getpgrp ();
+}
+
+int
+pipeline_pipe_size (pipeline_t *p)
+{
+    return p->pipe_size;
+}
+
+int
+pipeline_input_fd (pipeline_t *p)
+{
+    return p->in_fd;
+}
+
+int
+pipeline_output_fd (pipeline_t *p)
+{
+    return p->out_fd;
+}
+
+ssize_t
+pipeline_write (pipeline_t *p, const void *buf, size_t len)
+{
+    const char *next = buf;
+    size_t left;
+    ssize_t nw;
+
+    for (left = len; left > 0; left -= nw, next += nw){
+        nw = write (p->in_fd, next, left);
+        if (nw == -1){
+            if (errno != EINTR)
+                return -1;
+            nw = 0;
+        }
+    }
+    return len;
+}
+
+ssize_t
+pipeline_vmsplice (pipeline_t *p, const void *buf, size_t len)
+{
+    struct iovec iov;
+    ssize_t nw;
+
+    iov.iov_base = (void *)buf;
+    iov.iov_len = len;
+    while (iov.iov_len > 0){
+        /* Each call fills what room the pipe has with page references */
+        nw = vmsplice (p->in_fd, &iov, 1, 0);
+        if (nw == -1){
+            if (errno == EINTR)
+                continue;
+            if (errno == EINVAL || errno == ENOSYS){
+                /* Not a pipe after all, or no vmsplice (); copy the rest */
+                if (pipeline_write (p, iov.iov_base, iov.iov_len) == -1)
+                    return -1;
+                break;
+            }
+            return -1;
+        }
+        iov.iov_base = (char *)iov.iov_base + nw;
+        iov.iov_len -= nw;
+    }
+    return len;
+}
+
+void
+pipeline_close_input (pipeline_t *p)
+{
+    if (p->in_fd != -1){
+        close (p->in_fd);
+        p->in_fd = -1;
+    }
+}
+
+int
+pipeline_wait (pipeline_t *p, int *statuses)
+{
+    int i, status = 0, last = 0;
+
+    pipeline_close_input (p);
+    for (i = 0; i < p->npids; i++){
+        while (waitpid (p->pids[i], &status, 0) == -1)
+            if (errno != EINTR)
+                return -1;
+        if (statuses != NULL)
+            statuses[i] = status;
+        last = status;
+    }
+    p->npids = 0;
+    return last;
+}
+
+void
+pipeline_destroy (pipeline_t *p)
+{
+    if (p == NULL)
+        return;
+    pipeline_close_input (p);
+    if (p->out_fd != -1)
+        close (p->out_fd);
+    free (p->stages);
+    free (p->actions);
+    free (p->pids);
+    free (p);
+}
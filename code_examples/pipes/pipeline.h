@@ -0,0 +1,113 @@
+/* Header file for the pipeline builder in pipeline.c, used by pipe_ls_wc.c,
+ * pipeline_bench.c and coproc.c, and by pssh (shackleford/src/projects/pssh/pssh_v2)
+ *
+ * A shell pipeline such as ls | wc -l takes a pipe per connection, a fork ()
+ * per command, dup2 () to put the pipe ends on standard input and output, and
+ * careful closing of every other end so that each reader sees end of file.
+ * The builder does all of that from a description of the pipeline:
+ *
+ *      p = pipeline_create (0);
+ *      pipeline_add (p, ls_argv);
+ *      pipeline_add (p, wc_argv);
+ *      pipeline_open (p, 1, STDOUT_FILENO, "count", O_WRONLY | O_CREAT | O_TRUNC, 0666);
+ *      pipeline_start (p);
+ *      status = pipeline_wait (p, NULL);
+ *
+ * A stage is either a program, run with execvp (), or a function, run in the
+ * child process, whose return value becomes the exit status. File actions, in
+ * the manner of posix_spawn (), open a file onto a descriptor of one stage or of
+ * every stage, or duplicate one descriptor onto another (2>&1), after the pipes
+ * have been connected.
+ *
+ * With PIPELINE_NEW_PGRP the stages go into a process group of their own, led
+ * by the first stage, as a shell does for job control.
+ *
+ * Pipes hold 64 KB by default, so a fast writer stalls every 64 KB for the
+ * reader to catch up. pipeline_set_pipe_size () grows them with F_SETPIPE_SZ, up
+ * to /proc/sys/fs/pipe-max-size (1 MB by default) for unprivileged processes.
+ *
+ * The first stage can read from the caller instead of the caller's standard
+ * input (pipeline_feed ()), and the caller can read the output of the last
+ * stage (pipeline_capture ()). pipeline_vmsplice () feeds a buffer without
+ * copying it: the pipe takes references to the caller's pages, so the buffer
+ * must not change until the first stage has read it.
+ *
+ * Date created: October 19, 2026
+ *
+ */
+#ifndef _PIPELINE_H_
+#define _PIPELINE_H_
+
+#include <sys/types.h>
+
+/* Flags for pipeline_create () */
+#define PIPELINE_NEW_PGRP 1             /* Put the stages in a process group of their own */
+
+#define PIPELINE_ALL_STAGES -1          /* Stage number for actions on every stage */
+
+typedef struct pipeline pipeline_t;
+
+/* Create an empty pipeline. Returns NULL on error. */
+pipeline_t *pipeline_create (int flags);
+
+/* Append a stage that runs argv[0] with execvp (). argv must stay valid until
+ * pipeline_start (). Returns the stage number, or -1 on error. */
+int pipeline_add (pipeline_t *p, char *const argv[]);
+
+/* Append a stage that calls fn (arg) in the child and exits with its return
+ * value. Returns the stage number, or -1 on error. */
+int pipeline_add_fn (pipeline_t *p, int (*fn) (void *arg), void *arg);
+
+/* In stage (or PIPELINE_ALL_STAGES), open path with flags and mode onto fd.
+ * path must stay valid until pipeline_start (). Returns 0, or -1 on error. */
+int pipeline_open (pipeline_t *p, int stage, int fd, const char *path, int flags, mode_t mode);
+
+/* In stage (or PIPELINE_ALL_STAGES), make newfd a copy of oldfd. Returns 0, or
+ * -1 on error. */
+int pipeline_dup2 (pipeline_t *p, int stage, int oldfd, int newfd);
+
+/* Ask for pipes of size bytes. The size obtained is returned by
+ * pipeline_pipe_size () after pipeline_start (). */
+void pipeline_set_pipe_size (pipeline_t *p, int size);
+
+/* Connect the caller to the first stage's standard input, or to the last
+ * stage's standard output, with a pipe */
+void pipeline_feed (pipeline_t *p);
+void pipeline_capture (pipeline_t *p);
+
+/* Start every stage. Returns 0, or -1 with errno set; stages already started
+ * keep running and are waited for by pipeline_wait (). */
+int pipeline_start (pipeline_t *p);
+
+/* The pids of the stages started, in order, and their number in *count */
+const pid_t *pipeline_pids (pipeline_t *p, int *count);
+
+/* The process group of the stages */
+pid_t pipeline_pgid (pipeline_t *p);
+
+/* The size of the pipes, as obtained from the kernel */
+int pipeline_pipe_size (pipeline_t *p);
+
+/* The caller's ends of the pipes set up with pipeline_feed () and
+ * pipeline_capture (), or -1 */
+int pipeline_input_fd (pipeline_t *p);
+int pipeline_output_fd (pipeline_t *p);
+
+/* Write all of buf to the first stage, with write () or with vmsplice (). Returns
+ * len, or -1 with errno set. */
+ssize_t pipeline_write (pipeline_t *p, const void *buf, size_t len);
+ssize_t pipeline_vmsplice (pipeline_t *p, const void *buf, size_t len);
+
+/* Close the caller's end of the input, so that the first stage sees end of file */
+void pipeline_close_input (pipeline_t *p);
+
+/* Close the input, if still open, and wait for every stage started. The wait
+ * status of each stage goes in statuses, if not NULL. Returns the wait status of
+ * the last stage, as a shell does, or -1 with errno set. */
+int pipeline_wait (pipeline_t *p, int *statuses);
+
+/* Close what the caller still holds and free the pipeline. Stages that have
+ * not been waited for keep running. */
+void pipeline_destroy (pipeline_t *p);
+
+#endif /* _PIPELINE_H_ */
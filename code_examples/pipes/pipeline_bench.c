@@ -0,0 +1,188 @@
+/* Benchmark for the pipeline builder in pipeline.c. For each number of stages k
+ * it builds the pipeline cat | cat | ... | cat (k times) > /dev/null, feeds it a
+ * fixed amount of data from memory, and prints the rate in MB/s from the start
+ * of the pipeline until its last stage has exited, the best of a few runs.
+ *
+ * Each k gets four columns: the data is fed with write () or with vmsplice (),
+ * through pipes of the default size (64 KB) or of the size given with -p (1 MB
+ * by default, the most an unprivileged process may ask for unless
+ * /proc/sys/fs/pipe-max-size says otherwise). The same buffer is fed over and
+ * over and never changes, so vmsplice () can safely hand its pages to the pipe.
+ *
+ * Every byte still crosses each pipe with one write () and one read () by a cat;
+ * larger pipes let each cat move more per call and wait less often for its
+ * neighbours, which matters more as the chain grows.
+ *
+ * Usage: ./pipeline_bench [-k stage counts, e.g. 1,2,4,8] [-s MB to feed]
+ *                         [-b feed buffer size] [-p pipe size] [-r runs]
+ *
+ * Date created: October 19, 2026
+ *
+ * Compile as follows:
+ * gcc -o pipeline_bench pipeline_bench.c pipeline.c -std=c99 -Wall -O2
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "pipeline.h"
+
+#define MAX_LIST 16
+
+/* Parse a comma-separated list of positive numbers; returns how many */
+static int
+parse_list (const char *arg, long *values)
+{
+    char *copy = strdup (arg), *token, *save;
+    int n = 0;
+
+    for (token = strtok_r (copy, ",", &save); token != NULL && n < MAX_LIST;
+            token = strtok_r (NULL, ",", &save))
+        if ((values[n] = atol (token)) > 0)
+            n++;
+    free (copy);
+    return n;
+}
+
+static double
+now (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* Push total bytes through k cats once; returns MB/s and the pipe size obtained */
+static double
+run_chain (int k, const char *buf, size_t buf_size, long long total, int pipe_size,
+           int use_vmsplice, int *size_used)
+{
+    static char *cat_argv[] = { "cat", NULL };
+    pipeline_t *p = pipeline_create (0);
+    long long left;
+    size_t n;
+    ssize_t nw;
+    double start, elapsed;
+    int i, status;
+
+    if (p == NULL){
+        perror ("pipeline_create");
+        exit (EXIT_FAILURE);
+    }
+    for (i = 0; i < k; i++)
+        pipeline_add (p, cat_argv);
+    pipeline_open (p, k - 1, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    pipeline_set_pipe_size (p, pipe_size);
+    pipeline_feed (p);
+
+    start = now ();
+    if (pipeline_start (p) == -1){
+        perror ("pipeline_start");
+        exit (EXIT_FAILURE);
+    }
+    for (left = total; left > 0; left -= n){
+        n = (left < (long long) buf_size) ? (size_t) left : buf_size;
+        nw = use_vmsplice ? pipeline_vmsplice (p, buf, n) : pipeline_write (p, buf, n);
+        if (nw == -1){
+            perror (use_vmsplice ? "vmsplice" : "write");
+            exit (EXIT_FAILURE);
+        }
+    }
+    status = pipeline_wait (p, NULL);
+    elapsed = now () - start;
+    if (status == -1 || !WIFEXITED (status) || WEXITSTATUS (status) != 0){
+        fprintf (stderr, "The pipeline failed \n");
+        exit (EXIT_FAILURE);
+    }
+
+    *size_used = pipeline_pipe_size (p);
+    pipeline_destroy (p);
+    return total / elapsed / 1e6;
+}
+
+int
+main (int argc, char **argv)
+{
+    long stages[MAX_LIST] = { 1, 2, 4, 8 };
+    int nstages = 4, runs = 3, big_pipe = 1 << 20, sizes[2], size_used = 0;
+    size_t buf_size = 1 << 20;
+    long long total = 512LL << 20;
+    double rate, best;
+    char *buf, label[64];
+    int opt, i, j, r;
+
+    while ((opt = getopt (argc, argv, "k:s:b:p:r:")) != -1){
+        switch (opt){
+            case 'k':
+                nstages = parse_list (optarg, stages);
+                break;
+
+            case 's':
+                total = atoll (optarg) << 20;
+                break;
+
+            case 'b':
+                buf_size = atol (optarg);
+                break;
+
+            case 'p':
+                big_pipe = atoi (optarg);
+                break;
+
+            case 'r':
+                runs = atoi (optarg);
+                break;
+
+            default:
+                fprintf (stderr, "Usage: %s [-k stage counts] [-s MB to feed] [-b feed buffer size] "
+                         "[-p pipe size] [-r runs] \n", argv[0]);
+                exit (EXIT_FAILURE);
+        }
+    }
+    if (nstages == 0 || total <= 0 || buf_size == 0 || big_pipe <= 0 || runs < 1){
+        fprintf (stderr, "Bad arguments \n");
+        exit (EXIT_FAILURE);
+    }
+
+    /* Page-aligned, so that vmsplice () hands over whole pages */
+    if (posix_memalign ((void **)&buf, sysconf (_SC_PAGESIZE), buf_size) != 0){
+        perror ("posix_memalign");
+        exit (EXIT_FAILURE);
+    }
+    for (i = 0; i < (int) buf_size; i++)
+        buf[i] = 'a' + i % 26;
+
+    /* The second size is what the kernel actually grants */
+    sizes[0] = 0;
+    run_chain (1, buf, buf_size, buf_size, big_pipe, 0, &size_used);
+    sizes[1] = size_used;
+
+    printf ("%6s  %12s  %12s  %12s  %12s   (MB/s, %lld MB, best of %d) \n", "stages",
+            "write", "vmsplice", "write", "vmsplice", total >> 20, runs);
+    snprintf (label, sizeof (label), "pipes of %d KB", sizes[1] >> 10);
+    printf ("%6s  %26s  %26s \n", "", "default pipes", label);
+
+    for (i = 0; i < nstages; i++){
+        printf ("%6ld", stages[i]);
+        for (j = 0; j < 4; j++){
+            for (best = 0, r = 0; r < runs; r++){
+                rate = run_chain (stages[i], buf, buf_size, total, sizes[j / 2], j % 2, &size_used);
+                if (rate > best)
+                    best = rate;
+            }
+            printf ("  %12.0f", best);
+            fflush (stdout);
+        }
+        printf ("\n");
+    }
+
+    free (buf);
+    exit (EXIT_SUCCESS);
+}
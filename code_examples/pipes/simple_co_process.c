@@ -6,7 +6,20 @@
  * Date created: December 22, 2008
  * Date modified: July 6, 2018
  *
- * Compile the code as follows. gcc -o simple_co_process simple_co_process.c -std=c99 -Wall
+ * Each "number1 number2" argument is sent to add2 as one frame (see frame.h), and
+ * the sums come back as frames too. Since a frame carries its own length, several
+ * requests can be queued in the pipe at once without the two processes losing
+ * track of where one message ends and the next begins. The parent keeps at most
+ * MAX_IN_FLIGHT requests outstanding, though. Were it to write them all before
+ * reading any reply, add2 would fill the reply pipe and block writing, and the
+ * parent would then block writing to the request pipe that add2 no longer reads.
+ *
+ * coproc.c takes this further, with a pool of co-processes, many requests
+ * outstanding on each, and replies matched to requests by sequence number; see
+ * coproc_rpc.c.
+ *
+ * Compile the code as follows. gcc -o simple_co_process simple_co_process.c frame.c -std=c99 -Wall
+ * and compile add2.c the same way.
 */ 
 
 #include <stdio.h>
@@ -16,18 +29,23 @@
 #include <unistd.h>
 #include <stdlib.h>
 #include <errno.h>
+#include "frame.h"
 
 #define BUF_SIZE 256
 
+/* The replies to this many requests, at most a few dozen bytes each, fit in a pipe 
+ * of PIPE_BUF bytes, the least a pipe holds, so add2 never blocks writing them */
+#define MAX_IN_FLIGHT 64
+
 int 
 main (int argc, char **argv)
 {
     int fd0[2], fd1[2]; 
     int pid;
-    int n;
+    int i;
   
     if (argc < 2){
-        printf ("Usage: %s simple_co_process \"number1 number2\" \n", argv[0]);
+        printf ("Usage: %s \"number1 number2\" [\"number1 number2\" ...] \n", argv[0]);
         exit (EXIT_SUCCESS);
     }
 
@@ -51,7 +69,7 @@ main (int argc, char **argv)
     dup2 (fd1[1], STDOUT_FILENO); /* Make the standard output descriptor (STDOUT) refer to fd1[1], the writing end of pipe fd1 */
     close (fd1[1]);
 
-    execl ("./add2", "add2", (char *)0); /* Execute the add2 program without any command-line arguments */
+    execl ("./add2", "add2", "-f", (char *)0); /* Execute the add2 program in framed mode */
     exit (EXIT_FAILURE);
   }
 
@@ -59,17 +77,52 @@ main (int argc, char **argv)
   close (fd0[0]); /* Close the reading end of pipe 0 */
   close (fd1[1]); /* Close the writing end of pipe 1 */
   
-  /* Read the command line argument. */
+  /* Read the replies as the requests go out. The reader may pull in several of 
+   * them with one read. */
+  frame_reader_t reader;
   char buffer[BUF_SIZE];
-  strcpy (buffer, argv[1]); /* Read in the string input by the user */
-  printf ("Parent: writing %d bytes to the pipe. \n", (int) strlen(buffer));
-  write (fd0[1], buffer, strlen(buffer)); /* Write strlen(buffer) bytes to the writing end of fd0 */
-
-  n = read (fd1[0], buffer, BUF_SIZE); /* Read n bytes from the reading end of fd1 */
-  printf ("Parent: reading %d bytes from the pipe. \n", n);
-  buffer[n] = '\0'; // Terminate the string you just read
- 
-  printf ("Sum = %s \n", buffer); 
+  uint16_t type;
+  void *payload;
+  size_t length;
+  int answered = 1;
+
+  if (frame_reader_init (&reader, fd1[0]) == -1){
+      perror ("frame_reader_init");
+      exit (EXIT_FAILURE);
+  }
+  i = 1;
+  while (answered < argc){
+      /* Top up the requests in flight; the frames keep them apart in the pipe */
+      for (; i < argc && i - answered < MAX_IN_FLIGHT; i++){
+          printf ("Parent: writing a frame of %d bytes to the pipe. \n", (int) strlen (argv[i]));
+          /* The frame type carries the argument number, which add2 echoes back. It 
+           * wraps past 65535, but the requests in flight still differ in it. */
+          if (frame_write (fd0[1], (uint16_t) i, argv[i], strlen (argv[i])) == -1){
+              perror ("frame_write");
+              exit (EXIT_FAILURE);
+          }
+      }
+      if (i == argc && fd0[1] != -1){
+          close (fd0[1]); /* No more requests; add2 exits once it has answered them all */
+          fd0[1] = -1;
+      }
+
+      if (frame_read (&reader, &type, &payload, &length) != 1){
+          fprintf (stderr, "Parent: add2 went away with %d requests unanswered \n", argc - answered);
+          break;
+      }
+      if (length >= BUF_SIZE)
+          length = BUF_SIZE - 1;
+      memcpy (buffer, payload, length);
+      buffer[length] = '\0'; // Terminate the string you just read
+      printf ("Parent: reading a frame of %d bytes from the pipe. \n", (int) length);
+      /* add2 answers in order, so this is the reply to the oldest request */
+      if (type == (uint16_t) answered)
+          printf ("%s: Sum = %s \n", argv[answered], buffer);
+      answered++;
+  }
+  frame_reader_free (&reader);
+  waitpid (pid, NULL, 0);
  
   exit (EXIT_SUCCESS);
 }
@@ -5,7 +5,11 @@
  * Date created: January 14, 2009 
  * Date modified: July 4, 2018
  *
- * Compile as follows: gcc -o sync_with_pipes sync_with_pipes.c -std=c99 -Wall
+ * The signals travel as frames (see frame.h), which lets each one carry a message
+ * of any length along with it: the parent tells the child which file to read, and
+ * the child reports back what it found.
+ *
+ * Compile as follows: gcc -o sync_with_pipes sync_with_pipes.c frame.c -std=c99 -Wall
  *
  * */
 
@@ -16,6 +20,7 @@
 #include <sys/wait.h>
 #include <unistd.h>
 #include <errno.h>
+#include "frame.h"
 
 #define TRUE 1
 #define FALSE 0
@@ -24,74 +29,81 @@
 
 /* File descriptors for full-duplex communication between parent and child */
 int pfd1[2], pfd2[2];   
+frame_reader_t from_parent, from_child;
 
 int 
 create_sync_channel (void)          /* Create the communication channel */
 {                
     if (pipe (pfd1) < 0 || pipe (pfd2) < 0)
         return FALSE;
-  
-    return TRUE;
-}
-
-int 
-tell_parent (void)                  /* Tell the parent that child is done */
-{
-    if (write (pfd2[1], "c", 1) != 1)
+    if (frame_reader_init (&from_parent, pfd1[0]) < 0 
+        || frame_reader_init (&from_child, pfd2[0]) < 0)
         return FALSE;
   
     return TRUE;
 }
 
+/* Wait for a frame of the expected type and copy its message into buffer */
 int 
-wait_for_parent (void)              /* Wait for parent */
+wait_for (frame_reader_t *reader, uint16_t expected, char *buffer, const char *who)
 {
-    char c;
-    if (read (pfd1[0], &c, 1) != 1){
-        printf ("WAIT_PARENT: Read error; incorrect number of bytes \n");
+    uint16_t type;
+    void *payload;
+    size_t length;
+
+    if (frame_read (reader, &type, &payload, &length) != 1){
+        printf ("%s: Read error; no message from pipe \n", who);
         return FALSE;
     }
   
-    if (c != 'p'){
-        printf("WAIT_PARENT: Incorrect data from pipe \n");
+    if (type != expected){
+        printf ("%s: Incorrect data from pipe \n", who);
         return FALSE;
     }
-  
+
+    if (length >= BUF_SIZE)
+        length = BUF_SIZE - 1;
+    memcpy (buffer, payload, length);
+    buffer[length] = '\0';
     return TRUE;
 }
 
 int 
-tell_child (void)                   /* Tell child that parent is done */
+tell_parent (const char *message)   /* Tell the parent that child is done */
 {
-    if (write (pfd1[1], "p", 1) != 1)
+    if (frame_write (pfd2[1], 'c', message, strlen (message)) < 0)
         return FALSE;
   
     return TRUE;
 }
 
 int 
-wait_for_child (void)               /* Wait for the child process */
+wait_for_parent (char *buffer)      /* Wait for parent */
 {
-    char c;
-    if (read (pfd2[0], &c, 1) != 1){
-        printf("WAIT_PARENT: Read error; incorrect number of bytes \n");
-        return FALSE;
-    }
-  
-    if(c != 'c'){
-        printf("WAIT_PARENT: Incorrect data from pipe \n");
+    return wait_for (&from_parent, 'p', buffer, "WAIT_PARENT");
+}
+
+int 
+tell_child (const char *message)    /* Tell child that parent is done */
+{
+    if (frame_write (pfd1[1], 'p', message, strlen (message)) < 0)
         return FALSE;
-    }
   
     return TRUE;
 }
 
+int 
+wait_for_child (char *buffer)       /* Wait for the child process */
+{
+    return wait_for (&from_child, 'c', buffer, "WAIT_CHILD");
+}
+
 int 
 main(int argc, char **argv)
 {
     int pid, status;
     FILE *fp; 
-    char buffer[BUF_SIZE]; 
+    char buffer[BUF_SIZE], file_name[BUF_SIZE], report[BUF_SIZE]; 
 
     /* Create two pipes for full-duplex communication between parent and child */ 
     if (create_sync_channel () == FALSE){
@@ -107,14 +119,20 @@ main(int argc, char **argv)
         case 0:                                                             /* Child code */
             printf ("CHILD: Waiting for parent to give OK signal. \n");
             
-            wait_for_parent ();                                             /* Block until the parent signals it is OK to proceed */
-            printf ("CHILD: Reading message from parent. \n");
-            fp = fopen ("message.txt", "rt");                               /* Open the file in read mode */
+            if (wait_for_parent (file_name) == FALSE)                       /* Block until the parent signals it is OK to proceed */
+                exit (EXIT_FAILURE);
+            printf ("CHILD: Reading message from parent in %s. \n", file_name);
+            fp = fopen (file_name, "rt");                                   /* Open the file named by the parent in read mode */
+            if (fp == NULL){
+                perror ("open");
+                exit (EXIT_FAILURE);
+            }
             fscanf (fp, "%s", buffer);                                      /* Read the string */
             printf ("CHILD: Message says: %s \n", buffer);
             fclose (fp);
     
-            tell_parent ();                                                 /* Tell the parent that child is done */
+            snprintf (report, BUF_SIZE, "read %d characters", (int) strlen (buffer));
+            tell_parent (report);                                           /* Tell the parent that child is done */
 
             sleep (5);                                                      /* Simulate some processing */
             exit(EXIT_SUCCESS);                                             /* Child exits */
@@ -129,10 +147,11 @@ main(int argc, char **argv)
             fprintf (fp, "Hello_there. \n");                                 /* Print string to the file */
             fclose (fp);                                                     /* Close the file pointer */
 
-            tell_child ();                                                  /* Tell child that it can now read the file */
-            wait_for_child ();                                              /* Block until child finishes reading the file */
+            tell_child ("message.txt");                                     /* Tell child that it can now read the file */
+            if (wait_for_child (buffer) == FALSE)                           /* Block until child finishes reading the file */
+                exit (EXIT_FAILURE);
   
-            printf ("PARENT: Child is done reading the file. \n");
+            printf ("PARENT: Child is done reading the file: %s. \n", buffer);
     }
 
     waitpid (pid, &status, 0);                                              /* Wait for child to exit */
@@ -0,0 +1,225 @@
+/* Implementation of the semaphore set helpers described in semset.h.
+ *
+ * Date created: October 19, 2026
+ *
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include "semun.h"
+#include "semset.h"
+
+/* How long semset_open () waits for the creator to initialize the set */
+#define INIT_WAIT_TRIES 1000
+#define INIT_WAIT_US 1000
+
+static void
+fill_set (semset_t *set, int semid, int nsems, int flags)
+{
+    set->semid = semid;
+    set->nsems = nsems;
+    set->sem_flg = (flags & SEMSET_UNDO) ? SEM_UNDO : 0;
+}
+
+int
+semset_create (semset_t *set, key_t key, int nsems, const unsigned short *values, 
+               int perms, int flags)
+{
+    union semun arg;
+    struct sembuf touch[2];
+    unsigned short *zeros = NULL;
+    int semid;
+
+    semid = semget (key, nsems, perms | IPC_CREAT | IPC_EXCL);
+    if (semid == -1){
+        if (errno == EEXIST)
+            return semset_open (set, key, nsems, flags);
+        return -1;
+    }
+
+    if (values == NULL){
+        zeros = (unsigned short *)calloc (nsems, sizeof (unsigned short));
+        if (zeros == NULL)
+            goto fail;
+        values = zeros;
+    }
+    arg.array = (unsigned short *)values;
+    if (semctl (semid, 0, SETALL, arg) == -1)
+        goto fail;
+    free ((void *)zeros);
+
+    /* A new set is not initialized atomically with its creation, so processes 
+     * opening it wait until sem_otime becomes non-zero. Set it with a semop () 
+     * that leaves the values alone: +1 and -1 on semaphore 0, applied together. */
+    touch[0].sem_num = 0;
+    touch[0].sem_op = 1;
+    touch[0].sem_flg = 0;
+    touch[1].sem_num = 0;
+    touch[1].sem_op = -1;
+    touch[1].sem_flg = 0;
+    if (semop (semid, touch, 2) == -1)
+        goto fail;
+
+    fill_set (set, semid, nsems, flags);
+    return 0;
+
+fail:
+    free ((void *)zeros);
+    semctl (semid, 0, IPC_RMID);
+    return -1;
+}
+
+int
+semset_open (semset_t *set, key_t key, int nsems, int flags)
+{
+    struct semid_ds ds;
+    union semun arg;
+    int semid, i;
+
+    semid = semget (key, nsems, 0);
+    if (semid == -1)
+        return -1;
+
+    arg.buf = &ds;
+    for (i = 0; i < INIT_WAIT_TRIES; i++){
+        if (semctl (semid, 0, IPC_STAT, arg) == -1)
+            return -1;
+        if (ds.sem_otime != 0)
+            break;
+        usleep (INIT_WAIT_US);
+    }
+    if (i == INIT_WAIT_TRIES){
+        errno = ETIMEDOUT;
+        return -1;
+    }
+
+    fill_set (set, semid, ds.sem_nsems, flags);
+    return 0;
+}
+
+int
+semset_remove (semset_t *set)
+{
+    return semctl (set->semid, 0, IPC_RMID);
+}
+
+int
+semset_get_value (semset_t *set, int num)
+{
+    return semctl (set->semid, num, GETVAL);
+}
+
+int
+semset_op (semset_t *set, int num, int delta)
+{
+    struct sembuf sop;
+
+    sop.sem_num = num;
+    sop.sem_op = delta;
+    sop.sem_flg = set->sem_flg;
+    while (semop (set->semid, &sop, 1) == -1){
+        if (errno != EINTR)
+            return -1;
+    }
+    return 0;
+}
+
+void
+semset_batch_init (semset_batch_t *batch)
+{
+    batch->nops = 0;
+}
+
+int
+semset_batch_add (semset_batch_t *batch, int num, int delta)
+{
+    struct sembuf *sop;
+
+    if (batch->nops == SEMSET_MAX_OPS){
+        errno = E2BIG;
+        return -1;
+    }
+    sop = &batch->ops[batch->nops++];
+    sop->sem_num = num;
+    sop->sem_op = delta;
+    sop->sem_flg = 0;
+    return 0;
+}
+
+void
+semset_batch_invert (const semset_batch_t *batch, semset_batch_t *inverse)
+{
+    int i;
+
+    semset_batch_init (inverse);
+    for (i = 0; i < batch->nops; i++)
+        if (batch->ops[i].sem_op < 0)
+            semset_batch_add (inverse, batch->ops[i].sem_num, -batch->ops[i].sem_op);
+}
+
+/* Return the time left until the deadline, or zero if it has passed */
+static void
+time_left (const struct timespec *deadline, struct timespec *left)
+{
+    struct timespec now;
+
+    clock_gettime (CLOCK_MONOTONIC, &now);
+    left->tv_sec = deadline->tv_sec - now.tv_sec;
+    left->tv_nsec = deadline->tv_nsec - now.tv_nsec;
+    if (left->tv_nsec < 0){
+        left->tv_sec--;
+        left->tv_nsec += 1000000000L;
+    }
+    if (left->tv_sec < 0)
+        left->tv_sec = left->tv_nsec = 0;
+}
+
+int
+semset_commit (semset_t *set, const semset_batch_t *batch, long timeout_ms)
+{
+    struct sembuf ops[SEMSET_MAX_OPS];
+    struct timespec deadline, left;
+    short flags = set->sem_flg;
+    int i;
+
+    if (batch->nops == 0)
+        return 0;
+
+    if (timeout_ms == SEMSET_NO_WAIT)
+        flags |= IPC_NOWAIT;
+    for (i = 0; i < batch->nops; i++){
+        ops[i] = batch->ops[i];
+        ops[i].sem_flg = flags;
+    }
+
+    if (timeout_ms <= 0){
+        while (semop (set->semid, ops, batch->nops) == -1){
+            if (errno != EINTR)
+                return -1;
+        }
+        return 0;
+    }
+
+    clock_gettime (CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L){
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    left.tv_sec = timeout_ms / 1000;
+    left.tv_nsec = (timeout_ms % 1000) * 1000000L;
+    while (semtimedop (set->semid, ops, batch->nops, &left) == -1){
+        if (errno != EINTR)
+            return -1;
+        time_left (&deadline, &left);
+    }
+    return 0;
+}
@@ -0,0 +1,97 @@
+/* Header file for the semaphore set helpers in semset.c
+ *
+ * The P () and V () routines in ../../shm/SystemV call semget () to look up the 
+ * semaphore on every operation and then change a single semaphore with one call 
+ * to semop (). A program that takes many semaphores at once (a lock manager that 
+ * locks dozens of resources per transaction, say) pays for two system calls per 
+ * semaphore and, worse, takes them one at a time so that two such programs can 
+ * deadlock against each other.
+ *
+ * The helpers here resolve the identifier of the set once, when it is created or 
+ * opened, and let the caller collect any number of operations on the set into a 
+ * batch that is applied with a single semop () call. The kernel performs all the 
+ * operations of a batch atomically: either every one of them is applied or the 
+ * caller blocks (or fails) without any of them taking effect.
+ *
+ * Batches can be committed with a timeout (semtimedop ()), without blocking 
+ * (IPC_NOWAIT), or forever. Opening a set with SEMSET_UNDO adds SEM_UNDO to 
+ * every operation so that the kernel reverts them if the process dies while 
+ * holding the semaphores.
+ *
+ * Date created: October 19, 2026
+ *
+ */
+#ifndef _SEMSET_H_
+#define _SEMSET_H_
+
+#include <sys/types.h>
+#include <sys/ipc.h>
+#include <sys/sem.h>
+
+#define SEMSET_UNDO 0x1             /* Apply SEM_UNDO to every operation on the set */
+
+/* Largest number of operations in one batch. The kernel limit (SEMOPM, see 
+ * /proc/sys/kernel/sem) is 500 on current Linux kernels. */
+#define SEMSET_MAX_OPS 64
+
+/* Timeouts for semset_commit () */
+#define SEMSET_WAIT_FOREVER (-1L)
+#define SEMSET_NO_WAIT 0L
+
+typedef struct semset {
+    int semid;                      /* Identifier resolved when the set was opened */
+    int nsems;
+    short sem_flg;                  /* Flags added to every operation */
+} semset_t;
+
+typedef struct semset_batch {
+    int nops;
+    struct sembuf ops[SEMSET_MAX_OPS];
+} semset_batch_t;
+
+/* Create a new set of nsems semaphores under key with the given permissions and 
+ * initial values (all zero if values is NULL). If the set already exists it is 
+ * opened instead. Returns 0 on success, -1 on error. */
+int semset_create (semset_t *set, key_t key, int nsems, const unsigned short *values, 
+                   int perms, int flags);
+
+/* Open an existing set of nsems semaphores. Waits for a concurrent creator to 
+ * finish initializing the set. Returns 0 on success, -1 on error. */
+int semset_open (semset_t *set, key_t key, int nsems, int flags);
+
+/* Remove the set from the system. */
+int semset_remove (semset_t *set);
+
+/* Return the current value of semaphore num, or -1 on error. */
+int semset_get_value (semset_t *set, int num);
+
+/* Add delta to semaphore num with a single semop () call. A negative delta 
+ * blocks until the semaphore is large enough. */
+int semset_op (semset_t *set, int num, int delta);
+
+/* The familiar P () and V () operations on semaphore num */
+#define semset_P(set, num) semset_op ((set), (num), -1)
+#define semset_V(set, num) semset_op ((set), (num), 1)
+
+/* Start a new, empty batch. */
+void semset_batch_init (semset_batch_t *batch);
+
+/* Append an operation on semaphore num to the batch. A delta of zero waits for 
+ * the semaphore to become zero. Returns -1 if the batch is full. */
+int semset_batch_add (semset_batch_t *batch, int num, int delta);
+
+/* Apply every operation in the batch atomically with one semop () call.
+ *
+ *   timeout_ms == SEMSET_WAIT_FOREVER  block until the batch can be applied
+ *   timeout_ms == SEMSET_NO_WAIT       fail with EAGAIN instead of blocking
+ *   timeout_ms > 0                     fail with EAGAIN once the time is up
+ *
+ * Returns 0 if the batch was applied, -1 otherwise (see errno). A wait that is 
+ * interrupted by a signal handler is resumed for the remaining time. */
+int semset_commit (semset_t *set, const semset_batch_t *batch, long timeout_ms);
+
+/* Build the inverse of a batch of decrements (P operations), so that the 
+ * semaphores taken by one commit can be handed back by another. */
+void semset_batch_invert (const semset_batch_t *batch, semset_batch_t *inverse);
+
+#endif /* _SEMSET_H_ */
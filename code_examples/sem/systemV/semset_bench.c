@@ -0,0 +1,224 @@
+/* Microbenchmark for the semaphore set helpers in semset.c. 
+ *
+ * Every test is reported in semaphore operations per second, where one P or V 
+ * on one semaphore counts as one operation, and in semop () calls per second:
+ *
+ *   lookup per op   -- semget () followed by semop () for every P and V, which 
+ *                      is what P () and V () in ../../shm/SystemV/sem_ops.c did
+ *   cached id       -- semset_P ()/semset_V (), one semop () per operation
+ *   cached id, undo -- the same with SEM_UNDO, which the kernel has to record
+ *   batch of N      -- N semaphores taken and released with one semop () each way
+ *   timed batch     -- the same through semtimedop ()
+ *
+ * Finally a number of processes run lock-manager style transactions against a 
+ * shared set: each transaction locks N randomly chosen semaphores in one atomic 
+ * batch and releases them with another. Because every batch is all-or-nothing, 
+ * the transactions cannot deadlock however their lock sets overlap.
+ *
+ * Usage: ./semset_bench [iterations] [batch size] [processes]
+ *
+ * Date created: October 19, 2026
+ *
+ * Compile as follows: 
+ * gcc -o semset_bench semset_bench.c semset.c -std=c99 -Wall -O2
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/wait.h>
+#include "semset.h"
+
+#define NUM_LOCKS 256               /* Size of the set used by the transaction test */
+
+static double 
+now_seconds (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void 
+report (const char *name, double ops, double calls, double elapsed)
+{
+    printf ("%-22s %12.0f ops/s %12.0f semop/s \n", name, ops / elapsed, calls / elapsed);
+}
+
+static void 
+die (const char *message)
+{
+    perror (message);
+    exit (EXIT_FAILURE);
+}
+
+/* P followed by V, resolving the key each time as sem_ops.c does */
+static void 
+bench_lookup (key_t key, long iterations)
+{
+    struct sembuf sop;
+    double start;
+    long i;
+    int id;
+
+    start = now_seconds ();
+    for (i = 0; i < iterations; i++){
+        sop.sem_num = 0;
+        sop.sem_flg = 0;
+        if ((id = semget (key, 1, 0666)) < 0)
+            die ("semget");
+        sop.sem_op = -1;
+        semop (id, &sop, 1);
+        if ((id = semget (key, 1, 0666)) < 0)
+            die ("semget");
+        sop.sem_op = 1;
+        semop (id, &sop, 1);
+    }
+    report ("lookup per op", 2.0 * iterations, 2.0 * iterations, now_seconds () - start);
+}
+
+static void 
+bench_cached (const char *name, semset_t *set, long iterations)
+{
+    double start;
+    long i;
+
+    start = now_seconds ();
+    for (i = 0; i < iterations; i++){
+        semset_P (set, 0);
+        semset_V (set, 0);
+    }
+    report (name, 2.0 * iterations, 2.0 * iterations, now_seconds () - start);
+}
+
+static void 
+bench_batch (const char *name, semset_t *set, int batch_size, long iterations, long timeout_ms)
+{
+    semset_batch_t acquire, release;
+    double start;
+    long i;
+    int j;
+
+    semset_batch_init (&acquire);
+    for (j = 0; j < batch_size; j++)
+        semset_batch_add (&acquire, j, -1);
+    semset_batch_invert (&acquire, &release);
+
+    start = now_seconds ();
+    for (i = 0; i < iterations; i++){
+        if (semset_commit (set, &acquire, timeout_ms) == -1)
+            die ("semset_commit");
+        if (semset_commit (set, &release, timeout_ms) == -1)
+            die ("semset_commit");
+    }
+    report (name, 2.0 * batch_size * iterations, 2.0 * iterations, now_seconds () - start);
+}
+
+/* Each transaction locks batch_size distinct semaphores out of NUM_LOCKS */
+static void 
+run_transactions (semset_t *set, int batch_size, long transactions, unsigned int seed)
+{
+    semset_batch_t acquire, release;
+    char chosen[NUM_LOCKS];
+    long i;
+    int j, lock;
+
+    for (i = 0; i < transactions; i++){
+        memset (chosen, 0, sizeof (chosen));
+        semset_batch_init (&acquire);
+        for (j = 0; j < batch_size; j++){
+            do
+                lock = rand_r (&seed) % NUM_LOCKS;
+            while (chosen[lock]);
+            chosen[lock] = 1;
+            semset_batch_add (&acquire, lock, -1);
+        }
+        semset_batch_invert (&acquire, &release);
+
+        if (semset_commit (set, &acquire, SEMSET_WAIT_FOREVER) == -1)
+            die ("semset_commit");
+        if (semset_commit (set, &release, SEMSET_WAIT_FOREVER) == -1)
+            die ("semset_commit");
+    }
+}
+
+static void 
+bench_transactions (int batch_size, long iterations, int processes)
+{
+    unsigned short values[NUM_LOCKS];
+    semset_t set;
+    double start, elapsed;
+    long per_process = iterations / processes;
+    int i;
+
+    for (i = 0; i < NUM_LOCKS; i++)
+        values[i] = 1;
+    if (semset_create (&set, IPC_PRIVATE, NUM_LOCKS, values, 0600, SEMSET_UNDO) == -1)
+        die ("semset_create");
+
+    start = now_seconds ();
+    for (i = 0; i < processes; i++){
+        if (fork () == 0){
+            run_transactions (&set, batch_size, per_process, getpid ());
+            _exit (EXIT_SUCCESS);
+        }
+    }
+    while (wait (NULL) > 0);
+    elapsed = now_seconds () - start;
+
+    for (i = 0; i < NUM_LOCKS; i++)
+        if (semset_get_value (&set, i) != 1)
+            printf ("Lock %d was not released \n", i);
+
+    printf ("%d processes, %ld transactions of %d locks: %.0f transactions/s, %.0f ops/s \n", 
+            processes, per_process * processes, batch_size, 
+            per_process * processes / elapsed, 2.0 * batch_size * per_process * processes / elapsed);
+    semset_remove (&set);
+}
+
+int 
+main (int argc, char **argv)
+{
+    long iterations = (argc > 1) ? atol (argv[1]) : 200000;
+    int batch_size = (argc > 2) ? atoi (argv[2]) : 16;
+    int processes = (argc > 3) ? atoi (argv[3]) : 4;
+    unsigned short *values;
+    semset_t set, undo_set;
+    key_t key;
+    char name[32];
+    int i;
+
+    if (iterations <= 0 || batch_size <= 0 || batch_size > SEMSET_MAX_OPS || processes <= 0){
+        printf ("Usage: %s [iterations] [batch size <= %d] [processes] \n", argv[0], SEMSET_MAX_OPS);
+        exit (EXIT_FAILURE);
+    }
+
+    values = (unsigned short *)malloc (batch_size * sizeof (unsigned short));
+    for (i = 0; i < batch_size; i++)
+        values[i] = 1;
+
+    /* The lookup test needs a key to resolve, so use one derived from our pid */
+    key = (key_t)(0x53450000 | (getpid () & 0xffff));
+    if (semset_create (&set, key, batch_size, values, 0600, 0) == -1)
+        die ("semset_create");
+    semset_open (&undo_set, key, batch_size, SEMSET_UNDO);
+
+    bench_lookup (key, iterations);
+    bench_cached ("cached id", &set, iterations);
+    bench_cached ("cached id, undo", &undo_set, iterations);
+    snprintf (name, sizeof (name), "batch of %d", batch_size);
+    bench_batch (name, &set, batch_size, iterations, SEMSET_WAIT_FOREVER);
+    snprintf (name, sizeof (name), "timed batch of %d", batch_size);
+    bench_batch (name, &set, batch_size, iterations, 1000);
+    semset_remove (&set);
+    free ((void *)values);
+
+    bench_transactions (batch_size, iterations, processes);
+
+    exit (EXIT_SUCCESS);
+}
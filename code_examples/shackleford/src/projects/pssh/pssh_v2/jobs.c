@@ -3,6 +3,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <signal.h>
+#include <pthread.h>
 
 #include "parse.h"
 #include "jobs.h"
@@ -11,6 +12,10 @@
 
 static volatile Job J[MAX_JOBS];
 
+/* The job table is shared by the main thread and the signal
+ * dispatcher thread, which reaps children on SIGCHLD */
+static pthread_mutex_t jobs_mutex = PTHREAD_MUTEX_INITIALIZER;
+
 
 void jobs_init ()
 {
@@ -25,6 +30,18 @@ void jobs_init ()
 }
 
 
+void jobs_lock (void)
+{
+    pthread_mutex_lock (&jobs_mutex);
+}
+
+
+void jobs_unlock (void)
+{
+    pthread_mutex_unlock (&jobs_mutex);
+}
+
+
 int job_add (pid_t* pids, char* cmdline, Parse* P)
 {
     unsigned int i;
@@ -19,6 +19,8 @@ typedef struct {
 } Job;
 
 void jobs_init ();
+void jobs_lock (void);
+void jobs_unlock (void);
 int job_add (pid_t* pids, char* cmdline, Parse* P);
 int job_get_number (pid_t pid);
 char* job_get_name (unsigned int jnum);
@@ -6,22 +6,30 @@
 #include <fcntl.h>
 #include <sys/wait.h>
 #include <signal.h>
+#include <errno.h>
+#include <pthread.h>
 
 #include "builtin.h"
 #include "parse.h"
 #include "jobs.h"
+#include "pipeline.h"
+#include "reactor.h"
+#include "signal_dispatcher.h"
 
 /*******************************************
  * Set to 1 to view the command line parse *
  *******************************************/
 #define DEBUG_PARSE 0
 
-#define READ_SIDE  0
-#define WRITE_SIDE 1
-
 
 static pid_t pssh_pgrp;
 
+/* The process group last given the terminal */
+static volatile pid_t fg_pgrp;
+
+/* Mask for handler() to wait with: what main() blocks, less SIGCONT */
+static sigset_t tty_wait_mask;
+
 
 static void print_banner ()
 {
@@ -95,64 +103,26 @@ static int command_found (const char* cmd)
 }
 
 
-/* change the file associated with descriptor fd_old
- * to that associated to fd_new and remove the fd_new entry */
-static void redirect (int fd_old, int fd_new)
+/* exec the specified task (either builtin or on the filesystem).
+ * Runs in the child, once the pipeline has set up its stdin and
+ * stdout */
+static int run (void* arg)
 {
-    if (fd_new != fd_old) {
-        dup2 (fd_new, fd_old);
-        close (fd_new);
-    }
-}
-
+    Task* T = arg;
+    sigset_t set;
 
-/* close a file descriptor only if it is not
- * stdin or stdout */
-static int close_safe (int fd)
-{
-    if ((fd != STDIN_FILENO) && fd != (STDOUT_FILENO))
-        return close (fd);
-
-    return -1;
-}
-
-
-/* exec the specified task (either builtin or on the filesystem)
- * with the specified input and output file descriptors */
-static void run (Task* T, int in, int out)
-{
-    redirect (STDIN_FILENO, in);
-    redirect (STDOUT_FILENO, out);
+    /* give the child the signal mask pssh started with */
+    sig_dispatcher_child_reset ();
+    sigemptyset (&set);
+    sigaddset (&set, SIGCONT);
+    sigprocmask (SIG_UNBLOCK, &set, NULL);
 
     if (is_builtin (T->cmd))
         builtin_execute (*T);
     else if (command_found (T->cmd))
         execvp (T->cmd, T->argv);
-}
-
 
-/* Opens the infile from the Parse, if it exists, and returns
- * the associated file descriptor.  Otherwise, returns the
- * default stdin (0) file descriptor */
-static int get_infile (Parse* P)
-{
-    if (P->infile)
-        return open (P->infile, 0);
-    else
-        return STDIN_FILENO;
-}
-
-
-/* Opens the outfile from the Parse, if it exists, or creates
- * it with -rw-rw-r-- permissions if it does not. Returns
- * the associated file descriptor.  Otherwise, returns the
- * default stdout (1) file descriptor */
-static int get_outfile (Parse* P)
-{
-    if (P->outfile)
-        return creat (P->outfile, 0664);
-    else
-        return STDOUT_FILENO;
+    return EXIT_SUCCESS;
 }
 
 
@@ -231,192 +201,358 @@ static int job_control (Parse* P)
 
 void set_fg_process_group (pid_t pgid)
 {
-    void (*old)(int);
-
-    old = signal (SIGTTOU, SIG_IGN);
+    sigset_t set, old;
+
+    /* the dispatcher thread calls this too: block SIGTTOU in the
+     * calling thread only, rather than changing its disposition
+     * for the whole process under the main thread's feet */
+    sigemptyset (&set);
+    sigaddset (&set, SIGTTOU);
+    pthread_sigmask (SIG_BLOCK, &set, &old);
     tcsetpgrp (STDIN_FILENO, pgid);
     tcsetpgrp (STDOUT_FILENO, pgid);
-    signal (SIGTTOU, old);
+    pthread_sigmask (SIG_SETMASK, &old, NULL);
+
+    /* handler() may be waiting for the terminal on the main
+     * thread; see wait_for_foreground() */
+    fg_pgrp = pgid;
+    if (pgid == pssh_pgrp)
+        kill (getpid (), SIGCONT);
 }
 
 
-static void handler (int sig)
+/* Touching the terminal from the background.  If one of our jobs
+ * has it, the dispatcher thread hands it back when the job stops or
+ * finishes, and wakes us with a SIGCONT.  Otherwise we were started
+ * in the background: stop, so that the parent shell sees a stopped
+ * job, until its fg continues us.  SIGCONT is blocked in every
+ * thread outside of the sigsuspend(), so one that arrives early is
+ * left pending for it rather than lost. */
+static void wait_for_foreground ()
 {
-    pid_t chld;
-    int jnum;
-    char* name;
-    int status;
+    pid_t fg;
 
+    while ((fg = tcgetpgrp (STDIN_FILENO)) != pssh_pgrp) {
+        if (fg != fg_pgrp)
+            kill (getpid (), SIGSTOP);
+        sigsuspend (&tty_wait_mask);
+    }
+}
+
+
+static void handler (int sig)
+{
     switch (sig) {
     case SIGTTOU:
-        while (tcgetpgrp (STDIN_FILENO) != pssh_pgrp)
-            pause ();
+        wait_for_foreground ();
 
         return;
 
     case SIGTTIN:
-        while (tcgetpgrp (STDIN_FILENO) != pssh_pgrp)
-            pause ();
+        wait_for_foreground ();
 
         break;
+    }
+}
+
+
+/* Only here so that SIGCONT interrupts sigsuspend() in handler() */
+static void wake (int sig)
+{
+}
+
+
+/* Children reaped before their job was added to the table: a job's
+ * tasks are forked without holding the job table, and can finish
+ * before execute_tasks() gets to job_add().  Protected by the job
+ * table's lock. */
+static struct {
+    pid_t pid;
+    int status;
+} *early;
+static unsigned int nearly, early_max;
+
+
+/* Handle a change of state of one child.  Called with the job
+ * table locked */
+static void child_changed (pid_t chld, int status)
+{
+    int jnum;
+    char* name;
+    void* tmp;
+
+    jnum = job_get_number (chld);
+    if (jnum < 0) {
+        if (nearly == early_max) {
+            tmp = realloc (early, (2*early_max + 8) * sizeof(*early));
+            if (!tmp)
+                return;
+            early = tmp;
+            early_max = 2*early_max + 8;
+        }
+        early[nearly].pid = chld;
+        early[nearly].status = status;
+        nearly++;
+
+        return;
+    }
+
+    if (WIFSTOPPED (status)) {
+        /* check job status so that we don't report the change
+         * to stdout multiple times for jobs having multiple
+         * pipelined processes */
+        if (job_status (jnum) != STOPPED) {
+            job_set_status (jnum, STOPPED);
+            set_fg_process_group (pssh_pgrp);
+
+            name = job_get_name (jnum);
+            printf ("[%u] + suspended\t%s\n", jnum, name);
+            fflush (stdout);
+            free (name);
+        }
+
+        return;
+    }
+    else if (WIFCONTINUED (status)) {
+        if (job_status (jnum) == STOPPED) {
+            name = job_get_name (jnum);
+            printf ("[%u] + continued\t%s\n", jnum, name);
+            fflush (stdout);
+            free (name);
 
-    case SIGCHLD:
-        while ((chld = waitpid (-1, &status, WNOHANG | WUNTRACED | WCONTINUED)) > 0) {
-            jnum = job_get_number (chld);
-
-            if (WIFSTOPPED (status)) {
-                /* check job status so that we don't report the change
-                 * to stdout multiple times for jobs having multiple
-                 * pipelined processes */
-                if (job_status (jnum) != STOPPED) {
-                    job_set_status (jnum, STOPPED);
-                    set_fg_process_group (pssh_pgrp);
-
-                    name = job_get_name (jnum);
-                    printf ("[%u] + suspended\t%s\n", jnum, name);
-                    fflush (stdout);
-                    free (name);
-                }
-
-                continue;
-            }
-            else if (WIFCONTINUED (status)) {
-                if (job_status (jnum) == STOPPED) {
-                    name = job_get_name (jnum);
-                    printf ("[%u] + continued\t%s\n", jnum, name);
-                    fflush (stdout);
-                    free (name);
-
-                    job_set_status (jnum, BG);
-                }
-
-                continue;
-            }
-            else {
-                job_remove_pid (chld);
-            }
-
-            if (job_is_done (jnum)) {
-                name = job_get_name (jnum);
-
-                if (job_status (jnum) != FG) {
-                    printf ("[%u] + done\t%s\n", jnum, name);
-                    fflush (stdout);
-                }
-                else if (job_status (jnum) == FG) {
-                    set_fg_process_group (pssh_pgrp);
-                }
-
-                job_delete (jnum);
-                free (name);
-            }
+            job_set_status (jnum, BG);
         }
+
+        return;
+    }
+    else {
+        job_remove_pid (chld);
+    }
+
+    if (job_is_done (jnum)) {
+        name = job_get_name (jnum);
+
+        if (job_status (jnum) != FG) {
+            printf ("[%u] + done\t%s\n", jnum, name);
+            fflush (stdout);
+        }
+        else if (job_status (jnum) == FG) {
+            set_fg_process_group (pssh_pgrp);
+        }
+
+        job_delete (jnum);
+        free (name);
     }
 }
 
 
+/* SIGCHLD is not caught by an asynchronous handler: printf(),
+ * malloc() and free() are not async-signal-safe.  Instead it is
+ * delivered to the signal dispatcher thread, which calls this
+ * function in normal thread context.  Pending SIGCHLDs are
+ * coalesced into one call, and waitpid() reaps every child that
+ * has changed state anyway. */
+static void sigchld_event (const siginfo_t* info, unsigned long count, void* arg)
+{
+    pid_t chld;
+    int status;
+
+    jobs_lock ();
+    while ((chld = waitpid (-1, &status, WNOHANG | WUNTRACED | WCONTINUED)) > 0)
+        child_changed (chld, status);
+    jobs_unlock ();
+}
+
+
 /* Called upon receiving a successful parse.
  * This function is responsible for cycling through the
  * tasks, and forking, executing, etc as necessary to get
  * the job done! */
 static void execute_tasks (Parse* P, char* job_name)
 {
-    unsigned int t;
-    int fd[2];
-    int in, out;
+    int t, n;
+    const pid_t* pids;
     pid_t* pid;
+    pipeline_t* pl;
 
 
     if (!is_possible (P))
         return;
 
-    if (job_control (P))
+    jobs_lock ();
+    t = job_control (P);
+    jobs_unlock ();
+    if (t)
         return;
 
-    /* free()d in SIGCLD handler when job is done */
-    pid = malloc (P->ntasks * sizeof(*pid));
+    /* the pipeline forks the tasks into a process group of their
+     * own, led by the first one, with the pipes, infile and outfile
+     * in place */
+    pl = pipeline_create (PIPELINE_NEW_PGRP);
+    if (!pl)
+        return;
 
-    in = get_infile (P);
+    for (t=0; t<P->ntasks; t++)
+        pipeline_add_fn (pl, run, &P->tasks[t]);
 
-    for (t=0; t<P->ntasks-1; t++) {
-        pipe (fd);
-        pid[t] = fork ();
-        setpgid (pid[t], pid[0]);  /* both prnt & chld do this */
+    if (P->infile)
+        pipeline_open (pl, 0, STDIN_FILENO, P->infile, O_RDONLY, 0);
 
-        if (!pid[t]) {
-            close (fd[READ_SIDE]);
-            run (&P->tasks[t], in, fd[WRITE_SIDE]);
-        }
+    if (P->outfile)
+        pipeline_open (pl, P->ntasks-1, STDOUT_FILENO, P->outfile,
+                       O_WRONLY | O_CREAT | O_TRUNC, 0664);
 
-        close (fd[WRITE_SIDE]);
-        close_safe (in);
+    if (pipeline_start (pl) < 0) {
+        printf ("pssh: failed to start job: %s\n", strerror (errno));
+        fflush (stdout);
+    }
 
-        in = fd[READ_SIDE];
+    /* free()d in SIGCLD handler when job is done.  a job that
+     * failed to start completely only tracks what did start */
+    pids = pipeline_pids (pl, &n);
+    if (n > 0 && (pid = malloc (n * sizeof(*pid)))) {
+        memcpy (pid, pids, n * sizeof(*pid));
+        P->ntasks = n;
+
+        jobs_lock ();
+        if (!P->background)
+            set_fg_process_group (pid[0]);
+
+        job_add (pid, job_name, P);
+
+        /* now that the job exists, catch up with any of its tasks
+         * that the dispatcher reaped in the meantime.  no other
+         * job can be waiting in here, so the rest is dropped */
+        for (t=0; t<nearly; t++)
+            if (job_get_number (early[t].pid) >= 0)
+                child_changed (early[t].pid, early[t].status);
+        nearly = 0;
+        jobs_unlock ();
     }
 
-    out = get_outfile (P);
+    pipeline_destroy (pl);
+}
 
-    pid[t] = fork ();
-    setpgid (pid[t], pid[0]);  /* both prnt & chld do this */
 
-    if (!P->background)
-        set_fg_process_group (pid[0]);
+/* Called by readline with each complete command line, or with
+ * NULL at EOF (ex: ctrl-d) */
+static void handle_line (char* cmdline)
+{
+    char* prompt;
+    char* job_name;
+    Parse* P;
+
+    if (!cmdline)
+        exit (EXIT_SUCCESS);
+
+    job_name = strdup (cmdline);
+
+    P = parse_cmdline (cmdline);
+    if (!P)
+        goto next;
+
+    if (P->invalid_syntax) {
+        printf ("pssh: invalid syntax\n");
+        fflush (stdout);
+        goto next;
+    }
+
+#if DEBUG_PARSE
+    parse_debug (P);
+#endif
 
-    if (!pid[t])
-        run (&P->tasks[t], in, out);
+    execute_tasks (P, job_name);
+
+next:
+    free (job_name);
+    parse_destroy (&P);
+    free (cmdline);
+
+    /* the working directory may have changed; installing the
+     * handler again shows the new prompt */
+    prompt = build_prompt ();
+    rl_callback_handler_install (prompt, handle_line);
+    free (prompt);
+}
 
-    close_safe (in);
-    close_safe (out);
 
-    job_add (pid, job_name, P);
+static void stdin_ready (reactor_t* r, int fd, uint32_t events, void* arg)
+{
+    rl_callback_read_char ();
 }
 
 
 int main (int argc, char** argv)
 {
     char* prompt;
-    char* cmdline;
-    char* job_name;
-    Parse* P;
+    reactor_t* reactor;
+    sigset_t set;
 
-    signal (SIGCHLD, handler);
     signal (SIGTTIN, handler);
     signal (SIGTTOU, handler);
+    signal (SIGCONT, wake);
+
+    /* SIGCONT is blocked before the dispatcher thread is started,
+     * so that it inherits the mask too; see handler() */
+    sigemptyset (&set);
+    sigaddset (&set, SIGCONT);
+    sigprocmask (SIG_BLOCK, &set, NULL);
+
+    /* SIGCHLD is blocked in every thread and handled by the
+     * dispatcher thread; see sigchld_event() */
+    sigemptyset (&set);
+    sigaddset (&set, SIGCHLD);
+    sig_dispatcher_register (SIGCHLD, sigchld_event, NULL, SIG_DISPATCH_COALESCE);
+    if (sig_dispatcher_start (&set) < 0)
+        exit (EXIT_FAILURE);
+
+    /* handler() waits with SIGTTIN and SIGTTOU still blocked, as
+     * they are while it runs, and SIGCONT let through */
+    sigprocmask (SIG_BLOCK, NULL, &tty_wait_mask);
+    sigdelset (&tty_wait_mask, SIGCONT);
+    sigaddset (&tty_wait_mask, SIGTTIN);
+    sigaddset (&tty_wait_mask, SIGTTOU);
 
     print_banner ();
     jobs_init ();
 
     pssh_pgrp = getpgrp ();
 
-    while (1) {
-        prompt = build_prompt ();
-        cmdline = readline (prompt);
-        free (prompt);
-
-        if (!cmdline)       /* EOF (ex: ctrl-d) */
-            exit (EXIT_SUCCESS);
-
-        job_name = strdup (cmdline);
-
-        P = parse_cmdline (cmdline);
-        if (!P)
-            goto next;
+    /* started in the background: wait to be brought to the
+     * foreground before readline saves the terminal's modes,
+     * which until then are the parent shell's */
+    if (isatty (STDIN_FILENO))
+        wait_for_foreground ();
+
+    /* readline's callback interface reads a character at a time
+     * whenever the reactor finds stdin readable, and hands each
+     * complete line to handle_line() */
+    prompt = build_prompt ();
+    rl_callback_handler_install (prompt, handle_line);
+    free (prompt);
+
+    reactor = reactor_create ();
+    if (!reactor) {
+        perror ("reactor_create");
+        exit (EXIT_FAILURE);
+    }
 
-        if (P->invalid_syntax) {
-            printf ("pssh: invalid syntax\n");
-            fflush (stdout);
-            goto next;
+    if (reactor_add (reactor, STDIN_FILENO, EPOLLIN, stdin_ready, NULL) < 0) {
+        /* epoll cannot watch a regular file (ex: a script on
+         * stdin), but reading one never blocks anyway */
+        if (errno != EPERM) {
+            perror ("reactor_add");
+            exit (EXIT_FAILURE);
         }
 
-#if DEBUG_PARSE
-        parse_debug (P);
-#endif
-
-        execute_tasks (P, job_name);
-        free (job_name);
+        while (1)
+            rl_callback_read_char ();
+    }
 
-    next:
-        parse_destroy (&P);
-        free(cmdline);
+    if (reactor_run (reactor) < 0) {
+        perror ("epoll_wait");
+        exit (EXIT_FAILURE);
     }
+
+    return 0;
 }
@@ -0,0 +1,517 @@
+/* Producer consumer example using a fixed pool of producers, a lock-free
+ * ring buffer and eventfd notification.
+ *
+ *   Date: 10/19/2026
+ *
+ * 04-pc_bad.c and 05-pc_cv.c create one detached thread per work unit
+ * (NUM_PRODUCERS = 10000) and pass the work units through a non-blocking
+ * pipe guarded by a mutex.  Every work unit costs a thread (and a stack),
+ * two system calls and two trips through the mutex, and when the pipe is
+ * full the work unit is simply dropped.
+ *
+ * Here a small pool of producer threads generates all the work units and
+ * hands them to the consumer through a bounded ring buffer in user memory:
+ *
+ *   - The ring is a multi-producer queue: each slot carries a sequence
+ *     number, and producers claim slots with a compare-and-swap on the tail
+ *     index.  No mutex is taken on the fast path.
+ *
+ *   - The consumer only makes a system call when the ring is empty.  It
+ *     announces that it is going to sleep by setting `consumer_waiting`,
+ *     checks the ring once more, and then blocks in read() on an eventfd.
+ *     A producer that sees the flag after publishing a work unit clears it
+ *     and writes the eventfd to wake the consumer up.
+ *
+ *   - When the ring is full, producers do not drop the work unit.  They
+ *     register in `space_waiters` and block on a second eventfd until the
+ *     consumer has freed some slots (backpressure).  The consumer keeps
+ *     count of the wakeups it has posted and that nobody has taken yet
+ *     (`space_wakeups`), and posts only what the waiters lack, never more
+ *     than the slots it has just freed.  So the semaphore count stays
+ *     bounded by the number of producers.
+ *
+ * The program also contains the one-thread-per-work-unit design of
+ * 05-pc_cv.c (without the random sleeps) so the two can be compared:
+ *
+ *   $ ./06-pc_ring ring   [work units] [producers] [ring slots]
+ *   $ ./06-pc_ring thread [work units]
+ *
+ * Both print the work units per second, the number of dropped work units,
+ * the peak number of threads and the stack memory they reserved.
+ *
+ * Compile using:
+ *   gcc -o 06-pc_ring 06-pc_ring.c -O2 -Wall -lpthread
+ */
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+
+#define DEFAULT_WORK_UNITS 10000
+#define DEFAULT_PRODUCERS 4
+#define DEFAULT_RING_SLOTS 1024
+
+#define READ_SIDE 0
+#define WRITE_SIDE 1
+
+
+struct ring_slot {
+    atomic_ulong seq;           /* == position when free, position+1 when full */
+    unsigned int value;
+};
+
+struct ring {
+    struct ring_slot* slots;
+    unsigned long mask;
+
+    /* Keep the producer and consumer indices on separate cache lines */
+    atomic_ulong tail __attribute__ ((aligned (64)));
+    unsigned long head __attribute__ ((aligned (64)));
+
+    atomic_int consumer_waiting __attribute__ ((aligned (64)));
+    atomic_int space_waiters;
+    atomic_int space_wakeups;   /* posted to space_fd, not yet taken */
+    int data_fd;                /* eventfd: work is available   */
+    int space_fd;               /* eventfd: slots are available */
+};
+
+struct producer_data {
+    pthread_t tid;
+    struct ring* ring;
+    unsigned int first;         /* first work unit produced by this thread */
+    unsigned int count;         /* # work units produced by this thread    */
+};
+
+
+/* Statistics shared by both designs */
+static atomic_int threads_alive;
+static atomic_int threads_peak;
+
+
+static void thread_started (void)
+{
+    int alive = atomic_fetch_add (&threads_alive, 1) + 1;
+    int peak = atomic_load (&threads_peak);
+
+    while (alive > peak && !atomic_compare_exchange_weak (&threads_peak, &peak, alive));
+}
+
+
+static void thread_finished (void)
+{
+    atomic_fetch_sub (&threads_alive, 1);
+}
+
+
+static double now_seconds (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+static void eventfd_signal (int fd, uint64_t n)
+{
+    while (write (fd, &n, sizeof (n)) < 0 && errno == EINTR);
+}
+
+
+static void eventfd_wait (int fd)
+{
+    uint64_t n;
+
+    while (read (fd, &n, sizeof (n)) < 0 && errno == EINTR);
+}
+
+
+int ring_init (struct ring* r, unsigned long slots)
+{
+    unsigned long i, size = 2;
+
+    /* A one-slot ring cannot tell "full" (seq == pos+1) from "free for the
+     * next lap" (seq == pos+size), so the ring has at least two slots */
+    while (size < slots)
+        size <<= 1;
+
+    memset (r, 0, sizeof (*r));
+    r->slots = malloc (size * sizeof (struct ring_slot));
+    if (!r->slots)
+        return -1;
+
+    for (i=0; i<size; i++)
+        atomic_init (&r->slots[i].seq, i);
+    r->mask = size - 1;
+
+    r->data_fd = eventfd (0, EFD_CLOEXEC);
+    r->space_fd = eventfd (0, EFD_CLOEXEC | EFD_SEMAPHORE);
+    if (r->data_fd < 0 || r->space_fd < 0)
+        return -1;
+
+    return 0;
+}
+
+
+void ring_destroy (struct ring* r)
+{
+    close (r->data_fd);
+    close (r->space_fd);
+    free (r->slots);
+}
+
+
+/* Try to claim a free slot and publish the value.  Returns 0 if the ring
+ * was full. */
+static int ring_try_push (struct ring* r, unsigned int value)
+{
+    struct ring_slot* slot;
+    unsigned long pos, seq;
+    long diff;
+
+    pos = atomic_load_explicit (&r->tail, memory_order_relaxed);
+    while (1) {
+        slot = &r->slots[pos & r->mask];
+        seq = atomic_load_explicit (&slot->seq, memory_order_acquire);
+        diff = (long)seq - (long)pos;
+
+        if (diff == 0) {
+            /* slot is free -- try to claim it */
+            if (atomic_compare_exchange_weak_explicit (&r->tail, &pos, pos + 1,
+                        memory_order_relaxed, memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            /* slot still holds a value from the previous lap: ring is full */
+            return 0;
+        } else {
+            /* another producer claimed this slot, reload the tail */
+            pos = atomic_load_explicit (&r->tail, memory_order_relaxed);
+        }
+    }
+
+    slot->value = value;
+    atomic_store_explicit (&slot->seq, pos + 1, memory_order_release);
+
+    return 1;
+}
+
+
+/* Push a value, blocking while the ring is full.  Wakes the consumer if it
+ * went to sleep on an empty ring. */
+void ring_push (struct ring* r, unsigned int value)
+{
+    while (!ring_try_push (r, value)) {
+        /* Backpressure: announce ourselves, re-check and sleep until the
+         * consumer frees some slots */
+        atomic_fetch_add (&r->space_waiters, 1);
+        atomic_thread_fence (memory_order_seq_cst);
+        if (!ring_try_push (r, value)) {
+            eventfd_wait (r->space_fd);
+            /* Give up the wakeup before leaving the waiters, see ring_pop() */
+            atomic_fetch_sub (&r->space_wakeups, 1);
+            atomic_fetch_sub (&r->space_waiters, 1);
+            continue;
+        }
+        atomic_fetch_sub (&r->space_waiters, 1);
+        break;
+    }
+
+    /* Pairs with the store to consumer_waiting in ring_pop(): either we see
+     * the flag, or the consumer sees our value when it re-checks */
+    atomic_thread_fence (memory_order_seq_cst);
+    if (atomic_load_explicit (&r->consumer_waiting, memory_order_relaxed) &&
+        atomic_exchange (&r->consumer_waiting, 0))
+        eventfd_signal (r->data_fd, 1);
+}
+
+
+/* Take one value if there is one.  Only the consumer calls this. */
+static int ring_try_pop (struct ring* r, unsigned int* value)
+{
+    struct ring_slot* slot = &r->slots[r->head & r->mask];
+
+    if (atomic_load_explicit (&slot->seq, memory_order_acquire) != r->head + 1)
+        return 0;
+
+    *value = slot->value;
+    atomic_store_explicit (&slot->seq, r->head + r->mask + 1, memory_order_release);
+    r->head++;
+
+    return 1;
+}
+
+
+/* Take up to max values, blocking until at least one is available.
+ * Returns the number of values taken. */
+unsigned int ring_pop (struct ring* r, unsigned int* values, unsigned int max)
+{
+    unsigned int n = 0;
+    int waiters, wakeups;
+
+    while (1) {
+        while (n < max && ring_try_pop (r, &values[n]))
+            n++;
+        if (n > 0)
+            break;
+
+        /* Ring is empty: announce that we are going to sleep, then check
+         * once more before actually blocking */
+        atomic_store (&r->consumer_waiting, 1);
+        atomic_thread_fence (memory_order_seq_cst);
+        if (ring_try_pop (r, &values[n])) {
+            atomic_store (&r->consumer_waiting, 0);
+            n++;
+            continue;
+        }
+        eventfd_wait (r->data_fd);
+        atomic_store (&r->consumer_waiting, 0);
+    }
+
+    /* Slots were freed: release producers blocked on a full ring.  Wakeups
+     * that are posted but not taken yet each release a waiter already, so
+     * only the difference is posted, and no more than n waiters can get a
+     * slot.  A waiter that found a slot on its re-check leaves an unused
+     * wakeup behind; the next waiter takes it and simply tries again. */
+    atomic_thread_fence (memory_order_seq_cst);
+    waiters = atomic_load (&r->space_waiters);
+    if (waiters > (int)n)
+        waiters = n;
+    wakeups = atomic_load (&r->space_wakeups);
+    if (waiters > wakeups) {
+        atomic_fetch_add (&r->space_wakeups, waiters - wakeups);
+        eventfd_signal (r->space_fd, waiters - wakeups);
+    }
+
+    return n;
+}
+
+
+void* ring_producer (void* param)
+{
+    struct producer_data* p = (struct producer_data*)param;
+    unsigned int i;
+
+    thread_started ();
+
+    /* < Produce some work > */
+    /*   As in 05-pc_cv.c, the work unit is simply its own number */
+    for (i=0; i<p->count; i++)
+        ring_push (p->ring, p->first + i);
+
+    thread_finished ();
+    return NULL;
+}
+
+
+/* Pooled design: a few producers, lock-free ring, eventfd wakeups */
+void run_ring (unsigned int work_units, unsigned int producers, unsigned long slots,
+               unsigned long long* sum, unsigned int* dropped)
+{
+    struct ring ring;
+    struct producer_data* P;
+    unsigned int values[256];
+    unsigned int i, n, received = 0;
+    unsigned int share = work_units / producers;
+    int rc;
+
+    if (ring_init (&ring, slots) < 0) {
+        perror ("ring_init");
+        exit (EXIT_FAILURE);
+    }
+
+    P = calloc (producers, sizeof (*P));
+    if (!P) {
+        perror ("calloc");
+        exit (EXIT_FAILURE);
+    }
+    for (i=0; i<producers; i++) {
+        P[i].ring = &ring;
+        P[i].first = i * share;
+        P[i].count = (i == producers - 1) ? work_units - i * share : share;
+        if ((rc = pthread_create (&P[i].tid, NULL, ring_producer, &P[i]))) {
+            errno = rc;
+            perror ("pthread_create");
+            exit (EXIT_FAILURE);
+        }
+    }
+
+    /* The main thread is the consumer */
+    *sum = 0;
+    while (received < work_units) {
+        n = ring_pop (&ring, values, 256);
+        for (i=0; i<n; i++)
+            *sum += values[i];
+        received += n;
+    }
+
+    for (i=0; i<producers; i++)
+        pthread_join (P[i].tid, NULL);
+
+    *dropped = 0;       /* producers block instead of dropping */
+    free (P);
+    ring_destroy (&ring);
+}
+
+
+/* One-thread-per-work-unit design of 05-pc_cv.c, minus the random sleeps */
+static struct {
+    unsigned int avail;
+    unsigned int producers;
+    unsigned int dropped;
+    int work_pipe[2];
+    pthread_mutex_t mtx;
+    pthread_cond_t cond;
+} sdata = {
+    .mtx = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER
+};
+
+
+void* pipe_producer (void* param)
+{
+    unsigned int result = (unsigned int)(uintptr_t)param;
+
+    thread_started ();
+
+    pthread_mutex_lock (&sdata.mtx);
+    if (write (sdata.work_pipe[WRITE_SIDE], &result, sizeof (unsigned int)) <= 0)
+        sdata.dropped++;        /* pipe is full, the work unit is lost */
+    else
+        sdata.avail++;
+    sdata.producers--;
+    pthread_mutex_unlock (&sdata.mtx);
+    pthread_cond_signal (&sdata.cond);
+
+    thread_finished ();
+    return NULL;
+}
+
+
+void run_thread_per_unit (unsigned int work_units,
+                          unsigned long long* sum, unsigned int* dropped)
+{
+    unsigned int i, work_unit;
+    pthread_t tid;
+    int finished = 0;
+
+    sdata.avail = 0;
+    sdata.dropped = 0;
+    sdata.producers = work_units;
+    pipe (sdata.work_pipe);
+    fcntl (sdata.work_pipe[READ_SIDE], F_SETFL, O_NONBLOCK);
+    fcntl (sdata.work_pipe[WRITE_SIDE], F_SETFL, O_NONBLOCK);
+
+    for (i=0; i<work_units; i++) {
+        if (pthread_create (&tid, NULL, pipe_producer, (void*)(uintptr_t)i)) {
+            /* out of threads: account for the work unit as dropped */
+            pthread_mutex_lock (&sdata.mtx);
+            sdata.dropped++;
+            sdata.producers--;
+            pthread_mutex_unlock (&sdata.mtx);
+            continue;
+        }
+        pthread_detach (tid);
+    }
+
+    *sum = 0;
+    while (!finished) {
+        pthread_mutex_lock (&sdata.mtx);
+        while (!sdata.avail && sdata.producers)
+            pthread_cond_wait (&sdata.cond, &sdata.mtx);
+
+        while (sdata.avail > 0 &&
+               read (sdata.work_pipe[READ_SIDE], &work_unit, sizeof (unsigned int)) > 0) {
+            *sum += work_unit;
+            sdata.avail--;
+        }
+
+        if (sdata.producers == 0 && sdata.avail == 0)
+            finished = 1;
+        pthread_mutex_unlock (&sdata.mtx);
+    }
+
+    /* wait for the detached producers to run to completion */
+    while (atomic_load (&threads_alive) > 0)
+        usleep (1000);
+
+    *dropped = sdata.dropped;
+    close (sdata.work_pipe[READ_SIDE]);
+    close (sdata.work_pipe[WRITE_SIDE]);
+}
+
+
+void print_usage (char* prog)
+{
+    printf ("Usage: %s ring   [work units] [producers] [ring slots]\n", prog);
+    printf ("       %s thread [work units]\n", prog);
+}
+
+
+int main (int argc, char** argv)
+{
+    unsigned int work_units = DEFAULT_WORK_UNITS;
+    unsigned int producers = DEFAULT_PRODUCERS;
+    unsigned long slots = DEFAULT_RING_SLOTS;
+    unsigned long long sum, expected = 0;
+    unsigned int i, dropped;
+    size_t stack_size;
+    pthread_attr_t attr;
+    double start, elapsed;
+    int use_ring;
+
+    if (argc < 2 || (strcmp (argv[1], "ring") && strcmp (argv[1], "thread"))) {
+        print_usage (argv[0]);
+        exit (EXIT_FAILURE);
+    }
+    use_ring = !strcmp (argv[1], "ring");
+
+    if (argc > 2)
+        work_units = atoi (argv[2]);
+    if (argc > 3)
+        producers = atoi (argv[3]);
+    if (argc > 4)
+        slots = atol (argv[4]);
+    if (work_units == 0 || producers == 0 || slots == 0) {
+        print_usage (argv[0]);
+        exit (EXIT_FAILURE);
+    }
+
+    start = now_seconds ();
+    if (use_ring)
+        run_ring (work_units, producers, slots, &sum, &dropped);
+    else
+        run_thread_per_unit (work_units, &sum, &dropped);
+    elapsed = now_seconds () - start;
+
+    /* Compute what the answer should have been using a single thread */
+    for (i=0; i<work_units; i++)
+        expected += i;
+
+    pthread_attr_init (&attr);
+    pthread_attr_getstacksize (&attr, &stack_size);
+    pthread_attr_destroy (&attr);
+
+    if (use_ring)
+        printf ("design:            %u producers, %lu-slot ring, eventfd\n", producers, slots);
+    else
+        printf ("design:            one thread per work unit, pipe + mutex\n");
+    printf ("work units:        %u in %.3f s (%.0f units/s)\n",
+            work_units, elapsed, work_units / elapsed);
+    printf ("dropped:           %u\n", dropped);
+    printf ("peak threads:      %d (+1 consumer)\n", atomic_load (&threads_peak));
+    printf ("stack reserved:    %.1f MB at peak (%zu KB per thread)\n",
+            atomic_load (&threads_peak) * (double)stack_size / (1 << 20), stack_size >> 10);
+    printf ("  Work unit sum:   %llu\n", sum);
+    printf ("Expected result:   %llu\n", expected);
+
+    return 0;
+}
@@ -0,0 +1,167 @@
+/* Spinning and hybrid locks -- see locks.h
+ *
+ *   Date: 10/19/2026
+ *
+ * Compile using:
+ *   gcc -c -O2 -o locks.o locks.c
+ */
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <unistd.h>
+#include <sched.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+#include "locks.h"
+
+
+/* Tell the CPU we are in a spin-wait loop.  On x86 `pause` saves power and
+ * avoids a memory order mis-speculation penalty when the loop exits. */
+static inline void cpu_relax (void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause ();
+#elif defined(__aarch64__)
+    __asm__ __volatile__ ("yield");
+#endif
+}
+
+
+/* One step of a spin-wait loop that gives up the processor now and then */
+static inline void spin_step (unsigned int* spins)
+{
+    if (++(*spins) % SPIN_YIELD_THRESHOLD == 0)
+        sched_yield ();
+    else
+        cpu_relax ();
+}
+
+
+static void futex_wait (atomic_int* addr, int val)
+{
+    syscall (SYS_futex, addr, FUTEX_WAIT_PRIVATE, val, NULL, NULL, 0);
+}
+
+
+static void futex_wake (atomic_int* addr, int n)
+{
+    syscall (SYS_futex, addr, FUTEX_WAKE_PRIVATE, n, NULL, NULL, 0);
+}
+
+
+/* ---- adaptive spin-then-park mutex ---- */
+
+void adaptive_mutex_lock (adaptive_mutex_t* m)
+{
+    int expected = 0;
+    int spins, max_spins, estimate;
+
+    if (atomic_compare_exchange_strong (&m->state, &expected, 1))
+        return;
+
+    /* Spin for up to twice the number of iterations it took to get the
+     * lock in the past.  A lock that is usually released quickly gets a
+     * long spin; one that is held for a long time is parked right away. */
+    estimate = atomic_load_explicit (&m->spin_estimate, memory_order_relaxed);
+    max_spins = 2 * estimate + 10;
+    if (max_spins > ADAPTIVE_MAX_SPINS)
+        max_spins = ADAPTIVE_MAX_SPINS;
+
+    for (spins=0; spins<max_spins; spins++) {
+        cpu_relax ();
+        if (atomic_load_explicit (&m->state, memory_order_relaxed) != 0)
+            continue;
+
+        expected = 0;
+        if (atomic_compare_exchange_weak (&m->state, &expected, 1)) {
+            /* spin_estimate += (spins - spin_estimate) / 8 */
+            atomic_store_explicit (&m->spin_estimate,
+                    estimate + (spins - estimate) / 8, memory_order_relaxed);
+            return;
+        }
+    }
+
+    /* Spinning did not pay off; shrink the estimate by an eighth, so that
+     * a lock that keeps being held past the spin limit is soon parked on
+     * after only a few spins, and go to sleep.  The state is set to 2 so
+     * that the owner knows it has to wake us up. */
+    atomic_store_explicit (&m->spin_estimate,
+            estimate - estimate / 8, memory_order_relaxed);
+
+    while (atomic_exchange (&m->state, 2) != 0)
+        futex_wait (&m->state, 2);
+}
+
+
+void adaptive_mutex_unlock (adaptive_mutex_t* m)
+{
+    if (atomic_exchange (&m->state, 0) == 2)
+        futex_wake (&m->state, 1);
+}
+
+
+/* ---- ticket lock ---- */
+
+void ticket_lock (ticket_lock_t* l)
+{
+    unsigned int ticket = atomic_fetch_add_explicit (&l->next, 1, memory_order_relaxed);
+    unsigned int spins = 0;
+
+    while (atomic_load_explicit (&l->owner, memory_order_acquire) != ticket)
+        spin_step (&spins);
+}
+
+
+void ticket_unlock (ticket_lock_t* l)
+{
+    unsigned int owner = atomic_load_explicit (&l->owner, memory_order_relaxed);
+
+    atomic_store_explicit (&l->owner, owner + 1, memory_order_release);
+}
+
+
+/* ---- MCS queue lock ---- */
+
+void mcs_lock (mcs_lock_t* l, mcs_node_t* node)
+{
+    mcs_node_t* pred;
+    unsigned int spins = 0;
+
+    atomic_store_explicit (&node->next, NULL, memory_order_relaxed);
+    atomic_store_explicit (&node->locked, 1, memory_order_relaxed);
+
+    /* Append ourselves to the queue.  If there was nobody in it, the lock
+     * is ours. */
+    pred = atomic_exchange_explicit (&l->tail, node, memory_order_acq_rel);
+    if (pred == NULL)
+        return;
+
+    /* Link in behind the predecessor and spin on our own node until it
+     * hands the lock over */
+    atomic_store_explicit (&pred->next, node, memory_order_release);
+    while (atomic_load_explicit (&node->locked, memory_order_acquire))
+        spin_step (&spins);
+}
+
+
+void mcs_unlock (mcs_lock_t* l, mcs_node_t* node)
+{
+    mcs_node_t* next = atomic_load_explicit (&node->next, memory_order_acquire);
+    mcs_node_t* expected = node;
+    unsigned int spins = 0;
+
+    if (next == NULL) {
+        /* No known successor: if we are still the tail, the queue is empty */
+        if (atomic_compare_exchange_strong_explicit (&l->tail, &expected, NULL,
+                    memory_order_acq_rel, memory_order_relaxed))
+            return;
+
+        /* A successor swapped itself in but has not linked up yet */
+        while ((next = atomic_load_explicit (&node->next, memory_order_acquire)) == NULL)
+            spin_step (&spins);
+    }
+
+    atomic_store_explicit (&next->locked, 0, memory_order_release);
+}
@@ -0,0 +1,82 @@
+/* Spinning and hybrid locks for very short critical sections.
+ *
+ * This example consists of the following three files:
+ *   -- 07-lock_bench.c
+ *   -- locks.c          (implementation)
+ *   -- locks.h          (this file)
+ *
+ *   Date: 10/19/2026
+ *
+ * pthread_mutex_lock() puts a thread to sleep in the kernel as soon as the
+ * mutex is taken.  When the critical section is only a couple of integer
+ * operations (see asm/asm.c), the sleep/wakeup round trip costs far more
+ * than the work the lock protects.  Three alternatives are provided:
+ *
+ *   adaptive_mutex -- spins with the x86 `pause` instruction for a bounded
+ *                     number of iterations and only then parks the thread
+ *                     on a futex.  The spin limit adapts to how long the
+ *                     lock was actually held in the past.
+ *
+ *   ticket_lock    -- first-come first-served spinlock.  Fair, but every
+ *                     waiter spins on the same cache line.
+ *
+ *   mcs_lock       -- queue lock in which every waiter spins on its own
+ *                     node, so a release only touches the next waiter's
+ *                     cache line.  Fair and scales to many cores.
+ *
+ * The ticket and MCS locks never sleep in the kernel, but they yield the
+ * processor after spinning for a while so that an oversubscribed machine
+ * still makes progress.
+ */
+
+#ifndef _locks_h_
+#define _locks_h_
+
+#include <stdatomic.h>
+
+/* Upper bound for the adaptive spin count */
+#define ADAPTIVE_MAX_SPINS 4000
+
+/* Spin iterations before ticket/MCS waiters call sched_yield() */
+#define SPIN_YIELD_THRESHOLD 128
+
+
+typedef struct {
+    atomic_int state;          /* 0: free, 1: locked, 2: locked with sleepers */
+    atomic_int spin_estimate;  /* running average of spins needed to acquire */
+} adaptive_mutex_t;
+
+#define ADAPTIVE_MUTEX_INITIALIZER { 0, 100 }
+
+void adaptive_mutex_lock (adaptive_mutex_t* m);
+void adaptive_mutex_unlock (adaptive_mutex_t* m);
+
+
+typedef struct {
+    atomic_uint next;          /* next ticket to hand out  */
+    atomic_uint owner;         /* ticket being served now  */
+} ticket_lock_t;
+
+#define TICKET_LOCK_INITIALIZER { 0, 0 }
+
+void ticket_lock (ticket_lock_t* l);
+void ticket_unlock (ticket_lock_t* l);
+
+
+/* Every thread passes its own node to mcs_lock() and the same node to the
+ * matching mcs_unlock().  A node may only be queued on one lock at a time. */
+typedef struct mcs_node {
+    struct mcs_node* _Atomic next;
+    atomic_int locked;
+} mcs_node_t;
+
+typedef struct {
+    mcs_node_t* _Atomic tail;
+} mcs_lock_t;
+
+#define MCS_LOCK_INITIALIZER { NULL }
+
+void mcs_lock (mcs_lock_t* l, mcs_node_t* node);
+void mcs_unlock (mcs_lock_t* l, mcs_node_t* node);
+
+#endif /* _locks_h_ */
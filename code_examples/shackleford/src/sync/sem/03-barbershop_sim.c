@@ -0,0 +1,463 @@
+/* A parametric version of the sleeping barber problem (see 02-sleeping_barber.c)
+ * that can be used as a queueing model of a pool of worker threads.
+ *
+ *   - M barbers (servers) share one waiting room with a bounded number of
+ *     chairs.  A customer who finds every chair taken leaves (is dropped).
+ *   - Customers arrive as a Poisson process.  Instead of one thread per
+ *     customer, a few driver threads generate the arrivals, each driving an
+ *     equal share of the total arrival rate.
+ *   - Service times are exponentially distributed with a mean given in
+ *     microseconds.  The barbers spin for the service time instead of
+ *     sleeping, the way a CPU-bound worker would, so M should not exceed
+ *     the number of available cores.
+ *
+ * At the end the simulator reports the offered load, throughput, drop rate
+ * and the distribution of the time customers spent in the waiting room.
+ *
+ * Example: 4 barbers, 16 chairs, 30000 arrivals/sec, 100 us mean service,
+ * 5 seconds, 2 drivers (offered load 0.75):
+ *
+ *   $ ./03-barbershop_sim 4 16 30000 100 5 2
+ *
+ * Compile using:
+ *   gcc -o 03-barbershop_sim 03-barbershop_sim.c -O2 -Wall -lpthread -lm
+ */
+
+#define _GNU_SOURCE
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <math.h>
+#include <time.h>
+#include <errno.h>
+
+/* Make true and false situations more readable */
+#define FALSE 0
+#define TRUE !FALSE
+
+/* Make calls to sem_init() more readable */
+#define THREAD_LEVEL_SHARING 0
+#define PROCESS_LEVEL_SHARING 1
+
+#define DEFAULT_DRIVERS 2
+
+/* Data structure containing a Barber's state information and statistics */
+struct barber_data {
+    unsigned int id;            /* ID # of the barber                          */
+    pthread_t tid;              /* Barber's thread id                          */
+    unsigned int seed;          /* State of the barber's random number stream  */
+    unsigned long served;       /* # customers served by this barber           */
+    double busy_us;             /* Total time spent cutting hair               */
+    unsigned int* waits;        /* Waiting room time of each customer (us)     */
+    unsigned long waits_len;
+    unsigned long waits_max;
+
+    struct shop_data* shop;     /* Pointer to the shop's state information     */
+};
+
+/* Data structure containing a driver's (customer generator's) state */
+struct driver_data {
+    unsigned int id;            /* ID # of the driver                          */
+    pthread_t tid;              /* Driver's thread id                          */
+    unsigned int seed;          /* State of the driver's random number stream  */
+    unsigned long arrivals;     /* # customers this driver sent to the shop    */
+
+    struct shop_data* shop;     /* Pointer to the shop's state information     */
+};
+
+/* Data structure containing the Shop's state information */
+struct shop_data {
+    unsigned int num_barbers;   /* # barbers (servers)                         */
+    unsigned int num_chairs;    /* # chairs in the waiting room                */
+    unsigned int num_drivers;   /* # threads generating arrivals               */
+    double arrival_rate;        /* Customers per second, all drivers together  */
+    double service_us;          /* Mean service time in microseconds           */
+    double duration;            /* Length of the simulation in seconds         */
+
+    /* The waiting room is a ring buffer holding the arrival time of every
+     * waiting customer.  It is protected by "lock", and "customers" counts
+     * the number of customers waiting, on which idle barbers sleep. */
+    struct timespec* chairs;
+    unsigned int head;
+    unsigned int count;
+    pthread_mutex_t lock;
+    sem_t customers;
+
+    unsigned long dropped;      /* # customers turned away (room was full)     */
+    unsigned int closing;       /* True once the drivers have stopped          */
+
+    struct barber_data* barber;
+    struct driver_data* driver;
+};
+
+
+/* This function prints the usage for the program and details what the various
+ * command line parameters do */
+void print_usage (char* prog)
+{
+    printf("Usage: %s barbers chairs rate service_us seconds [drivers]\n\n", prog);
+    printf("   barbers     -      # of barbers (servers)\n");
+    printf("   chairs      -      # of chairs in the waiting room (queue bound)\n");
+    printf("   rate        -      mean # of customer arrivals per second\n");
+    printf("   service_us  -      mean service time in microseconds\n");
+    printf("   seconds     -      length of the simulation\n");
+    printf("   drivers     -      # of arrival generator threads (default %d)\n\n",
+            DEFAULT_DRIVERS);
+}
+
+
+/* Returns the time elapsed from a to b in microseconds */
+double elapsed_us (struct timespec* a, struct timespec* b)
+{
+    return (b->tv_sec - a->tv_sec) * 1e6 + (b->tv_nsec - a->tv_nsec) / 1e3;
+}
+
+
+/* Advances a time stamp by the given number of microseconds */
+void timespec_add_us (struct timespec* t, double us)
+{
+    long long ns = t->tv_nsec + (long long)(us * 1e3);
+
+    t->tv_sec += ns / 1000000000LL;
+    t->tv_nsec = ns % 1000000000LL;
+}
+
+
+/* Returns an exponentially distributed random number with the given mean */
+double random_exp (unsigned int* seed, double mean)
+{
+    double u = (double)rand_r(seed) / ((double)RAND_MAX + 1.0);
+
+    return -mean * log(1.0 - u);
+}
+
+
+/* Busy-wait for the given number of microseconds */
+void spin_for (double us)
+{
+    struct timespec start, now;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    do {
+        clock_gettime(CLOCK_MONOTONIC, &now);
+    } while (elapsed_us(&start, &now) < us);
+}
+
+
+/* Thread defining Barber's behavior */
+void* thread_barber (void* param)
+{
+    struct barber_data* barber;
+    struct shop_data* shop;
+    struct timespec arrived, now;
+    unsigned int* tmp;
+    unsigned int closing;
+    double cut_time;
+
+    barber = (struct barber_data*)param;
+    shop = barber->shop;
+
+    while (1) {
+        /* sleep until there is a customer in the waiting room */
+        sem_wait(&shop->customers);
+
+        pthread_mutex_lock(&shop->lock);
+        if (shop->count == 0) {
+            /* woken up to go home: the drivers are done & the room is
+             * empty.  Every other wakeup comes with a customer. */
+            closing = shop->closing;
+            pthread_mutex_unlock(&shop->lock);
+            if (closing)
+                break;
+            continue;
+        }
+        arrived = shop->chairs[shop->head];
+        shop->head = (shop->head + 1) % shop->num_chairs;
+        shop->count--;
+        pthread_mutex_unlock(&shop->lock);
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (barber->waits_len == barber->waits_max) {
+            barber->waits_max = barber->waits_max ? 2 * barber->waits_max : 4096;
+            tmp = realloc(barber->waits, barber->waits_max * sizeof(*tmp));
+            if (!tmp) {
+                fprintf(stderr, "error -- out of memory for statistics\n");
+                exit(EXIT_FAILURE);
+            }
+            barber->waits = tmp;
+        }
+        barber->waits[barber->waits_len++] = (unsigned int)elapsed_us(&arrived, &now);
+
+        cut_time = random_exp(&barber->seed, shop->service_us);
+        spin_for(cut_time);
+        barber->busy_us += cut_time;
+        barber->served++;
+    }
+
+    return NULL;
+}
+
+
+/* Thread generating a Poisson stream of customers.  Each driver handles an
+ * equal share of the total arrival rate, which keeps the merged stream
+ * Poisson with the requested rate. */
+void* thread_driver (void* param)
+{
+    struct driver_data* driver;
+    struct shop_data* shop;
+    struct timespec start, next, now;
+    double mean_gap_us;
+    unsigned int tail;
+
+    driver = (struct driver_data*)param;
+    shop = driver->shop;
+    mean_gap_us = 1e6 * shop->num_drivers / shop->arrival_rate;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    next = start;
+
+    while (1) {
+        timespec_add_us(&next, random_exp(&driver->seed, mean_gap_us));
+        if (elapsed_us(&start, &next) >= shop->duration * 1e6)
+            break;
+
+        /* sleep until the next arrival is due.  If we have fallen behind,
+         * arrive right away so the long-run rate stays correct. */
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (elapsed_us(&now, &next) > 0)
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL) == EINTR);
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        driver->arrivals++;
+
+        pthread_mutex_lock(&shop->lock);
+        if (shop->count == shop->num_chairs) {
+            /* waiting room is full -- the customer leaves */
+            shop->dropped++;
+            pthread_mutex_unlock(&shop->lock);
+            continue;
+        }
+        tail = (shop->head + shop->count) % shop->num_chairs;
+        shop->chairs[tail] = now;
+        shop->count++;
+        pthread_mutex_unlock(&shop->lock);
+
+        /* wake up a sleeping barber, if there is one */
+        sem_post(&shop->customers);
+    }
+
+    return NULL;
+}
+
+
+/* This function parses the command line arguments and populates the
+ * shop_data data structure */
+int barbershop_create (struct shop_data* shop, int argc, char** argv)
+{
+    int ret;
+
+    /* did the user specify all required command line parameters? */
+    if (argc < 6) {
+        print_usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+
+    memset(shop, 0, sizeof(*shop));
+    shop->num_barbers = atoi(argv[1]);
+    shop->num_chairs = atoi(argv[2]);
+    shop->arrival_rate = atof(argv[3]);
+    shop->service_us = atof(argv[4]);
+    shop->duration = atof(argv[5]);
+    shop->num_drivers = (argc > 6) ? atoi(argv[6]) : DEFAULT_DRIVERS;
+
+    /* sanity check user input */
+    if (atoi(argv[1]) <= 0 || atoi(argv[2]) <= 0 || shop->num_drivers <= 0 ||
+        (argc > 6 && atoi(argv[6]) <= 0)) {
+        fprintf(stderr, "error -- # of barbers, chairs and drivers must be positive\n");
+        print_usage(argv[0]);
+        return -1;
+    }
+
+    if (shop->arrival_rate <= 0 || shop->service_us <= 0 || shop->duration <= 0) {
+        fprintf(stderr, "error -- rate, service time and duration must be positive\n");
+        print_usage(argv[0]);
+        return -1;
+    }
+
+    shop->chairs = malloc(shop->num_chairs * sizeof(*shop->chairs));
+    if (!shop->chairs)
+        return -1;
+
+    ret = pthread_mutex_init(&shop->lock, NULL);
+    if (ret)
+        return ret;
+    ret = sem_init(&shop->customers, THREAD_LEVEL_SHARING, 0);
+    if (ret)
+        return ret;
+
+    return 0;
+}
+
+
+/* Cleans up any resources allocated by barbershop_create() */
+void barbershop_destroy (struct shop_data* shop)
+{
+    sem_destroy(&shop->customers);
+    pthread_mutex_destroy(&shop->lock);
+    free(shop->chairs);
+}
+
+
+/* Creates the barber and the driver threads */
+int threads_create (struct shop_data* shop)
+{
+    int i;
+
+    shop->barber = calloc(shop->num_barbers, sizeof(struct barber_data));
+    shop->driver = calloc(shop->num_drivers, sizeof(struct driver_data));
+    if (!shop->barber || !shop->driver)
+        return -1;
+
+    for (i=0; i<shop->num_barbers; i++) {
+        shop->barber[i].id = i;
+        shop->barber[i].seed = 1000 + i;
+        shop->barber[i].shop = shop;
+        if (pthread_create(&shop->barber[i].tid, NULL, thread_barber, &shop->barber[i]))
+            return -1;
+    }
+
+    for (i=0; i<shop->num_drivers; i++) {
+        shop->driver[i].id = i;
+        shop->driver[i].seed = 1 + i;
+        shop->driver[i].shop = shop;
+        if (pthread_create(&shop->driver[i].tid, NULL, thread_driver, &shop->driver[i]))
+            return -1;
+    }
+
+    return 0;
+}
+
+
+/* Waits for the drivers to finish, lets the barbers serve the customers
+ * still in the waiting room and then sends them home */
+void threads_join (struct shop_data* shop)
+{
+    int i;
+
+    for (i=0; i<shop->num_drivers; i++)
+        pthread_join(shop->driver[i].tid, NULL);
+
+    pthread_mutex_lock(&shop->lock);
+    shop->closing = TRUE;
+    pthread_mutex_unlock(&shop->lock);
+
+    /* one extra wakeup per barber; a barber that finds the room empty leaves */
+    for (i=0; i<shop->num_barbers; i++)
+        sem_post(&shop->customers);
+
+    for (i=0; i<shop->num_barbers; i++)
+        pthread_join(shop->barber[i].tid, NULL);
+}
+
+
+int compare_uint (const void* a, const void* b)
+{
+    unsigned int x = *(const unsigned int*)a;
+    unsigned int y = *(const unsigned int*)b;
+
+    return (x > y) - (x < y);
+}
+
+
+/* Returns the value below which the given fraction of the sorted samples lie */
+unsigned int percentile (unsigned int* sorted, unsigned long n, double p)
+{
+    unsigned long idx;
+
+    if (n == 0)
+        return 0;
+
+    idx = (unsigned long)(p * (n - 1) + 0.5);
+    return sorted[idx];
+}
+
+
+/* Merges the per-barber statistics and prints the report */
+void report (struct shop_data* shop, double elapsed)
+{
+    unsigned long arrivals = 0, served = 0, n = 0;
+    unsigned int* waits;
+    double busy_us = 0, total_wait = 0;
+    int i;
+
+    for (i=0; i<shop->num_drivers; i++)
+        arrivals += shop->driver[i].arrivals;
+
+    for (i=0; i<shop->num_barbers; i++) {
+        served += shop->barber[i].served;
+        busy_us += shop->barber[i].busy_us;
+    }
+
+    waits = malloc((served ? served : 1) * sizeof(*waits));
+    for (i=0; i<shop->num_barbers; i++) {
+        memcpy(waits + n, shop->barber[i].waits, shop->barber[i].waits_len * sizeof(*waits));
+        n += shop->barber[i].waits_len;
+        free(shop->barber[i].waits);
+    }
+    qsort(waits, n, sizeof(*waits), compare_uint);
+    for (i=0; i<n; i++)
+        total_wait += waits[i];
+
+    printf("barbers %u, chairs %u, drivers %u, %.0f arrivals/s, %.1f us mean service\n",
+            shop->num_barbers, shop->num_chairs, shop->num_drivers,
+            shop->arrival_rate, shop->service_us);
+    printf("   offered load     %.3f per barber\n",
+            shop->arrival_rate * shop->service_us / 1e6 / shop->num_barbers);
+    printf("   utilization      %.3f per barber\n",
+            busy_us / (elapsed * 1e6) / shop->num_barbers);
+    printf("   arrivals         %lu (%.0f /s)\n", arrivals, arrivals / elapsed);
+    printf("   served           %lu (%.0f /s)\n", served, served / elapsed);
+    printf("   dropped          %lu (%.3f%%)\n", shop->dropped,
+            arrivals ? 100.0 * shop->dropped / arrivals : 0.0);
+    printf("   wait mean        %.1f us\n", n ? total_wait / n : 0.0);
+    printf("   wait p50         %u us\n", percentile(waits, n, 0.50));
+    printf("   wait p90         %u us\n", percentile(waits, n, 0.90));
+    printf("   wait p99         %u us\n", percentile(waits, n, 0.99));
+    printf("   wait max         %u us\n", n ? waits[n-1] : 0);
+
+    free(waits);
+}
+
+
+int main (int argc, char** argv)
+{
+    struct shop_data shop;
+    struct timespec start, end;
+    int ret;
+
+    ret = barbershop_create(&shop, argc, argv);
+    if (ret) {
+        fprintf(stderr, "error -- barbershop_create() failure\n");
+        exit(EXIT_FAILURE);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ret = threads_create(&shop);
+    if (ret) {
+        fprintf(stderr, "error -- threads_create() failure\n");
+        exit(EXIT_FAILURE);
+    }
+    threads_join(&shop);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    report(&shop, elapsed_us(&start, &end) / 1e6);
+
+    free(shop.barber);
+    free(shop.driver);
+    barbershop_destroy(&shop);
+
+    return 0;
+}
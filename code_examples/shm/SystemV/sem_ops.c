@@ -1,27 +1,55 @@
 #define _SVID_SOURCE
 
+#include <errno.h>
 #include "shm_xfr.h"
 
-/* The probe or wait operation on the semaphore */
-void 
-P (int key)
+/* Identifier of the most recently used semaphore. Looking the semaphore up with 
+ * semget () on every P () and V () doubles the number of system calls, so the 
+ * identifier is resolved once and reused. A cached identifier goes stale if the 
+ * semaphore is removed and created again, in which case semop () fails with 
+ * EINVAL or EIDRM and we look it up afresh. 
+ *
+ * See ../../sem/systemV/semset.c for helpers that also batch several operations 
+ * into a single semop (). */
+static int cached_key = -1;
+static int cached_id = -1;
+
+static int 
+lookup_semaphore (int key, int refresh)
 {
-	int id;
-	struct sembuf operations[1]; /* An array of one operation to perform on the semaphore */
+	if (refresh || key != cached_key){
+		if ((cached_id = semget (key, 1, 0666)) < 0){
+			perror ("semget");
+			exit (EXIT_FAILURE);
+		}
+		cached_key = key;
+	}
+	return cached_id;
+}
 
-	/* Get the index of the semaphore using the provided key. */
-  	if ((id = semget (key, 1, 0666)) < 0){
-		perror ("semget");
-		exit (EXIT_FAILURE);
-  	}
+/* Perform one operation on the semaphore, retrying once with a fresh identifier */
+static int 
+semaphore_op (int key, int delta)
+{
+	struct sembuf operations[1]; /* An array of one operation to perform on the semaphore */
+	int status;
 
-    /* Perform the semaphore P operation. */
   	operations[0].sem_num = 0; /* We are operating on semaphore 0 in the array of semaphores */
-  	operations[0].sem_op = -1; /* Subtract 1 to the semaphore value */
+  	operations[0].sem_op = delta; /* Add delta to the semaphore value */
   	operations[0].sem_flg = 0; /* We will wait until the OS completes the requested semaphore operation */
 
-  	/* Perform the P operation. */
-  	if (semop (id, operations, 1) == 0)
+	status = semop (lookup_semaphore (key, FALSE), operations, 1);
+	if (status == -1 && (errno == EINVAL || errno == EIDRM))
+		status = semop (lookup_semaphore (key, TRUE), operations, 1);
+	return status;
+}
+
+/* The probe or wait operation on the semaphore */
+void 
+P (int key)
+{
+  	/* Perform the P operation: subtract 1 from the semaphore value. */
+  	if (semaphore_op (key, -1) == 0)
 		printf ("Server: P operation performed on semaphore %d. \n", key);
   	else 
 		printf ("Server: P operation on semaphore %d failed. \n", key);
@@ -33,22 +61,8 @@ P (int key)
 void 
 V (int key)
 {
-	int id;
-	struct sembuf operations[1]; /* An array of one operation to perform on the semaphore */
-
-	/* Get the index of the semaphore using the provided key. */
-  	if ((id = semget (key, 1, 0666)) < 0){
-		perror("semget");
-		exit (EXIT_FAILURE);
-  	}
-
- 	 /* Perform the semaphore V operation. */
-  	operations[0].sem_num = 0; /* We are operating on semaphore 0 in the array of semaphores */
-  	operations[0].sem_op = 1; /* Add 1 to the semaphore value */
-  	operations[0].sem_flg = 0; /* We will wait until the OS completes the requested semaphore operation */
-
-  	/* Perform the V operation. */
-  	if (semop (id, operations, 1) == 0)
+  	/* Perform the V operation: add 1 to the semaphore value. */
+  	if (semaphore_op (key, 1) == 0)
 		printf ( "Server: V operation performed on semaphore %d. \n", key);
   	else 
 		printf ("Server: V operation on semaphore %d failed. \n", key);
@@ -5,7 +5,7 @@
  * Author: Naga Kandasamy
  * Date modified: 01/14/2014
  *
- * compile as follows: gcc -o server server_code.c -std=c99 
+ * compile as follows: gcc -o server server_code.c sem_ops.c -std=c99 
 */
 
 #define _SVID_SOURCE
@@ -28,52 +28,9 @@
 #define SEMAPHORE_KEY 32281 // This semaphore synchronizes access to shared memory
 
 
-/* The probe or wait operation on the semaphore */
-void P(int key){
-	int id;
-	struct sembuf operations[1]; // An array of one operation to perform on the semaphore
-
-	/* Get the index of the semaphore using the provided key. */
-  	if ((id = semget(key, 1, 0666)) < 0){
-		printf("Program cannot find the semaphore. Exiting. \n");
-		exit(0);
-  	}
-
- 	 /* Perform the semaphore P operation. */
-  	operations[0].sem_num = 0; // We are operating on semaphore 0 in the array of semaphores
-  	operations[0].sem_op = -1; // Subtract 1 to the semaphore value 
-  	operations[0].sem_flg = 0; // We will wait until the OS completes the requested semaphore operation 
-
-  	/* Perform the P operation. */
-  	if(semop(id, operations, 1) == 0)
-		printf("Server: P operation performed on semaphore %d. \n", key);
-  	else 
-		printf("Server: P operation on semaphore %d failed. \n", key);
-
-}
-
-/* The signal operation on the semaphore. */
-void V(int key){
-	int id;
-	struct sembuf operations[1]; // An array of one operation to perform on the semaphore
-
-	/* Get the index of the semaphore using the provided key. */
-  	if ((id = semget(key, 1, 0666)) < 0){
-		printf("Program cannot find the semaphore. Exiting. \n");
-		exit(0);
-  	}
-
- 	 /* Perform the semaphore V operation. */
-  	operations[0].sem_num = 0; // We are operating on semaphore 0 in the array of semaphores
-  	operations[0].sem_op = 1; // Add 1 to the semaphore value 
-  	operations[0].sem_flg = 0; // We will wait until the OS completes the requested semaphore operation 
-
-  	/* Perform the V operation. */
-  	if(semop(id, operations, 1) == 0)
-		printf("Server: V operation performed on semaphore %d. \n", key);
-  	else 
-		printf("Server: V operation on semaphore %d failed. \n", key);
-}
+/* P () and V () are in sem_ops.c, which caches the semaphore's identifier */
+extern void P(int key);
+extern void V(int key);
 
 /* Creates a shared memory area with the specified SHARED_MEMORY_KEY. */
 SHARED_MEMORY_STRUCT *create_shared_memory_area(key_t key, int *id){
@@ -0,0 +1,213 @@
+/* Benchmark for the shared memory message channel. 
+ *
+ * Throughput: a number of client processes send messages to one receiver over a 
+ * single channel. Reports messages per second and the number of futex wake-ups 
+ * per message, which approaches zero once the receiver is kept busy.
+ *
+ * Latency: a request/response ping-pong between two processes over a pair of 
+ * channels, compared with the same ping-pong done with a pair of System V 
+ * semaphores (one semop () per P or V, as in ../SystemV/sem_ops.c).
+ *
+ * Usage: ./channel_bench [clients] [messages per client] [message size]
+ *
+ * Date created: October 19, 2026
+ *
+ * Compile as follows: 
+ * gcc -o channel_bench channel_bench.c shm_channel.c -std=c11 -Wall -O2 -lrt
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/wait.h>
+#include <sys/ipc.h>
+#include <sys/sem.h>
+#include "shm_channel.h"
+
+#define BENCH_CHANNEL "/bench_channel"
+#define PING_CHANNEL "/bench_ping"
+#define PONG_CHANNEL "/bench_pong"
+#define ROUND_TRIPS 100000
+
+static double 
+now_seconds (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void 
+throughput (int clients, long messages, int msg_size)
+{
+    shm_channel_t *ch;
+    struct channel_stats stats;
+    char *buf;
+    long i, total = clients * messages, checksum = 0, expected = 0;
+    double start, elapsed;
+    int c;
+
+    channel_unlink (BENCH_CHANNEL);
+    ch = channel_create (BENCH_CHANNEL, CHANNEL_DEFAULT_SLOTS, msg_size);
+    if (ch == NULL){
+        perror ("channel_create");
+        exit (EXIT_FAILURE);
+    }
+    buf = malloc (msg_size);
+
+    start = now_seconds ();
+    for (c = 0; c < clients; c++){
+        if (fork () == 0){
+            shm_channel_t *cl = channel_open (BENCH_CHANNEL);
+
+            memset (buf, 0, msg_size);
+            for (i = 0; i < messages; i++){
+                *(long *)buf = i;
+                channel_send (cl, buf, msg_size);
+            }
+            channel_close (cl);
+            _exit (EXIT_SUCCESS);
+        }
+    }
+
+    for (i = 0; i < total; i++){
+        channel_receive (ch, buf, msg_size);
+        checksum += *(long *)buf;
+    }
+    elapsed = now_seconds () - start;
+    while (wait (NULL) > 0);
+
+    for (i = 0; i < messages; i++)
+        expected += i * clients;
+
+    channel_get_stats (ch, &stats);
+    printf ("throughput: %d clients, %ld messages of %d bytes \n", clients, total, msg_size);
+    printf ("   %.0f messages/s, %.1f MB/s \n", total / elapsed, total * (double)msg_size / elapsed / 1e6);
+    printf ("   %.4f receiver wake-ups and %.4f sender wake-ups per message \n", 
+            (double)stats.receiver_wakeups / total, (double)stats.sender_wakeups / total);
+    printf ("   data %s \n", checksum == expected ? "ok" : "CORRUPT");
+
+    free (buf);
+    channel_close (ch);
+    channel_unlink (BENCH_CHANNEL);
+}
+
+static void 
+latency_channel (int msg_size)
+{
+    shm_channel_t *ping, *pong;
+    char *buf = malloc (msg_size);
+    double start, elapsed;
+    long i;
+    pid_t pid;
+
+    channel_unlink (PING_CHANNEL);
+    channel_unlink (PONG_CHANNEL);
+    ping = channel_create (PING_CHANNEL, 16, msg_size);
+    pong = channel_create (PONG_CHANNEL, 16, msg_size);
+    if (ping == NULL || pong == NULL){
+        perror ("channel_create");
+        exit (EXIT_FAILURE);
+    }
+    memset (buf, 0, msg_size);
+
+    pid = fork ();
+    if (pid == 0){
+        for (i = 0; i < ROUND_TRIPS; i++){
+            channel_receive (ping, buf, msg_size);
+            channel_send (pong, buf, msg_size);
+        }
+        _exit (EXIT_SUCCESS);
+    }
+
+    start = now_seconds ();
+    for (i = 0; i < ROUND_TRIPS; i++){
+        channel_send (ping, buf, msg_size);
+        channel_receive (pong, buf, msg_size);
+    }
+    elapsed = now_seconds () - start;
+    waitpid (pid, NULL, 0);
+
+    printf ("latency: shm channel     %8.2f us per round trip \n", elapsed * 1e6 / ROUND_TRIPS);
+
+    channel_close (ping);
+    channel_close (pong);
+    channel_unlink (PING_CHANNEL);
+    channel_unlink (PONG_CHANNEL);
+    free (buf);
+}
+
+static void 
+sem_op (int semid, int num, int op)
+{
+    struct sembuf sops;
+
+    sops.sem_num = num;
+    sops.sem_op = op;
+    sops.sem_flg = 0;
+    if (semop (semid, &sops, 1) == -1){
+        perror ("semop");
+        exit (EXIT_FAILURE);
+    }
+}
+
+static void 
+latency_semaphore (void)
+{
+    double start, elapsed;
+    long i;
+    int semid;
+    pid_t pid;
+
+    /* Both semaphores of a new set start out at zero */
+    semid = semget (IPC_PRIVATE, 2, IPC_CREAT | 0600);
+    if (semid == -1){
+        perror ("semget");
+        exit (EXIT_FAILURE);
+    }
+
+    pid = fork ();
+    if (pid == 0){
+        for (i = 0; i < ROUND_TRIPS; i++){
+            sem_op (semid, 0, -1);
+            sem_op (semid, 1, 1);
+        }
+        _exit (EXIT_SUCCESS);
+    }
+
+    start = now_seconds ();
+    for (i = 0; i < ROUND_TRIPS; i++){
+        sem_op (semid, 0, 1);
+        sem_op (semid, 1, -1);
+    }
+    elapsed = now_seconds () - start;
+    waitpid (pid, NULL, 0);
+    semctl (semid, 0, IPC_RMID);
+
+    printf ("latency: SysV semaphores %8.2f us per round trip \n", elapsed * 1e6 / ROUND_TRIPS);
+}
+
+int 
+main (int argc, char **argv)
+{
+    int clients = (argc > 1) ? atoi (argv[1]) : 4;
+    long messages = (argc > 2) ? atol (argv[2]) : 1000000;
+    int msg_size = (argc > 3) ? atoi (argv[3]) : 64;
+
+    if (clients <= 0 || messages <= 0 || msg_size < (int)sizeof (long)){
+        printf ("Usage: %s [clients] [messages per client] [message size >= %zu] \n", 
+                argv[0], sizeof (long));
+        exit (EXIT_FAILURE);
+    }
+
+    throughput (clients, messages, msg_size);
+    latency_channel (msg_size);
+    latency_semaphore ();
+
+    exit (EXIT_SUCCESS);
+}
@@ -0,0 +1,56 @@
+/* The client opens the message channel created by channel_server.c and sends each 
+ * of its command line arguments to the server as a separate message. Send the 
+ * message "quit" to stop the server.
+ *
+ * Usage: ./channel_client message [message ...]
+ *
+ * Date created: October 19, 2026
+ *
+ * Compile as follows: 
+ * gcc -o channel_client channel_client.c shm_channel.c -std=c11 -Wall -lrt
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "shm_channel.h"
+
+#define CHANNEL_NAME "/sv_channel"
+
+int 
+main (int argc, char **argv)
+{
+    shm_channel_t *ch;
+    char buf[CHANNEL_DEFAULT_MSG_SIZE];
+    int i, len;
+
+    if (argc < 2){
+        printf ("Usage: %s message [message ...] \n", argv[0]);
+        exit (EXIT_FAILURE);
+    }
+
+    ch = channel_open (CHANNEL_NAME);
+    if (ch == NULL){
+        perror ("channel_open");
+        exit (EXIT_FAILURE);
+    }
+
+    for (i = 1; i < argc; i++){
+        if (strcmp (argv[i], "quit") == 0)
+            len = snprintf (buf, sizeof (buf), "quit");
+        else
+            len = snprintf (buf, sizeof (buf), "[%ld] %s", (long)getpid (), argv[i]);
+        if (len >= (int)sizeof (buf))
+            len = sizeof (buf) - 1;
+        if (channel_send (ch, buf, len) == -1){
+            perror ("channel_send");
+            exit (EXIT_FAILURE);
+        }
+    }
+
+    channel_close (ch);
+    exit (EXIT_SUCCESS);
+}
@@ -0,0 +1,55 @@
+/* The server creates a shared memory message channel and prints the messages that 
+ * clients (see channel_client.c) send to it. Any number of clients may send at the 
+ * same time. The server stops when a client sends the message "quit" and prints 
+ * how many futex wake-ups were needed for the messages it received.
+ *
+ * Date created: October 19, 2026
+ *
+ * Compile as follows: 
+ * gcc -o channel_server channel_server.c shm_channel.c -std=c11 -Wall -lrt
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "shm_channel.h"
+
+#define CHANNEL_NAME "/sv_channel"
+
+int 
+main (int argc, char **argv)
+{
+    shm_channel_t *ch;
+    struct channel_stats stats;
+    char buf[CHANNEL_DEFAULT_MSG_SIZE + 1];
+    ssize_t n;
+
+    /* Remove a channel left behind by a previous run */
+    channel_unlink (CHANNEL_NAME);
+
+    ch = channel_create (CHANNEL_NAME, CHANNEL_DEFAULT_SLOTS, CHANNEL_DEFAULT_MSG_SIZE);
+    if (ch == NULL){
+        perror ("channel_create");
+        exit (EXIT_FAILURE);
+    }
+    fprintf (stderr, "Created channel %s \n", CHANNEL_NAME);
+
+    while (1){
+        n = channel_receive (ch, buf, CHANNEL_DEFAULT_MSG_SIZE);
+        buf[n] = '\0';
+        if (strcmp (buf, "quit") == 0)
+            break;
+        printf ("Server: %s \n", buf);
+    }
+
+    channel_get_stats (ch, &stats);
+    fprintf (stderr, "Received %lu messages with %lu receiver wake-ups and %lu sender wake-ups \n", 
+             (unsigned long)stats.received, (unsigned long)stats.receiver_wakeups, 
+             (unsigned long)stats.sender_wakeups);
+
+    channel_close (ch);
+    channel_unlink (CHANNEL_NAME);
+    exit (EXIT_SUCCESS);
+}
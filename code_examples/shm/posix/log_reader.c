@@ -0,0 +1,111 @@
+/* Program reads the shared memory message log written by log_writer.c. The messages 
+ * are printed straight out of the shared segment; the reader takes no locks and 
+ * copies nothing.
+ *
+ * Usage: ./log_reader [-t type] [-l] [-f] [-u]
+ *      -t type     Only read messages of the given type, using the per-type index
+ *      -l          Print only the latest message (of the given type)
+ *      -f          Keep following the log as new messages are appended
+ *      -u          Remove the log when done
+ *
+ * Date created: October 19, 2026
+ *
+ * Compile as follows: 
+ * gcc -o log_reader log_reader.c shm_log.c -std=c11 -Wall -pthread -lrt
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "shm_log.h"
+
+static void 
+print_record (const struct log_record *rec)
+{
+    printf ("[%lu.%06lu] type %u: %.*s \n", 
+            (unsigned long)(rec->timestamp / 1000000000ULL), 
+            (unsigned long)(rec->timestamp % 1000000000ULL) / 1000, 
+            rec->type, (int)strnlen (rec->data, rec->length), rec->data);
+}
+
+int 
+main (int argc, char **argv)
+{
+    int type = LOG_ANY_TYPE, latest = 0, follow = 0, unlink_log = 0, c;
+    const struct log_record *rec;
+    log_cursor_t cursor;
+    shm_log_t *log;
+    uint32_t commits;
+    long count = 0;
+
+    while ((c = getopt (argc, argv, "t:lfu")) != -1){
+        switch (c){
+            case 't':
+                type = atoi (optarg);
+                if (type < 0 || type >= MESSAGE_TYPES){
+                    fprintf (stderr, "Type must be between 0 and %d \n", MESSAGE_TYPES - 1);
+                    exit (EXIT_FAILURE);
+                }
+                break;
+
+            case 'l':
+                latest = 1;
+                break;
+
+            case 'f':
+                follow = 1;
+                break;
+
+            case 'u':
+                unlink_log = 1;
+                break;
+
+            default:
+                fprintf (stderr, "Usage: %s [-t type] [-l] [-f] [-u] \n", argv[0]);
+                exit (EXIT_FAILURE);
+        }
+    }
+
+    log = log_open (LOG_OBJECT_PATH);
+    if (log == NULL){
+        perror ("log_open");
+        exit (EXIT_FAILURE);
+    }
+
+    if (latest){
+        if (type == LOG_ANY_TYPE){
+            fprintf (stderr, "-l needs a type \n");
+            exit (EXIT_FAILURE);
+        }
+        rec = log_latest (log, type);
+        if (rec != NULL)
+            print_record (rec);
+    }
+    else {
+        log_cursor_init (&cursor, type);
+        while (1){
+            /* Read the commit count before looking, so that a message committed 
+             * after we found nothing still wakes us up. */
+            commits = log_commits (log);
+            while ((rec = log_next (log, &cursor)) != NULL){
+                print_record (rec);
+                count++;
+            }
+            if (!follow)
+                break;
+            fflush (stdout);
+            log_wait (log, commits, -1);
+        }
+        fprintf (stderr, "Read %ld messages \n", count);
+    }
+
+    log_close (log);
+    if (unlink_log && log_unlink (LOG_OBJECT_PATH) != 0){
+        perror ("log_unlink");
+        exit (EXIT_FAILURE);
+    }
+    exit (EXIT_SUCCESS);
+}
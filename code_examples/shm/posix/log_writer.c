@@ -0,0 +1,69 @@
+/* Program appends messages to the shared memory message log (see shm_log.h). Like 
+ * sv_xfr.c, each message has a random type and contents, but instead of overwriting 
+ * a single message the writer adds to a log that any number of writers may share. 
+ * The messages are formatted directly into the log, without an intermediate buffer.
+ *
+ * The log is created under /dev/shm if it does not exist yet. Start as many writers 
+ * as you like, and read the log with log_reader.c.
+ *
+ * Usage: ./log_writer [number of messages] [microseconds between messages]
+ *
+ * Date created: October 19, 2026
+ *
+ * Compile as follows: 
+ * gcc -o log_writer log_writer.c shm_log.c -std=c11 -Wall -pthread -lrt
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "shm_log.h"
+
+int 
+main (int argc, char **argv)
+{
+    long count = (argc > 1) ? atol (argv[1]) : 10;
+    long interval_us = (argc > 2) ? atol (argv[2]) : 0;
+    uint64_t used, size;
+    shm_log_t *log;
+    long i, random_number;
+    char *buf;
+    int type;
+
+    log = log_open (LOG_OBJECT_PATH);
+    if (log == NULL){
+        log = log_create (LOG_OBJECT_PATH, LOG_INITIAL_SIZE);
+        if (log == NULL){
+            perror ("log_create");
+            exit (EXIT_FAILURE);
+        }
+        fprintf (stderr, "Created message log %s \n", LOG_OBJECT_PATH);
+    }
+
+    srandom (time (NULL) ^ getpid ());
+    for (i = 0; i < count; i++){
+        random_number = random ();
+        type = random_number % MESSAGE_TYPES;
+
+        /* Write the message in place and then publish it */
+        buf = (char *)log_reserve (log, type, BUF_LEN);
+        if (buf == NULL){
+            perror ("log_reserve");
+            exit (EXIT_FAILURE);
+        }
+        snprintf (buf, BUF_LEN, "Process %d, type %d, num %ld", (int)getpid (), type, random_number);
+        log_commit (log);
+
+        if (interval_us > 0)
+            usleep (interval_us);
+    }
+
+    log_usage (log, &used, &size);
+    fprintf (stderr, "Appended %ld messages; log uses %lu of %lu bytes \n", 
+             count, (unsigned long)used, (unsigned long)size);
+
+    log_close (log);
+    exit (EXIT_SUCCESS);
+}
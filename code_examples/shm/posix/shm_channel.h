@@ -0,0 +1,83 @@
+/* Header file for the shared memory message channel used by channel_server.c, 
+ * channel_client.c and channel_bench.c.
+ *
+ * The SystemV examples in ../SystemV pass a single message through shared memory 
+ * and guard it with one semaphore. Every P () and V () is a semop () system call, 
+ * so every message costs several trips into the kernel. 
+ *
+ * A channel is a POSIX shared memory object holding a bounded queue of fixed-size 
+ * message slots. Any number of processes may send on a channel, but only one 
+ * process receives from it (multiple producers, single consumer):
+ *
+ *   - Senders claim a slot by advancing the shared tail index with a 
+ *     compare-and-swap. Every slot carries a sequence number that tells whether 
+ *     it is free or holds a message, so no lock is needed.
+ *
+ *   - The receiver sleeps on a futex only when the queue is empty, after setting 
+ *     a flag in the header. A sender calls FUTEX_WAKE only if it sees that flag. 
+ *     The same is done in the other direction for senders blocked on a full queue.
+ *
+ * While both sides keep up with each other, sending and receiving a message does 
+ * not make a single system call. The header counts the futex wake-ups so that 
+ * this can be checked.
+ *
+ * Date created: October 19, 2026
+ *
+ */
+#ifndef _SHM_CHANNEL_H_
+#define _SHM_CHANNEL_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#define CHANNEL_DEFAULT_SLOTS 1024
+#define CHANNEL_DEFAULT_MSG_SIZE 256
+
+/* Number of times the receiver polls an empty queue before going to sleep
+ * (on machines with more than one CPU) */
+#define CHANNEL_SPIN_COUNT 200
+
+typedef struct shm_channel shm_channel_t;
+
+/* Statistics kept in the shared header */
+struct channel_stats {
+    uint64_t sent;                  /* Messages sent */
+    uint64_t received;              /* Messages received */
+    uint64_t receiver_wakeups;      /* FUTEX_WAKE calls made for the receiver */
+    uint64_t sender_wakeups;        /* FUTEX_WAKE calls made for blocked senders */
+};
+
+/* Create a channel with the given number of slots (rounded up to a power of two) 
+ * and maximum message size. Fails if a channel with the name already exists. */
+shm_channel_t *channel_create (const char *name, unsigned int slots, unsigned int msg_size);
+
+/* Open an existing channel. */
+shm_channel_t *channel_open (const char *name);
+
+/* Send a message of len bytes, blocking while the queue is full. Returns 0 on 
+ * success, -1 if the message is larger than the channel's message size. */
+int channel_send (shm_channel_t *ch, const void *msg, size_t len);
+
+/* Send without blocking. Returns 0 on success, -1 if the queue is full. */
+int channel_try_send (shm_channel_t *ch, const void *msg, size_t len);
+
+/* Receive the next message into buf, blocking while the queue is empty. Returns 
+ * the length of the message. Only one process may receive from a channel. */
+ssize_t channel_receive (shm_channel_t *ch, void *buf, size_t len);
+
+/* Receive without blocking. Returns -1 if the queue is empty. */
+ssize_t channel_try_receive (shm_channel_t *ch, void *buf, size_t len);
+
+/* Maximum message size of the channel. */
+unsigned int channel_msg_size (shm_channel_t *ch);
+
+/* Copy the statistics from the shared header. */
+void channel_get_stats (shm_channel_t *ch, struct channel_stats *stats);
+
+/* Unmap the channel. The shared memory object stays until channel_unlink (). */
+void channel_close (shm_channel_t *ch);
+
+/* Remove the shared memory object. */
+int channel_unlink (const char *name);
+
+#endif /* _SHM_CHANNEL_H_ */
@@ -0,0 +1,486 @@
+/* Implementation of the shared memory message log described in shm_log.h.
+ *
+ * Layout of the shared memory object:
+ *
+ *   struct log_header           -- tail, size, per-type index, wake-up counter
+ *   record, record, ...         -- struct log_record followed by the message,
+ *                                  padded to a multiple of eight bytes
+ *
+ * Offsets are counted from the start of the object, so an offset of zero never
+ * names a record and is used to mean "none".
+ *
+ * Date created: October 19, 2026
+ *
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <limits.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "shm_log.h"
+
+#define CACHE_LINE 64
+#define LOG_MAGIC 0x4c4f4753U           /* "LOGS" */
+#define RECORD_ALIGN 8
+
+struct log_header {
+    atomic_uint magic;                  /* Set last, once the header is ready */
+    pthread_mutex_t grow_lock;          /* Serializes growing the object */
+
+    _Alignas (CACHE_LINE) atomic_ullong tail;       /* Offset of the next record to reserve */
+    _Alignas (CACHE_LINE) atomic_ullong capacity;   /* Current size of the object */
+
+    _Alignas (CACHE_LINE) atomic_int commits;       /* Bumped on every commit; futex word */
+    atomic_int readers_waiting;
+
+    _Alignas (CACHE_LINE) atomic_ullong first[MESSAGE_TYPES];
+    atomic_ullong last[MESSAGE_TYPES];
+};
+
+struct shm_log {
+    struct log_header *hdr;
+    char *base;
+    size_t map_size;
+    int fd;
+    uint64_t reserved;                  /* Offset of the record awaiting log_commit () */
+    uint32_t reserved_size;
+};
+
+#define RECORD(log, offset) ((struct log_record *)((log)->base + (offset)))
+
+static size_t
+header_size (void)
+{
+    return (sizeof (struct log_header) + CACHE_LINE - 1) & ~(size_t)(CACHE_LINE - 1);
+}
+
+/* Space taken by a record with length bytes of message */
+static uint64_t
+record_size (size_t length)
+{
+    return (sizeof (struct log_record) + length + RECORD_ALIGN - 1) & ~(uint64_t)(RECORD_ALIGN - 1);
+}
+
+/* Non-zero if the process that reserved an uncommitted record has died, so that
+ * the record will never be committed */
+static int
+writer_gone (const struct log_record *rec)
+{
+    pid_t writer = (pid_t)__atomic_load_n (&rec->writer, __ATOMIC_ACQUIRE);
+
+    return writer != 0 && kill (writer, 0) == -1 && errno == ESRCH;
+}
+
+static void
+futex_wait (atomic_int *addr, int val, int timeout_ms)
+{
+    struct timespec ts, *tsp = NULL;
+
+    if (timeout_ms >= 0){
+        ts.tv_sec = timeout_ms / 1000;
+        ts.tv_nsec = (timeout_ms % 1000) * 1000000L;
+        tsp = &ts;
+    }
+    syscall (SYS_futex, addr, FUTEX_WAIT, val, tsp, NULL, 0);
+}
+
+static void
+futex_wake (atomic_int *addr, int n)
+{
+    syscall (SYS_futex, addr, FUTEX_WAKE, n, NULL, NULL, 0);
+}
+
+/* Make sure that the first end bytes of the object are mapped. The object only
+ * ever grows, so if another process has grown it we simply map more of it. */
+static int
+ensure_mapped (shm_log_t *log, uint64_t end)
+{
+    uint64_t size;
+    void *base;
+
+    if (end <= log->map_size)
+        return 0;
+
+    size = atomic_load (&log->hdr->capacity);
+    if (size < end){
+        errno = EFAULT;
+        return -1;
+    }
+
+    base = mremap (log->base, log->map_size, size, MREMAP_MAYMOVE);
+    if (base == MAP_FAILED)
+        return -1;
+    log->base = (char *)base;
+    log->hdr = (struct log_header *)base;
+    log->map_size = size;
+    return 0;
+}
+
+/* Grow the object so that it holds at least end bytes. Writers race past the end
+ * of the object together, so growing is done under the header mutex; whoever gets
+ * there first doubles the size and the others find nothing left to do. */
+static int
+grow (shm_log_t *log, uint64_t end)
+{
+    struct log_header *hdr = log->hdr;
+    uint64_t size;
+    int status = 0;
+
+    if (pthread_mutex_lock (&hdr->grow_lock) == EOWNERDEAD)
+        pthread_mutex_consistent (&hdr->grow_lock);
+
+    size = atomic_load (&hdr->capacity);
+    if (size < end){
+        while (size < end)
+            size *= 2;
+        if (ftruncate (log->fd, size) == 0)
+            atomic_store (&hdr->capacity, size);
+        else
+            status = -1;
+    }
+
+    pthread_mutex_unlock (&hdr->grow_lock);
+    return status;
+}
+
+static shm_log_t *
+log_map (int fd, size_t size)
+{
+    shm_log_t *log;
+    void *base;
+
+    base = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED)
+        return NULL;
+
+    log = (shm_log_t *)malloc (sizeof (shm_log_t));
+    if (log == NULL){
+        munmap (base, size);
+        return NULL;
+    }
+    log->base = (char *)base;
+    log->hdr = (struct log_header *)base;
+    log->map_size = size;
+    log->fd = fd;
+    log->reserved = 0;
+    return log;
+}
+
+shm_log_t *
+log_create (const char *name, size_t initial_size)
+{
+    struct log_header *hdr;
+    pthread_mutexattr_t attr;
+    shm_log_t *log;
+    int fd, i;
+
+    if (initial_size < header_size () * 2)
+        initial_size = header_size () * 2;
+
+    fd = shm_open (name, O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+    if (fd < 0)
+        return NULL;
+    if (ftruncate (fd, initial_size) == -1 || (log = log_map (fd, initial_size)) == NULL){
+        close (fd);
+        shm_unlink (name);
+        return NULL;
+    }
+
+    hdr = log->hdr;
+    pthread_mutexattr_init (&attr);
+    pthread_mutexattr_setpshared (&attr, PTHREAD_PROCESS_SHARED);
+    pthread_mutexattr_setrobust (&attr, PTHREAD_MUTEX_ROBUST);
+    pthread_mutex_init (&hdr->grow_lock, &attr);
+    pthread_mutexattr_destroy (&attr);
+
+    atomic_init (&hdr->tail, header_size ());
+    atomic_init (&hdr->capacity, initial_size);
+    atomic_init (&hdr->commits, 0);
+    atomic_init (&hdr->readers_waiting, 0);
+    for (i = 0; i < MESSAGE_TYPES; i++){
+        atomic_init (&hdr->first[i], 0);
+        atomic_init (&hdr->last[i], 0);
+    }
+    atomic_store (&hdr->magic, LOG_MAGIC);
+
+    return log;
+}
+
+shm_log_t *
+log_open (const char *name)
+{
+    struct log_header *hdr;
+    shm_log_t *log;
+    struct stat st;
+    int fd, tries;
+
+    fd = shm_open (name, O_RDWR, 0);
+    if (fd < 0)
+        return NULL;
+    if (fstat (fd, &st) == -1 || (size_t)st.st_size < header_size ()
+        || (log = log_map (fd, st.st_size)) == NULL){
+        close (fd);
+        return NULL;
+    }
+
+    /* The creator may still be setting up the header */
+    hdr = log->hdr;
+    for (tries = 0; atomic_load (&hdr->magic) != LOG_MAGIC; tries++){
+        if (tries == 1000){
+            log_close (log);
+            errno = EINVAL;
+            return NULL;
+        }
+        usleep (1000);
+    }
+
+    return log;
+}
+
+void *
+log_reserve (shm_log_t *log, int type, size_t length)
+{
+    struct log_record *rec, mine, other;
+    struct timespec now;
+    uint64_t size, offset, next, claim;
+
+    if (type < 0 || type >= MESSAGE_TYPES || length > UINT32_MAX / 2){
+        errno = EINVAL;
+        return NULL;
+    }
+
+    /* Readers walking every record stop at the first one not yet committed, so
+     * space is only claimed once the object holds it and it is mapped: a claim
+     * that then failed would stop them for good.
+     *
+     * The claim stores the length and our pid at the tail in one step, so that a
+     * record below the tail always tells readers how to step over it and whom to
+     * ask whether it will ever be committed. The tail is advanced past the record
+     * afterwards, by us or by any writer that finds the space already claimed and
+     * helps the tail along before trying further on. */
+    size = record_size (length);
+    mine.length = length;
+    mine.writer = (uint32_t)getpid ();
+    offset = atomic_load (&log->hdr->tail);
+    for (;;){
+        if (offset + size > atomic_load (&log->hdr->capacity) && grow (log, offset + size) == -1)
+            return NULL;
+        if (ensure_mapped (log, offset + size) == -1)
+            return NULL;
+        rec = RECORD (log, offset);
+        claim = 0;
+        if (__atomic_compare_exchange_n (&rec->claim, &claim, mine.claim, 0,
+                                         __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+            break;
+        other.claim = claim;
+        next = offset + record_size (other.length);
+        if (atomic_compare_exchange_strong (&log->hdr->tail, &offset, next))
+            offset = next;
+    }
+    next = offset;
+    atomic_compare_exchange_strong (&log->hdr->tail, &next, offset + size);
+
+    /* The object is never reused, so the rest of the record starts out as zeros;
+     * the size field stays zero until the record is committed */
+    rec->type = type;
+    clock_gettime (CLOCK_REALTIME, &now);
+    rec->timestamp = (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+    rec->next_of_type = 0;
+
+    log->reserved = offset;
+    log->reserved_size = size;
+    return rec->data;
+}
+
+void
+log_commit (shm_log_t *log)
+{
+    struct log_header *hdr = log->hdr;
+    uint64_t offset = log->reserved, prev;
+    struct log_record *rec;
+
+    if (offset == 0)
+        return;
+    log->reserved = 0;
+
+    rec = RECORD (log, offset);
+    __atomic_store_n (&rec->size, log->reserved_size, __ATOMIC_RELEASE);
+
+    /* Add the record to the chain of its type. The exchange orders the records
+     * of one type; the link from the previous record is set right after, so a
+     * reader that gets there first just sees the end of the chain for a moment. */
+    prev = atomic_exchange (&hdr->last[rec->type], offset);
+    if (prev == 0)
+        atomic_store (&hdr->first[rec->type], offset);
+    else {
+        /* The previous record may lie beyond our mapping if another process grew
+         * the log after we reserved ours. Failing to link it would hide every later
+         * record of the type from the index, so there is no way to back out here. */
+        if (ensure_mapped (log, prev + sizeof (struct log_record)) == -1){
+            perror ("log_commit: mremap");
+            abort ();
+        }
+        hdr = log->hdr;
+        __atomic_store_n (&RECORD (log, prev)->next_of_type, offset, __ATOMIC_RELEASE);
+    }
+
+    /* Wake the readers only if one of them has gone to sleep */
+    atomic_fetch_add (&hdr->commits, 1);
+    atomic_thread_fence (memory_order_seq_cst);
+    if (atomic_load_explicit (&hdr->readers_waiting, memory_order_relaxed) > 0)
+        futex_wake (&hdr->commits, INT_MAX);
+}
+
+int
+log_append (shm_log_t *log, int type, const void *data, size_t length)
+{
+    void *buf;
+
+    buf = log_reserve (log, type, length);
+    if (buf == NULL)
+        return -1;
+    memcpy (buf, data, length);
+    log_commit (log);
+    return 0;
+}
+
+void
+log_cursor_init (log_cursor_t *cursor, int type)
+{
+    cursor->type = type;
+    cursor->offset = (type == LOG_ANY_TYPE) ? header_size () : 0;
+}
+
+void
+log_cursor_tail (shm_log_t *log, log_cursor_t *cursor, int type)
+{
+    cursor->type = type;
+    if (type == LOG_ANY_TYPE)
+        cursor->offset = atomic_load (&log->hdr->tail);
+    else
+        cursor->offset = atomic_load (&log->hdr->last[type]);
+}
+
+const struct log_record *
+log_next (shm_log_t *log, log_cursor_t *cursor)
+{
+    struct log_record *rec;
+    uint64_t offset;
+    uint32_t size;
+
+    if (cursor->type == LOG_ANY_TYPE){
+        /* Walk the records in the order they were reserved, stopping at the first
+         * one that has not been committed yet, unless its writer has died */
+        for (;;){
+            offset = cursor->offset;
+            if (offset >= atomic_load (&log->hdr->tail))
+                return NULL;
+            if (ensure_mapped (log, offset + sizeof (struct log_record)) == -1)
+                return NULL;
+            rec = RECORD (log, offset);
+            size = __atomic_load_n (&rec->size, __ATOMIC_ACQUIRE);
+            if (size == 0){
+                if (!writer_gone (rec))
+                    return NULL;
+                /* It may have committed just before it exited */
+                size = __atomic_load_n (&rec->size, __ATOMIC_ACQUIRE);
+                if (size == 0){
+                    cursor->offset = offset + record_size (rec->length);
+                    continue;
+                }
+            }
+            if (ensure_mapped (log, offset + size) == -1)
+                return NULL;
+            cursor->offset = offset + size;
+            return RECORD (log, offset);
+        }
+    }
+
+    /* Follow the chain of one type */
+    if (cursor->type < 0 || cursor->type >= MESSAGE_TYPES)
+        return NULL;
+    if (cursor->offset == 0)
+        offset = atomic_load (&log->hdr->first[cursor->type]);
+    else {
+        if (ensure_mapped (log, cursor->offset + sizeof (struct log_record)) == -1)
+            return NULL;
+        offset = __atomic_load_n (&RECORD (log, cursor->offset)->next_of_type, __ATOMIC_ACQUIRE);
+    }
+    if (offset == 0)
+        return NULL;
+
+    if (ensure_mapped (log, offset + sizeof (struct log_record)) == -1)
+        return NULL;
+    rec = RECORD (log, offset);
+    if (ensure_mapped (log, offset + __atomic_load_n (&rec->size, __ATOMIC_ACQUIRE)) == -1)
+        return NULL;
+    cursor->offset = offset;
+    return RECORD (log, offset);
+}
+
+const struct log_record *
+log_latest (shm_log_t *log, int type)
+{
+    uint64_t offset;
+
+    if (type < 0 || type >= MESSAGE_TYPES)
+        return NULL;
+    offset = atomic_load (&log->hdr->last[type]);
+    if (offset == 0)
+        return NULL;
+    if (ensure_mapped (log, offset + sizeof (struct log_record)) == -1
+        || ensure_mapped (log, offset + __atomic_load_n (&RECORD (log, offset)->size, __ATOMIC_ACQUIRE)) == -1)
+        return NULL;
+    return RECORD (log, offset);
+}
+
+uint32_t
+log_commits (shm_log_t *log)
+{
+    return (uint32_t)atomic_load (&log->hdr->commits);
+}
+
+void
+log_wait (shm_log_t *log, uint32_t commits, int timeout_ms)
+{
+    struct log_header *hdr = log->hdr;
+
+    atomic_fetch_add (&hdr->readers_waiting, 1);
+    atomic_thread_fence (memory_order_seq_cst);
+    if ((uint32_t)atomic_load (&hdr->commits) == commits)
+        futex_wait (&hdr->commits, (int)commits, timeout_ms);
+    atomic_fetch_sub (&hdr->readers_waiting, 1);
+}
+
+void
+log_usage (shm_log_t *log, uint64_t *used, uint64_t *size)
+{
+    *used = atomic_load (&log->hdr->tail);
+    *size = atomic_load (&log->hdr->capacity);
+}
+
+void
+log_close (shm_log_t *log)
+{
+    munmap (log->base, log->map_size);
+    close (log->fd);
+    free ((void *)log);
+}
+
+int
+log_unlink (const char *name)
+{
+    return shm_unlink (name);
+}
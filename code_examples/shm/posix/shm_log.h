@@ -0,0 +1,125 @@
+/* Header file for the shared memory message log used by log_writer.c and log_reader.c
+ *
+ * sv_xfr.c leaves a single message in a shared memory object for cl_xfr.c to pick
+ * up. The message log generalizes this into an append-only log of messages that
+ * lives in /dev/shm, so that any number of processes can publish events and any
+ * number of processes can read them, without a broker process in between and
+ * without copying the messages out of the shared segment.
+ *
+ *   - The object starts with a header holding the offset at which the next
+ *     record goes (the tail), the current size of the object and, for each of
+ *     the MESSAGE_TYPES message types, the offsets of the first and the last
+ *     record of that type.
+ *
+ *   - Records have a variable length. A writer reserves space for its record,
+ *     once the object is large enough to hold it, by storing its length and its
+ *     pid at the tail with one compare-and-swap, and then advances the tail past
+ *     it; a writer that finds the space at the tail already claimed advances the
+ *     tail on behalf of its owner and tries again. It fills the record in place
+ *     and then commits it by storing the record size, which readers use as the
+ *     "record is complete" flag. Committed records of the same type are chained
+ *     together, which gives the per-type index.
+ *
+ *   - A writer that dies between reserving and committing leaves a record that
+ *     is never completed. Readers walking every record step over it once they
+ *     find that the process which reserved it no longer exists; the chain of its
+ *     type never included it.
+ *
+ *   - Readers never take a lock. They walk the log with a cursor, either over
+ *     every record in order or along the chain of one message type, and get a
+ *     pointer to the record inside the mapping.
+ *
+ *   - When the tail runs past the end of the object, the writer that noticed
+ *     grows it with ftruncate () under a process-shared mutex (the only lock in
+ *     the log, taken once per doubling). Every process remaps its view with
+ *     mremap () when it finds records beyond the end of its mapping. Records are
+ *     addressed by their offset, so it does not matter where the mapping lands.
+ *
+ * A log handle must not be shared between threads without a lock of their own,
+ * and a record pointer returned by the log is only valid until the next call on
+ * the same handle, which may move the mapping.
+ *
+ * Date created: October 19, 2026
+ *
+ */
+#ifndef _SHM_LOG_H_
+#define _SHM_LOG_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+#include "sv_cl_xfr.h"
+
+#define LOG_OBJECT_PATH "/sv_log"
+#define LOG_INITIAL_SIZE (1 << 20)
+#define LOG_ANY_TYPE (-1)
+
+typedef struct shm_log shm_log_t;
+
+/* A record as it appears in the log */
+struct log_record {
+    uint32_t size;                  /* Size of the whole record, zero until committed */
+    uint32_t type;
+    union {
+        struct {
+            uint32_t length;        /* Number of bytes in data */
+            uint32_t writer;        /* Process that reserved the record */
+        };
+        uint64_t claim;             /* Both, stored together to claim the record */
+    };
+    uint64_t timestamp;             /* CLOCK_REALTIME in nanoseconds when reserved */
+    uint64_t next_of_type;          /* Offset of the next record of the same type */
+    char data[];
+};
+
+/* A reader's position in the log */
+typedef struct log_cursor {
+    int type;                       /* Type to follow, or LOG_ANY_TYPE */
+    uint64_t offset;                /* Next record (any type) or last record returned */
+} log_cursor_t;
+
+/* Create a new log with the given initial size. Fails if the log already exists. */
+shm_log_t *log_create (const char *name, size_t initial_size);
+
+/* Open an existing log. */
+shm_log_t *log_open (const char *name);
+
+/* Reserve space for a message of the given type and length and return a pointer
+ * where the message can be written in place. The record becomes visible to
+ * readers with log_commit (). Returns NULL on error. */
+void *log_reserve (shm_log_t *log, int type, size_t length);
+
+/* Publish the record reserved by the last call to log_reserve (). */
+void log_commit (shm_log_t *log);
+
+/* Reserve, copy and commit in one go. Returns 0 on success, -1 on error. */
+int log_append (shm_log_t *log, int type, const void *data, size_t length);
+
+/* Position a cursor at the first record of the given type (or of any type). */
+void log_cursor_init (log_cursor_t *cursor, int type);
+
+/* Position a cursor so that it returns only records committed from now on. */
+void log_cursor_tail (shm_log_t *log, log_cursor_t *cursor, int type);
+
+/* Return the next committed record for the cursor, or NULL if there is none yet. */
+const struct log_record *log_next (shm_log_t *log, log_cursor_t *cursor);
+
+/* Return the most recent record of the given type, or NULL if there is none. */
+const struct log_record *log_latest (shm_log_t *log, int type);
+
+/* Sleep until a record is committed after the given count was read with
+ * log_commits (), or the timeout (milliseconds, -1 for none) runs out. */
+void log_wait (shm_log_t *log, uint32_t commits, int timeout_ms);
+
+/* Number of records committed so far (wraps around). */
+uint32_t log_commits (shm_log_t *log);
+
+/* Number of bytes in use and current size of the shared memory object. */
+void log_usage (shm_log_t *log, uint64_t *used, uint64_t *size);
+
+/* Unmap the log. The shared memory object stays until log_unlink (). */
+void log_close (shm_log_t *log);
+
+/* Remove the shared memory object. */
+int log_unlink (const char *name);
+
+#endif /* _SHM_LOG_H_ */
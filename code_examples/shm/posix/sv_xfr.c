@@ -12,12 +12,6 @@
 
 #include "sv_cl_xfr.h"
 
-/* Message structure for messages in the shared segment */
-struct msg {
-    int type;
-    char buf[BUF_LEN];
-};
-
 
 int 
 main (int argc, char **argv) 
@@ -0,0 +1,63 @@
+/* Header file for the multi-slot version of the reader-writer programs: 
+ * svshm_ring_writer.c, svshm_ring_reader.c and svshm_ring_bench.c.
+ *
+ * The original programs (svshm_xfr_writer.c and svshm_xfr_reader.c) move data 
+ * through a single 1 KB buffer, so the writer and the reader take strict turns: 
+ * while one of them works on the buffer, the other one waits. Here the shared 
+ * memory segment holds a ring of NUM_SLOTS slots of SLOT_SIZE bytes each. The 
+ * writer fills slot i + 1 while the reader drains slot i. 
+ *
+ * Two counting semaphores keep track of the ring:
+ *   EMPTY_SEM -- number of free slots, initialized to the number of slots
+ *   FULL_SEM  -- number of filled slots, initialized to 0
+ *
+ * The writer waits on EMPTY_SEM before filling a slot and posts FULL_SEM after; 
+ * the reader does the opposite. The slot count and size are chosen by the writer 
+ * and stored in the header of the segment so that the reader can find them.
+ *
+ * Date created: October 19, 2026
+ *
+ */
+#ifndef _SVSHM_RING_H
+#define _SVSHM_RING_H
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/sem.h>
+#include <sys/shm.h>
+#include "binary_sems.h" 				/* Header file for the semaphore operations. */
+
+#define SHM_RING_KEY 0x1235					/* Key for shared memory segment. */ 
+#define SEM_RING_KEY 0x5679					/* Key for semaphore set. */
+
+#define OBJ_PERMS (S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP)	
+												/* Permissions for our IPC objects. */
+
+#define EMPTY_SEM 0						/* Semaphore numbers for free and filled slots. */
+#define FULL_SEM 1
+
+#define DEFAULT_SLOT_SIZE 65536			/* Default size of each slot in bytes. */
+#define DEFAULT_NUM_SLOTS 16			/* Default number of slots in the ring. */
+
+struct shmring {						/* Header at the start of the shared memory segment. */
+    int num_slots;
+    int slot_size;
+    size_t slot_stride;					/* Distance between two slots in bytes. */
+};
+
+struct shmslot {						/* Each slot starts with this header. */
+    int count;							/* Number of bytes used in the slot; 0 means EOF. */
+    char buf[];							/* slot_size bytes of data. */
+};
+
+/* Round the slot size up so that every slot starts on its own cache line. */
+#define SLOT_STRIDE(size) ((sizeof (struct shmslot) + (size) + 63) & ~(size_t)63)
+
+/* Size of the whole segment. */
+#define RING_SEG_SIZE(slots, size) (64 + (size_t)(slots) * SLOT_STRIDE (size))
+
+/* Address of slot i. */
+#define RING_SLOT(ring, i) \
+    ((struct shmslot *)((char *)(ring) + 64 + (size_t)(i) * (ring)->slot_stride))
+
+#endif
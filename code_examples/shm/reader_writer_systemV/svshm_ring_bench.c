@@ -0,0 +1,250 @@
+/* Benchmark comparing the single-buffer protocol of svshm_xfr_writer.c and 
+ * svshm_xfr_reader.c with the ring of slots used by svshm_ring_writer.c and 
+ * svshm_ring_reader.c. 
+ *
+ * The program forks: the child plays the writer and copies a block of memory into 
+ * shared memory, and the parent plays the reader and copies the data back out. 
+ * For each protocol the bytes per second and the number of semop () calls are 
+ * reported, and a checksum verifies that the data arrived intact.
+ *
+ * Usage: ./svshm_ring_bench [megabytes] [slot-size] [num-slots]
+ *
+ * Date created: October 19, 2026
+ *
+ * Compile as follows: make clean && make
+ *
+ */
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <sys/wait.h>
+#include "semun.h"
+#include "svshm_xfr.h"
+#include "svshm_ring.h"
+
+#define CHUNK (1 << 20)                 /* Size of the source/sink buffers */
+
+void			/* Print out the error returned by the system and exit. */ 
+errExit (char *message)
+{
+    perror (message);
+    exit (EXIT_FAILURE);
+}
+
+static double 
+now_seconds (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static unsigned long 
+checksum (const char *buf, int len, unsigned long sum)
+{
+    int i;
+
+    for (i = 0; i < len; i++)
+        sum = sum * 31 + (unsigned char)buf[i];
+    return sum;
+}
+
+/* Copy up to len bytes of the endless source pattern, starting at offset pos */
+static int 
+produce (char *dst, const char *src, long pos, long total, int len)
+{
+    int n, off, chunk;
+
+    if (total - pos < len)
+        len = total - pos;
+    for (n = 0; n < len; n += chunk){
+        off = (pos + n) % CHUNK;
+        chunk = (CHUNK - off < len - n) ? CHUNK - off : len - n;
+        memcpy (dst + n, src + off, chunk);
+    }
+    return len;
+}
+
+/* The original protocol: one buffer, writer and reader take turns. */
+static void 
+single_buffer (long total, const char *src, char *sink, unsigned long *sum, long *semops)
+{
+    int semid, shmid, count;
+    long pos;
+    struct shmseg *shmp;
+    union semun dummy;
+    pid_t pid;
+
+    semid = semget (IPC_PRIVATE, 2, IPC_CREAT | OBJ_PERMS);
+    if (semid == -1)
+        errExit ("semget");
+    if (initSemAvailable (semid, WRITE_SEM) == -1 || initSemInUse (semid, READ_SEM) == -1)
+        errExit ("semctl");
+    shmid = shmget (IPC_PRIVATE, sizeof (struct shmseg), IPC_CREAT | OBJ_PERMS);
+    if (shmid == -1)
+        errExit ("shmget");
+    shmp = shmat (shmid, NULL, 0);
+    if (shmp == (void *) -1)
+        errExit ("shmat");
+
+    pid = fork ();
+    if (pid == -1)
+        errExit ("fork");
+
+    if (pid == 0){                      /* Writer */
+        for (pos = 0; ; pos += shmp->count){
+            if (reserveSem (semid, WRITE_SEM) == -1)
+                errExit ("reserveSem");
+            shmp->count = produce (shmp->buf, src, pos, total, BUF_SIZE);
+            if (releaseSem (semid, READ_SEM) == -1)
+                errExit ("releaseSem");
+            if (shmp->count == 0)
+                break;
+        }
+        _exit (EXIT_SUCCESS);
+    }
+
+    *sum = 0;
+    *semops = 0;
+    for (pos = 0; ; pos += count){      /* Reader */
+        if (reserveSem (semid, READ_SEM) == -1)
+            errExit ("reserveSem");
+        count = shmp->count;
+        if (count == 0)
+            break;
+        memcpy (sink, shmp->buf, count);
+        *sum = checksum (sink, count, *sum);
+        if (releaseSem (semid, WRITE_SEM) == -1)
+            errExit ("releaseSem");
+        *semops += 4;
+    }
+    waitpid (pid, NULL, 0);
+
+    shmdt (shmp);
+    shmctl (shmid, IPC_RMID, 0);
+    semctl (semid, 0, IPC_RMID, dummy);
+}
+
+/* The ring protocol: the writer runs ahead of the reader by up to num_slots slots. */
+static void 
+ring_buffer (long total, int slot_size, int num_slots, const char *src, char *sink, 
+             unsigned long *sum, long *semops)
+{
+    int semid, shmid, count, i, off, n;
+    long pos;
+    struct shmring *ring;
+    struct shmslot *slot;
+    union semun arg, dummy;
+    pid_t pid;
+
+    semid = semget (IPC_PRIVATE, 2, IPC_CREAT | OBJ_PERMS);
+    if (semid == -1)
+        errExit ("semget");
+    arg.val = num_slots;
+    if (semctl (semid, EMPTY_SEM, SETVAL, arg) == -1 || initSemInUse (semid, FULL_SEM) == -1)
+        errExit ("semctl");
+    shmid = shmget (IPC_PRIVATE, RING_SEG_SIZE (num_slots, slot_size), IPC_CREAT | OBJ_PERMS);
+    if (shmid == -1)
+        errExit ("shmget");
+    ring = shmat (shmid, NULL, 0);
+    if (ring == (void *) -1)
+        errExit ("shmat");
+    ring->num_slots = num_slots;
+    ring->slot_size = slot_size;
+    ring->slot_stride = SLOT_STRIDE (slot_size);
+
+    pid = fork ();
+    if (pid == -1)
+        errExit ("fork");
+
+    if (pid == 0){                      /* Writer */
+        for (pos = 0, i = 0; ; pos += slot->count, i = (i + 1) % num_slots){
+            if (reserveSem (semid, EMPTY_SEM) == -1)
+                errExit ("reserveSem");
+            slot = RING_SLOT (ring, i);
+            slot->count = produce (slot->buf, src, pos, total, slot_size);
+            if (releaseSem (semid, FULL_SEM) == -1)
+                errExit ("releaseSem");
+            if (slot->count == 0)
+                break;
+        }
+        _exit (EXIT_SUCCESS);
+    }
+
+    *sum = 0;
+    *semops = 0;
+    for (pos = 0, i = 0; ; pos += count, i = (i + 1) % num_slots){     /* Reader */
+        if (reserveSem (semid, FULL_SEM) == -1)
+            errExit ("reserveSem");
+        slot = RING_SLOT (ring, i);
+        count = slot->count;
+        if (count == 0)
+            break;
+        for (off = 0; off < count; off += n){
+            n = (count - off < CHUNK) ? count - off : CHUNK;
+            memcpy (sink, slot->buf + off, n);
+            *sum = checksum (sink, n, *sum);
+        }
+        if (releaseSem (semid, EMPTY_SEM) == -1)
+            errExit ("releaseSem");
+        *semops += 4;
+    }
+    waitpid (pid, NULL, 0);
+
+    shmdt (ring);
+    shmctl (shmid, IPC_RMID, 0);
+    semctl (semid, 0, IPC_RMID, dummy);
+}
+
+int
+main (int argc, char **argv)
+{
+    long megabytes = (argc > 1) ? atol (argv[1]) : 256;
+    int slot_size = (argc > 2) ? atoi (argv[2]) : DEFAULT_SLOT_SIZE;
+    int num_slots = (argc > 3) ? atoi (argv[3]) : DEFAULT_NUM_SLOTS;
+    long total, semops, pos;
+    unsigned long sum, expected;
+    char *src, *sink;
+    double start, elapsed;
+    int i;
+
+    if (megabytes <= 0 || slot_size <= 0 || num_slots <= 0){
+        fprintf (stderr, "Usage: %s [megabytes] [slot-size] [num-slots] \n", argv[0]);
+        exit (EXIT_FAILURE);
+    }
+    total = megabytes << 20;
+
+    src = malloc (CHUNK);
+    sink = malloc (CHUNK);
+    if (src == NULL || sink == NULL)
+        errExit ("malloc");
+    for (i = 0; i < CHUNK; i++)
+        src[i] = 'a' + i % 26;
+
+    /* Checksum of the data as the reader should see it */
+    for (expected = 0, pos = 0; pos < total; pos += CHUNK)
+        expected = checksum (src, (total - pos < CHUNK) ? total - pos : CHUNK, expected);
+
+    printf ("%-34s %12s %12s %10s\n", "protocol", "MB/s", "semops/MB", "data");
+
+    start = now_seconds ();
+    single_buffer (total, src, sink, &sum, &semops);
+    elapsed = now_seconds () - start;
+    printf ("single %5d B buffer               %12.1f %12.1f %10s\n", BUF_SIZE, 
+            megabytes / elapsed, (double)semops / megabytes, sum == expected ? "ok" : "CORRUPT");
+
+    start = now_seconds ();
+    ring_buffer (total, slot_size, num_slots, src, sink, &sum, &semops);
+    elapsed = now_seconds () - start;
+    printf ("ring %4d x %8d B slots        %12.1f %12.1f %10s\n", num_slots, slot_size, 
+            megabytes / elapsed, (double)semops / megabytes, sum == expected ? "ok" : "CORRUPT");
+
+    free (src);
+    free (sink);
+    exit (EXIT_SUCCESS);
+}
@@ -0,0 +1,80 @@
+/* The reader program that transfers data written by svshm_ring_writer to the ring 
+ * of slots in shared memory and displays it on stdout. Once a slot has been 
+ * drained, it is handed back to the writer via the EMPTY_SEM semaphore.  
+ *
+ * Date created: October 19, 2026
+ *
+ * Notes: Based on svshm_xfr_reader.c.
+ *
+ * Compile as follows: make clean && make
+ *
+ */
+
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "semun.h"
+#include "svshm_ring.h"
+
+void			/* Print out the error returned by the system and exit. */ 
+errExit (char *message)
+{
+    perror(message);
+    exit(EXIT_FAILURE);
+}
+
+
+int
+main (int argc, char **argv)
+{
+    int semid, shmid, xfrs, i, count;
+    long nbytes;
+    struct shmring *ring;
+    struct shmslot *slot;
+	
+    /* Get the ids for the semaphore set and shared memory previously created by the writer. */
+    semid = semget (SEM_RING_KEY, 0, 0);
+    if (semid == -1)
+        errExit ("semget");
+		
+    shmid = shmget (SHM_RING_KEY, 0, 0);
+    if (shmid == -1)
+        errExit ("shmget");
+		
+    ring = shmat (shmid, NULL, SHM_RDONLY);
+    if (ring == (void *) -1)
+        errExit ("shmat");
+
+    /* Transfer blocks of data from the slots to stdout, in the order they were filled. */
+    for (nbytes = 0, xfrs = 0, i = 0; ; xfrs++, i = (i + 1) % ring->num_slots) {
+	
+        if (reserveSem (semid, FULL_SEM) == -1)		/* Wait for a filled slot. */
+            errExit ("reserveSem");
+
+        slot = RING_SLOT (ring, i);
+        count = slot->count;
+        if (count == 0)								/* Writer encountered EOF. */
+            break;
+			
+        nbytes += count;
+		
+        if (write (STDOUT_FILENO, slot->buf, count) != count)
+            errExit ("write");
+					
+        if (releaseSem (semid, EMPTY_SEM) == -1)		/* Give the slot back to the writer. */
+            errExit ("releaseSem");	
+    }
+		   
+    if (shmdt (ring) == -1)
+        errExit ("shmdt");
+		
+    /* Return the EOF slot so that the writer can clean up. */
+    if (releaseSem (semid, EMPTY_SEM) == -1)																
+        errExit ("releaseSem");
+	
+    fprintf (stderr, "Received %ld bytes from the writer in %d transfers.\n", nbytes, xfrs);
+	
+    exit (EXIT_SUCCESS);
+}
@@ -0,0 +1,114 @@
+/* The writer program that transfers user input from stdin to a ring of slots in 
+ * shared memory. After a slot is filled, the reader process is signalled via the 
+ * FULL_SEM semaphore, and the writer carries on with the next slot as long as 
+ * EMPTY_SEM says there is one free. The reader obtains the data from the slots 
+ * and displays it on stdout.
+ *
+ * Usage: ./svshm_ring_writer [slot-size] [num-slots] < input
+ *
+ * Date created: October 19, 2026
+ *
+ * Notes: Based on svshm_xfr_writer.c.
+ *
+ * Compile as follows: make clean && make
+ *
+ */
+#define _DEFAULT_SOURCE
+
+#include <stdio.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <errno.h>
+#include "semun.h"
+#include "svshm_ring.h"
+
+void			/* Print out the error returned by the system and exit. */ 
+errExit (char *message)
+{
+    perror (message);
+    exit (EXIT_FAILURE);
+}
+
+
+int
+main (int argc, char **argv)
+{
+    int semid, shmid, xfrs, slot_size, num_slots, i;
+    long nbytes;
+    struct shmring *ring;
+    struct shmslot *slot;
+    union semun arg, dummy;
+
+    slot_size = (argc > 1) ? atoi (argv[1]) : DEFAULT_SLOT_SIZE;
+    num_slots = (argc > 2) ? atoi (argv[2]) : DEFAULT_NUM_SLOTS;
+    if (slot_size <= 0 || num_slots <= 0){
+        fprintf (stderr, "Usage: %s [slot-size] [num-slots] \n", argv[0]);
+        exit (EXIT_FAILURE);
+    }
+
+    /* Create the two counting semaphores. All slots start out empty. Since the 
+     * writer creates the shared memory segment, it must be started before the reader. */
+    semid = semget (SEM_RING_KEY, 2, IPC_CREAT | OBJ_PERMS);
+    if (semid == -1)
+        errExit ("semget");
+
+    arg.val = num_slots;
+    if (semctl (semid, EMPTY_SEM, SETVAL, arg) == -1)
+        errExit ("semctl");
+		
+    if (initSemInUse (semid, FULL_SEM) == -1)
+        errExit ("initSemInUse");
+
+    /* Create the shared memory segment, large enough for the header and all the 
+     * slots, and describe the ring in the header for the reader. */
+    shmid = shmget (SHM_RING_KEY, RING_SEG_SIZE (num_slots, slot_size), IPC_CREAT | OBJ_PERMS);
+    if (shmid == -1)
+        errExit ("shmget");
+
+    ring = shmat (shmid, NULL, 0);
+    if (ring == (void *) -1)
+        errExit ("shmat");
+
+    ring->num_slots = num_slots;
+    ring->slot_size = slot_size;
+    ring->slot_stride = SLOT_STRIDE (slot_size);
+	  
+    /* Transfer blocks of data from stdin to the slots of the ring, one after the other. */
+    for (xfrs = 0, nbytes = 0, i = 0; ; xfrs++, i = (i + 1) % num_slots) {
+        
+        if (reserveSem (semid, EMPTY_SEM) == -1)						/* Wait for a free slot. */
+            errExit ("reserveSem");
+
+        slot = RING_SLOT (ring, i);
+        slot->count = read (STDIN_FILENO, slot->buf, slot_size);		/* Write data to the slot. */
+        if (slot->count == -1)
+            errExit ("read");
+
+        if (releaseSem (semid, FULL_SEM) == -1)							/* Hand the slot to the reader. */
+            errExit ("releaseSem");
+
+        if (slot->count == 0)											/* EOF, also seen by the reader. */
+            break;
+
+        nbytes += slot->count;
+    }
+
+    /* Wait until the reader has emptied every slot, including the EOF marker. This 
+     * way we know that the reader has finished and we can clean up the IPC objects. */
+    for (i = 0; i < num_slots; i++)
+        if (reserveSem (semid, EMPTY_SEM) == -1)
+            errExit ("reserveSem");
+		
+    if (semctl (semid, 0, IPC_RMID, dummy) == -1)
+        errExit ("semctl");
+		
+    if (shmdt (ring) == -1)
+        errExit ("shmdt");
+		
+    if (shmctl (shmid, IPC_RMID, 0) == -1)
+        errExit ("shmctl");
+
+    fprintf (stderr, "Sent %ld bytes to the reader using %d transfers.\n", nbytes, xfrs);
+	
+    exit (EXIT_SUCCESS);
+}
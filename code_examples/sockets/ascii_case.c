@@ -0,0 +1,119 @@
+/* Implementation of the ASCII case conversion described in ascii_case.h.
+ *
+ * The range check uses signed byte comparisons, the only kind SSE2 and AVX2
+ * have: adding 128 - 'a' to each byte moves 'a' .. 'z' to -128 .. -103, the
+ * bottom of the signed range, so that "is a lower-case letter" becomes a single
+ * "less than -102" comparison. The resulting mask selects where to xor 0x20.
+ *
+ * Date created: October 19, 2026
+ *
+ */
+
+#include <stdint.h>
+#include "ascii_case.h"
+
+#define SHIFT ((char)(128 - 'a'))
+#define LIMIT ((char)(-128 + 26))
+
+static void
+upper_scalar (char *buf, size_t len)
+{
+    size_t i;
+
+    for (i = 0; i < len; i++)
+        if (buf[i] >= 'a' && buf[i] <= 'z')
+            buf[i] ^= 0x20;
+}
+
+#if defined (__x86_64__) || (defined (__i386__) && defined (__SSE2__))
+#include <immintrin.h>
+
+static void
+upper_sse2 (char *buf, size_t len)
+{
+    const __m128i shift = _mm_set1_epi8 (SHIFT);
+    const __m128i limit = _mm_set1_epi8 (LIMIT);
+    const __m128i flip = _mm_set1_epi8 (0x20);
+    __m128i v, mask;
+    size_t i;
+
+    for (i = 0; i + 16 <= len; i += 16){
+        v = _mm_loadu_si128 ((const __m128i *)(buf + i));
+        mask = _mm_cmplt_epi8 (_mm_add_epi8 (v, shift), limit);
+        v = _mm_xor_si128 (v, _mm_and_si128 (mask, flip));
+        _mm_storeu_si128 ((__m128i *)(buf + i), v);
+    }
+    upper_scalar (buf + i, len - i);
+}
+
+__attribute__ ((target ("avx2")))
+static void
+upper_avx2 (char *buf, size_t len)
+{
+    const __m256i shift = _mm256_set1_epi8 (SHIFT);
+    const __m256i limit = _mm256_set1_epi8 (LIMIT);
+    const __m256i flip = _mm256_set1_epi8 (0x20);
+    __m256i v, mask;
+    size_t i;
+
+    for (i = 0; i + 32 <= len; i += 32){
+        v = _mm256_loadu_si256 ((const __m256i *)(buf + i));
+        /* cmpgt with the operands swapped is "less than" */
+        mask = _mm256_cmpgt_epi8 (limit, _mm256_add_epi8 (v, shift));
+        v = _mm256_xor_si256 (v, _mm256_and_si256 (mask, flip));
+        _mm256_storeu_si256 ((__m256i *)(buf + i), v);
+    }
+    upper_sse2 (buf + i, len - i);
+}
+
+static void (*upper_impl) (char *, size_t);
+static const char *impl_name;
+
+/* Several threads may race to set this up; they all pick the same answer */
+static void (*get_impl (void)) (char *, size_t)
+{
+    void (*impl) (char *, size_t) = __atomic_load_n (&upper_impl, __ATOMIC_ACQUIRE);
+
+    if (impl == NULL){
+        __builtin_cpu_init ();
+        if (__builtin_cpu_supports ("avx2")){
+            impl_name = "avx2";
+            impl = upper_avx2;
+        }
+        else {
+            impl_name = "sse2";
+            impl = upper_sse2;
+        }
+        __atomic_store_n (&upper_impl, impl, __ATOMIC_RELEASE);
+    }
+    return impl;
+}
+
+void
+ascii_upper (char *buf, size_t len)
+{
+    get_impl () (buf, len);
+}
+
+const char *
+ascii_upper_impl (void)
+{
+    get_impl ();
+    return impl_name;
+}
+
+#else
+
+void
+ascii_upper (char *buf, size_t len)
+{
+    upper_scalar (buf, len);
+}
+
+const char *
+ascii_upper_impl (void)
+{
+    return "scalar";
+}
+
+#endif
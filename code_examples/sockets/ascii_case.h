@@ -0,0 +1,27 @@
+/* Header file for the ASCII case conversion in ascii_case.c, used by the batched
+ * mode of ud_ucase_server.c
+ *
+ * toupper () looks up one character at a time in the locale's tables. For plain
+ * ASCII the conversion is just a range check ('a' to 'z') and clearing bit 5
+ * (xor with 0x20), which SIMD instructions can do for 16 (SSE2) or 32 (AVX2)
+ * bytes at once. Bytes outside 'a' to 'z', including those above 127, are left
+ * alone, which matches toupper () in the "C" locale.
+ *
+ * The AVX2 version is chosen at run time if the processor has it; SSE2 is always
+ * there on x86-64, and other machines use the plain loop.
+ *
+ * Date created: October 19, 2026
+ *
+ */
+#ifndef _ASCII_CASE_H_
+#define _ASCII_CASE_H_
+
+#include <stddef.h>
+
+/* Convert the ASCII lower-case letters in buf to upper case, in place. */
+void ascii_upper (char *buf, size_t len);
+
+/* Name of the implementation in use: "avx2", "sse2" or "scalar". */
+const char *ascii_upper_impl (void);
+
+#endif /* _ASCII_CASE_H_ */
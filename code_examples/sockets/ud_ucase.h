@@ -25,4 +25,15 @@
 /* Maximum size of messages exchanged between client and server */
 #define BUF_SIZE 10
 
+/* The batched server (ud_ucase_server -b N -t T) has one socket per thread:
+ * SERVER_SOCKET_PATH for thread 0 and SERVER_SOCKET_PATH.i for thread i. */
+static inline void
+server_socket_path (char *path, size_t size, int index)
+{
+    if (index == 0)
+        snprintf (path, size, "%s", SERVER_SOCKET_PATH);
+    else
+        snprintf (path, size, "%s.%d", SERVER_SOCKET_PATH, index);
+}
+
 #endif /* _UD_UCASE_H_ */
@@ -0,0 +1,238 @@
+/* Load generator for ud_ucase_server.c. Each client thread binds its own socket,
+ * as ud_ucase_client.c does, and then works in rounds: it sends a window of
+ * datagrams with one sendmmsg () and collects the replies with recvmmsg (). A
+ * reply that has not arrived within a second is counted as lost; the batched
+ * server drops replies rather than wait for a client whose socket is full.
+ * Every reply is checked to be the upper-case version of what was sent.
+ *
+ * With -t T the clients spread themselves over the T sockets of a server
+ * started with -t T (client i uses socket i % T).
+ *
+ * Keep the window below /proc/sys/net/unix/max_dgram_qlen (10 by default), or
+ * raise that limit: replies beyond it do not fit in the client's socket.
+ *
+ * Start the server first, for example:
+ *      ./ud_ucase_server -b 64 -t 2 -m 64 -v &
+ *      ./ud_ucase_load -c 4 -n 250000 -w 8 -l 32 -t 2
+ *
+ * Usage: ./ud_ucase_load [-c clients] [-n datagrams per client] [-w window]
+ *                        [-l length] [-t server sockets]
+ *
+ * Date created: October 19, 2026
+ *
+ * Compile as follows: gcc -o ud_ucase_load ud_ucase_load.c -std=c99 -Wall -O2 -pthread
+ */
+
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <time.h>
+#include <sys/time.h>
+#include "ud_ucase.h"
+
+#define MAX_WINDOW 1024
+
+struct client {
+    int index;
+    pthread_t thread;
+    long replies;
+    long lost;
+    long wrong;
+};
+
+static long datagrams = 100000;
+static int window = 8, length = 32, nsockets = 1;
+
+static double
+now_seconds (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *
+client_thread (void *arg)
+{
+    struct client *c = arg;
+    struct sockaddr_un svaddr, claddr;
+    struct mmsghdr out[MAX_WINDOW], in[MAX_WINDOW];
+    struct iovec out_iov, in_iov[MAX_WINDOW];
+    struct timeval tv = {1, 0};
+    char *msg, *expected, *replies;
+    long sent;
+    int sfd, n, got, r, i;
+
+    msg = malloc (length);
+    expected = malloc (length);
+    replies = malloc ((size_t)window * length);
+    if (msg == NULL || expected == NULL || replies == NULL){
+        perror ("malloc");
+        exit (EXIT_FAILURE);
+    }
+    for (i = 0; i < length; i++){
+        msg[i] = "abcdefghijklmnopqrstuvwxyz0123456789-ABC"[i % 40];
+        expected[i] = toupper ((unsigned char) msg[i]);
+    }
+
+    /* Create the client socket and bind it to a unique pathname */
+    sfd = socket (AF_UNIX, SOCK_DGRAM, 0);
+    if (sfd == -1){
+        perror ("socket");
+        exit (EXIT_FAILURE);
+    }
+
+    memset (&claddr, 0, sizeof (struct sockaddr_un));
+    claddr.sun_family = AF_UNIX;
+    snprintf (claddr.sun_path, sizeof (claddr.sun_path), \
+              "/tmp/ud_ucase_load.%ld.%d", (long) getpid (), c->index);
+
+    if (bind (sfd, (struct sockaddr *)&claddr, sizeof (struct sockaddr_un)) == -1){
+        perror ("bind");
+        exit (EXIT_FAILURE);
+    }
+    if (setsockopt (sfd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof (tv)) == -1){
+        perror ("setsockopt");
+        exit (EXIT_FAILURE);
+    }
+
+    memset (&svaddr, 0, sizeof (struct sockaddr_un));
+    svaddr.sun_family = AF_UNIX;
+    server_socket_path (svaddr.sun_path, sizeof (svaddr.sun_path), c->index % nsockets);
+
+    /* Every datagram of a window is the same message to the same address */
+    out_iov.iov_base = msg;
+    out_iov.iov_len = length;
+    memset (out, 0, sizeof (out));
+    memset (in, 0, sizeof (in));
+    for (i = 0; i < window; i++){
+        out[i].msg_hdr.msg_name = &svaddr;
+        out[i].msg_hdr.msg_namelen = sizeof (struct sockaddr_un);
+        out[i].msg_hdr.msg_iov = &out_iov;
+        out[i].msg_hdr.msg_iovlen = 1;
+        in_iov[i].iov_base = replies + (size_t)i * length;
+        in_iov[i].iov_len = length;
+        in[i].msg_hdr.msg_iov = &in_iov[i];
+        in[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    for (sent = 0; sent < datagrams; sent += n){
+        n = window;
+        if (datagrams - sent < n)
+            n = datagrams - sent;
+
+        for (i = 0; i < n; i += r){
+            r = sendmmsg (sfd, out + i, n - i, 0);
+            if (r == -1){
+                if (errno == EINTR){
+                    r = 0;
+                    continue;
+                }
+                perror ("sendmmsg");
+                exit (EXIT_FAILURE);
+            }
+        }
+
+        /* Collect the replies; a timeout means the rest of them were lost */
+        for (got = 0; got < n; got += r){
+            r = recvmmsg (sfd, in, n - got, MSG_WAITFORONE, NULL);
+            if (r == -1){
+                if (errno == EINTR){
+                    r = 0;
+                    continue;
+                }
+                if (errno == EAGAIN || errno == EWOULDBLOCK){
+                    c->lost += n - got;
+                    break;
+                }
+                perror ("recvmmsg");
+                exit (EXIT_FAILURE);
+            }
+            for (i = 0; i < r; i++)
+                if (in[i].msg_len != (unsigned int)length || \
+                        memcmp (in_iov[i].iov_base, expected, length) != 0)
+                    c->wrong++;
+            c->replies += r;
+        }
+    }
+
+    /* Remove client socket pathname */
+    close (sfd);
+    remove (claddr.sun_path);
+    free (msg);
+    free (expected);
+    free (replies);
+    return NULL;
+}
+
+int
+main (int argc, char **argv)
+{
+    struct client *clients;
+    int opt, nclients = 4, i;
+    long replies = 0, lost = 0, wrong = 0;
+    double start, elapsed;
+
+    while ((opt = getopt (argc, argv, "c:n:w:l:t:")) != -1){
+        switch (opt){
+            case 'c':
+                nclients = atoi (optarg);
+                break;
+
+            case 'n':
+                datagrams = atol (optarg);
+                break;
+
+            case 'w':
+                window = atoi (optarg);
+                break;
+
+            case 'l':
+                length = atoi (optarg);
+                break;
+
+            case 't':
+                nsockets = atoi (optarg);
+                break;
+
+            default:
+                fprintf (stderr, "Usage: %s [-c clients] [-n datagrams per client] [-w window] "
+                         "[-l length] [-t server sockets] \n", argv[0]);
+                exit (EXIT_FAILURE);
+        }
+    }
+    if (nclients < 1 || datagrams < 1 || window < 1 || window > MAX_WINDOW || \
+            length < 1 || nsockets < 1){
+        fprintf (stderr, "Bad arguments (window at most %d) \n", MAX_WINDOW);
+        exit (EXIT_FAILURE);
+    }
+
+    clients = calloc (nclients, sizeof (struct client));
+    if (clients == NULL){
+        perror ("calloc");
+        exit (EXIT_FAILURE);
+    }
+
+    start = now_seconds ();
+    for (i = 0; i < nclients; i++){
+        clients[i].index = i;
+        if (pthread_create (&clients[i].thread, NULL, client_thread, &clients[i]) != 0){
+            fprintf (stderr, "pthread_create failed \n");
+            exit (EXIT_FAILURE);
+        }
+    }
+    for (i = 0; i < nclients; i++){
+        pthread_join (clients[i].thread, NULL);
+        replies += clients[i].replies;
+        lost += clients[i].lost;
+        wrong += clients[i].wrong;
+    }
+    elapsed = now_seconds () - start;
+
+    printf ("%ld datagrams of %d bytes from %d clients (window %d, %d server sockets) in %.2f s \n",
+            datagrams * nclients, length, nclients, window, nsockets, elapsed);
+    printf ("   %.0f datagrams/s answered, %ld lost, %ld wrong \n",
+            replies / elapsed, lost, wrong);
+
+    exit (wrong == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -4,17 +4,71 @@
  * The server program enters an infinite loop. It receives datagrams from 
  * the client, converts the received text to upper-case and returns 
  * it back to the client. 
+ *
+ * With -b N the server works on batches instead: recvmmsg () takes up to N 
+ * datagrams in one call, the ASCII kernel in ascii_case.c converts them with 
+ * SSE2/AVX2 instructions, and sendmmsg () returns all the replies in one call. 
+ * Nothing is printed per datagram; -v prints the rate once a second. A reply 
+ * to a client whose socket is full is dropped rather than waited for, so that 
+ * one slow client cannot hold up the others (-v reports the drops).
+ *
+ * Each batched thread runs an epoll reactor (../file_io/reactor.c) with its 
+ * socket registered in edge-triggered mode, and drains the socket in batches 
+ * until it is empty. Every recvmmsg () and sendmmsg () passes MSG_DONTWAIT, so 
+ * an empty socket or a full client never blocks the thread. After BATCH_BUDGET 
+ * batches in a row the thread defers the rest to the end of the round so that 
+ * timers get their turn. The rate printed with -v 
+ * comes from a periodic timer on the reactor of the main thread.
+ *
+ * With -t T the batched server runs T threads, each with its own socket: 
+ * thread 0 on SERVER_SOCKET_PATH and thread i on SERVER_SOCKET_PATH.i (see 
+ * ud_ucase.h). Clients spread themselves over the sockets (ud_ucase_load.c).
+ *
+ * Linux lets only /proc/sys/net/unix/max_dgram_qlen datagrams (10 by default) 
+ * queue up on a socket before senders have to wait, which also caps how many 
+ * datagrams one recvmmsg () can find. Raise it to make full use of large batches.
+ *
+ * Usage: ./ud_ucase_server [-b batch size] [-t threads] [-m max message size] [-v]
  * 
  * Author: Naga Kandasamy
  * Date created: July 15, 2018
  *
  * Source: M. Kerrisk, The Linux Programming Interface
  *
+ * Compile as follows: 
+ * gcc -o ud_ucase_server ud_ucase_server.c ascii_case.c ../file_io/reactor.c -std=c99 -Wall -O2 -pthread
+ *
  */
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <stddef.h>
+#include "../file_io/reactor.h"
+#include "ascii_case.h"
 #include "ud_ucase.h"
 
-int
-main (int argc, char **argv)
+#define MAX_BATCH 1024
+#define BATCH_BUDGET 16                 /* Batches per round before yielding */
+
+struct worker {
+    int sfd;
+    pthread_t thread;
+    reactor_t *reactor;
+    struct mmsghdr *in, *out;
+    struct iovec *iov;
+    struct sockaddr_un *addrs;
+    char *bufs;
+    unsigned long received;             /* Datagrams, updated atomically */
+    unsigned long dropped;              /* Replies that could not be sent */
+};
+
+static int batch_size = 0;
+static size_t msg_size = BUF_SIZE;
+static struct worker *workers;
+static int nworkers;
+
+/* Create a datagram socket bound to the well-known address of thread index */
+static int
+bind_server_socket (int index)
 {
     struct sockaddr_un svaddr;
     int sfd;
@@ -27,19 +81,229 @@ main (int argc, char **argv)
     }
 
     /* Construct the well-known address and bind server socket to it */
-    if (remove (SERVER_SOCKET_PATH) == -1 && errno != ENOENT){
+    memset (&svaddr, 0, sizeof (struct sockaddr_un));
+    svaddr.sun_family = AF_UNIX;
+    server_socket_path (svaddr.sun_path, sizeof (svaddr.sun_path), index);
+
+    if (remove (svaddr.sun_path) == -1 && errno != ENOENT){
         perror ("remove");
         exit (EXIT_FAILURE);
     }
 
-    memset (&svaddr, 0, sizeof (struct sockaddr_un));
-    svaddr.sun_family = AF_UNIX;
-    strncpy (svaddr.sun_path, SERVER_SOCKET_PATH, sizeof (svaddr.sun_path) -1);
-
     if (bind (sfd, (struct sockaddr *)&svaddr, sizeof (struct sockaddr_un)) == -1){
         perror ("bind");
         exit (EXIT_FAILURE);
     }
+    return sfd;
+}
+
+/* Receive one batch, convert it and send the replies. Returns the number of 
+ * datagrams received, 0 if the socket was empty. */
+static int
+serve_batch (struct worker *w)
+{
+    struct mmsghdr *in = w->in, *out = w->out;
+    struct iovec *iov = w->iov;
+    int n, m, i, sent, r;
+
+    for (i = 0; i < batch_size; i++){
+        iov[i].iov_base = w->bufs + i * msg_size;
+        iov[i].iov_len = msg_size;
+        in[i].msg_hdr.msg_iov = &iov[i];
+        in[i].msg_hdr.msg_iovlen = 1;
+        in[i].msg_hdr.msg_name = &w->addrs[i];
+        in[i].msg_hdr.msg_namelen = sizeof (struct sockaddr_un);
+    }
+
+    /* Take whatever is already queued */
+    do
+        n = recvmmsg (w->sfd, in, batch_size, MSG_DONTWAIT, NULL);
+    while (n == -1 && errno == EINTR);
+    if (n == -1){
+        if (errno == EAGAIN)
+            return 0;
+        perror ("recvmmsg");
+        exit (EXIT_FAILURE);
+    }
+    __atomic_add_fetch (&w->received, n, __ATOMIC_RELAXED);
+
+    /* Clients that did not bind an address cannot be answered */
+    for (i = 0, m = 0; i < n; i++){
+        if (in[i].msg_hdr.msg_namelen <= offsetof (struct sockaddr_un, sun_path))
+            continue;
+        ascii_upper (iov[i].iov_base, in[i].msg_len);
+        iov[i].iov_len = in[i].msg_len;
+        out[m].msg_hdr = in[i].msg_hdr;
+        m++;
+    }
+
+    /* A reply that fails (the client's socket is full or gone) is skipped */
+    for (sent = 0; sent < m; sent += r){
+        r = sendmmsg (w->sfd, out + sent, m - sent, MSG_DONTWAIT);
+        if (r == -1){
+            if (errno == EINTR){
+                r = 0;
+                continue;
+            }
+            __atomic_add_fetch (&w->dropped, 1, __ATOMIC_RELAXED);
+            r = 1;
+        }
+    }
+    return n;
+}
+
+static void resume_batches (reactor_t *reactor, void *arg);
+
+/* The socket is edge-triggered, so it is drained until empty, a budget at a time */
+static void
+serve_batches (struct worker *w)
+{
+    int budget;
+
+    for (budget = BATCH_BUDGET; budget > 0; budget--)
+        if (serve_batch (w) == 0)
+            return;
+    if (reactor_defer (w->reactor, resume_batches, w) == -1){
+        perror ("reactor_defer");
+        exit (EXIT_FAILURE);
+    }
+}
+
+static void
+resume_batches (reactor_t *reactor, void *arg)
+{
+    serve_batches (arg);
+}
+
+static void
+datagrams_waiting (reactor_t *reactor, int sfd, uint32_t events, void *arg)
+{
+    serve_batches (arg);
+}
+
+static void
+print_rate (reactor_t *reactor, void *arg)
+{
+    static unsigned long last = 0;
+    unsigned long received = 0, dropped = 0;
+    int i;
+
+    for (i = 0; i < nworkers; i++){
+        received += __atomic_load_n (&workers[i].received, __ATOMIC_RELAXED);
+        dropped += __atomic_load_n (&workers[i].dropped, __ATOMIC_RELAXED);
+    }
+    fprintf (stderr, "%lu datagrams/s, %lu replies dropped in total \n", received - last, dropped);
+    last = received;
+}
+
+static void *
+run_worker (void *arg)
+{
+    struct worker *w = arg;
+
+    if (reactor_run (w->reactor) == -1){
+        perror ("epoll_wait");
+        exit (EXIT_FAILURE);
+    }
+    return NULL;
+}
+
+static void
+init_worker (struct worker *w, int index)
+{
+    w->sfd = bind_server_socket (index);
+    w->in = calloc (batch_size, sizeof (struct mmsghdr));
+    w->out = calloc (batch_size, sizeof (struct mmsghdr));
+    w->iov = calloc (batch_size, sizeof (struct iovec));
+    w->addrs = calloc (batch_size, sizeof (struct sockaddr_un));
+    w->bufs = malloc (batch_size * msg_size);
+    if (w->in == NULL || w->out == NULL || w->iov == NULL || w->addrs == NULL || w->bufs == NULL){
+        perror ("calloc");
+        exit (EXIT_FAILURE);
+    }
+
+    /* Every call on the socket passes MSG_DONTWAIT, so it can stay blocking */
+    w->reactor = reactor_create ();
+    if (w->reactor == NULL || \
+            reactor_add (w->reactor, w->sfd, EPOLLIN | EPOLLET, datagrams_waiting, w) == -1){
+        perror ("reactor");
+        exit (EXIT_FAILURE);
+    }
+}
+
+static void
+run_batched (int nthreads, int verbose)
+{
+    int i;
+
+    nworkers = nthreads;
+    workers = calloc (nthreads, sizeof (struct worker));
+    if (workers == NULL){
+        perror ("calloc");
+        exit (EXIT_FAILURE);
+    }
+    for (i = 0; i < nthreads; i++)
+        init_worker (&workers[i], i);
+
+    /* The main thread runs the first worker itself */
+    for (i = 1; i < nthreads; i++){
+        if (pthread_create (&workers[i].thread, NULL, run_worker, &workers[i]) != 0){
+            fprintf (stderr, "pthread_create failed \n");
+            exit (EXIT_FAILURE);
+        }
+    }
+    fprintf (stderr, "Serving batches of up to %d datagrams on %d sockets (%s) \n",
+             batch_size, nthreads, ascii_upper_impl ());
+
+    if (verbose && reactor_timer_add (workers[0].reactor, 1000, 1000, print_rate, NULL) == NULL){
+        perror ("reactor_timer_add");
+        exit (EXIT_FAILURE);
+    }
+    run_worker (&workers[0]);
+}
+
+int
+main (int argc, char **argv)
+{
+    int sfd;
+    int opt, nthreads = 1, verbose = 0;
+
+    while ((opt = getopt (argc, argv, "b:t:m:v")) != -1){
+        switch (opt){
+            case 'b':
+                batch_size = atoi (optarg);
+                break;
+
+            case 't':
+                nthreads = atoi (optarg);
+                break;
+
+            case 'm':
+                msg_size = atol (optarg);
+                break;
+
+            case 'v':
+                verbose = 1;
+                break;
+
+            default:
+                fprintf (stderr, "Usage: %s [-b batch size] [-t threads] [-m max message size] [-v] \n", argv[0]);
+                exit (EXIT_FAILURE);
+        }
+    }
+    if (batch_size < 0 || batch_size > MAX_BATCH || nthreads < 1 || msg_size == 0){
+        fprintf (stderr, "Bad arguments (at most %d datagrams per batch) \n", MAX_BATCH);
+        exit (EXIT_FAILURE);
+    }
+    if (nthreads > 1 && batch_size == 0)
+        batch_size = MAX_BATCH / 16;
+
+    if (batch_size > 0){
+        run_batched (nthreads, verbose);
+        exit (EXIT_SUCCESS);
+    }
+
+    sfd = bind_server_socket (0);
 
     /* Execute an infinite loop to perform the following steps:
      *   - Receive messages from a client
@@ -50,11 +314,16 @@ main (int argc, char **argv)
     struct sockaddr_un claddr;
     socklen_t len;
     int num_bytes;
-    char buf[BUF_SIZE];
+    char *buf = malloc (msg_size);      /* -m applies here too */
+
+    if (buf == NULL){
+        perror ("malloc");
+        exit (EXIT_FAILURE);
+    }
 
     while (1){
         len = sizeof (struct sockaddr_un);
-        num_bytes = recvfrom (sfd, buf, BUF_SIZE, 0,\
+        num_bytes = recvfrom (sfd, buf, msg_size, 0,\
                               (struct sockaddr *)&claddr, &len);
         if (num_bytes == -1){
             perror ("recvfrom");
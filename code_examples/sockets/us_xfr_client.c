@@ -4,19 +4,111 @@
  * The client connects to the server and uses the connection to transfer 
  * data from its stdin to the server. 
  *
+ * With -z the data goes to the socket without being copied through the client: 
+ * sendfile () when the input is a regular file, splice () when it is a pipe, 
+ * and read () and write () with a large buffer (1 MB unless -b says otherwise) 
+ * for anything else. A file to send can be named instead of using stdin.
+ *
+ * Usage: ./us_xfr_client [-z] [-b buffer size] [file]
+ *
  * Author: Naga Kandasamy
  * Date created: July 15, 2018
  *
  * Source: M. Kerrisk, The Linux Programming Interface
  *
  */
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <sys/sendfile.h>
 #include "us_xfr.h"
 
+#define ZERO_COPY_SIZE (1 << 20)
+#define SENDFILE_CHUNK (1 << 30)        /* The kernel caps a sendfile () call at ~2 GB */
+
+/* Copy everything from in_fd to the socket, trying sendfile (), then splice (), 
+ * then falling back to a plain copy through a buffer of buf_size bytes. */
+static void
+send_zero_copy (int in_fd, int sfd, size_t buf_size)
+{
+    enum { USE_SENDFILE, USE_SPLICE, USE_COPY } how = USE_SENDFILE;
+    char *buf = NULL;
+    ssize_t n;
+
+    for (;;){
+        switch (how){
+            case USE_SENDFILE:
+                n = sendfile (sfd, in_fd, NULL, SENDFILE_CHUNK);
+                break;
+
+            case USE_SPLICE:
+                n = splice (in_fd, NULL, sfd, NULL, buf_size, SPLICE_F_MOVE | SPLICE_F_MORE);
+                break;
+
+            default:
+                n = read (in_fd, buf, buf_size);
+                if (n > 0 && write (sfd, buf, n) != n){
+                    perror ("write");
+                    exit (EXIT_FAILURE);
+                }
+        }
+
+        if (n == 0)
+            return;
+        if (n > 0 || errno == EINTR)
+            continue;
+
+        /* This kind of input cannot be sent that way; try the next way. Nothing 
+         * has been consumed by the failed call. */
+        if (how == USE_SENDFILE && (errno == EINVAL || errno == ENOSYS))
+            how = USE_SPLICE;
+        else if (how == USE_SPLICE && errno == EINVAL){
+            how = USE_COPY;
+            buf = malloc (buf_size);
+            if (buf == NULL){
+                perror ("malloc");
+                exit (EXIT_FAILURE);
+            }
+        }
+        else {
+            perror (how == USE_SENDFILE ? "sendfile" : how == USE_SPLICE ? "splice" : "read");
+            exit (EXIT_FAILURE);
+        }
+    }
+}
+
 int 
 main (int argc, char **argv)
 {
     struct sockaddr_un addr;
     int sfd;
+    int opt, zero_copy = 0, in_fd = STDIN_FILENO;
+    size_t buf_size = 0;
+
+    while ((opt = getopt (argc, argv, "zb:")) != -1){
+        switch (opt){
+            case 'z':
+                zero_copy = 1;
+                break;
+
+            case 'b':
+                buf_size = atol (optarg);
+                break;
+
+            default:
+                fprintf (stderr, "Usage: %s [-z] [-b buffer size] [file] \n", argv[0]);
+                exit (EXIT_FAILURE);
+        }
+    }
+    if (buf_size == 0)
+        buf_size = zero_copy ? ZERO_COPY_SIZE : BUF_SIZE;
+
+    if (optind < argc){
+        in_fd = open (argv[optind], O_RDONLY);
+        if (in_fd == -1){
+            perror ("open");
+            exit (EXIT_FAILURE);
+        }
+    }
 
     /* Create the client socket */
     sfd = socket (AF_UNIX, SOCK_STREAM, 0);
@@ -39,9 +131,18 @@ main (int argc, char **argv)
      * When the child terminates, its socket is closed and 
      * the server sees EOF when reading from the other side of the connection */
 
+    if (zero_copy){
+        send_zero_copy (in_fd, sfd, buf_size);
+        exit (EXIT_SUCCESS);
+    }
+
     ssize_t nr;
-    char buf[BUF_SIZE];
-    while ((nr =  read (STDIN_FILENO, buf, BUF_SIZE)) > 0){
+    char *buf = malloc (buf_size);
+    if (buf == NULL){
+        perror ("malloc");
+        exit (EXIT_FAILURE);
+    }
+    while ((nr =  read (in_fd, buf, buf_size)) > 0){
         if (write (sfd, buf, nr) != nr){
             perror ("write");
             exit (EXIT_FAILURE);
@@ -0,0 +1,280 @@
+/* Load generator for us_xfr_server.c. Each connection does what us_xfr_client.c
+ * does, sending a block of data in place of its standard input, and then shuts
+ * down its side of the connection and waits for the server to close the other,
+ * so that a connection counts as done only once the server has read all of it.
+ *
+ * A number of threads run connections back to back until the requested total has
+ * been made. The program reports connections per second, MB/s, and how long the
+ * connections took from connect () to the server closing them.
+ *
+ * With -s, that many slow clients connect first and send a byte every 100 ms for
+ * SLOW_SECONDS seconds. The iterative server cannot serve anybody else meanwhile;
+ * the epoll server (-e) is not held up by them.
+ *
+ * With -i, that many idle connections are opened before anything else and held, 
+ * without sending a byte, until the active connections are done. The active 
+ * connections are still only as many as there are threads, so -i is what shows 
+ * how each mode of the server copes as the number of open connections grows: 
+ * the epoll servers (-e, -t, -p) watch idle connections at no cost, the async 
+ * server (-a depth) has only depth - 1 connection slots, and the iterative server 
+ * waits on the first connection it accepts. A server that makes no progress for 
+ * STALL_SECONDS is reported as stuck and the program exits.
+ *
+ * Start the server first, for example:
+ *      ./us_xfr_server -q &        (or ./us_xfr_server -e -q, -e -t 4 -q)
+ *      ./us_xfr_load -c 16 -n 2000 -b 65536 -s 1
+ *      ./us_xfr_load -c 16 -n 2000 -i 10000
+ *
+ * Usage: ./us_xfr_load [-c concurrency] [-n connections] [-b bytes per connection]
+ *                      [-w write size] [-s slow clients] [-i idle connections]
+ *
+ * Date created: October 19, 2026
+ *
+ * Compile as follows: gcc -o us_xfr_load us_xfr_load.c -std=c99 -Wall -O2 -pthread
+ */
+
+#define _GNU_SOURCE
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/resource.h>
+#include "us_xfr.h"
+
+#define SLOW_SECONDS 2
+#define STALL_SECONDS 10
+
+static long connections = 1000, bytes_per_connection = 65536;
+static size_t write_size = 4096;
+static long next_connection = 0;        /* Handed out with an atomic add */
+static double *durations;               /* Seconds per connection */
+static volatile long progress;          /* Connections opened or finished */
+
+static double
+now_seconds (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int
+connect_to_server (void)
+{
+    struct sockaddr_un addr;
+    int sfd;
+
+    /* Create the client socket */
+    sfd = socket (AF_UNIX, SOCK_STREAM, 0);
+    if (sfd == -1){
+        perror ("socket");
+        exit (EXIT_FAILURE);
+    }
+
+    /* Construct the server-socket address and make the connection */
+    memset (&addr, 0, sizeof (struct sockaddr_un));
+    addr.sun_family = AF_UNIX;
+    strncpy (addr.sun_path, SERVER_SOCKET_PATH, sizeof (addr.sun_path) - 1);
+
+    if (connect (sfd, (struct sockaddr *)&addr, sizeof (struct sockaddr_un)) == -1){
+        perror ("connect");
+        exit (EXIT_FAILURE);
+    }
+    __atomic_fetch_add (&progress, 1, __ATOMIC_RELAXED);
+    return sfd;
+}
+
+/* Give up if no connection was opened or finished since the last alarm */
+static void
+stall_handler (int sig)
+{
+    static long last = -1;
+    static const char message[] = "No progress: the server is stuck behind the idle connections \n";
+
+    if (progress == last){
+        write (STDERR_FILENO, message, sizeof (message) - 1);
+        _exit (EXIT_FAILURE);
+    }
+    last = progress;
+    alarm (STALL_SECONDS);
+}
+
+/* Idle connections are descriptors too */
+static void
+raise_fd_limit (void)
+{
+    struct rlimit limit;
+
+    if (getrlimit (RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max){
+        limit.rlim_cur = limit.rlim_max;
+        if (setrlimit (RLIMIT_NOFILE, &limit) == -1)
+            perror ("setrlimit");
+    }
+}
+
+/* Wait for the server to close its end, which it does after reading everything */
+static void
+wait_for_close (int sfd)
+{
+    char c;
+    ssize_t nr;
+
+    if (shutdown (sfd, SHUT_WR) == -1){
+        perror ("shutdown");
+        exit (EXIT_FAILURE);
+    }
+    while ((nr = read (sfd, &c, 1)) > 0 || (nr == -1 && errno == EINTR));
+    close (sfd);
+}
+
+static void *
+client_thread (void *arg)
+{
+    char *buf = malloc (write_size);
+    long conn, sent;
+    size_t n;
+    double start;
+    int sfd;
+
+    if (buf == NULL){
+        perror ("malloc");
+        exit (EXIT_FAILURE);
+    }
+    memset (buf, 'x', write_size);
+
+    while ((conn = __atomic_fetch_add (&next_connection, 1, __ATOMIC_RELAXED)) < connections){
+        start = now_seconds ();
+        sfd = connect_to_server ();
+        for (sent = 0; sent < bytes_per_connection; sent += n){
+            n = write_size;
+            if (bytes_per_connection - sent < (long)n)
+                n = bytes_per_connection - sent;
+            if (write (sfd, buf, n) != (ssize_t)n){
+                perror ("write");
+                exit (EXIT_FAILURE);
+            }
+        }
+        wait_for_close (sfd);
+        durations[conn] = now_seconds () - start;
+        __atomic_fetch_add (&progress, 1, __ATOMIC_RELAXED);
+    }
+
+    free (buf);
+    return NULL;
+}
+
+static void *
+slow_thread (void *arg)
+{
+    int sfd = connect_to_server (), i;
+
+    for (i = 0; i < SLOW_SECONDS * 10; i++){
+        if (write (sfd, "s", 1) != 1){
+            perror ("write");
+            exit (EXIT_FAILURE);
+        }
+        usleep (100000);
+    }
+    wait_for_close (sfd);
+    return NULL;
+}
+
+static int
+compare_double (const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+int
+main (int argc, char **argv)
+{
+    pthread_t *clients, *slow;
+    int opt, concurrency = 16, nslow = 0, nidle = 0, *idle, i;
+    double start, elapsed;
+
+    while ((opt = getopt (argc, argv, "c:n:b:w:s:i:")) != -1){
+        switch (opt){
+            case 'c':
+                concurrency = atoi (optarg);
+                break;
+
+            case 'n':
+                connections = atol (optarg);
+                break;
+
+            case 'b':
+                bytes_per_connection = atol (optarg);
+                break;
+
+            case 'w':
+                write_size = atol (optarg);
+                break;
+
+            case 's':
+                nslow = atoi (optarg);
+                break;
+
+            case 'i':
+                nidle = atoi (optarg);
+                break;
+
+            default:
+                fprintf (stderr, "Usage: %s [-c concurrency] [-n connections] [-b bytes per connection] "
+                         "[-w write size] [-s slow clients] [-i idle connections] \n", argv[0]);
+                exit (EXIT_FAILURE);
+        }
+    }
+    if (concurrency < 1 || connections < 1 || bytes_per_connection < 0 || write_size == 0 || nslow < 0 || nidle < 0){
+        fprintf (stderr, "Bad arguments \n");
+        exit (EXIT_FAILURE);
+    }
+
+    durations = calloc (connections, sizeof (double));
+    clients = calloc (concurrency, sizeof (pthread_t));
+    slow = calloc (nslow + 1, sizeof (pthread_t));
+    idle = calloc (nidle + 1, sizeof (int));
+    if (durations == NULL || clients == NULL || slow == NULL || idle == NULL){
+        perror ("calloc");
+        exit (EXIT_FAILURE);
+    }
+
+    /* The idle connections go in first and stay open for the whole run */
+    if (nidle > 0){
+        raise_fd_limit ();
+        signal (SIGALRM, stall_handler);
+        alarm (STALL_SECONDS);
+    }
+    for (i = 0; i < nidle; i++)
+        idle[i] = connect_to_server ();
+
+    /* Let the slow clients get their connections in first */
+    for (i = 0; i < nslow; i++)
+        pthread_create (&slow[i], NULL, slow_thread, NULL);
+    if (nslow > 0)
+        usleep (100000);
+
+    start = now_seconds ();
+    for (i = 0; i < concurrency; i++)
+        pthread_create (&clients[i], NULL, client_thread, NULL);
+    for (i = 0; i < concurrency; i++)
+        pthread_join (clients[i], NULL);
+    elapsed = now_seconds () - start;
+    for (i = 0; i < nslow; i++)
+        pthread_join (slow[i], NULL);
+    alarm (0);
+    for (i = 0; i < nidle; i++)
+        close (idle[i]);
+
+    qsort (durations, connections, sizeof (double), compare_double);
+    printf ("%ld connections of %ld bytes from %d threads (%d slow clients, %d idle) in %.2f s \n",
+            connections, bytes_per_connection, concurrency, nslow, nidle, elapsed);
+    printf ("   %.0f connections/s, %.1f MB/s \n", connections / elapsed,
+            connections * (double)bytes_per_connection / elapsed / 1e6);
+    printf ("   per connection: median %.3f ms, 99th percentile %.3f ms, max %.3f ms \n",
+            durations[connections / 2] * 1e3, durations[connections * 99 / 100] * 1e3,
+            durations[connections - 1] * 1e3);
+
+    exit (EXIT_SUCCESS);
+}
@@ -4,57 +4,207 @@
  * The server program accepts client connections and transfers 
  * all data sent on the connection by the client to standard output. 
  *
- * The server is an example of an iterative server; that is, it one 
- * client at a time before moving on to the next one.
+ * By default the server is an example of an iterative server; that is, it 
+ * handles one client at a time before moving on to the next one. A single slow 
+ * client therefore stalls every client queued behind it.
+ *
+ * With -e the server is event-driven instead, running on the epoll reactor in 
+ * ../file_io/reactor.c: the listening socket and every connection are 
+ * non-blocking and registered in edge-triggered mode. An edge-triggered event is 
+ * reported once per burst of data, so each ready socket is read until it reports 
+ * EAGAIN; new connections are likewise accepted with accept4 () in a loop until 
+ * there are no more. To keep one busy client from starving the others, a 
+ * connection is read at most READ_BUDGET times per round and then deferred, to be 
+ * resumed after the other events. The soft limit on open descriptors is raised to 
+ * the hard limit, so the server can hold as many connections as it is allowed.
+ *
+ * With -t N, N reactor threads each run their own reactor. UNIX domain 
+ * sockets cannot be sharded with SO_REUSEPORT, so all threads watch the one 
+ * listening socket with EPOLLEXCLUSIVE, which wakes a single thread per new 
+ * connection; the connection then stays with the thread that accepted it.
+ *
+ * Output from concurrent clients is interleaved on stdout a buffer at a time; 
+ * use -q to discard the data (for benchmarks, see us_xfr_load.c).
+ *
+ * With -z the data is not copied through a user buffer at all: splice () moves 
+ * it from the socket into a pipe and from the pipe to stdout, so the kernel only 
+ * passes page references along. The pipe is grown to the buffer size (1 MB unless 
+ * -b says otherwise) so that each pair of calls moves a large chunk. If stdout 
+ * cannot take spliced data (a file opened for appending), the server says so and 
+ * falls back to read () and write () with a buffer of the same size.
+ *
+ * With -p N the server preforks N worker processes. The parent only accepts: it 
+ * hands each connection to a worker by sending the descriptor over a UNIX domain 
+ * socket pair as SCM_RIGHTS ancillary data, and each worker runs the epoll 
+ * reactor above on the connections it is given. Workers report how many 
+ * connections they have received and still hold open, and the parent gives each 
+ * new connection to the least-loaded one, counting connections that are sent 
+ * but not yet reported as received. Unlike threads, a worker that crashes only 
+ * takes its own connections with it; the parent notices the closed socket pair, 
+ * reaps the worker and starts a new one.
+ *
+ * With -a N the server runs on the asynchronous I/O engine in 
+ * ../file_io/io_engine.c (io_uring, or a pool of threads on older kernels) with up 
+ * to N requests in flight: one accept, and for every connection either a read 
+ * from it or the write of what was read to stdout. Nothing polls for readiness; 
+ * the thread just collects whichever requests have finished and queues the next 
+ * request of each connection. Connections beyond N - 1 wait for a free slot. 
+ * With -T the engine uses its pool of threads even where io_uring works.
+ *
+ * Usage: ./us_xfr_server [-e] [-t threads] [-p workers] [-a depth [-T]] [-b buffer size] [-q] [-z]
  *
  * Author: Naga Kandasamy
  * Date created: July 15, 2018
  *
  * Source: M. Kerrisk, The Linux Programming Interface
  *
+ * Compile as follows: 
+ * gcc -o us_xfr_server us_xfr_server.c ../file_io/io_engine.c ../file_io/reactor.c \
+ *     -std=c99 -Wall -O2 -pthread
+ *
  */
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "../file_io/io_engine.h"
+#include "../file_io/reactor.h"
 #include "us_xfr.h"
 
 /* Define the maximum backlog allowed in terms of client connections */
 #define BACKLOG 5
+#define READ_BUDGET 16                  /* Reads per connection before yielding */
+#define ZERO_COPY_SIZE (1 << 20)        /* Default pipe size with -z */
 
-int
-main (int argc, char **argv)
-{
-    struct sockaddr_un addr;     /* Structure for stream socket */
+struct loop;
+
+struct connection {
+    int fd;
+    char *buf;
+    struct loop *loop;
+    int deferred;                       /* Resumed by a deferred task, not by events */
+};
+
+/* One reactor thread, or a worker process */
+struct loop {
+    reactor_t *reactor;
+    int chanfd;                         /* Socket pair end to the dispatcher, or -1 */
+    uint32_t received, active;          /* Connections, reported to the dispatcher */
+    int changed;                        /* A report is due at the end of the round */
+    pthread_t thread;
+    int pipefd[2];                      /* For splice (), empty between transfers */
+};
+
+/* Sent by a worker to the dispatcher whenever its counts change */
+struct load_report {
+    uint32_t received;                  /* Connections received so far */
+    uint32_t active;                    /* Connections open now */
+};
+
+struct worker {
+    pid_t pid;
+    int chanfd;                         /* Dispatcher's end of the socket pair */
+    uint32_t sent;                      /* Connections handed to the worker */
+    struct load_report load;            /* The latest report */
+};
+
+struct dispatcher {
+    reactor_t *reactor;
     int sfd;
+    struct worker *workers;
+    int nworkers;
+    int accepting;                      /* Accepting is deferred to the end of the round */
+};
 
-    /* Open a stream socket in the UNIX domain */
-    sfd = socket (AF_UNIX, SOCK_STREAM, 0);
-    if (sfd == -1){
-        perror ("socket");
+static size_t buf_size = BUF_SIZE;
+static int discard = 0;
+static int zero_copy = 0;
+static int out_fd = STDOUT_FILENO;      /* /dev/null with -q -z */
+
+static void
+output (const char *buf, ssize_t nr)
+{
+    if (!discard && write (STDOUT_FILENO, buf, nr) != nr){
+        perror ("write");
         exit (EXIT_FAILURE);
     }
+}
 
-    /* Construct server socket address and bind it to the previously 
-     * created socket. make it a listening socket. First, remove 
-     * any existing file with the same pathname at that to which we 
-     * want to bind the socket */
-    if (remove (SERVER_SOCKET_PATH) == -1 && errno != ENOENT){
-        perror ("remove");
+/* Create the pipe that spliced data passes through, as large as the buffer size 
+ * (or as large as the system lets it be, in which case the buffer shrinks). */
+static void
+make_splice_pipe (int pipefd[2])
+{
+    int size;
+
+    if (pipe2 (pipefd, O_CLOEXEC) == -1){
+        perror ("pipe2");
         exit (EXIT_FAILURE);
     }
+    if (fcntl (pipefd[1], F_SETPIPE_SZ, (int)buf_size) == -1){
+        size = fcntl (pipefd[1], F_GETPIPE_SZ);
+        if (size > 0 && (size_t)size < buf_size)
+            buf_size = size;
+    }
+}
 
-    memset (&addr, 0, sizeof (struct sockaddr_un));
-    addr.sun_family = AF_UNIX;
-    strncpy (addr.sun_path, SERVER_SOCKET_PATH, sizeof (addr.sun_path) -1);
+/* Move up to buf_size bytes from a connection to the output: with splice () by 
+ * way of the pipe, or with read () and write () through buf. Returns the number of 
+ * bytes moved, 0 at end of file, or -1 with errno set. The pipe is always left 
+ * empty, so it can be shared by every connection of a thread. */
+static ssize_t
+transfer (int fd, char *buf, int pipefd[2], unsigned int flags)
+{
+    ssize_t nr, nw;
+    size_t left;
 
-    if (bind (sfd, (struct sockaddr *)&addr, sizeof (struct sockaddr_un)) == -1){
-        perror ("bind");
-        exit (EXIT_FAILURE);
+    if (!zero_copy){
+        nr = read (fd, buf, buf_size);
+        if (nr > 0)
+            output (buf, nr);
+        return nr;
     }
 
-    if (listen (sfd, BACKLOG) == -1){
-        perror ("listen");
-        exit (EXIT_FAILURE);
+    nr = splice (fd, NULL, pipefd[1], NULL, buf_size, SPLICE_F_MOVE | flags);
+    for (left = (nr > 0) ? nr : 0; left > 0; left -= nw){
+        nw = splice (pipefd[0], NULL, out_fd, NULL, left, SPLICE_F_MOVE | SPLICE_F_MORE);
+        if (nw == -1 && errno == EINTR)
+            nw = 0;
+        else if (nw <= 0){
+            perror ("splice");
+            exit (EXIT_FAILURE);
+        }
     }
+    return nr;
+}
 
+/* splice () refuses to write to a file opened with O_APPEND */
+static void
+check_zero_copy (void)
+{
+    int flags;
 
+    if (discard){
+        out_fd = open ("/dev/null", O_WRONLY | O_CLOEXEC);
+        if (out_fd == -1){
+            perror ("open");
+            exit (EXIT_FAILURE);
+        }
+        return;
+    }
+
+    flags = fcntl (STDOUT_FILENO, F_GETFL);
+    if (flags != -1 && (flags & O_APPEND)){
+        fprintf (stderr, "stdout is opened for appending; using read () and write () \n");
+        zero_copy = 0;
+    }
+}
+
+static void
+serve_iterative (int sfd)
+{
     /* Execute an infinite loop to handle incoming client requests. The loop performs
      * the following functions:
      *  - Accept a connection, obtaining a new socket, cfd, for the connection 
@@ -64,7 +214,16 @@ main (int argc, char **argv)
 
     int cfd;
     ssize_t nr;
-    char buf[BUF_SIZE];
+    char *buf = NULL;
+    int pipefd[2];
+
+    if (zero_copy)
+        make_splice_pipe (pipefd);
+    else if ((buf = malloc (buf_size)) == NULL){
+        perror ("malloc");
+        exit (EXIT_FAILURE);
+    }
+
     while (1){
         /* Accept a connection which is returned on a new socket cfd. 
          * Note that the listening socket, sfd, remains open, and can 
@@ -81,12 +240,8 @@ main (int argc, char **argv)
         }
 
         /* Transfer data from cfd to stdout until EOF is received */
-        while ((nr = read (cfd, buf, BUF_SIZE)) > 0){
-            if (write (STDOUT_FILENO, buf, nr) != nr){
-                perror ("write");
-                exit (EXIT_FAILURE);
-            }
-        }
+        while ((nr = transfer (cfd, buf, pipefd, 0)) > 0)
+            ;
 
         if (nr == -1){
             perror ("read");
@@ -97,6 +252,725 @@ main (int argc, char **argv)
             perror ("close");
         }
     }
+}
+
+/* A worker reports its counts once per round in which they changed */
+static void
+report_load (reactor_t *reactor, void *arg)
+{
+    struct loop *l = arg;
+    struct load_report report;
+
+    /* A report that does not fit is simply dropped; the next one has the totals */
+    report.received = l->received;
+    report.active = l->active;
+    send (l->chanfd, &report, sizeof (report), MSG_DONTWAIT | MSG_NOSIGNAL);
+    l->changed = 0;
+}
+
+static void
+counts_changed (struct loop *l)
+{
+    if (l->chanfd == -1 || l->changed)
+        return;
+    if (reactor_defer (l->reactor, report_load, l) == 0)
+        l->changed = 1;
+}
+
+static void
+close_connection (struct loop *l, struct connection *conn)
+{
+    reactor_remove (l->reactor, conn->fd);
+    close (conn->fd);
+    free (conn->buf);
+    free (conn);
+    l->active--;
+    counts_changed (l);
+}
+
+static void resume_connection (reactor_t *reactor, void *arg);
+
+/* Read a connection until it runs dry, closes, or uses up its budget. In the last 
+ * case it is resumed by a deferred task, since edge-triggered epoll will not 
+ * report the data that is still waiting; until then its events are ignored, so 
+ * that it is not closed while the task still refers to it. */
+static void
+handle_connection (struct loop *l, struct connection *conn)
+{
+    ssize_t nr;
+    int budget;
+
+    for (budget = READ_BUDGET; budget > 0; budget--){
+        nr = transfer (conn->fd, conn->buf, l->pipefd, SPLICE_F_NONBLOCK);
+        if (nr > 0)
+            continue;
+        if (nr == -1 && errno == EINTR)
+            continue;
+        if (nr == -1 && errno == EAGAIN)
+            return;
+        if (nr == -1)
+            perror ("read");
+        close_connection (l, conn);     /* EOF or error */
+        return;
+    }
+
+    if (reactor_defer (l->reactor, resume_connection, conn) == 0)
+        conn->deferred = 1;
+    else
+        close_connection (l, conn);     /* Out of memory; it would stall otherwise */
+}
+
+static void
+resume_connection (reactor_t *reactor, void *arg)
+{
+    struct connection *conn = arg;
+
+    conn->deferred = 0;
+    handle_connection (conn->loop, conn);
+}
+
+static void
+on_connection (reactor_t *reactor, int fd, uint32_t events, void *arg)
+{
+    struct connection *conn = arg;
+
+    if (!conn->deferred)
+        handle_connection (conn->loop, conn);
+}
+
+/* Add a non-blocking connected socket to the reactor */
+static void
+add_connection (struct loop *l, int cfd)
+{
+    struct connection *conn;
+
+    /* Spliced data never passes through a buffer of the connection's own */
+    conn = malloc (sizeof (struct connection));
+    if (conn != NULL)
+        conn->buf = NULL;
+    if (conn == NULL || (!zero_copy && (conn->buf = malloc (buf_size)) == NULL)){
+        perror ("malloc");
+        free (conn);
+        close (cfd);
+        return;
+    }
+    conn->fd = cfd;
+    conn->loop = l;
+    conn->deferred = 0;
+
+    /* Data that arrived before the socket was added is reported right away */
+    if (reactor_add (l->reactor, cfd, EPOLLIN | EPOLLRDHUP | EPOLLET, on_connection, conn) == -1){
+        perror ("reactor_add");
+        close (cfd);
+        free (conn->buf);
+        free (conn);
+        return;
+    }
+    l->active++;
+    counts_changed (l);
+}
+
+static void
+accept_connections (reactor_t *reactor, int sfd, uint32_t events, void *arg)
+{
+    int cfd;
+
+    for (;;){
+        cfd = accept4 (sfd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (cfd == -1){
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            if (errno != EAGAIN)
+                perror ("accept4");     /* E.g. EMFILE; retried on the next connection */
+            return;
+        }
+        add_connection (arg, cfd);
+    }
+}
+
+/* Pass descriptor fd over a UNIX domain socket. One byte of ordinary data goes 
+ * with it, since the descriptor travels as ancillary data on a message. */
+static int
+send_fd (int chanfd, int fd)
+{
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE (sizeof (int))];
+    } control;
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr *cmsg;
+    char byte = 'c';
+
+    memset (&msg, 0, sizeof (msg));
+    memset (&control, 0, sizeof (control));
+    iov.iov_base = &byte;
+    iov.iov_len = 1;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof (control.buf);
+
+    cmsg = CMSG_FIRSTHDR (&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN (sizeof (int));
+    memcpy (CMSG_DATA (cmsg), &fd, sizeof (int));
+
+    /* A dead worker must not kill the dispatcher with SIGPIPE */
+    return sendmsg (chanfd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL) == 1 ? 0 : -1;
+}
+
+/* Receive a descriptor sent by send_fd (). Returns 1 and sets *fd, 0 at end of 
+ * file, or -1 with errno set (EAGAIN when nothing is waiting). */
+static int
+recv_fd (int chanfd, int *fd)
+{
+    union {
+        struct cmsghdr align;
+        char buf[CMSG_SPACE (sizeof (int))];
+    } control;
+    struct msghdr msg;
+    struct iovec iov;
+    struct cmsghdr *cmsg;
+    ssize_t nr;
+    char byte;
+
+    memset (&msg, 0, sizeof (msg));
+    iov.iov_base = &byte;
+    iov.iov_len = 1;
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.buf;
+    msg.msg_controllen = sizeof (control.buf);
+
+    nr = recvmsg (chanfd, &msg, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+    if (nr <= 0)
+        return nr;
+
+    cmsg = CMSG_FIRSTHDR (&msg);
+    if (cmsg == NULL || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS || \
+            cmsg->cmsg_len != CMSG_LEN (sizeof (int))){
+        errno = EBADMSG;
+        return -1;
+    }
+    memcpy (fd, CMSG_DATA (cmsg), sizeof (int));
+    return 1;
+}
+
+
+/* Take the connections the dispatcher has sent; quit when the dispatcher has gone */
+static void
+receive_connections (reactor_t *reactor, int chanfd, uint32_t events, void *arg)
+{
+    struct loop *l = arg;
+    int cfd = -1, status;
+
+    for (;;){
+        status = recv_fd (chanfd, &cfd);
+        if (status == 1){
+            l->received++;
+            add_connection (l, cfd);    /* Non-blocking already: the flag is shared */
+            continue;
+        }
+        if (status == -1 && errno == EINTR)
+            continue;
+        if (status == -1 && errno == EAGAIN)
+            return;
+        if (status == -1)
+            perror ("recvmsg");
+        exit (EXIT_SUCCESS);
+    }
+}
+
+static void *
+run_loop (void *arg)
+{
+    struct loop *l = arg;
+
+    if (reactor_run (l->reactor) == -1){
+        perror ("epoll_wait");
+        exit (EXIT_FAILURE);
+    }
+    return NULL;
+}
+
+/* Set up a loop with no connections. Its one source of new connections is the 
+ * listening socket, or else the channel from the dispatcher. */
+static void
+init_loop (struct loop *l, int sfd, int chanfd, int exclusive)
+{
+    int status;
+
+    memset (l, 0, sizeof (struct loop));
+    l->chanfd = chanfd;
+    if (zero_copy)
+        make_splice_pipe (l->pipefd);
+    l->reactor = reactor_create ();
+    if (l->reactor == NULL){
+        perror ("reactor_create");
+        exit (EXIT_FAILURE);
+    }
+
+    if (chanfd != -1)
+        status = reactor_add (l->reactor, chanfd, EPOLLIN | EPOLLET, receive_connections, l);
+    else
+        status = reactor_add (l->reactor, sfd, EPOLLIN | EPOLLET | (exclusive ? EPOLLEXCLUSIVE : 0), 
+                              accept_connections, l);
+    if (status == -1){
+        perror ("reactor_add");
+        exit (EXIT_FAILURE);
+    }
+}
+
+static void
+serve_epoll (int sfd, int nthreads)
+{
+    struct loop *loops;
+    int i;
+
+    if (fcntl (sfd, F_SETFL, fcntl (sfd, F_GETFL) | O_NONBLOCK) == -1){
+        perror ("fcntl");
+        exit (EXIT_FAILURE);
+    }
+
+    loops = calloc (nthreads, sizeof (struct loop));
+    if (loops == NULL){
+        perror ("calloc");
+        exit (EXIT_FAILURE);
+    }
+
+    for (i = 0; i < nthreads; i++)
+        init_loop (&loops[i], sfd, -1, nthreads > 1);
+
+    /* The main thread runs the first loop itself */
+    for (i = 1; i < nthreads; i++){
+        if (pthread_create (&loops[i].thread, NULL, run_loop, &loops[i]) != 0){
+            fprintf (stderr, "pthread_create failed \n");
+            exit (EXIT_FAILURE);
+        }
+    }
+    run_loop (&loops[0]);
+}
+
+static void read_reports (reactor_t *reactor, int chanfd, uint32_t events, void *arg);
+
+/* Fork worker index; the child serves the connections it is sent and never returns */
+static void
+start_worker (struct dispatcher *d, int index)
+{
+    struct worker *workers = d->workers;
+    struct loop l;
+    int pair[2], i;
+
+    /* Sequenced packets keep each descriptor and each report a message of its own */
+    if (socketpair (AF_UNIX, SOCK_SEQPACKET, 0, pair) == -1){
+        perror ("socketpair");
+        exit (EXIT_FAILURE);
+    }
+
+    switch (workers[index].pid = fork ()){
+        case -1:
+            perror ("fork");
+            exit (EXIT_FAILURE);
+
+        case 0:
+            /* Child: keep only its own end of its own socket pair. It never returns 
+             * to the dispatcher's reactor, so that can go too. */
+            close (pair[0]);
+            close (d->sfd);
+            reactor_destroy (d->reactor);
+            for (i = 0; i < d->nworkers; i++)
+                if (i != index && workers[i].chanfd != -1)
+                    close (workers[i].chanfd);
+            init_loop (&l, -1, pair[1], 0);
+            run_loop (&l);
+            exit (EXIT_SUCCESS);
+
+        default:
+            break;
+    }
+
+    close (pair[1]);
+    workers[index].chanfd = pair[0];
+    workers[index].sent = 0;
+    memset (&workers[index].load, 0, sizeof (struct load_report));
+
+    if (reactor_add (d->reactor, pair[0], EPOLLIN, read_reports, d) == -1){
+        perror ("reactor_add");
+        exit (EXIT_FAILURE);
+    }
+}
+
+/* Read a worker's load reports; if it has gone, reap it and start another */
+static void
+read_reports (reactor_t *reactor, int chanfd, uint32_t events, void *arg)
+{
+    struct dispatcher *d = arg;
+    struct load_report report;
+    struct worker *w;
+    ssize_t nr;
+    int index, status;
+
+    for (index = 0; d->workers[index].chanfd != chanfd; index++)
+        ;
+    w = &d->workers[index];
+
+    while ((nr = recv (w->chanfd, &report, sizeof (report), MSG_DONTWAIT)) == sizeof (report))
+        w->load = report;
+    if (nr == -1 && (errno == EAGAIN || errno == EINTR))
+        return;
+
+    reactor_remove (reactor, w->chanfd);
+    close (w->chanfd);
+    w->chanfd = -1;
+    if (waitpid (w->pid, &status, 0) == -1)
+        perror ("waitpid");
+    else if (WIFSIGNALED (status))
+        fprintf (stderr, "Worker %ld killed by signal %d; starting a new one \n", 
+                 (long) w->pid, WTERMSIG (status));
+    else
+        fprintf (stderr, "Worker %ld exited with status %d; starting a new one \n", 
+                 (long) w->pid, WEXITSTATUS (status));
+    start_worker (d, index);
+}
+
+/* Hand a connection to the least-loaded worker that will take it */
+static void
+dispatch (struct worker *workers, int nworkers, int cfd)
+{
+    uint32_t load, best_load;
+    int i, best, tries;
+    char tried[nworkers];
+
+    memset (tried, 0, nworkers);
+    for (tries = 0; tries < nworkers; tries++){
+        best = -1;
+        best_load = UINT32_MAX;
+        for (i = 0; i < nworkers; i++){
+            if (workers[i].chanfd == -1 || tried[i])
+                continue;
+            /* Connections in flight count as well as those the worker reported */
+            load = workers[i].load.active + (workers[i].sent - workers[i].load.received);
+            if (load < best_load){
+                best = i;
+                best_load = load;
+            }
+        }
+        if (best == -1)
+            break;
+        if (send_fd (workers[best].chanfd, cfd) == 0){
+            workers[best].sent++;
+            close (cfd);                /* The worker has its own copy now */
+            return;
+        }
+        /* The worker's socket is full or gone; try the next one */
+        tried[best] = 1;
+    }
+
+    fprintf (stderr, "No worker can take a connection; dropping it \n");
+    close (cfd);
+}
+
+static void
+dispatch_connections (reactor_t *reactor, void *arg)
+{
+    struct dispatcher *d = arg;
+    int cfd;
+
+    d->accepting = 0;
+    while ((cfd = accept4 (d->sfd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1)
+        dispatch (d->workers, d->nworkers, cfd);
+    if (errno != EAGAIN && errno != EINTR && errno != ECONNABORTED)
+        perror ("accept4");
+}
+
+/* New connections are dispatched once the round's reports are in, so that they go 
+ * to the right place */
+static void
+connections_waiting (reactor_t *reactor, int sfd, uint32_t events, void *arg)
+{
+    struct dispatcher *d = arg;
+
+    if (!d->accepting && reactor_defer (reactor, dispatch_connections, d) == 0)
+        d->accepting = 1;
+}
+
+static void
+serve_prefork (int sfd, int nworkers)
+{
+    struct dispatcher d;
+    int i;
+
+    memset (&d, 0, sizeof (d));
+    d.sfd = sfd;
+    d.nworkers = nworkers;
+    d.workers = calloc (nworkers, sizeof (struct worker));
+    d.reactor = reactor_create ();
+    if (d.workers == NULL || d.reactor == NULL){
+        perror ("calloc or reactor_create");
+        exit (EXIT_FAILURE);
+    }
+    for (i = 0; i < nworkers; i++)
+        d.workers[i].chanfd = -1;
+    for (i = 0; i < nworkers; i++)
+        start_worker (&d, i);
+
+    if (fcntl (sfd, F_SETFL, fcntl (sfd, F_GETFL) | O_NONBLOCK) == -1){
+        perror ("fcntl");
+        exit (EXIT_FAILURE);
+    }
+    if (reactor_add (d.reactor, sfd, EPOLLIN, connections_waiting, &d) == -1){
+        perror ("reactor_add");
+        exit (EXIT_FAILURE);
+    }
+
+    if (reactor_run (d.reactor) == -1){
+        perror ("epoll_wait");
+        exit (EXIT_FAILURE);
+    }
+}
+
+/* Let an event-driven server hold as many connections as the hard limit allows */
+static void
+raise_fd_limit (void)
+{
+    struct rlimit limit;
+
+    if (getrlimit (RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max){
+        limit.rlim_cur = limit.rlim_max;
+        if (setrlimit (RLIMIT_NOFILE, &limit) == -1)
+            perror ("setrlimit");
+    }
+}
+
+struct async_conn {
+    int fd;
+    char *buf;
+    size_t have, written;               /* Bytes read into buf, and written out so far */
+};
+
+/* Queue the next request for a connection: write out what is left in its buffer, 
+ * or else read more. Returns 0, or -1 if the request could not be queued. */
+static int
+async_next (io_engine_t *e, struct async_conn *conn)
+{
+    if (conn->written < conn->have)
+        return ioe_prep (e, IOE_WRITE, STDOUT_FILENO, conn->buf + conn->written,
+                         conn->have - conn->written, -1, 0, conn);
+    return ioe_prep (e, IOE_READ, conn->fd, conn->buf, buf_size, -1, 0, conn);
+}
+
+static void
+async_close (struct async_conn *conn)
+{
+    close (conn->fd);
+    free (conn->buf);
+    free (conn);
+}
+
+static void
+serve_async (int sfd, int depth, int engine_flags)
+{
+    struct ioe_completion *done;
+    struct async_conn *conn;
+    io_engine_t *e;
+    int accepting = 0, n, i;
+
+    e = ioe_create (depth, engine_flags);
+    done = calloc (depth, sizeof (struct ioe_completion));
+    if (e == NULL || done == NULL){
+        perror ("ioe_create");
+        exit (EXIT_FAILURE);
+    }
+    ioe_register_files (e, &sfd, 1);
+    fprintf (stderr, "Serving with %s, up to %d requests in flight \n", ioe_backend (e), depth);
+
+    for (;;){
+        /* The accept (user data NULL) goes back in whenever there is room for it */
+        if (!accepting && ioe_space (e) > 0){
+            if (ioe_prep (e, IOE_ACCEPT, sfd, NULL, 0, 0, 0, NULL) == -1){
+                perror ("ioe_prep");
+                exit (EXIT_FAILURE);
+            }
+            accepting = 1;
+        }
+        if (ioe_submit (e) == -1 || (n = ioe_complete (e, done, depth, 1)) == -1){
+            perror ("io engine");
+            exit (EXIT_FAILURE);
+        }
+
+        for (i = 0; i < n; i++){
+            conn = done[i].user;
+
+            if (conn == NULL){
+                accepting = 0;
+                if (done[i].result < 0){
+                    errno = -done[i].result;
+                    perror ("accept");
+                    continue;
+                }
+                conn = malloc (sizeof (struct async_conn));
+                if (conn == NULL || (conn->buf = malloc (buf_size)) == NULL){
+                    perror ("malloc");
+                    close (done[i].result);
+                    free (conn);
+                    continue;
+                }
+                conn->fd = done[i].result;
+                conn->have = conn->written = 0;
+            }
+            else if (conn->written < conn->have){
+                /* A write finished; a short one goes round again, but one that 
+                 * wrote nothing would go round for ever */
+                if (done[i].result <= 0){
+                    if (done[i].result == 0)
+                        fprintf (stderr, "write: wrote nothing \n");
+                    else {
+                        errno = -done[i].result;
+                        perror ("write");
+                    }
+                    exit (EXIT_FAILURE);
+                }
+                conn->written += done[i].result;
+            }
+            else if (done[i].result > 0){
+                /* A read finished; with -q the data is simply dropped */
+                conn->have = discard ? 0 : done[i].result;
+                conn->written = 0;
+            }
+            else {
+                if (done[i].result < 0){
+                    errno = -done[i].result;
+                    perror ("read");
+                }
+                async_close (conn);     /* EOF or error */
+                continue;
+            }
+            /* Each connection has one request in flight, and its last one has just 
+             * finished, so there is room; should the engine refuse all the same, 
+             * the connection is dropped rather than left without a request */
+            if (async_next (e, conn) == -1){
+                perror ("ioe_prep");
+                async_close (conn);
+            }
+        }
+    }
+}
+
+int
+main (int argc, char **argv)
+{
+    struct sockaddr_un addr;     /* Structure for stream socket */
+    int sfd;
+    int opt, use_epoll = 0, nthreads = 1, nworkers = 0, depth = 0, size_given = 0;
+    int engine_flags = 0;
+
+    while ((opt = getopt (argc, argv, "et:p:a:Tb:qz")) != -1){
+        switch (opt){
+            case 'e':
+                use_epoll = 1;
+                break;
+
+            case 't':
+                nthreads = atoi (optarg);
+                use_epoll = 1;
+                break;
+
+            case 'p':
+                nworkers = atoi (optarg);
+                use_epoll = 1;
+                break;
+
+            case 'a':
+                depth = atoi (optarg);
+                use_epoll = 1;          /* For the longer backlog */
+                break;
+
+            case 'T':
+                engine_flags |= IOE_THREADS;
+                break;
+
+            case 'b':
+                buf_size = atol (optarg);
+                size_given = 1;
+                break;
+
+            case 'q':
+                discard = 1;
+                break;
+
+            case 'z':
+                zero_copy = 1;
+                break;
+
+            default:
+                fprintf (stderr, "Usage: %s [-e] [-t threads] [-p workers] [-a depth [-T]] [-b buffer size] "
+                         "[-q] [-z] \n", argv[0]);
+                exit (EXIT_FAILURE);
+        }
+    }
+    if (nthreads < 1 || nworkers < 0 || (nworkers > 0 && nthreads > 1) || buf_size == 0){
+        fprintf (stderr, "Bad thread or worker count (-t and -p do not mix) or buffer size \n");
+        exit (EXIT_FAILURE);
+    }
+    if (depth < 0 || (depth > 0 && (nworkers > 0 || nthreads > 1 || zero_copy))){
+        fprintf (stderr, "Bad queue depth (-a does not mix with -t, -p or -z) \n");
+        exit (EXIT_FAILURE);
+    }
+    if (engine_flags && depth == 0){
+        fprintf (stderr, "-T picks the backend of the I/O engine, which only -a uses \n");
+        exit (EXIT_FAILURE);
+    }
+    if (depth == 1)
+        depth = 2;                      /* One accept and one connection at least */
+    if (zero_copy){
+        if (!size_given)
+            buf_size = ZERO_COPY_SIZE;
+        check_zero_copy ();
+    }
+
+    /* Open a stream socket in the UNIX domain */
+    sfd = socket (AF_UNIX, SOCK_STREAM, 0);
+    if (sfd == -1){
+        perror ("socket");
+        exit (EXIT_FAILURE);
+    }
+
+    /* Construct server socket address and bind it to the previously 
+     * created socket. make it a listening socket. First, remove 
+     * any existing file with the same pathname at that to which we 
+     * want to bind the socket */
+    if (remove (SERVER_SOCKET_PATH) == -1 && errno != ENOENT){
+        perror ("remove");
+        exit (EXIT_FAILURE);
+    }
+
+    memset (&addr, 0, sizeof (struct sockaddr_un));
+    addr.sun_family = AF_UNIX;
+    strncpy (addr.sun_path, SERVER_SOCKET_PATH, sizeof (addr.sun_path) -1);
+
+    if (bind (sfd, (struct sockaddr *)&addr, sizeof (struct sockaddr_un)) == -1){
+        perror ("bind");
+        exit (EXIT_FAILURE);
+    }
+
+    /* An event-driven server drains the backlog in bursts, so let it be long */
+    if (listen (sfd, use_epoll ? SOMAXCONN : BACKLOG) == -1){
+        perror ("listen");
+        exit (EXIT_FAILURE);
+    }
+    if (use_epoll && depth == 0)
+        raise_fd_limit ();
+
+    if (depth > 0)
+        serve_async (sfd, depth, engine_flags);
+    else if (nworkers > 0)
+        serve_prefork (sfd, nworkers);
+    else if (use_epoll)
+        serve_epoll (sfd, nthreads);
+    else
+        serve_iterative (sfd);
 
     exit (EXIT_SUCCESS);
 }
@@ -0,0 +1,143 @@
+/* This code illustrates the signal dispatcher, a reusable version of the signal 
+ * handler thread in signal_handler_thread.c. All signals of interest are blocked 
+ * in every thread and handled by one dispatcher thread, which calls the handlers 
+ * registered below in normal thread context.
+ *
+ * The worker threads sleep in blocking system calls; since they never receive 
+ * signals, the calls are never interrupted with EINTR.
+ *
+ * Try the following from another terminal:
+ *
+ *   $ kill -s SIGUSR1 <process id>               (coalesced)
+ *   $ for i in 1 2 3 4 5; do kill -s SIGUSR1 <process id>; done
+ *   $ kill -s SIGRTMIN <process id>              (queued, every one is delivered)
+ *   $ kill -s SIGINT <process id>                (or Ctrl+C)
+ *
+ * The program also queues a few real-time signals with payloads to itself.
+ *
+ * Date created: October 19, 2026
+ *
+ * Compile as follows: 
+ * gcc -o signal_dispatch_thread signal_dispatch_thread.c signal_dispatcher.c -std=c99 -Wall -lpthread 
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include "signal_dispatcher.h"
+
+#define NUM_WORKERS 4
+
+static pthread_mutex_t done_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t done_cv = PTHREAD_COND_INITIALIZER;
+static int done = 0;
+
+/* Handler for SIGUSR1 and SIGUSR2, registered in coalescing mode */
+static void 
+on_user_signal (const siginfo_t *info, unsigned long count, void *arg)
+{
+    printf ("Received %s x %lu (last one from pid %ld) \n", 
+            info->si_signo == SIGUSR1 ? "SIGUSR1" : "SIGUSR2", count, (long)info->si_pid);
+}
+
+/* Handler for SIGRTMIN, registered in queued mode so that no payload is lost */
+static void 
+on_rt_signal (const siginfo_t *info, unsigned long count, void *arg)
+{
+    printf ("Received SIGRTMIN with payload %d \n", info->si_value.sival_int);
+}
+
+/* Handler for SIGINT and SIGTERM. Tells main () to shut down. */
+static void 
+on_terminate (const siginfo_t *info, unsigned long count, void *arg)
+{
+    printf ("Received %s ... quitting \n", info->si_signo == SIGINT ? "SIGINT" : "SIGTERM");
+    pthread_mutex_lock (&done_lock);
+    done = 1;
+    pthread_cond_signal (&done_cv);
+    pthread_mutex_unlock (&done_lock);
+}
+
+/* Worker thread that sits in a blocking read () on a pipe that nobody writes to */
+static void *
+worker (void *arg)
+{
+    int fd = *(int *)arg;
+    char c;
+    ssize_t n;
+
+    while (1){
+        n = read (fd, &c, 1);
+        if (n == -1 && errno == EINTR){
+            printf ("Worker: read () interrupted by a signal \n");
+            continue;
+        }
+        break;
+    }
+    return NULL;
+}
+
+int 
+main (int argc, char **argv)
+{
+    sigset_t set;
+    pthread_t tid[NUM_WORKERS];
+    int fd[2];
+    union sigval value;
+    int i;
+
+    sigemptyset (&set);
+    sigaddset (&set, SIGINT);
+    sigaddset (&set, SIGTERM);
+    sigaddset (&set, SIGUSR1);
+    sigaddset (&set, SIGUSR2);
+    sigaddset (&set, SIGRTMIN);
+
+    sig_dispatcher_register (SIGINT, on_terminate, NULL, SIG_DISPATCH_COALESCE);
+    sig_dispatcher_register (SIGTERM, on_terminate, NULL, SIG_DISPATCH_COALESCE);
+    sig_dispatcher_register (SIGUSR1, on_user_signal, NULL, SIG_DISPATCH_COALESCE);
+    sig_dispatcher_register (SIGUSR2, on_user_signal, NULL, SIG_DISPATCH_COALESCE);
+    sig_dispatcher_register (SIGRTMIN, on_rt_signal, NULL, SIG_DISPATCH_QUEUED);
+
+    /* Start the dispatcher before creating any other thread */
+    if (sig_dispatcher_start (&set) == -1)
+        exit (EXIT_FAILURE);
+
+    if (pipe (fd) == -1){
+        perror ("pipe");
+        exit (EXIT_FAILURE);
+    }
+    for (i = 0; i < NUM_WORKERS; i++){
+        if (pthread_create (&tid[i], NULL, worker, (void *)&fd[0]) != 0){
+            perror ("pthread_create");
+            exit (EXIT_FAILURE);
+        }
+    }
+
+    printf ("Process ID: %ld \n", (long)getpid ());
+
+    /* Queue a few real-time signals with payloads to ourselves */
+    for (i = 0; i < 3; i++){
+        value.sival_int = i;
+        sigqueue (getpid (), SIGRTMIN, value);
+    }
+
+    pthread_mutex_lock (&done_lock);
+    while (!done)
+        pthread_cond_wait (&done_cv, &done_lock);
+    pthread_mutex_unlock (&done_lock);
+
+    /* Closing the write end makes the workers' read () return 0 */
+    close (fd[1]);
+    for (i = 0; i < NUM_WORKERS; i++)
+        pthread_join (tid[i], NULL);
+    sig_dispatcher_stop ();
+
+    printf ("SIGUSR1: %lu, SIGUSR2: %lu, SIGRTMIN: %lu \n", sig_dispatcher_count (SIGUSR1), 
+            sig_dispatcher_count (SIGUSR2), sig_dispatcher_count (SIGRTMIN));
+    exit (EXIT_SUCCESS);
+}
@@ -0,0 +1,173 @@
+/* Implementation of the signal dispatcher described in signal_dispatcher.h.
+ *
+ * The dispatcher thread sleeps in sigwaitinfo (). When it wakes up it drains the 
+ * remaining pending signals of the set with a zero-timeout sigtimedwait () so that 
+ * a burst of signals is handled as one batch, then calls the registered handlers. 
+ * The handler table is protected by a mutex so handlers can be changed at any time.
+ *
+ * Date created: October 19, 2026
+ *
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include "signal_dispatcher.h"
+
+typedef struct handler_tag {
+    sig_dispatch_handler_t handler;
+    void *arg;
+    int mode;
+} handler_t;
+
+static handler_t handlers[NSIG];
+static volatile unsigned long counters[NSIG];
+static pthread_mutex_t handlers_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static sigset_t wait_set;
+static pthread_t dispatcher_tid;
+static int running = 0;
+static volatile int stop_requested = 0;
+
+int 
+sig_dispatcher_register (int sig, sig_dispatch_handler_t handler, void *arg, int mode)
+{
+    if (sig <= 0 || sig >= NSIG || sig == SIG_DISPATCH_WAKEUP)
+        return -1;
+    if (mode != SIG_DISPATCH_QUEUED && mode != SIG_DISPATCH_COALESCE)
+        return -1;
+
+    pthread_mutex_lock (&handlers_lock);
+    handlers[sig].handler = handler;
+    handlers[sig].arg = arg;
+    handlers[sig].mode = mode;
+    pthread_mutex_unlock (&handlers_lock);
+
+    return 0;
+}
+
+/* Call the handlers for one batch of received signals. Queued handlers see every 
+ * siginfo in order; coalescing handlers are called once per signal with the last 
+ * siginfo and the number of occurrences in the batch. */
+static void 
+dispatch_batch (siginfo_t *batch, int num)
+{
+    unsigned long occurrences[NSIG];
+    int last[NSIG];
+    handler_t h;
+    int i, sig;
+
+    memset (occurrences, 0, sizeof (occurrences));
+    for (i = 0; i < num; i++){
+        sig = batch[i].si_signo;
+        counters[sig]++;
+        occurrences[sig]++;
+        last[sig] = i;
+    }
+
+    for (i = 0; i < num; i++){
+        sig = batch[i].si_signo;
+        if (sig == SIG_DISPATCH_WAKEUP)
+            continue;
+
+        pthread_mutex_lock (&handlers_lock);
+        h = handlers[sig];
+        pthread_mutex_unlock (&handlers_lock);
+        if (h.handler == NULL)
+            continue;
+
+        if (h.mode == SIG_DISPATCH_QUEUED)
+            h.handler (&batch[i], 1, h.arg);
+        else if (last[sig] == i)
+            h.handler (&batch[i], occurrences[sig], h.arg);
+    }
+}
+
+/* The dispatcher thread */
+static void *
+dispatcher_thread (void *arg)
+{
+    siginfo_t batch[SIG_DISPATCH_BATCH];
+    struct timespec no_wait = {0, 0};
+    int num;
+
+    while (!stop_requested){
+        if (sigwaitinfo (&wait_set, &batch[0]) == -1){
+            if (errno == EINTR)
+                continue;
+            perror ("sigwaitinfo");
+            break;
+        }
+
+        /* Pick up whatever else is pending without blocking */
+        num = 1;
+        while (num < SIG_DISPATCH_BATCH && sigtimedwait (&wait_set, &batch[num], &no_wait) > 0)
+            num++;
+
+        dispatch_batch (batch, num);
+    }
+
+    return NULL;
+}
+
+int 
+sig_dispatcher_start (const sigset_t *set)
+{
+    int status;
+
+    if (running)
+        return -1;
+
+    wait_set = *set;
+    sigaddset (&wait_set, SIG_DISPATCH_WAKEUP);
+
+    /* Block the signals in this thread. Threads created from now on, including the 
+     * dispatcher, inherit the mask, so the signals can only be consumed by sigwaitinfo (). */
+    status = pthread_sigmask (SIG_BLOCK, &wait_set, NULL);
+    if (status != 0){
+        errno = status;
+        perror ("pthread_sigmask");
+        return -1;
+    }
+
+    stop_requested = 0;
+    status = pthread_create (&dispatcher_tid, NULL, dispatcher_thread, NULL);
+    if (status != 0){
+        errno = status;
+        perror ("pthread_create");
+        return -1;
+    }
+    running = 1;
+
+    return 0;
+}
+
+void 
+sig_dispatcher_stop (void)
+{
+    if (!running)
+        return;
+
+    stop_requested = 1;
+    pthread_kill (dispatcher_tid, SIG_DISPATCH_WAKEUP);
+    pthread_join (dispatcher_tid, NULL);
+    running = 0;
+}
+
+void 
+sig_dispatcher_child_reset (void)
+{
+    sigprocmask (SIG_UNBLOCK, &wait_set, NULL);
+}
+
+unsigned long 
+sig_dispatcher_count (int sig)
+{
+    if (sig <= 0 || sig >= NSIG)
+        return 0;
+    return counters[sig];
+}
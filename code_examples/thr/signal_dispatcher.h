@@ -0,0 +1,64 @@
+/* Header file for the signal dispatcher used by signal_dispatch_thread.c and by pssh
+ * (shackleford/src/projects/pssh/pssh_v2)
+ *
+ * The dispatcher turns the block-all-then-sigwait pattern of signal_handler_thread.c 
+ * into a reusable component. The signals of interest are blocked in every thread, 
+ * and one dedicated thread waits for them with sigwaitinfo (). Each signal that 
+ * arrives is handed to a handler that was registered for it, and the handler runs 
+ * in normal thread context, so it may call printf (), malloc (), take locks and so 
+ * on, none of which are allowed in an asynchronous signal handler. Worker threads 
+ * never see the signals, so their blocking system calls are not interrupted with EINTR.
+ *
+ * Handlers are registered in one of two modes:
+ *
+ * SIG_DISPATCH_QUEUED:   The handler is called once for every siginfo received, in 
+ *                        arrival order. Use this for real-time signals sent with 
+ *                        sigqueue () whose payload (si_value) must not be lost.
+ *
+ * SIG_DISPATCH_COALESCE: All occurrences of the signal that are pending when the 
+ *                        dispatcher wakes up are folded into a single call, which 
+ *                        receives the most recent siginfo and the number of 
+ *                        occurrences. Use this for SIGCHLD, SIGHUP and the like, where 
+ *                        the handler rescans some state anyway.
+ *
+ * The dispatcher also keeps a counter of how many times each signal was received.
+ *
+ * Date created: October 19, 2026
+ *
+ */
+#ifndef _SIGNAL_DISPATCHER_H_
+#define _SIGNAL_DISPATCHER_H_
+
+#include <signal.h>
+
+#define SIG_DISPATCH_QUEUED 0
+#define SIG_DISPATCH_COALESCE 1
+
+/* Signal used internally to wake up the dispatcher thread when it is stopped */
+#define SIG_DISPATCH_WAKEUP SIGRTMAX
+
+/* Number of siginfo structures drained from the kernel per wake-up */
+#define SIG_DISPATCH_BATCH 64
+
+typedef void (*sig_dispatch_handler_t) (const siginfo_t *info, unsigned long count, void *arg);
+
+/* Register (or, with a NULL handler, remove) the handler for the given signal. May 
+ * be called before or after the dispatcher is started. Returns 0 on success, -1 on error. */
+int sig_dispatcher_register (int sig, sig_dispatch_handler_t handler, void *arg, int mode);
+
+/* Block the signals in set in the calling thread and start the dispatcher thread. 
+ * Call this from main () before any other thread is created so that all threads 
+ * inherit the signal mask. Returns 0 on success, -1 on error. */
+int sig_dispatcher_start (const sigset_t *set);
+
+/* Stop the dispatcher thread and wait for it to exit. The signals stay blocked. */
+void sig_dispatcher_stop (void);
+
+/* Unblock the dispatcher's signals again. Call this in a child created with fork () 
+ * before exec (), since the signal mask is inherited across both. */
+void sig_dispatcher_child_reset (void);
+
+/* Return the number of times the signal has been received since the start */
+unsigned long sig_dispatcher_count (int sig);
+
+#endif /* _SIGNAL_DISPATCHER_H_ */
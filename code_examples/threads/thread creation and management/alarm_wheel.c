@@ -0,0 +1,88 @@
+/* Program to illustrate the timer service. It behaves like alarm_thread.c, but 
+ * instead of creating and detaching a thread per alarm that sleep()s for the 
+ * requested number of seconds, every alarm is a timer entry in the timing wheel 
+ * of a single timer thread. The message is printed by one of the callback workers.
+ *
+ * Date created: October 19, 2026
+ *
+ * Compile as follows: 
+ * gcc -o alarm_wheel alarm_wheel.c timer_service.c -std=c99 -Wall -lpthread 
+*/
+
+#define _REENTRANT // Make sure the library functions are MT (muti-thread) safe
+#include <stdio.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include "timer_service.h"
+
+#define MAX_LENGTH 256
+#define TICK_MS 10
+#define NUM_WORKERS 2
+
+typedef struct alarm_tag{
+    timer_entry_t timer;            /* Embedded timer entry; no separate allocation needed */
+    int seconds;
+    char message[MAX_LENGTH];
+} alarm_t;
+
+static void alarm_expired (void *arg);
+
+int 
+main (int argc, char **argv)
+{
+    char message[MAX_LENGTH];
+    alarm_t *alarm;
+    timer_service_t *ts;
+
+    ts = timer_service_create (TICK_MS, NUM_WORKERS);
+    if (ts == NULL){
+        printf ("Error creating the timer service. \n");
+        exit (EXIT_FAILURE);
+    }
+
+    while (1){
+        printf ("Alarm> ");
+        fflush (stdout);
+        if (fgets (message, MAX_LENGTH, stdin) == NULL)
+            break;
+        if (strlen (message) <= 1) 
+            continue;
+
+        /* Create the alarm structure. It must start zeroed so that the timer entry is idle. */
+        alarm = (alarm_t *)calloc (1, sizeof (alarm_t));
+        if (alarm == NULL){
+            printf ("Error allocating alarm structure. \n");
+            exit (EXIT_FAILURE);
+        }
+
+        /* Parse the input message into two fields: the number of seconds and the message. */
+        if (sscanf (message, "%d %s", &alarm->seconds, alarm->message) < 2 || alarm->seconds < 0){
+            printf ("Bad input. \n");
+            free ((void *)alarm);
+            continue;
+        }
+
+        if (timer_service_add (ts, &alarm->timer, alarm->seconds * 1000, alarm_expired, (void *)alarm) != 0){
+            printf ("Error scheduling alarm. \n");
+            free ((void *)alarm);
+        }
+    } /* End while */
+
+    /* Alarms that have not gone off yet are dropped, just like the detached 
+     * threads of alarm_thread.c die with the process. */
+    timer_service_destroy (ts);
+    exit (EXIT_SUCCESS);
+}
+
+/* Timer callback that prints the message and releases the alarm. It runs on one of
+ * the worker threads of the timer service. */
+static void 
+alarm_expired (void *arg)
+{
+    alarm_t *alarm = (alarm_t *)arg;
+
+    printf ("(%d) %s \n", alarm->seconds, alarm->message);
+    free ((void *)alarm);
+}
@@ -0,0 +1,397 @@
+/* Implementation of the timer service described in timer_service.h.
+ *
+ * A single timer thread blocks in read () on a timerfd that fires once per tick
+ * while there are pending timers, and is disarmed when the wheel is empty so an
+ * idle service costs no wake-ups. On every tick the thread turns the wheel: it
+ * cascades the upper level slots that have come due down into the lower levels and
+ * moves the level 0 slot for the current tick onto the dispatch list, from where
+ * the worker threads pick up the expired timers and run their callbacks.
+ *
+ * All wheel and dispatch list operations are protected by one mutex. Each of them
+ * is O(1) (a list link or unlink), so the lock is held only briefly.
+ *
+ * Date created: October 19, 2026
+ *
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/timerfd.h>
+#include "timer_service.h"
+
+struct timer_service {
+    pthread_mutex_t lock;
+    pthread_cond_t work_available;
+    timer_entry_t wheel[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];   /* List heads for each slot */
+    timer_entry_t dispatch;         /* List head for expired timers */
+    uint64_t now;                   /* Next tick to be processed */
+    uint64_t tick_ns;
+    struct timespec start;
+    unsigned long num_pending;      /* Timers in the wheel */
+    unsigned long num_queued;       /* Timers on the dispatch list */
+    int timer_fd;
+    int armed;
+    int shutdown;
+    pthread_t timer_thread;
+    int num_workers;
+    pthread_t *workers;
+};
+
+static void
+list_init (timer_entry_t *head)
+{
+    head->next = head;
+    head->prev = head;
+}
+
+static void
+list_append (timer_entry_t *head, timer_entry_t *t)
+{
+    t->prev = head->prev;
+    t->next = head;
+    head->prev->next = t;
+    head->prev = t;
+}
+
+static void
+list_unlink (timer_entry_t *t)
+{
+    t->prev->next = t->next;
+    t->next->prev = t->prev;
+    t->next = t->prev = NULL;
+}
+
+/* Return the number of ticks that have elapsed since the service was created */
+static uint64_t
+current_tick (timer_service_t *ts)
+{
+    struct timespec now;
+    uint64_t elapsed_ns;
+
+    clock_gettime (CLOCK_MONOTONIC, &now);
+    elapsed_ns = (uint64_t)(now.tv_sec - ts->start.tv_sec) * 1000000000ULL \
+                 + now.tv_nsec - ts->start.tv_nsec;
+    return elapsed_ns / ts->tick_ns;
+}
+
+/* Arm the timerfd to fire once per tick; a zero interval disarms it. */
+static int
+set_timer_fd (timer_service_t *ts, uint64_t value_ns, uint64_t interval_ns)
+{
+    struct itimerspec its;
+
+    its.it_value.tv_sec = value_ns / 1000000000ULL;
+    its.it_value.tv_nsec = value_ns % 1000000000ULL;
+    its.it_interval.tv_sec = interval_ns / 1000000000ULL;
+    its.it_interval.tv_nsec = interval_ns % 1000000000ULL;
+    return timerfd_settime (ts->timer_fd, 0, &its, NULL);
+}
+
+/* Place the timer in the slot that matches how far in the future it expires. The
+ * level is chosen by the distance from the current tick and the slot within the
+ * level by the corresponding bits of the absolute expiry time. */
+static void
+wheel_insert (timer_service_t *ts, timer_entry_t *t)
+{
+    uint64_t delta;
+    int level;
+    unsigned int slot;
+
+    if (t->expires < ts->now)
+        t->expires = ts->now;
+    delta = t->expires - ts->now;
+    if (delta > 0xffffffffULL){
+        delta = 0xffffffffULL;
+        t->expires = ts->now + delta;
+    }
+
+    for (level = 0; level < TIMER_WHEEL_LEVELS - 1; level++)
+        if (delta < (1ULL << (TIMER_WHEEL_BITS * (level + 1))))
+            break;
+
+    slot = (t->expires >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK;
+    list_append (&ts->wheel[level][slot], t);
+}
+
+/* Re-insert every timer of the given slot; they all land in lower levels. Returns
+ * the slot index so the caller knows whether the next level has to be cascaded too. */
+static unsigned int
+cascade (timer_service_t *ts, int level, unsigned int slot)
+{
+    timer_entry_t *head = &ts->wheel[level][slot];
+    timer_entry_t *t;
+
+    while (head->next != head){
+        t = head->next;
+        list_unlink (t);
+        wheel_insert (ts, t);
+    }
+    return slot;
+}
+
+/* Process the current tick and move the wheel one step forward */
+static void
+advance_one (timer_service_t *ts)
+{
+    unsigned int slot = ts->now & TIMER_WHEEL_MASK;
+    timer_entry_t *head, *t;
+    int level;
+
+    if (slot == 0){
+        for (level = 1; level < TIMER_WHEEL_LEVELS; level++)
+            if (cascade (ts, level, (ts->now >> (TIMER_WHEEL_BITS * level)) & TIMER_WHEEL_MASK) != 0)
+                break;
+    }
+
+    head = &ts->wheel[0][slot];
+    while (head->next != head){
+        t = head->next;
+        list_unlink (t);
+        t->state = TIMER_QUEUED;
+        list_append (&ts->dispatch, t);
+        ts->num_pending--;
+        ts->num_queued++;
+    }
+    ts->now++;
+}
+
+/* The timer thread. Sleeps on the timerfd and turns the wheel up to the current tick. */
+static void *
+timer_thread (void *arg)
+{
+    timer_service_t *ts = (timer_service_t *)arg;
+    uint64_t expirations, target;
+    unsigned long queued;
+
+    while (1){
+        if (read (ts->timer_fd, &expirations, sizeof (expirations)) != sizeof (expirations)){
+            if (errno == EINTR)
+                continue;
+            perror ("timer_thread: read");
+            break;
+        }
+
+        pthread_mutex_lock (&ts->lock);
+        if (ts->shutdown){
+            pthread_mutex_unlock (&ts->lock);
+            break;
+        }
+
+        queued = ts->num_queued;
+        target = current_tick (ts);
+        while (ts->now <= target && ts->num_pending > 0)
+            advance_one (ts);
+        if (ts->num_pending == 0 && ts->armed){
+            set_timer_fd (ts, 0, 0);
+            ts->armed = 0;
+        }
+
+        if (ts->num_queued > queued)
+            pthread_cond_broadcast (&ts->work_available);
+        pthread_mutex_unlock (&ts->lock);
+    }
+
+    return NULL;
+}
+
+/* The worker threads that run the callbacks of expired timers */
+static void *
+worker_thread (void *arg)
+{
+    timer_service_t *ts = (timer_service_t *)arg;
+    timer_entry_t *t;
+    timer_callback_t callback;
+    void *callback_arg;
+
+    pthread_mutex_lock (&ts->lock);
+    while (1){
+        while (ts->dispatch.next == &ts->dispatch && !ts->shutdown)
+            pthread_cond_wait (&ts->work_available, &ts->lock);
+        if (ts->shutdown)
+            break;
+
+        t = ts->dispatch.next;
+        list_unlink (t);
+        ts->num_queued--;
+
+        /* The entry belongs to the caller again once the callback starts. The callback
+         * is free to re-add or release it, so we must not touch it afterwards. */
+        t->state = TIMER_IDLE;
+        callback = t->callback;
+        callback_arg = t->arg;
+
+        pthread_mutex_unlock (&ts->lock);
+        callback (callback_arg);
+        pthread_mutex_lock (&ts->lock);
+    }
+    pthread_mutex_unlock (&ts->lock);
+
+    return NULL;
+}
+
+timer_service_t *
+timer_service_create (unsigned int tick_ms, int num_workers)
+{
+    timer_service_t *ts;
+    int i, j;
+
+    if (tick_ms == 0 || num_workers <= 0)
+        return NULL;
+
+    ts = (timer_service_t *)malloc (sizeof (timer_service_t));
+    if (ts == NULL)
+        return NULL;
+    memset (ts, 0, sizeof (timer_service_t));
+
+    for (i = 0; i < TIMER_WHEEL_LEVELS; i++)
+        for (j = 0; j < TIMER_WHEEL_SLOTS; j++)
+            list_init (&ts->wheel[i][j]);
+    list_init (&ts->dispatch);
+
+    ts->tick_ns = (uint64_t)tick_ms * 1000000ULL;
+    clock_gettime (CLOCK_MONOTONIC, &ts->start);
+    pthread_mutex_init (&ts->lock, NULL);
+    pthread_cond_init (&ts->work_available, NULL);
+
+    ts->timer_fd = timerfd_create (CLOCK_MONOTONIC, TFD_CLOEXEC);
+    if (ts->timer_fd == -1){
+        perror ("timerfd_create");
+        free ((void *)ts);
+        return NULL;
+    }
+
+    ts->workers = (pthread_t *)malloc (num_workers * sizeof (pthread_t));
+    if (ts->workers == NULL){
+        close (ts->timer_fd);
+        free ((void *)ts);
+        return NULL;
+    }
+
+    if (pthread_create (&ts->timer_thread, NULL, timer_thread, (void *)ts) != 0){
+        close (ts->timer_fd);
+        free ((void *)ts->workers);
+        free ((void *)ts);
+        return NULL;
+    }
+
+    for (i = 0; i < num_workers; i++){
+        if (pthread_create (&ts->workers[i], NULL, worker_thread, (void *)ts) != 0)
+            break;
+        ts->num_workers++;
+    }
+    if (ts->num_workers == 0){
+        timer_service_destroy (ts);
+        return NULL;
+    }
+
+    return ts;
+}
+
+int
+timer_service_add (timer_service_t *ts, timer_entry_t *timer, unsigned int timeout_ms,
+                   timer_callback_t callback, void *arg)
+{
+    uint64_t ticks;
+
+    if (callback == NULL || timer->state != TIMER_IDLE)
+        return -1;
+
+    /* Round the timeout up to a whole number of ticks */
+    ticks = ((uint64_t)timeout_ms * 1000000ULL + ts->tick_ns - 1) / ts->tick_ns;
+
+    pthread_mutex_lock (&ts->lock);
+    if (ts->shutdown){
+        pthread_mutex_unlock (&ts->lock);
+        return -1;
+    }
+
+    /* The wheel stands still while it is empty, so catch it up with real time
+     * before the first timer goes in and start the periodic tick. */
+    if (!ts->armed){
+        if (ts->num_pending == 0)
+            ts->now = current_tick (ts);
+        if (set_timer_fd (ts, ts->tick_ns, ts->tick_ns) == -1){
+            pthread_mutex_unlock (&ts->lock);
+            return -1;
+        }
+        ts->armed = 1;
+    }
+
+    timer->callback = callback;
+    timer->arg = arg;
+    timer->expires = ts->now + ticks;
+    timer->state = TIMER_PENDING;
+    wheel_insert (ts, timer);
+    ts->num_pending++;
+    pthread_mutex_unlock (&ts->lock);
+
+    return 0;
+}
+
+int
+timer_service_cancel (timer_service_t *ts, timer_entry_t *timer)
+{
+    int status = 0;
+
+    pthread_mutex_lock (&ts->lock);
+    switch (timer->state){
+        case TIMER_PENDING:
+            list_unlink (timer);
+            ts->num_pending--;
+            break;
+
+        case TIMER_QUEUED:
+            list_unlink (timer);
+            ts->num_queued--;
+            break;
+
+        default:
+            status = -1;
+    }
+    if (status == 0)
+        timer->state = TIMER_IDLE;
+    pthread_mutex_unlock (&ts->lock);
+
+    return status;
+}
+
+unsigned long
+timer_service_pending (timer_service_t *ts)
+{
+    unsigned long count;
+
+    pthread_mutex_lock (&ts->lock);
+    count = ts->num_pending + ts->num_queued;
+    pthread_mutex_unlock (&ts->lock);
+
+    return count;
+}
+
+void
+timer_service_destroy (timer_service_t *ts)
+{
+    int i;
+
+    /* Wake up the timer thread right away so that it sees the shutdown flag */
+    pthread_mutex_lock (&ts->lock);
+    ts->shutdown = 1;
+    set_timer_fd (ts, 1, 0);
+    pthread_cond_broadcast (&ts->work_available);
+    pthread_mutex_unlock (&ts->lock);
+
+    pthread_join (ts->timer_thread, NULL);
+    for (i = 0; i < ts->num_workers; i++)
+        pthread_join (ts->workers[i], NULL);
+
+    close (ts->timer_fd);
+    pthread_mutex_destroy (&ts->lock);
+    pthread_cond_destroy (&ts->work_available);
+    free ((void *)ts->workers);
+    free ((void *)ts);
+}
@@ -0,0 +1,68 @@
+/* Header file for the timer service used by alarm_wheel.c and timer_service_bench.c
+ *
+ * The timer service replaces the thread-per-alarm design in alarm_thread.c with
+ * a single timer thread driven by a timerfd, and a hierarchical timing wheel that
+ * holds the pending timeouts. Expired timers are handed off to a small pool of
+ * worker threads which run the user callbacks, so a slow callback never delays
+ * the timer thread.
+ *
+ * The wheel has TIMER_WHEEL_LEVELS levels of TIMER_WHEEL_SLOTS slots each. Every
+ * slot is a doubly-linked list, so adding and cancelling a timer are both O(1).
+ * Timers that are far in the future sit in the upper levels and are cascaded
+ * down one level at a time as the wheel turns.
+ *
+ * Timer entries are allocated by the caller (typically embedded in a larger
+ * structure such as a connection) so that the service itself never calls malloc
+ * on the add/cancel path.
+ *
+ * Date created: October 19, 2026
+ *
+ */
+#ifndef _TIMER_SERVICE_H_
+#define _TIMER_SERVICE_H_
+
+#include <stdint.h>
+
+#define TIMER_WHEEL_BITS 8
+#define TIMER_WHEEL_SLOTS (1 << TIMER_WHEEL_BITS)
+#define TIMER_WHEEL_MASK (TIMER_WHEEL_SLOTS - 1)
+#define TIMER_WHEEL_LEVELS 4        /* 2^32 ticks of range */
+
+/* States of a timer entry */
+#define TIMER_IDLE 0                /* Not known to the service */
+#define TIMER_PENDING 1             /* Sitting in one of the wheel slots */
+#define TIMER_QUEUED 2              /* Expired, waiting for a worker to run it */
+
+typedef void (*timer_callback_t) (void *arg);
+
+typedef struct timer_entry {
+    struct timer_entry *next;
+    struct timer_entry *prev;
+    uint64_t expires;               /* Absolute expiry time in ticks */
+    timer_callback_t callback;
+    void *arg;
+    int state;
+} timer_entry_t;
+
+typedef struct timer_service timer_service_t;
+
+/* Create a timer service with the given tick resolution in milliseconds and
+ * number of callback worker threads. Returns NULL on failure. */
+timer_service_t *timer_service_create (unsigned int tick_ms, int num_workers);
+
+/* Schedule the timer to call callback (arg) after timeout_ms milliseconds. The
+ * entry must be idle. Returns 0 on success, -1 on error. */
+int timer_service_add (timer_service_t *ts, timer_entry_t *timer, unsigned int timeout_ms,
+                       timer_callback_t callback, void *arg);
+
+/* Cancel a timer that has not yet started running. Returns 0 if the timer was
+ * cancelled, -1 if it was idle or its callback has already been started. */
+int timer_service_cancel (timer_service_t *ts, timer_entry_t *timer);
+
+/* Return the number of timers that are pending or queued for dispatch. */
+unsigned long timer_service_pending (timer_service_t *ts);
+
+/* Stop the timer thread and the workers. Timers that have not fired are dropped. */
+void timer_service_destroy (timer_service_t *ts);
+
+#endif /* _TIMER_SERVICE_H_ */
@@ -0,0 +1,143 @@
+/* Benchmark for the timer service. Schedules a large number of timers (one million 
+ * by default) with timeouts spread uniformly over a window, cancels a fraction of them 
+ * the way connection-idle tracking does when traffic arrives on a connection, and then 
+ * waits for the remaining ones to fire. Reports the cost of add and cancel, how late 
+ * the timers fired relative to their deadline, and the number of threads used.
+ *
+ * For comparison, alarm_thread.c needs one thread (and one stack, 8 MB of address 
+ * space by default) per pending alarm, and typically runs into the thread or memory 
+ * limit after a few thousand of them.
+ *
+ * Date created: October 19, 2026
+ *
+ * Compile as follows: 
+ * gcc -o timer_service_bench timer_service_bench.c timer_service.c -std=c99 -Wall -O2 -lpthread 
+ *
+ * Usage: ./timer_service_bench [num-timers] [window-ms] [cancel-percent]
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include "timer_service.h"
+
+#define TICK_MS 1
+#define NUM_WORKERS 4
+
+typedef struct conn_tag{
+    timer_entry_t timer;
+    double deadline;                /* Absolute deadline in seconds */
+} conn_t;
+
+static double max_late = 0.0;
+static double total_late = 0.0;
+static unsigned long num_fired = 0;
+static pthread_mutex_t stats_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static double 
+now_seconds (void)
+{
+    struct timespec ts;
+
+    clock_gettime (CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void 
+idle_timeout (void *arg)
+{
+    conn_t *conn = (conn_t *)arg;
+    double late = now_seconds () - conn->deadline;
+
+    pthread_mutex_lock (&stats_lock);
+    num_fired++;
+    total_late += late;
+    if (late > max_late)
+        max_late = late;
+    pthread_mutex_unlock (&stats_lock);
+}
+
+int 
+main (int argc, char **argv)
+{
+    unsigned long num_timers = 1000000;
+    unsigned int window_ms = 2000;
+    int cancel_percent = 50;
+    unsigned long i, num_cancelled = 0, expected;
+    unsigned int timeout;
+    conn_t *conns;
+    timer_service_t *ts;
+    double start, add_time, cancel_time, wait_start;
+
+    if (argc > 1)
+        num_timers = strtoul (argv[1], NULL, 10);
+    if (argc > 2)
+        window_ms = atoi (argv[2]);
+    if (argc > 3)
+        cancel_percent = atoi (argv[3]);
+
+    conns = (conn_t *)calloc (num_timers, sizeof (conn_t));
+    if (conns == NULL){
+        perror ("calloc");
+        exit (EXIT_FAILURE);
+    }
+
+    ts = timer_service_create (TICK_MS, NUM_WORKERS);
+    if (ts == NULL){
+        printf ("Error creating the timer service. \n");
+        exit (EXIT_FAILURE);
+    }
+
+    srand (1);
+    start = now_seconds ();
+    for (i = 0; i < num_timers; i++){
+        timeout = 100 + rand () % (window_ms + 1);
+        conns[i].deadline = now_seconds () + timeout / 1000.0;
+        if (timer_service_add (ts, &conns[i].timer, timeout, idle_timeout, (void *)&conns[i]) != 0){
+            printf ("Error adding timer %lu. \n", i);
+            exit (EXIT_FAILURE);
+        }
+    }
+    add_time = now_seconds () - start;
+    printf ("Pending timers: %lu \n", timer_service_pending (ts));
+
+    start = now_seconds ();
+    for (i = 0; i < num_timers; i++)
+        if (rand () % 100 < cancel_percent)
+            if (timer_service_cancel (ts, &conns[i].timer) == 0)
+                num_cancelled++;
+    cancel_time = now_seconds () - start;
+    expected = num_timers - num_cancelled;
+
+    wait_start = now_seconds ();
+    while (1){
+        pthread_mutex_lock (&stats_lock);
+        i = num_fired;
+        pthread_mutex_unlock (&stats_lock);
+        if (i >= expected)
+            break;
+        if (now_seconds () - wait_start > window_ms / 1000.0 + 10.0){
+            printf ("Timed out waiting for timers: %lu of %lu fired. \n", i, expected);
+            break;
+        }
+        usleep (10000);
+    }
+
+    printf ("Timers added:     %lu (%.1f ns per add) \n", num_timers, add_time * 1e9 / num_timers);
+    printf ("Timers cancelled: %lu (%.1f ns per cancel) \n", num_cancelled, 
+            num_timers ? cancel_time * 1e9 / num_timers : 0.0);
+    printf ("Timers fired:     %lu of %lu expected \n", num_fired, expected);
+    if (num_fired > 0)
+        printf ("Lateness:         mean %.2f ms, max %.2f ms \n", 
+                total_late * 1e3 / num_fired, max_late * 1e3);
+    printf ("Threads used:     %d (1 timer thread + %d workers + main) \n", NUM_WORKERS + 2, NUM_WORKERS);
+    printf ("Timer entry size: %zu bytes \n", sizeof (timer_entry_t));
+
+    timer_service_destroy (ts);
+    free ((void *)conns);
+    exit (EXIT_SUCCESS);
+}